@@ -122,14 +122,36 @@ void *MEM_lockfree_reallocN_id(void *vmemh, size_t len, const char *str)
 		size_t old_len = MEM_lockfree_allocN_len(vmemh);
 
 		if (!MEMHEAD_IS_ALIGNED(memh)) {
-			newp = MEM_lockfree_mallocN(len, "realloc");
-		}
-		else {
-			MemHeadAligned *memh_aligned = MEMHEAD_ALIGNED_FROM_PTR(vmemh);
-			newp = MEM_lockfree_mallocN_aligned(
-				len, (size_t)memh_aligned->alignment, "realloc");
+			/* The system allocator can often grow the block in place, or for
+			 * large blocks remap the pages instead of copying them. */
+			len = SIZET_ALIGN_4(len);
+			MemHead *memh_new = (MemHead *)realloc(memh,
+												   len + sizeof(MemHead));
+			if (memh_new == NULL) {
+				print_error("Realloc returns null: len=" SIZET_FORMAT
+							" in %s, total " SIZET_FORMAT "\n",
+							SIZET_ARG(len),
+							str,
+							SIZET_ARG(memory_usage_current()));
+				return NULL;
+			}
+
+#if defined(MEM_MALLOC_DEBUG_MEMSET)
+			if (len > old_len) {
+				memset((char *)(memh_new + 1) + old_len, 255, len - old_len);
+			}
+#endif
+
+			memory_usage_block_free(old_len);
+			memory_usage_block_alloc(len);
+			memh_new->len = len;
+			return PTR_FROM_MEMHEAD(memh_new);
 		}
 
+		MemHeadAligned *memh_aligned = MEMHEAD_ALIGNED_FROM_PTR(vmemh);
+		newp = MEM_lockfree_mallocN_aligned(
+			len, (size_t)memh_aligned->alignment, "realloc");
+
 		if (newp) {
 			if (len < old_len) {
 				memcpy(newp, vmemh, len);
@@ -1,5 +1,8 @@
 #include "utfconv.h"
 
+#include <stddef.h>
+#include <string.h>
+
 size_t count_utf_8_from_16(const wchar_t *string16)
 {
 	int i;
@@ -267,26 +270,985 @@ static void utf_8_cut_end ( char *inout8 , size_t maxcutpoint ) {
 }
 #endif
 
+/* -------------------------------------------------------------------- */
+/** \name Vectorized Transcoding
+ *
+ * Runs of ASCII are converted 16 or 32 code units at a time, everything else
+ * one sequence at a time, and the validator classifies every byte with the
+ * nibble lookup tables of Keiser & Lemire ("Validating UTF-8 In Less Than One
+ * Instruction Per Byte"). The instruction set is picked at runtime.
+ *
+ * The vector paths need 16-bit code units, with a wider wchar_t only the
+ * validator is vectorized.
+ * \{ */
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+	defined(_M_IX86)
+#	define UTF_SIMD_X86
+#	include <immintrin.h>
+#	if defined(_MSC_VER)
+#		include <intrin.h>
+#	else
+#		include <cpuid.h>
+#	endif
+#endif
+
+#if defined(UTF_SIMD_X86) && WCHAR_MAX <= 0xFFFF
+#	define UTF_SIMD_UTF16
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#	define UTF_TARGET(_isa) __attribute__((target(_isa)))
+#else
+#	define UTF_TARGET(_isa)
+#endif
+
+/** Decode the sequence at \a p (shortest form only, no surrogates).
+ * \return Its length or 0 when it is invalid. */
+static size_t utf_8_decode(const unsigned char *p,
+						   const unsigned char *end,
+						   unsigned int *r_u32)
+{
+	const unsigned char c = p[0];
+	const size_t avail = (size_t)(end - p);
+
+	if (c < 0x80) {
+		*r_u32 = c;
+		return 1;
+	}
+	if (c < 0xC2) {
+		return 0;
+	}
+	if (c < 0xE0) {
+		if (avail < 2 || (p[1] & 0xC0) != 0x80) {
+			return 0;
+		}
+		*r_u32 = ((c & 0x1Fu) << 6) | (p[1] & 0x3Fu);
+		return 2;
+	}
+	if (c < 0xF0) {
+		const unsigned char lo = (c == 0xE0) ? 0xA0 : 0x80;
+		const unsigned char hi = (c == 0xED) ? 0x9F : 0xBF;
+		if (avail < 3 || p[1] < lo || p[1] > hi || (p[2] & 0xC0) != 0x80) {
+			return 0;
+		}
+		*r_u32 = ((c & 0x0Fu) << 12) | ((p[1] & 0x3Fu) << 6) | (p[2] & 0x3Fu);
+		return 3;
+	}
+	if (c < 0xF5) {
+		const unsigned char lo = (c == 0xF0) ? 0x90 : 0x80;
+		const unsigned char hi = (c == 0xF4) ? 0x8F : 0xBF;
+		if (avail < 4 || p[1] < lo || p[1] > hi || (p[2] & 0xC0) != 0x80 ||
+			(p[3] & 0xC0) != 0x80)
+		{
+			return 0;
+		}
+		*r_u32 = ((c & 0x07u) << 18) | ((p[1] & 0x3Fu) << 12) |
+				 ((p[2] & 0x3Fu) << 6) | (p[3] & 0x3Fu);
+		return 4;
+	}
+	return 0;
+}
+
+/** Convert the non ASCII sequences at \a *r_in up to the next ASCII byte. */
+static wchar_t *utf_8_to_16_sequences(const unsigned char **r_in,
+									  const unsigned char *end,
+									  wchar_t *out,
+									  int *r_err)
+{
+	const unsigned char *in = *r_in;
+	while (in < end && *in >= 0x80) {
+		unsigned int u32;
+		const size_t n = utf_8_decode(in, end, &u32);
+		if (n == 0) {
+			*r_err |= (*in >= 0xC2 && *in < 0xF5) ? UTF_ERROR_ILLSEQ :
+													  UTF_ERROR_ILLCHAR;
+			in++;
+		}
+		else if (u32 < 0x10000) {
+			*out++ = (wchar_t)u32;
+			in += n;
+		}
+		else {
+			u32 -= 0x10000;
+			*out++ = (wchar_t)(0xD800 + (u32 >> 10));
+			*out++ = (wchar_t)(0xDC00 + (u32 & 0x3FF));
+			in += n;
+		}
+	}
+	*r_in = in;
+	return out;
+}
+
+/** Convert the non ASCII code units at \a *r_in up to the next ASCII one. */
+static char *utf_16_to_8_sequences(const wchar_t **r_in,
+								   const wchar_t *end,
+								   char *out,
+								   int *r_err)
+{
+	const wchar_t *in = *r_in;
+	while (in < end && (unsigned int)*in >= 0x80) {
+		unsigned int u = (unsigned int)*in++;
+		if (u >= 0xD800 && u < 0xE000) {
+			if (u >= 0xDC00 || in == end || (unsigned int)*in < 0xDC00 ||
+				(unsigned int)*in >= 0xE000)
+			{
+				*r_err |= UTF_ERROR_ILLCHAR;
+				continue;
+			}
+			u = 0x10000 + ((u - 0xD800) << 10) + ((unsigned int)*in++ - 0xDC00);
+		}
+		else if (u >= 0x110000) {
+			*r_err |= UTF_ERROR_ILLCHAR;
+			continue;
+		}
+
+		if (u < 0x800) {
+			*out++ = (char)(0xC0 | (u >> 6));
+			*out++ = (char)(0x80 | (u & 0x3F));
+		}
+		else if (u < 0x10000) {
+			*out++ = (char)(0xE0 | (u >> 12));
+			*out++ = (char)(0x80 | ((u >> 6) & 0x3F));
+			*out++ = (char)(0x80 | (u & 0x3F));
+		}
+		else {
+			*out++ = (char)(0xF0 | (u >> 18));
+			*out++ = (char)(0x80 | ((u >> 12) & 0x3F));
+			*out++ = (char)(0x80 | ((u >> 6) & 0x3F));
+			*out++ = (char)(0x80 | (u & 0x3F));
+		}
+	}
+	*r_in = in;
+	return out;
+}
+
+static size_t utf_8_to_16_scalar(const unsigned char *in,
+								 const unsigned char *end,
+								 wchar_t *out16,
+								 int *r_err)
+{
+	wchar_t *out = out16;
+	while (in < end) {
+		while (in < end && *in < 0x80) {
+			*out++ = *in++;
+		}
+		out = utf_8_to_16_sequences(&in, end, out, r_err);
+	}
+	return (size_t)(out - out16);
+}
+
+static size_t utf_16_to_8_scalar(const wchar_t *in,
+								 const wchar_t *end,
+								 char *out8,
+								 int *r_err)
+{
+	char *out = out8;
+	while (in < end) {
+		while (in < end && (unsigned int)*in < 0x80) {
+			*out++ = (char)*in++;
+		}
+		out = utf_16_to_8_sequences(&in, end, out, r_err);
+	}
+	return (size_t)(out - out8);
+}
+
+static int utf_8_validate_scalar(const unsigned char *in, size_t len8)
+{
+	const unsigned char *end = in + len8;
+	while (in < end) {
+		unsigned int u32;
+		const size_t n = utf_8_decode(in, end, &u32);
+		if (n == 0) {
+			return 0;
+		}
+		in += n;
+	}
+	return 1;
+}
+
+#ifdef UTF_SIMD_X86
+
+/* Error bits of the lookup tables, a byte pair is invalid when a bit is set
+ * in the entries of all three of its nibbles. */
+#	define UTF_TOO_SHORT (1 << 0)
+#	define UTF_TOO_LONG (1 << 1)
+#	define UTF_OVERLONG_3 (1 << 2)
+#	define UTF_TOO_LARGE (1 << 3)
+#	define UTF_SURROGATE (1 << 4)
+#	define UTF_OVERLONG_2 (1 << 5)
+#	define UTF_TOO_LARGE_1000 (1 << 6)
+#	define UTF_OVERLONG_4 (1 << 6)
+#	define UTF_TWO_CONTS (1 << 7)
+#	define UTF_CARRY (UTF_TOO_SHORT | UTF_TOO_LONG | UTF_TWO_CONTS)
+
+/** Indexed by the high nibble of the first byte of the pair. */
+static const unsigned char utf_lut_byte_1_high[16] = {
+	UTF_TOO_LONG,
+	UTF_TOO_LONG,
+	UTF_TOO_LONG,
+	UTF_TOO_LONG,
+	UTF_TOO_LONG,
+	UTF_TOO_LONG,
+	UTF_TOO_LONG,
+	UTF_TOO_LONG,
+	UTF_TWO_CONTS,
+	UTF_TWO_CONTS,
+	UTF_TWO_CONTS,
+	UTF_TWO_CONTS,
+	UTF_TOO_SHORT | UTF_OVERLONG_2,
+	UTF_TOO_SHORT,
+	UTF_TOO_SHORT | UTF_OVERLONG_3 | UTF_SURROGATE,
+	UTF_TOO_SHORT | UTF_TOO_LARGE | UTF_TOO_LARGE_1000 | UTF_OVERLONG_4,
+};
+
+/** Indexed by the low nibble of the first byte of the pair. */
+static const unsigned char utf_lut_byte_1_low[16] = {
+	UTF_CARRY | UTF_OVERLONG_3 | UTF_OVERLONG_2 | UTF_OVERLONG_4,
+	UTF_CARRY | UTF_OVERLONG_2,
+	UTF_CARRY,
+	UTF_CARRY,
+	UTF_CARRY | UTF_TOO_LARGE,
+	UTF_CARRY | UTF_TOO_LARGE | UTF_TOO_LARGE_1000,
+	UTF_CARRY | UTF_TOO_LARGE | UTF_TOO_LARGE_1000,
+	UTF_CARRY | UTF_TOO_LARGE | UTF_TOO_LARGE_1000,
+	UTF_CARRY | UTF_TOO_LARGE | UTF_TOO_LARGE_1000,
+	UTF_CARRY | UTF_TOO_LARGE | UTF_TOO_LARGE_1000,
+	UTF_CARRY | UTF_TOO_LARGE | UTF_TOO_LARGE_1000,
+	UTF_CARRY | UTF_TOO_LARGE | UTF_TOO_LARGE_1000,
+	UTF_CARRY | UTF_TOO_LARGE | UTF_TOO_LARGE_1000,
+	UTF_CARRY | UTF_TOO_LARGE | UTF_TOO_LARGE_1000 | UTF_SURROGATE,
+	UTF_CARRY | UTF_TOO_LARGE | UTF_TOO_LARGE_1000,
+	UTF_CARRY | UTF_TOO_LARGE | UTF_TOO_LARGE_1000,
+};
+
+/** Indexed by the high nibble of the second byte of the pair. */
+static const unsigned char utf_lut_byte_2_high[16] = {
+	UTF_TOO_SHORT,
+	UTF_TOO_SHORT,
+	UTF_TOO_SHORT,
+	UTF_TOO_SHORT,
+	UTF_TOO_SHORT,
+	UTF_TOO_SHORT,
+	UTF_TOO_SHORT,
+	UTF_TOO_SHORT,
+	UTF_TOO_LONG | UTF_OVERLONG_2 | UTF_TWO_CONTS | UTF_OVERLONG_3 |
+		UTF_TOO_LARGE_1000 | UTF_OVERLONG_4,
+	UTF_TOO_LONG | UTF_OVERLONG_2 | UTF_TWO_CONTS | UTF_OVERLONG_3 |
+		UTF_TOO_LARGE,
+	UTF_TOO_LONG | UTF_OVERLONG_2 | UTF_TWO_CONTS | UTF_SURROGATE |
+		UTF_TOO_LARGE,
+	UTF_TOO_LONG | UTF_OVERLONG_2 | UTF_TWO_CONTS | UTF_SURROGATE |
+		UTF_TOO_LARGE,
+	UTF_TOO_SHORT,
+	UTF_TOO_SHORT,
+	UTF_TOO_SHORT,
+	UTF_TOO_SHORT,
+};
+
+/** The last bytes of a block that may not be lead bytes of sequences longer
+ * than the rest of the block. */
+static const unsigned char utf_incomplete_max[32] = {
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1,
+};
+
+UTF_TARGET("ssse3")
+static int utf_8_validate_ssse3(const unsigned char *in, size_t len8)
+{
+	const __m128i lut_1_high =
+		_mm_loadu_si128((const __m128i *)utf_lut_byte_1_high);
+	const __m128i lut_1_low =
+		_mm_loadu_si128((const __m128i *)utf_lut_byte_1_low);
+	const __m128i lut_2_high =
+		_mm_loadu_si128((const __m128i *)utf_lut_byte_2_high);
+	const __m128i incomplete_max =
+		_mm_loadu_si128((const __m128i *)(utf_incomplete_max + 16));
+	const __m128i nibble = _mm_set1_epi8(0x0F);
+	const __m128i zero = _mm_setzero_si128();
+
+	__m128i prev_input = zero, prev_incomplete = zero, error = zero;
+	unsigned char tail[16];
+
+	for (size_t i = 0; i < len8; i += 16) {
+		__m128i input;
+		if (len8 - i >= 16) {
+			input = _mm_loadu_si128((const __m128i *)(in + i));
+		}
+		else {
+			/* Pad with ASCII, a truncated sequence at the end is an error. */
+			memset(tail, 0x20, sizeof(tail));
+			memcpy(tail, in + i, len8 - i);
+			input = _mm_loadu_si128((const __m128i *)tail);
+		}
+
+		if (_mm_movemask_epi8(input) == 0) {
+			error = _mm_or_si128(error, prev_incomplete);
+			prev_incomplete = zero;
+		}
+		else {
+			const __m128i prev1 = _mm_alignr_epi8(input, prev_input, 15);
+			const __m128i special_cases = _mm_and_si128(
+				_mm_and_si128(
+					_mm_shuffle_epi8(
+						lut_1_high,
+						_mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+					_mm_shuffle_epi8(lut_1_low, _mm_and_si128(prev1, nibble))),
+				_mm_shuffle_epi8(
+					lut_2_high,
+					_mm_and_si128(_mm_srli_epi16(input, 4), nibble)));
+
+			/* Third and fourth bytes of sequences must be continuations. */
+			const __m128i prev2 = _mm_alignr_epi8(input, prev_input, 14);
+			const __m128i prev3 = _mm_alignr_epi8(input, prev_input, 13);
+			const __m128i is_third =
+				_mm_subs_epu8(prev2, _mm_set1_epi8((char)(0xE0 - 1)));
+			const __m128i is_fourth =
+				_mm_subs_epu8(prev3, _mm_set1_epi8((char)(0xF0 - 1)));
+			const __m128i must23 = _mm_and_si128(
+				_mm_cmpgt_epi8(_mm_or_si128(is_third, is_fourth), zero),
+				_mm_set1_epi8((char)0x80));
+
+			error = _mm_or_si128(error, _mm_xor_si128(must23, special_cases));
+			prev_incomplete = _mm_subs_epu8(input, incomplete_max);
+		}
+		prev_input = input;
+	}
+
+	error = _mm_or_si128(error, prev_incomplete);
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(error, zero)) == 0xFFFF;
+}
+
+UTF_TARGET("avx2")
+static int utf_8_validate_avx2(const unsigned char *in, size_t len8)
+{
+	const __m256i lut_1_high = _mm256_broadcastsi128_si256(
+		_mm_loadu_si128((const __m128i *)utf_lut_byte_1_high));
+	const __m256i lut_1_low = _mm256_broadcastsi128_si256(
+		_mm_loadu_si128((const __m128i *)utf_lut_byte_1_low));
+	const __m256i lut_2_high = _mm256_broadcastsi128_si256(
+		_mm_loadu_si128((const __m128i *)utf_lut_byte_2_high));
+	const __m256i incomplete_max =
+		_mm256_loadu_si256((const __m256i *)utf_incomplete_max);
+	const __m256i nibble = _mm256_set1_epi8(0x0F);
+	const __m256i zero = _mm256_setzero_si256();
+
+	__m256i prev_input = zero, prev_incomplete = zero, error = zero;
+	unsigned char tail[32];
+
+	for (size_t i = 0; i < len8; i += 32) {
+		__m256i input;
+		if (len8 - i >= 32) {
+			input = _mm256_loadu_si256((const __m256i *)(in + i));
+		}
+		else {
+			memset(tail, 0x20, sizeof(tail));
+			memcpy(tail, in + i, len8 - i);
+			input = _mm256_loadu_si256((const __m256i *)tail);
+		}
+
+		if (_mm256_movemask_epi8(input) == 0) {
+			error = _mm256_or_si256(error, prev_incomplete);
+			prev_incomplete = zero;
+		}
+		else {
+			/* The previous bytes across the 128-bit lanes. */
+			const __m256i prev_lanes =
+				_mm256_permute2x128_si256(prev_input, input, 0x21);
+			const __m256i prev1 = _mm256_alignr_epi8(input, prev_lanes, 15);
+			const __m256i prev2 = _mm256_alignr_epi8(input, prev_lanes, 14);
+			const __m256i prev3 = _mm256_alignr_epi8(input, prev_lanes, 13);
+
+			const __m256i special_cases = _mm256_and_si256(
+				_mm256_and_si256(
+					_mm256_shuffle_epi8(
+						lut_1_high,
+						_mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+					_mm256_shuffle_epi8(lut_1_low,
+										_mm256_and_si256(prev1, nibble))),
+				_mm256_shuffle_epi8(
+					lut_2_high,
+					_mm256_and_si256(_mm256_srli_epi16(input, 4), nibble)));
+
+			const __m256i is_third =
+				_mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xE0 - 1)));
+			const __m256i is_fourth =
+				_mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xF0 - 1)));
+			const __m256i must23 = _mm256_and_si256(
+				_mm256_cmpgt_epi8(_mm256_or_si256(is_third, is_fourth), zero),
+				_mm256_set1_epi8((char)0x80));
+
+			error = _mm256_or_si256(error,
+									_mm256_xor_si256(must23, special_cases));
+			prev_incomplete = _mm256_subs_epu8(input, incomplete_max);
+		}
+		prev_input = input;
+	}
+
+	error = _mm256_or_si256(error, prev_incomplete);
+	return _mm256_testz_si256(error, error);
+}
+
+#	ifdef UTF_SIMD_UTF16
+
+static unsigned int utf_ctz(unsigned int x)
+{
+#		if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, x);
+	return (unsigned int)index;
+#		else
+	return (unsigned int)__builtin_ctz(x);
+#		endif
+}
+
+UTF_TARGET("sse2")
+static size_t utf_8_to_16_sse2(const unsigned char *in,
+							   const unsigned char *end,
+							   wchar_t *out16,
+							   int *r_err)
+{
+	const __m128i zero = _mm_setzero_si128();
+	wchar_t *out = out16;
+
+	/* The output never runs ahead of the input, so whole blocks can be stored
+	 * before knowing how much of them is ASCII. */
+	while (in < end) {
+		while (end - in >= 16) {
+			const __m128i v = _mm_loadu_si128((const __m128i *)in);
+			_mm_storeu_si128((__m128i *)out, _mm_unpacklo_epi8(v, zero));
+			_mm_storeu_si128((__m128i *)(out + 8), _mm_unpackhi_epi8(v, zero));
+			const unsigned int mask = (unsigned int)_mm_movemask_epi8(v);
+			if (mask) {
+				const unsigned int n = utf_ctz(mask);
+				in += n;
+				out += n;
+				break;
+			}
+			in += 16;
+			out += 16;
+		}
+		while (in < end && *in < 0x80) {
+			*out++ = *in++;
+		}
+		out = utf_8_to_16_sequences(&in, end, out, r_err);
+	}
+	return (size_t)(out - out16);
+}
+
+UTF_TARGET("avx2")
+static size_t utf_8_to_16_avx2(const unsigned char *in,
+							   const unsigned char *end,
+							   wchar_t *out16,
+							   int *r_err)
+{
+	wchar_t *out = out16;
+
+	while (in < end) {
+		while (end - in >= 32) {
+			const __m256i v = _mm256_loadu_si256((const __m256i *)in);
+			const __m256i lo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(v));
+			const __m256i hi =
+				_mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1));
+			_mm256_storeu_si256((__m256i *)out, lo);
+			_mm256_storeu_si256((__m256i *)(out + 16), hi);
+			const unsigned int mask = (unsigned int)_mm256_movemask_epi8(v);
+			if (mask) {
+				const unsigned int n = utf_ctz(mask);
+				in += n;
+				out += n;
+				break;
+			}
+			in += 32;
+			out += 32;
+		}
+		while (in < end && *in < 0x80) {
+			*out++ = *in++;
+		}
+		out = utf_8_to_16_sequences(&in, end, out, r_err);
+	}
+	return (size_t)(out - out16);
+}
+
+UTF_TARGET("sse2")
+static size_t utf_16_to_8_sse2(const wchar_t *in,
+							   const wchar_t *end,
+							   char *out8,
+							   int *r_err)
+{
+	const __m128i non_ascii = _mm_set1_epi16((short)0xFF80);
+	const __m128i zero = _mm_setzero_si128();
+	char *out = out8;
+
+	while (in < end) {
+		while (end - in >= 16) {
+			const __m128i a = _mm_loadu_si128((const __m128i *)in);
+			const __m128i b = _mm_loadu_si128((const __m128i *)(in + 8));
+			_mm_storeu_si128((__m128i *)out, _mm_packus_epi16(a, b));
+			const unsigned int mask =
+				~(unsigned int)_mm_movemask_epi8(_mm_packs_epi16(
+					_mm_cmpeq_epi16(_mm_and_si128(a, non_ascii), zero),
+					_mm_cmpeq_epi16(_mm_and_si128(b, non_ascii), zero))) &
+				0xFFFF;
+			if (mask) {
+				const unsigned int n = utf_ctz(mask);
+				in += n;
+				out += n;
+				break;
+			}
+			in += 16;
+			out += 16;
+		}
+		while (in < end && (unsigned int)*in < 0x80) {
+			*out++ = (char)*in++;
+		}
+		out = utf_16_to_8_sequences(&in, end, out, r_err);
+	}
+	return (size_t)(out - out8);
+}
+
+UTF_TARGET("avx2")
+static size_t utf_16_to_8_avx2(const wchar_t *in,
+							   const wchar_t *end,
+							   char *out8,
+							   int *r_err)
+{
+	const __m256i non_ascii = _mm256_set1_epi16((short)0xFF80);
+	char *out = out8;
+
+	while (in < end) {
+		while (end - in >= 32) {
+			const __m256i a = _mm256_loadu_si256((const __m256i *)in);
+			const __m256i b = _mm256_loadu_si256((const __m256i *)(in + 16));
+			/* Packing works per lane, restore the order of the quadwords. */
+			const __m256i packed = _mm256_permute4x64_epi64(
+				_mm256_packus_epi16(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+			_mm256_storeu_si256((__m256i *)out, packed);
+			const __m256i is_ascii = _mm256_permute4x64_epi64(
+				_mm256_packs_epi16(
+					_mm256_cmpeq_epi16(_mm256_and_si256(a, non_ascii),
+									   _mm256_setzero_si256()),
+					_mm256_cmpeq_epi16(_mm256_and_si256(b, non_ascii),
+									   _mm256_setzero_si256())),
+				_MM_SHUFFLE(3, 1, 2, 0));
+			const unsigned int mask =
+				~(unsigned int)_mm256_movemask_epi8(is_ascii);
+			if (mask) {
+				const unsigned int n = utf_ctz(mask);
+				in += n;
+				out += n;
+				break;
+			}
+			in += 32;
+			out += 32;
+		}
+		while (in < end && (unsigned int)*in < 0x80) {
+			*out++ = (char)*in++;
+		}
+		out = utf_16_to_8_sequences(&in, end, out, r_err);
+	}
+	return (size_t)(out - out8);
+}
+
+#	endif /* UTF_SIMD_UTF16 */
+
+#endif /* UTF_SIMD_X86 */
+
+typedef struct UTFConvFuncs {
+	int (*validate_8)(const unsigned char *in, size_t len8);
+	size_t (*utf_8_to_16)(const unsigned char *in,
+						  const unsigned char *end,
+						  wchar_t *out16,
+						  int *r_err);
+	size_t (*utf_16_to_8)(const wchar_t *in,
+						  const wchar_t *end,
+						  char *out8,
+						  int *r_err);
+} UTFConvFuncs;
+
+static UTFConvFuncs utf_funcs;
+
+static void utf_funcs_init(void)
+{
+	UTFConvFuncs funcs = {
+		utf_8_validate_scalar, utf_8_to_16_scalar, utf_16_to_8_scalar};
+
+#ifdef UTF_SIMD_X86
+	unsigned int regs1[4] = {0}, regs7[4] = {0};
+	unsigned long long xcr0 = 0;
+
+#	if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	const int max_leaf = info[0];
+	__cpuid(info, 1);
+	memcpy(regs1, info, sizeof(regs1));
+	if (max_leaf >= 7) {
+		__cpuidex(info, 7, 0);
+		memcpy(regs7, info, sizeof(regs7));
+	}
+	if (regs1[2] & (1u << 27)) {
+		xcr0 = _xgetbv(0);
+	}
+#	else
+	const unsigned int max_leaf = __get_cpuid_max(0, NULL);
+	__cpuid(1, regs1[0], regs1[1], regs1[2], regs1[3]);
+	if (max_leaf >= 7) {
+		__cpuid_count(7, 0, regs7[0], regs7[1], regs7[2], regs7[3]);
+	}
+	if (regs1[2] & (1u << 27)) {
+		unsigned int eax, edx;
+		__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		xcr0 = ((unsigned long long)edx << 32) | eax;
+	}
+#	endif
+
+	const int has_sse2 = (regs1[3] & (1u << 26)) != 0;
+	const int has_ssse3 = (regs1[2] & (1u << 9)) != 0;
+	const int has_avx2 = (xcr0 & 0x6) == 0x6 && (regs1[2] & (1u << 28)) &&
+						 (regs7[1] & (1u << 5));
+
+	if (has_avx2) {
+		funcs.validate_8 = utf_8_validate_avx2;
+	}
+	else if (has_ssse3) {
+		funcs.validate_8 = utf_8_validate_ssse3;
+	}
+#	ifdef UTF_SIMD_UTF16
+	if (has_avx2) {
+		funcs.utf_8_to_16 = utf_8_to_16_avx2;
+		funcs.utf_16_to_8 = utf_16_to_8_avx2;
+	}
+	else if (has_sse2) {
+		funcs.utf_8_to_16 = utf_8_to_16_sse2;
+		funcs.utf_16_to_8 = utf_16_to_8_sse2;
+	}
+#	else
+	(void)has_sse2;
+#	endif
+#endif
+
+	/* Racing threads store the same values. */
+	utf_funcs = funcs;
+}
+
+#define UTF_FUNCS_ENSURE() \
+	if (utf_funcs.validate_8 == NULL) { \
+		utf_funcs_init(); \
+	} \
+	((void)0)
+
+int is_valid_utf_8(const char *in8, size_t len8)
+{
+	UTF_FUNCS_ENSURE();
+	return utf_funcs.validate_8((const unsigned char *)in8, len8);
+}
+
+size_t transcode_utf_8_to_16(const char *in8,
+							 size_t len8,
+							 wchar_t *out16,
+							 int *r_err)
+{
+	int err = 0;
+	UTF_FUNCS_ENSURE();
+	const unsigned char *in = (const unsigned char *)in8;
+	const size_t len16 = utf_funcs.utf_8_to_16(in, in + len8, out16, &err);
+	if (r_err) {
+		*r_err = err;
+	}
+	return len16;
+}
+
+size_t transcode_utf_16_to_8(const wchar_t *in16,
+							 size_t len16,
+							 char *out8,
+							 int *r_err)
+{
+	int err = 0;
+	UTF_FUNCS_ENSURE();
+	const size_t len8 = utf_funcs.utf_16_to_8(in16, in16 + len16, out8, &err);
+	if (r_err) {
+		*r_err = err;
+	}
+	return len8;
+}
+
+/** The length of a NULL terminated UTF-16 string. */
+static size_t utf_16_len(const wchar_t *in16)
+{
+	const wchar_t *p = in16;
+	while (*p) {
+		p++;
+	}
+	return (size_t)(p - in16);
+}
+
+/** Give back the unused part of an allocation sized for the worst case, when
+ * it is most of it. */
+static void *utf_shrink(void *buf, size_t size, size_t used)
+{
+	if (used < size / 2) {
+		void *shrunk = realloc(buf, used);
+		if (shrunk) {
+			return shrunk;
+		}
+	}
+	return buf;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Streaming Transcoding
+ *
+ * Chunks are converted in pieces whose worst case output fits the space
+ * left, cut between sequences, so the vector converters (which may store
+ * past what they write, within the worst case) are used as they are.
+ * \{ */
+
+#define UTF_IS_HIGH_SURROGATE(u) \
+	((unsigned int)(u) >= 0xD800 && (unsigned int)(u) < 0xDC00)
+#define UTF_IS_LOW_SURROGATE(u) \
+	((unsigned int)(u) >= 0xDC00 && (unsigned int)(u) < 0xE000)
+
+/** \return The length of the sequence a valid lead byte starts, else 0. */
+static size_t utf_8_sequence_len(const unsigned char c)
+{
+	if (c < 0xC2 || c >= 0xF5) {
+		return 0;
+	}
+	return (c < 0xE0) ? 2 : (c < 0xF0) ? 3 : 4;
+}
+
+/** Whether the \a n bytes at \a p can still be completed to a sequence. */
+static int utf_8_is_valid_prefix(const unsigned char *p, const size_t n)
+{
+	const unsigned char c = p[0];
+	if (n >= 2) {
+		const unsigned char lo = (c == 0xE0) ? 0xA0 : (c == 0xF0) ? 0x90 : 0x80;
+		const unsigned char hi = (c == 0xED) ? 0x9F : (c == 0xF4) ? 0x8F : 0xBF;
+		if (p[1] < lo || p[1] > hi) {
+			return 0;
+		}
+	}
+	for (size_t i = 2; i < n; i++) {
+		if ((p[i] & 0xC0) != 0x80) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/**
+ * \return The length of the sequence start ending \a end, when the sequence
+ * needs more bytes than that, else 0.
+ */
+static size_t utf_8_split_len(const unsigned char *in, const unsigned char *end)
+{
+	for (size_t k = 1; k <= 3 && k <= (size_t)(end - in); k++) {
+		const unsigned char c = end[-(ptrdiff_t)k];
+		if (c < 0x80) {
+			return 0;
+		}
+		if (c >= 0xC0) {
+			return (utf_8_sequence_len(c) > k) ? k : 0;
+		}
+	}
+	return 0;
+}
+
+void utf_stream_init(UTFStream *stream)
+{
+	memset(stream, 0, sizeof(*stream));
+}
+
+size_t utf_stream_feed_8_to_16(UTFStream *stream,
+							   const char *in8,
+							   size_t len8,
+							   wchar_t *out16,
+							   size_t size16,
+							   size_t *r_len16)
+{
+	const unsigned char *in = (const unsigned char *)in8;
+	const unsigned char *in_end = in + len8;
+	wchar_t *out = out16, *out_end = out16 + size16;
+	UTF_FUNCS_ENSURE();
+
+	if (stream->pending8_len) {
+		/* Complete the sequence split by the end of the last chunk. */
+		const size_t n = (size_t)stream->pending8_len;
+		const size_t need = utf_8_sequence_len(stream->pending8[0]);
+		const size_t take = (need - n < len8) ? need - n : len8;
+		unsigned char seq[4];
+		memcpy(seq, stream->pending8, n);
+		memcpy(seq + n, in, take);
+
+		if (n + take < need && utf_8_is_valid_prefix(seq, n + take)) {
+			memcpy(stream->pending8, seq, n + take);
+			stream->pending8_len = (int)(n + take);
+			*r_len16 = 0;
+			return len8;
+		}
+
+		unsigned int u32;
+		if (utf_8_decode(seq, seq + n + take, &u32) == need) {
+			if ((size_t)(out_end - out) < ((u32 < 0x10000) ? 1u : 2u)) {
+				*r_len16 = 0;
+				return 0;
+			}
+			const unsigned char *seq_in = seq;
+			out = utf_8_to_16_sequences(&seq_in, seq + need, out, &stream->err);
+			in += take;
+		}
+		else {
+			/* As in a single buffer the lead byte and the continuation bytes
+			 * after it are skipped, the new bytes are converted as usual. */
+			stream->err |= UTF_ERROR_ILLSEQ | ((n > 1) ? UTF_ERROR_ILLCHAR : 0);
+		}
+		stream->pending8_len = 0;
+	}
+
+	while (in < in_end) {
+		const unsigned char *piece_end;
+		size_t tail = 0;
+		if ((size_t)(in_end - in) <= (size_t)(out_end - out)) {
+			/* Keep a sequence the next chunk may complete. */
+			tail = utf_8_split_len(in, in_end);
+			if (tail && !utf_8_is_valid_prefix(in_end - tail, tail)) {
+				tail = 0;
+			}
+			piece_end = in_end - tail;
+		}
+		else {
+			/* At most one code unit per byte, cut before a split sequence. */
+			piece_end = in + (out_end - out);
+			piece_end -= utf_8_split_len(in, piece_end);
+			if (piece_end == in) {
+				break;
+			}
+		}
+
+		out += utf_funcs.utf_8_to_16(in, piece_end, out, &stream->err);
+		in = piece_end;
+
+		if (tail) {
+			memcpy(stream->pending8, in, tail);
+			stream->pending8_len = (int)tail;
+			in = in_end;
+		}
+	}
+
+	*r_len16 = (size_t)(out - out16);
+	return (size_t)(in - (const unsigned char *)in8);
+}
+
+size_t utf_stream_feed_16_to_8(UTFStream *stream,
+							   const wchar_t *in16,
+							   size_t len16,
+							   char *out8,
+							   size_t size8,
+							   size_t *r_len8)
+{
+	const wchar_t *in = in16, *in_end = in16 + len16;
+	char *out = out8, *out_end = out8 + size8;
+	UTF_FUNCS_ENSURE();
+
+	if (stream->pending16 && in < in_end) {
+		if (UTF_IS_LOW_SURROGATE(*in)) {
+			if (out_end - out < 4) {
+				*r_len8 = 0;
+				return 0;
+			}
+			const wchar_t pair[2] = {stream->pending16, *in};
+			const wchar_t *pair_in = pair;
+			out = utf_16_to_8_sequences(&pair_in, pair + 2, out, &stream->err);
+			in++;
+		}
+		else {
+			stream->err |= UTF_ERROR_ILLCHAR;
+		}
+		stream->pending16 = 0;
+	}
+
+	while (in < in_end) {
+		const size_t room = (size_t)(out_end - out) / UTF_8_LEN_MAX_FROM_16(1);
+		const wchar_t *piece_end;
+		int tail = 0;
+		if ((size_t)(in_end - in) <= room) {
+			piece_end = in_end;
+			if (UTF_IS_HIGH_SURROGATE(piece_end[-1])) {
+				piece_end--;
+				tail = 1;
+			}
+		}
+		else {
+			/* At most #UTF_8_LEN_MAX_FROM_16 bytes per code unit, keep pairs
+			 * together. */
+			piece_end = in + room;
+			if (piece_end > in && UTF_IS_HIGH_SURROGATE(piece_end[-1])) {
+				piece_end--;
+			}
+			if (piece_end == in) {
+				break;
+			}
+		}
+
+		out += utf_funcs.utf_16_to_8(in, piece_end, out, &stream->err);
+		in = piece_end;
+
+		if (tail) {
+			stream->pending16 = *in;
+			in = in_end;
+		}
+	}
+
+	*r_len8 = (size_t)(out - out8);
+	return (size_t)(in - in16);
+}
+
+int utf_stream_finish(UTFStream *stream)
+{
+	int err = stream->err;
+	if (stream->pending8_len) {
+		err |= UTF_ERROR_ILLSEQ |
+			   ((stream->pending8_len > 1) ? UTF_ERROR_ILLCHAR : 0);
+	}
+	if (stream->pending16) {
+		err |= UTF_ERROR_ILLCHAR;
+	}
+	utf_stream_init(stream);
+	return err;
+}
+
+/** \} */
+
 char *alloc_utf_8_from_16(const wchar_t *in16, size_t add)
 {
-	size_t bsize = count_utf_8_from_16(in16);
-	char *out8 = NULL;
-	if (!bsize) {
+	if (!in16) {
 		return NULL;
 	}
-	out8 = (char *)malloc(sizeof(char) * (bsize + add));
-	conv_utf_16_to_8(in16, out8, bsize);
-	return out8;
+	/* One pass into a buffer sized for the worst case. */
+	const size_t len16 = utf_16_len(in16);
+	const size_t bsize = UTF_8_LEN_MAX_FROM_16(len16) + 1;
+	char *out8 = (char *)malloc(sizeof(char) * (bsize + add));
+	const size_t len8 = transcode_utf_16_to_8(in16, len16, out8, NULL);
+	out8[len8] = 0;
+	return (char *)utf_shrink(
+		out8, sizeof(char) * (bsize + add), sizeof(char) * (len8 + 1 + add));
 }
 
 wchar_t *alloc_utf16_from_8(const char *in8, size_t add)
 {
-	size_t bsize = count_utf_16_from_8(in8);
-	wchar_t *out16 = NULL;
-	if (!bsize) {
+	if (!in8) {
 		return NULL;
 	}
-	out16 = (wchar_t *)malloc(sizeof(wchar_t) * (bsize + add));
-	conv_utf_8_to_16(in8, out16, bsize);
-	return out16;
+	const size_t len8 = strlen(in8);
+	const size_t bsize = UTF_16_LEN_MAX_FROM_8(len8) + 1;
+	wchar_t *out16 = (wchar_t *)malloc(sizeof(wchar_t) * (bsize + add));
+	const size_t len16 = transcode_utf_8_to_16(in8, len8, out16, NULL);
+	out16[len16] = 0;
+	return (wchar_t *)utf_shrink(out16,
+								 sizeof(wchar_t) * (bsize + add),
+								 sizeof(wchar_t) * (len16 + 1 + add));
 }
@@ -69,6 +69,105 @@ char *alloc_utf_8_from_16(const wchar_t *in16, size_t add);
  */
 wchar_t *alloc_utf16_from_8(const char *in8, size_t add);
 
+/**
+ * The most code units #transcode_utf_8_to_16 writes for \a len8 bytes.
+ */
+#define UTF_16_LEN_MAX_FROM_8(len8) (len8)
+
+/**
+ * The most bytes #transcode_utf_16_to_8 writes for \a len16 code units,
+ * a 32 bit `wchar_t` unit above U+FFFF takes four.
+ */
+#define UTF_8_LEN_MAX_FROM_16(len16) ((len16) * (sizeof(wchar_t) > 2 ? 4 : 3))
+
+/**
+ * Checks that the \a len8 bytes at \a in8 are well formed utf-8: shortest
+ * form sequences only, no surrogates and nothing above U+10FFFF.
+ * \return 1 when valid, 0 otherwise.
+ */
+int is_valid_utf_8(const char *in8, size_t len8);
+
+/**
+ * Converts \a len8 bytes of utf-8 to utf-16 in one pass, ASCII runs are
+ * converted a vector at a time. Invalid sequences are skipped.
+ * \param out16: Must fit #UTF_16_LEN_MAX_FROM_8 code units, it is not NULL
+ * terminated.
+ * \param r_err: Optionally the errors found, see the block above.
+ * \return The number of code units written.
+ */
+size_t transcode_utf_8_to_16(const char *in8,
+							 size_t len8,
+							 wchar_t *out16,
+							 int *r_err);
+
+/**
+ * Converts \a len16 code units of utf-16 to utf-8 in one pass, ASCII runs
+ * are converted a vector at a time. Unpaired surrogates are skipped.
+ * \param out8: Must fit #UTF_8_LEN_MAX_FROM_16 bytes, it is not NULL
+ * terminated.
+ * \param r_err: Optionally the errors found, see the block above.
+ * \return The number of bytes written.
+ */
+size_t transcode_utf_16_to_8(const wchar_t *in16,
+							 size_t len16,
+							 char *out8,
+							 int *r_err);
+
+/**
+ * The state of a streaming conversion, for input that arrives in chunks (a
+ * file read a block at a time, a pipe) and is converted into a bounded
+ * buffer, so memory use stays constant whatever the size of the input.
+ * A sequence split by the end of a chunk is carried over to the next one,
+ * the output is the same as converting all the input at once.
+ */
+typedef struct UTFStream {
+	/** The start of a utf-8 sequence that ended the last chunk. */
+	unsigned char pending8[4];
+	int pending8_len;
+	/** A high surrogate that ended the last utf-16 chunk, or 0. */
+	wchar_t pending16;
+	/** The errors found so far, see the block above. */
+	int err;
+} UTFStream;
+
+/** Start a streaming conversion, in either direction. */
+void utf_stream_init(UTFStream *stream);
+
+/**
+ * Converts the next chunk of a utf-8 stream to utf-16, as much of it as fits
+ * \a size16 code units of \a out16, which should be at least 4.
+ * \param r_len16: The number of code units written.
+ * \return The number of bytes of \a in8 consumed, when less than \a len8
+ * the output is full and the rest must be fed again.
+ */
+size_t utf_stream_feed_8_to_16(UTFStream *stream,
+							   const char *in8,
+							   size_t len8,
+							   wchar_t *out16,
+							   size_t size16,
+							   size_t *r_len16);
+
+/**
+ * Converts the next chunk of a utf-16 stream to utf-8, as much of it as fits
+ * \a size8 bytes of \a out8, which should be at least 8.
+ * \param r_len8: The number of bytes written.
+ * \return The number of code units of \a in16 consumed, when less than
+ * \a len16 the output is full and the rest must be fed again.
+ */
+size_t utf_stream_feed_16_to_8(UTFStream *stream,
+							   const wchar_t *in16,
+							   size_t len16,
+							   char *out8,
+							   size_t size8,
+							   size_t *r_len8);
+
+/**
+ * Ends a streaming conversion, a sequence left incomplete by the last chunk
+ * is an error. The stream can be used again afterwards.
+ * \return Returns any errors occurred during conversion. See the block above.
+ */
+int utf_stream_finish(UTFStream *stream);
+
 /* Easy allocation and conversion of new utf-16 string. New string has _16
  * suffix. Must be deallocated with UTF16_UN_ENCODE in right order. */
 #define UTF16_ENCODE(in8str) \
@@ -0,0 +1,228 @@
+#include "guardedalloc/mem_guardedalloc.h"
+
+#include "loomlib/loomlib_assert.h"
+#include "loomlib/loomlib_dynstr.h"
+#include "loomlib/loomlib_memarena.h"
+#include "loomlib/loomlib_string.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* -------------------------------------------------------------------- */
+/** \name Structs
+ * \{ */
+
+/** The size of the first chunk, unless a larger one is needed. */
+#define DYNSTR_CHUNK_MIN 256
+
+typedef struct DynStrElem {
+	struct DynStrElem *next;
+	/** Allocated separately, so it can be handed out by #GLU_dynstr_steal. */
+	char *str;
+	size_t len;
+	/** The capacity of #str, one more byte is allocated for the terminator. */
+	size_t size;
+} DynStrElem;
+
+struct DynStr {
+	DynStrElem *elems, *last;
+	size_t curlen;
+	struct MemArena *memarena;
+};
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Internal Utility API
+ * \{ */
+
+static char *dynstr_elem_add(DynStr *ds, const size_t len)
+{
+	/* Grow geometrically, the number of chunks stays logarithmic. */
+	const size_t size = MAX2(len, MAX2(ds->curlen, DYNSTR_CHUNK_MIN));
+	DynStrElem *elem;
+
+	if (ds->memarena) {
+		elem = GLU_memarena_alloc(ds->memarena, sizeof(*elem));
+		elem->str = GLU_memarena_alloc(ds->memarena, size + 1);
+	}
+	else {
+		elem = MEM_mallocN(sizeof(*elem), "DynStrElem");
+		elem->str = MEM_mallocN(size + 1, "DynStrElem::str");
+	}
+	elem->next = NULL;
+	elem->len = 0;
+	elem->size = size;
+
+	if (ds->last) {
+		ds->last->next = elem;
+	}
+	else {
+		ds->elems = elem;
+	}
+	ds->last = elem;
+	return elem->str;
+}
+
+/** \return Where to write \a len more bytes, without committing them. */
+LOOM_INLINE char *dynstr_tail(DynStr *ds, const size_t len)
+{
+	DynStrElem *last = ds->last;
+	if (last && last->size - last->len >= len) {
+		return last->str + last->len;
+	}
+	return dynstr_elem_add(ds, len);
+}
+
+LOOM_INLINE void dynstr_commit(DynStr *ds, const size_t len)
+{
+	ds->last->len += len;
+	ds->curlen += len;
+}
+
+static void dynstr_elems_free(DynStr *ds)
+{
+	if (ds->memarena == NULL) {
+		for (DynStrElem *elem = ds->elems, *elem_next; elem; elem = elem_next) {
+			elem_next = elem->next;
+			if (elem->str) {
+				MEM_freeN(elem->str);
+			}
+			MEM_freeN(elem);
+		}
+	}
+	ds->elems = ds->last = NULL;
+	ds->curlen = 0;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name DynStr API
+ * \{ */
+
+DynStr *GLU_dynstr_new(void)
+{
+	return MEM_callocN(sizeof(DynStr), "DynStr");
+}
+
+DynStr *GLU_dynstr_new_memarena(struct MemArena *ma)
+{
+	DynStr *ds = MEM_callocN(sizeof(DynStr), "DynStr");
+	ds->memarena = ma;
+	return ds;
+}
+
+void GLU_dynstr_reserve(DynStr *__restrict ds, size_t len)
+{
+	dynstr_tail(ds, len);
+}
+
+void GLU_dynstr_append(DynStr *__restrict ds, const char *cstr)
+{
+	const size_t len = GLU_strlen(cstr);
+	memcpy(dynstr_tail(ds, len), cstr, len);
+	dynstr_commit(ds, len);
+}
+
+void GLU_dynstr_nappend(DynStr *__restrict ds, const char *cstr, size_t len)
+{
+	len = GLU_strnlen(cstr, len);
+	memcpy(dynstr_tail(ds, len), cstr, len);
+	dynstr_commit(ds, len);
+}
+
+void GLU_dynstr_vappendf(DynStr *__restrict ds,
+						 const char *ATTR_PRINTF_FORMAT_STRING format,
+						 va_list args)
+{
+	/* Print into the free space of the last chunk, only when it doesn't fit
+	 * print again into a chunk of the size now known. */
+	char *dst = dynstr_tail(ds, 0);
+	const size_t avail = ds->last->size - ds->last->len;
+
+	va_list args_copy;
+	va_copy(args_copy, args);
+	const int len = vsnprintf(dst, avail + 1, format, args_copy);
+	va_end(args_copy);
+
+	if (len < 0) {
+		LOOM_assert_unreachable();
+		return;
+	}
+	if ((size_t)len > avail) {
+		dst = dynstr_tail(ds, (size_t)len);
+		vsnprintf(dst, (size_t)len + 1, format, args);
+	}
+	dynstr_commit(ds, (size_t)len);
+}
+
+void GLU_dynstr_appendf(DynStr *__restrict ds,
+						const char *ATTR_PRINTF_FORMAT_STRING format,
+						...)
+{
+	va_list args;
+	va_start(args, format);
+	GLU_dynstr_vappendf(ds, format, args);
+	va_end(args);
+}
+
+size_t GLU_dynstr_get_len(const DynStr *ds)
+{
+	return ds->curlen;
+}
+
+void GLU_dynstr_get_cstring_ex(const DynStr *__restrict ds,
+							   char *__restrict rets)
+{
+	char *s = rets;
+	for (const DynStrElem *elem = ds->elems; elem; elem = elem->next) {
+		memcpy(s, elem->str, elem->len);
+		s += elem->len;
+	}
+	*s = '\0';
+}
+
+char *GLU_dynstr_get_cstring(const DynStr *ds)
+{
+	char *rets = MEM_mallocN(ds->curlen + 1, "dynstr_cstring");
+	GLU_dynstr_get_cstring_ex(ds, rets);
+	return rets;
+}
+
+char *GLU_dynstr_steal(DynStr *ds, size_t *r_len)
+{
+	char *rets;
+
+	if (ds->elems && ds->elems == ds->last) {
+		rets = ds->elems->str;
+		rets[ds->elems->len] = '\0';
+		ds->elems->str = NULL;
+	}
+	else if (ds->memarena) {
+		rets = GLU_memarena_alloc(ds->memarena, ds->curlen + 1);
+		GLU_dynstr_get_cstring_ex(ds, rets);
+	}
+	else {
+		rets = GLU_dynstr_get_cstring(ds);
+	}
+
+	if (r_len) {
+		*r_len = ds->curlen;
+	}
+	dynstr_elems_free(ds);
+	return rets;
+}
+
+void GLU_dynstr_clear(DynStr *ds)
+{
+	dynstr_elems_free(ds);
+}
+
+void GLU_dynstr_free(DynStr *ds)
+{
+	dynstr_elems_free(ds);
+	MEM_freeN(ds);
+}
+
+/** \} */
@@ -0,0 +1,639 @@
+#include "guardedalloc/mem_guardedalloc.h"
+
+#include "loomlib/loomlib_assert.h"
+#include "loomlib/loomlib_string.h"
+#include "loomlib/loomlib_utildefines.h"
+
+#define GHASH_INTERNAL_API
+#include "loomlib/loomlib_filter.h"
+#include "loomlib/loomlib_ghash.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+/* -------------------------------------------------------------------- */
+/** \name Platform
+ *
+ * The AVX2 block kernels follow #GLU_str_simd_level_get, so they are picked
+ * at runtime from CPUID and the build only needs to target the baseline.
+ * \{ */
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+	defined(_M_IX86)
+#	define BLOOM_SIMD_X86
+#	include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#	define BLOOM_TARGET(_isa) __attribute__((target(_isa)))
+#else
+#	define BLOOM_TARGET(_isa)
+#endif
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Structs & Constants
+ * \{ */
+
+#define BLOOM_BLOCK_WORDS 8
+#define BLOOM_BLOCK_SIZE (BLOOM_BLOCK_WORDS * sizeof(uint64_t))
+
+typedef struct BloomBlock {
+	uint64_t words[BLOOM_BLOCK_WORDS];
+} BloomBlock;
+
+struct GBloom {
+	GHashHashFP hashfp;
+	/** Aligned to #BLOOM_BLOCK_SIZE, so a block is one cache line. */
+	BloomBlock *blocks;
+	uint32_t nblocks;
+};
+
+/** Odd constants, the bit of a key in word `i` is the top 6 bits of
+ * `key * bloom_salt[i]`. */
+static const uint32_t bloom_salt[BLOOM_BLOCK_WORDS] = {
+	0x47B6137Bu,
+	0x44974D91u,
+	0x8824AD5Bu,
+	0xA2B7289Du,
+	0x705495C7u,
+	0x2DF1424Bu,
+	0x9EFC4947u,
+	0x5C6BFB31u,
+};
+
+#define CUCKOO_BUCKET_SLOTS 4
+/** Relocations tried before an insertion gives up. */
+#define CUCKOO_MAX_KICKS 500
+/** The fill of the slots the filter is sized for. */
+#define CUCKOO_LOAD_FACTOR 0.95
+#define CUCKOO_LANES_LO 0x0001000100010001ull
+#define CUCKOO_LANES_HI 0x8000800080008000ull
+
+struct GCuckoo {
+	GHashHashFP hashfp;
+	/** Four 16 bit fingerprints per bucket, zero is an empty slot. */
+	uint64_t *buckets;
+	uint32_t bucket_mask;
+	unsigned int nentries;
+	/** State of the generator picking the slot to relocate. */
+	uint32_t seed;
+
+	/** The key that was left over when an insertion ran out of kicks, the
+	 * filter is full while it is set. */
+	bool has_victim;
+	uint16_t victim_fp;
+	uint32_t victim_index;
+};
+
+#define GSET_BLOOM_FPP_DEFAULT 0.01
+#define GSET_BLOOM_CAPACITY_MIN 64
+
+struct GSetBloom {
+	GSet *gset;
+	GBloom *bloom;
+	GSetHashFP hashfp;
+	double fpp;
+	/** The number of keys #bloom is sized for. */
+	unsigned int capacity;
+	/** Keys removed since #bloom was built, their bits are still set. */
+	unsigned int nremoved;
+};
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Internal Utility API
+ * \{ */
+
+/** Spread the bits of a hash, the #GHashHashFP functions are only made for
+ * picking a bucket. The high half picks the block or bucket, the low half
+ * the bits or fingerprint. */
+LOOM_INLINE uint64_t filter_hash_mix(const unsigned int hash)
+{
+	return (uint64_t)hash * 0x9E3779B97F4A7C15ull;
+}
+
+/** \return The false positive probability of a Bloom filter block holding
+ * \a keys_per_block keys on average. */
+static double bloom_block_fpp(const double keys_per_block)
+{
+	/* The keys in a block are Poisson distributed, with `j` keys a bit of a
+	 * word is set with probability `1 - (63/64)^j` and a lookup tests one bit
+	 * in each of the words. */
+	const double lambda = keys_per_block;
+	const int jmax = (int)(lambda + 12.0 * sqrt(lambda) + 24.0);
+	double term = exp(-lambda);
+	double fpp = 0.0;
+	for (int j = 0; j <= jmax; j++) {
+		if (j) {
+			term *= lambda / j;
+		}
+		fpp += term * pow(1.0 - pow(63.0 / 64.0, j), BLOOM_BLOCK_WORDS);
+	}
+	return fpp;
+}
+
+LOOM_INLINE const BloomBlock *bloom_block(const GBloom *bloom,
+										  const uint64_t h)
+{
+	/* Scale the high half to the number of blocks, no division. */
+	return bloom->blocks + (((h >> 32) * bloom->nblocks) >> 32);
+}
+
+LOOM_INLINE uint32_t cuckoo_rand(GCuckoo *cuckoo)
+{
+	uint32_t x = cuckoo->seed;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return cuckoo->seed = x;
+}
+
+LOOM_INLINE uint32_t cuckoo_alt_index(const GCuckoo *cuckoo,
+									  const uint32_t index,
+									  const uint16_t fp)
+{
+	/* Its own inverse, either bucket finds the other from the fingerprint. */
+	return (index ^ (fp * 0x5BD1E995u)) & cuckoo->bucket_mask;
+}
+
+LOOM_INLINE void cuckoo_hash(const GCuckoo *cuckoo,
+							 const unsigned int hash,
+							 uint32_t *r_index,
+							 uint16_t *r_fp)
+{
+	const uint64_t h = filter_hash_mix(hash);
+	const uint16_t fp = (uint16_t)(h >> 16);
+	*r_index = (uint32_t)(h >> 32) & cuckoo->bucket_mask;
+	*r_fp = fp ? fp : 1;
+}
+
+/** \return Whether a fingerprint of \a bucket is \a fp, all four slots
+ * compared at once. */
+LOOM_INLINE bool cuckoo_bucket_has(const uint64_t bucket, const uint16_t fp)
+{
+	const uint64_t x = bucket ^ (fp * CUCKOO_LANES_LO);
+	return ((x - CUCKOO_LANES_LO) & ~x & CUCKOO_LANES_HI) != 0;
+}
+
+LOOM_INLINE uint16_t cuckoo_slot_get(const uint64_t bucket, const int slot)
+{
+	return (uint16_t)(bucket >> (slot * 16));
+}
+
+LOOM_INLINE void cuckoo_slot_set(uint64_t *bucket,
+								 const int slot,
+								 const uint16_t fp)
+{
+	*bucket = (*bucket & ~((uint64_t)0xFFFF << (slot * 16))) |
+			  ((uint64_t)fp << (slot * 16));
+}
+
+/** \return The slot of \a fp in \a bucket or -1. */
+static int cuckoo_slot_find(const uint64_t bucket, const uint16_t fp)
+{
+	for (int slot = 0; slot < CUCKOO_BUCKET_SLOTS; slot++) {
+		if (cuckoo_slot_get(bucket, slot) == fp) {
+			return slot;
+		}
+	}
+	return -1;
+}
+
+static bool cuckoo_bucket_insert(GCuckoo *cuckoo,
+								 const uint32_t index,
+								 const uint16_t fp)
+{
+	const int slot = cuckoo_slot_find(cuckoo->buckets[index], 0);
+	if (slot == -1) {
+		return false;
+	}
+	cuckoo_slot_set(&cuckoo->buckets[index], slot, fp);
+	return true;
+}
+
+/** Store \a fp in bucket \a index or its alternative, relocating others as
+ * needed, what is left over after #CUCKOO_MAX_KICKS becomes the victim. */
+static void cuckoo_insert(GCuckoo *cuckoo, uint32_t index, uint16_t fp)
+{
+	LOOM_assert(!cuckoo->has_victim);
+
+	if (cuckoo_bucket_insert(cuckoo, index, fp)) {
+		return;
+	}
+	index = cuckoo_alt_index(cuckoo, index, fp);
+	if (cuckoo_bucket_insert(cuckoo, index, fp)) {
+		return;
+	}
+	for (int kick = 0; kick < CUCKOO_MAX_KICKS; kick++) {
+		const int slot = (int)(cuckoo_rand(cuckoo) % CUCKOO_BUCKET_SLOTS);
+		const uint16_t evicted = cuckoo_slot_get(cuckoo->buckets[index], slot);
+		cuckoo_slot_set(&cuckoo->buckets[index], slot, fp);
+		fp = evicted;
+		index = cuckoo_alt_index(cuckoo, index, fp);
+		if (cuckoo_bucket_insert(cuckoo, index, fp)) {
+			return;
+		}
+	}
+	cuckoo->has_victim = true;
+	cuckoo->victim_fp = fp;
+	cuckoo->victim_index = index;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Bloom Block Kernels
+ *
+ * Set or test the bit of \a key in each word of a block.
+ * \{ */
+
+static void bloom_block_add_scalar(BloomBlock *block, const uint32_t key)
+{
+	for (int i = 0; i < BLOOM_BLOCK_WORDS; i++) {
+		block->words[i] |= (uint64_t)1 << ((key * bloom_salt[i]) >> 26);
+	}
+}
+
+static bool bloom_block_test_scalar(const BloomBlock *block,
+									const uint32_t key)
+{
+	uint64_t missing = 0;
+	for (int i = 0; i < BLOOM_BLOCK_WORDS; i++) {
+		missing |= ~block->words[i] &
+				   ((uint64_t)1 << ((key * bloom_salt[i]) >> 26));
+	}
+	return missing == 0;
+}
+
+#ifdef BLOOM_SIMD_X86
+
+/** The bit of \a key in each word, for the lower and upper four words. */
+BLOOM_TARGET("avx2")
+static void bloom_block_masks_avx2(const uint32_t key,
+								   __m256i *r_mask_lo,
+								   __m256i *r_mask_hi)
+{
+	const __m256i salt = _mm256_loadu_si256((const __m256i *)bloom_salt);
+	const __m256i bits = _mm256_srli_epi32(
+		_mm256_mullo_epi32(_mm256_set1_epi32((int)key), salt), 26);
+	const __m256i one = _mm256_set1_epi64x(1);
+	*r_mask_lo = _mm256_sllv_epi64(
+		one, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(bits)));
+	*r_mask_hi = _mm256_sllv_epi64(
+		one, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(bits, 1)));
+}
+
+BLOOM_TARGET("avx2")
+static void bloom_block_add_avx2(BloomBlock *block, const uint32_t key)
+{
+	__m256i mask_lo, mask_hi;
+	bloom_block_masks_avx2(key, &mask_lo, &mask_hi);
+	__m256i *words = (__m256i *)block->words;
+	_mm256_store_si256(words, _mm256_or_si256(_mm256_load_si256(words), mask_lo));
+	_mm256_store_si256(words + 1,
+					   _mm256_or_si256(_mm256_load_si256(words + 1), mask_hi));
+}
+
+BLOOM_TARGET("avx2")
+static bool bloom_block_test_avx2(const BloomBlock *block, const uint32_t key)
+{
+	__m256i mask_lo, mask_hi;
+	bloom_block_masks_avx2(key, &mask_lo, &mask_hi);
+	const __m256i *words = (const __m256i *)block->words;
+	/* Set when all the bits of the mask are set in the block. */
+	return _mm256_testc_si256(_mm256_load_si256(words), mask_lo) &
+		   _mm256_testc_si256(_mm256_load_si256(words + 1), mask_hi);
+}
+
+#endif /* BLOOM_SIMD_X86 */
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Bloom Filter API
+ * \{ */
+
+GBloom *GLU_bloom_new(GHashHashFP hashfp,
+					  unsigned int nentries_reserve,
+					  double fpp)
+{
+	GBloom *bloom = MEM_mallocN(sizeof(*bloom), "GBloom");
+	bloom->hashfp = hashfp;
+
+	/* The fill that gives the wanted rate, found by bisection as the rate
+	 * rises with the fill. Past the clamped range the bits per key are
+	 * beyond any use (64) or too few to filter much (about 1). */
+	fpp = MIN2(MAX2(fpp, 1e-6), 0.5);
+	double lo = 8.0, hi = 400.0;
+	for (int iter = 0; iter < 40; iter++) {
+		const double mid = (lo + hi) / 2.0;
+		if (bloom_block_fpp(mid) <= fpp) {
+			lo = mid;
+		}
+		else {
+			hi = mid;
+		}
+	}
+	const double nblocks = ceil(MAX2(nentries_reserve, 1u) / lo);
+	bloom->nblocks = (uint32_t)MIN2(nblocks, (double)(1u << 26));
+
+	const size_t size = (size_t)bloom->nblocks * BLOOM_BLOCK_SIZE;
+	bloom->blocks = MEM_mallocN_aligned(size, BLOOM_BLOCK_SIZE, "GBloom::blocks");
+	memset(bloom->blocks, 0, size);
+	return bloom;
+}
+
+void GLU_bloom_free(GBloom *bloom)
+{
+	MEM_freeN(bloom->blocks);
+	MEM_freeN(bloom);
+}
+
+void GLU_bloom_clear(GBloom *bloom)
+{
+	memset(bloom->blocks, 0, (size_t)bloom->nblocks * BLOOM_BLOCK_SIZE);
+}
+
+void GLU_bloom_add_hash(GBloom *bloom, unsigned int hash)
+{
+	const uint64_t h = filter_hash_mix(hash);
+	BloomBlock *block = (BloomBlock *)bloom_block(bloom, h);
+#ifdef BLOOM_SIMD_X86
+	if (GLU_str_simd_level_get() >= STR_SIMD_AVX2) {
+		bloom_block_add_avx2(block, (uint32_t)h);
+		return;
+	}
+#endif
+	bloom_block_add_scalar(block, (uint32_t)h);
+}
+
+bool GLU_bloom_may_contain_hash(const GBloom *bloom, unsigned int hash)
+{
+	const uint64_t h = filter_hash_mix(hash);
+	const BloomBlock *block = bloom_block(bloom, h);
+#ifdef BLOOM_SIMD_X86
+	if (GLU_str_simd_level_get() >= STR_SIMD_AVX2) {
+		return bloom_block_test_avx2(block, (uint32_t)h);
+	}
+#endif
+	return bloom_block_test_scalar(block, (uint32_t)h);
+}
+
+void GLU_bloom_add(GBloom *bloom, const void *key)
+{
+	GLU_bloom_add_hash(bloom, bloom->hashfp(key));
+}
+
+bool GLU_bloom_may_contain(const GBloom *bloom, const void *key)
+{
+	return GLU_bloom_may_contain_hash(bloom, bloom->hashfp(key));
+}
+
+double GLU_bloom_calc_fpp(const GBloom *bloom, unsigned int nentries)
+{
+	return bloom_block_fpp((double)nentries / bloom->nblocks);
+}
+
+size_t GLU_bloom_size(const GBloom *bloom)
+{
+	return (size_t)bloom->nblocks * BLOOM_BLOCK_SIZE;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Cuckoo Filter API
+ * \{ */
+
+GCuckoo *GLU_cuckoo_new(GHashHashFP hashfp, unsigned int nentries_reserve)
+{
+	GCuckoo *cuckoo = MEM_callocN(sizeof(*cuckoo), "GCuckoo");
+	cuckoo->hashfp = hashfp;
+	cuckoo->seed = 0x2545F491u;
+
+	/* Buckets are picked with a mask, the alternative bucket is only an
+	 * involution for a power of two. */
+	const double nbuckets = ceil(MAX2(nentries_reserve, 1u) /
+								 (CUCKOO_BUCKET_SLOTS * CUCKOO_LOAD_FACTOR));
+	uint32_t size = 1;
+	while (size < nbuckets && size < (1u << 30)) {
+		size <<= 1;
+	}
+	cuckoo->bucket_mask = size - 1;
+	cuckoo->buckets = MEM_callocN(sizeof(*cuckoo->buckets) * size,
+								  "GCuckoo::buckets");
+	return cuckoo;
+}
+
+void GLU_cuckoo_free(GCuckoo *cuckoo)
+{
+	MEM_freeN(cuckoo->buckets);
+	MEM_freeN(cuckoo);
+}
+
+void GLU_cuckoo_clear(GCuckoo *cuckoo)
+{
+	memset(cuckoo->buckets,
+		   0,
+		   sizeof(*cuckoo->buckets) * ((size_t)cuckoo->bucket_mask + 1));
+	cuckoo->nentries = 0;
+	cuckoo->has_victim = false;
+}
+
+bool GLU_cuckoo_add_hash(GCuckoo *cuckoo, unsigned int hash)
+{
+	if (cuckoo->has_victim) {
+		return false;
+	}
+	uint32_t index;
+	uint16_t fp;
+	cuckoo_hash(cuckoo, hash, &index, &fp);
+	cuckoo_insert(cuckoo, index, fp);
+	cuckoo->nentries++;
+	return true;
+}
+
+bool GLU_cuckoo_may_contain_hash(const GCuckoo *cuckoo, unsigned int hash)
+{
+	uint32_t index;
+	uint16_t fp;
+	cuckoo_hash(cuckoo, hash, &index, &fp);
+	const uint32_t alt = cuckoo_alt_index(cuckoo, index, fp);
+
+	if (cuckoo->has_victim && cuckoo->victim_fp == fp &&
+		(cuckoo->victim_index == index || cuckoo->victim_index == alt))
+	{
+		return true;
+	}
+	return cuckoo_bucket_has(cuckoo->buckets[index], fp) ||
+		   cuckoo_bucket_has(cuckoo->buckets[alt], fp);
+}
+
+bool GLU_cuckoo_remove_hash(GCuckoo *cuckoo, unsigned int hash)
+{
+	uint32_t index;
+	uint16_t fp;
+	cuckoo_hash(cuckoo, hash, &index, &fp);
+	const uint32_t alt = cuckoo_alt_index(cuckoo, index, fp);
+
+	if (cuckoo->has_victim && cuckoo->victim_fp == fp &&
+		(cuckoo->victim_index == index || cuckoo->victim_index == alt))
+	{
+		cuckoo->has_victim = false;
+		cuckoo->nentries--;
+		return true;
+	}
+
+	const uint32_t indices[2] = {index, alt};
+	for (int i = 0; i < 2; i++) {
+		const int slot = cuckoo_slot_find(cuckoo->buckets[indices[i]], fp);
+		if (slot == -1) {
+			continue;
+		}
+		cuckoo_slot_set(&cuckoo->buckets[indices[i]], slot, 0);
+		cuckoo->nentries--;
+		if (cuckoo->has_victim) {
+			/* There is room again. */
+			cuckoo->has_victim = false;
+			cuckoo_insert(cuckoo, cuckoo->victim_index, cuckoo->victim_fp);
+		}
+		return true;
+	}
+	return false;
+}
+
+bool GLU_cuckoo_add(GCuckoo *cuckoo, const void *key)
+{
+	return GLU_cuckoo_add_hash(cuckoo, cuckoo->hashfp(key));
+}
+
+bool GLU_cuckoo_may_contain(const GCuckoo *cuckoo, const void *key)
+{
+	return GLU_cuckoo_may_contain_hash(cuckoo, cuckoo->hashfp(key));
+}
+
+bool GLU_cuckoo_remove(GCuckoo *cuckoo, const void *key)
+{
+	return GLU_cuckoo_remove_hash(cuckoo, cuckoo->hashfp(key));
+}
+
+unsigned int GLU_cuckoo_len(const GCuckoo *cuckoo)
+{
+	return cuckoo->nentries;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Filtered GSet API
+ * \{ */
+
+static void gset_bloom_rebuild(GSetBloom *gsb, const unsigned int capacity)
+{
+	if (gsb->bloom) {
+		GLU_bloom_free(gsb->bloom);
+	}
+	gsb->capacity = MAX2(capacity, GSET_BLOOM_CAPACITY_MIN);
+	gsb->bloom = GLU_bloom_new(gsb->hashfp, gsb->capacity, gsb->fpp);
+	gsb->nremoved = 0;
+
+	GSET_FOREACH_BEGIN (const void *, key, gsb->gset) {
+		GLU_bloom_add(gsb->bloom, key);
+	}
+	GSET_FOREACH_END();
+}
+
+GSetBloom *GLU_gset_bloom_new_ex(GSetHashFP hashfp,
+								 GSetCmpFP cmpfp,
+								 const char *info,
+								 unsigned int nentries_reserve,
+								 double fpp)
+{
+	GSetBloom *gsb = MEM_callocN(sizeof(*gsb), info);
+	gsb->gset = GLU_gset_new_ex(hashfp, cmpfp, info, nentries_reserve);
+	gsb->hashfp = hashfp;
+	gsb->fpp = fpp;
+	gset_bloom_rebuild(gsb, nentries_reserve);
+	return gsb;
+}
+
+GSetBloom *GLU_gset_bloom_new(GSetHashFP hashfp,
+							  GSetCmpFP cmpfp,
+							  const char *info)
+{
+	return GLU_gset_bloom_new_ex(hashfp, cmpfp, info, 0, GSET_BLOOM_FPP_DEFAULT);
+}
+
+void GLU_gset_bloom_free(GSetBloom *gsb, GSetKeyFreeFP keyfreefp)
+{
+	GLU_gset_free(gsb->gset, keyfreefp);
+	GLU_bloom_free(gsb->bloom);
+	MEM_freeN(gsb);
+}
+
+bool GLU_gset_bloom_add(GSetBloom *gsb, void *key)
+{
+	/* Hashed once for the filter and the set. */
+	const unsigned int hash = gsb->hashfp(key);
+	if (!GLU_gset_internal_add_hash(gsb->gset, key, hash)) {
+		return false;
+	}
+	if (GLU_gset_len(gsb->gset) > gsb->capacity) {
+		/* Grown past the size of the filter, the rate would rise. */
+		gset_bloom_rebuild(gsb, gsb->capacity * 2);
+	}
+	else {
+		GLU_bloom_add_hash(gsb->bloom, hash);
+	}
+	return true;
+}
+
+bool GLU_gset_bloom_haskey(const GSetBloom *gsb, const void *key)
+{
+	const unsigned int hash = gsb->hashfp(key);
+	return GLU_bloom_may_contain_hash(gsb->bloom, hash) &&
+		   GLU_gset_internal_haskey_hash(gsb->gset, key, hash);
+}
+
+void *GLU_gset_bloom_lookup(const GSetBloom *gsb, const void *key)
+{
+	const unsigned int hash = gsb->hashfp(key);
+	if (!GLU_bloom_may_contain_hash(gsb->bloom, hash)) {
+		return NULL;
+	}
+	return GLU_gset_internal_lookup_hash(gsb->gset, key, hash);
+}
+
+bool GLU_gset_bloom_remove(GSetBloom *gsb,
+						   const void *key,
+						   GSetKeyFreeFP keyfreefp)
+{
+	const unsigned int hash = gsb->hashfp(key);
+	if (!GLU_bloom_may_contain_hash(gsb->bloom, hash) ||
+		!GLU_gset_internal_remove_hash(gsb->gset, key, hash, keyfreefp))
+	{
+		return false;
+	}
+	if (++gsb->nremoved > gsb->capacity / 2) {
+		/* Clear the bits of the removed keys, shrinking the filter along
+		 * with the set. */
+		gset_bloom_rebuild(gsb, GLU_gset_len(gsb->gset) * 2);
+	}
+	return true;
+}
+
+unsigned int GLU_gset_bloom_len(const GSetBloom *gsb)
+{
+	return GLU_gset_len(gsb->gset);
+}
+
+const GSet *GLU_gset_bloom_gset(const GSetBloom *gsb)
+{
+	return gsb->gset;
+}
+
+/** \} */
@@ -17,6 +17,12 @@
 
 #define GHASH_USE_MODULO_BUCKETS
 
+/**
+ * Count lookups and #GHash.cmpfp calls, reported by
+ * #GLU_ghash_calc_quality_ex. Costs a (non-atomic) increment per compare.
+ */
+// #define GHASH_DEBUG_STATS
+
 // Next prime after `2^n` (skipping 2 & 3)
 extern const unsigned int GLU_ghash_hash_sizes[];
 const unsigned int GLU_ghash_hash_sizes[] = {
@@ -83,8 +89,20 @@ struct GHash {
 
 	unsigned int nentries;
 	unsigned int flag;
+
+#ifdef GHASH_DEBUG_STATS
+	unsigned long long stat_lookups, stat_cmps;
+#endif
 };
 
+#ifdef GHASH_DEBUG_STATS
+#	define GHASH_STAT_LOOKUP(gh) (((GHash *)(gh))->stat_lookups++)
+#	define GHASH_STAT_CMP(gh) (((GHash *)(gh))->stat_cmps++)
+#else
+#	define GHASH_STAT_LOOKUP(gh) ((void)0)
+#	define GHASH_STAT_CMP(gh) ((void)0)
+#endif
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -352,7 +370,9 @@ LOOM_INLINE Entry *ghash_lookup_entry_ex(const GHash *gh,
 {
 	Entry *e;
 
+	GHASH_STAT_LOOKUP(gh);
 	for (e = gh->buckets[bucket_index]; e; e = e->next) {
+		GHASH_STAT_CMP(gh);
 		if (gh->cmpfp(key, e->key) == false) {
 			return e;
 		}
@@ -361,6 +381,26 @@ LOOM_INLINE Entry *ghash_lookup_entry_ex(const GHash *gh,
 	return NULL;
 }
 
+/** Lookup with a precomputed \a hash and a compare function of the caller. */
+static Entry *ghash_lookup_entry_hash(const GHash *gh,
+									  const unsigned int hash,
+									  GHashLookupCmpFP cmpfp,
+									  const void *user_data)
+{
+	const unsigned int bucket_index = ghash_bucket_index(gh, hash);
+	Entry *e;
+
+	GHASH_STAT_LOOKUP(gh);
+	for (e = gh->buckets[bucket_index]; e; e = e->next) {
+		GHASH_STAT_CMP(gh);
+		if (cmpfp(user_data, e->key) == false) {
+			return e;
+		}
+	}
+
+	return NULL;
+}
+
 LOOM_INLINE Entry *ghash_lookup_entry_prev_ex(const GHash *gh,
 											  const void *key,
 											  Entry **r_e_prev,
@@ -368,8 +408,10 @@ LOOM_INLINE Entry *ghash_lookup_entry_prev_ex(const GHash *gh,
 {
 	Entry *e_prev, *e;
 
+	GHASH_STAT_LOOKUP(gh);
 	for (e_prev = NULL, e = gh->buckets[bucket_index]; e;
 		 e_prev = e, e = e->next) {
+		GHASH_STAT_CMP(gh);
 		if (gh->cmpfp(key, e->key) == false) {
 			*r_e_prev = e_prev;
 			return e;
@@ -387,6 +429,46 @@ LOOM_INLINE Entry *ghash_lookup_entry(const GHash *gh, const void *key)
 	return ghash_lookup_entry_ex(gh, key, bucket_index);
 }
 
+/** Number of keys hashed and prefetched ahead by batched lookups. */
+#define GHASH_LOOKUP_BATCH 32
+
+/**
+ * Lookup up to #GHASH_LOOKUP_BATCH keys, each pass only issues the loads of
+ * the next pass as prefetches so they are in flight together.
+ */
+static void ghash_lookup_entry_batch(const GHash *gh,
+									 const void *const *keys,
+									 const unsigned int n,
+									 Entry **r_entries)
+{
+	unsigned int bucket_index[GHASH_LOOKUP_BATCH];
+	unsigned int i;
+
+	LOOM_assert(n <= GHASH_LOOKUP_BATCH);
+
+	for (i = 0; i < n; i++) {
+		bucket_index[i] = ghash_bucket_index(gh, ghash_keyhash(gh, keys[i]));
+		LOOM_PREFETCH(&gh->buckets[bucket_index[i]]);
+	}
+	for (i = 0; i < n; i++) {
+		r_entries[i] = gh->buckets[bucket_index[i]];
+		if (r_entries[i]) {
+			LOOM_PREFETCH(r_entries[i]);
+		}
+	}
+	for (i = 0; i < n; i++) {
+		Entry *e;
+		GHASH_STAT_LOOKUP(gh);
+		for (e = r_entries[i]; e; e = e->next) {
+			GHASH_STAT_CMP(gh);
+			if (gh->cmpfp(keys[i], e->key) == false) {
+				break;
+			}
+		}
+		r_entries[i] = e;
+	}
+}
+
 static GHash *ghash_new(GHashHashFP hashfp,
 						GHashCmpFP cmpfp,
 						const char *info,
@@ -400,6 +482,10 @@ static GHash *ghash_new(GHashHashFP hashfp,
 
 	gh->buckets = NULL;
 	gh->flag = flag;
+#ifdef GHASH_DEBUG_STATS
+	gh->stat_lookups = 0;
+	gh->stat_cmps = 0;
+#endif
 
 	ghash_buckets_reset(gh, nentries_reserve);
 	gh->entrypool = GLU_mempool_create(
@@ -450,7 +536,7 @@ LOOM_INLINE void ghash_insert_ex_keyonly(GHash *gh,
 
 	LOOM_assert((gh->flag & GHASH_FLAG_ALLOW_DUPS) ||
 				(GLU_ghash_haskey(gh, key) == 0));
-	LOOM_assert(!(gh->flag & GHASH_FLAG_IS_GSET));
+	LOOM_assert((gh->flag & GHASH_FLAG_IS_GSET) != 0);
 
 	e->next = gh->buckets[bucket_index];
 	e->key = key;
@@ -679,6 +765,12 @@ unsigned int GLU_ghash_len(const GHash *gh)
 	return gh->nentries;
 }
 
+size_t GLU_ghash_calc_memory(const GHash *gh)
+{
+	return sizeof(*gh) + sizeof(*gh->buckets) * gh->nbuckets +
+		   GLU_mempool_calc_memory(gh->entrypool);
+}
+
 void GLU_ghash_insert(GHash *gh, void *key, void *val)
 {
 	ghash_insert(gh, key, val);
@@ -729,6 +821,36 @@ void **GLU_ghash_lookup_p(GHash *gh, const void *key)
 	return e ? &e->val : NULL;
 }
 
+void *GLU_ghash_lookup_ex(const GHash *gh,
+						  const unsigned int hash,
+						  GHashLookupCmpFP cmpfp,
+						  const void *user_data)
+{
+	GHashEntry *e = (GHashEntry *)ghash_lookup_entry_hash(
+		gh, hash, cmpfp, user_data);
+	LOOM_assert(!(gh->flag & GHASH_FLAG_IS_GSET));
+	return e ? e->val : NULL;
+}
+
+void GLU_ghash_lookup_batch(const GHash *gh,
+							const void *const *keys,
+							const unsigned int n,
+							void **r_vals)
+{
+	Entry *entries[GHASH_LOOKUP_BATCH];
+
+	LOOM_assert(!(gh->flag & GHASH_FLAG_IS_GSET));
+
+	for (unsigned int start = 0; start < n; start += GHASH_LOOKUP_BATCH) {
+		const unsigned int len = MIN2(n - start, (unsigned int)GHASH_LOOKUP_BATCH);
+		ghash_lookup_entry_batch(gh, keys + start, len, entries);
+		for (unsigned int i = 0; i < len; i++) {
+			r_vals[start + i] = entries[i] ? ((GHashEntry *)entries[i])->val :
+											 NULL;
+		}
+	}
+}
+
 bool GLU_ghash_ensure_p(GHash *gh, void *key, void ***r_val)
 {
 	const unsigned int hash = ghash_keyhash(gh, key);
@@ -919,6 +1041,368 @@ void GLU_ghash_iterator_free(GHashIterator *ghi)
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Frozen GHash
+ *
+ * The slots are placed with a minimal perfect hash built by "hash and
+ * displace": keys are split into small buckets, every bucket then searches a
+ * pilot value that moves all of its keys to free slots. Larger buckets are
+ * placed first while most slots are still free.
+ *
+ * Keys sharing the exact same hash value can't be separated by any pilot,
+ * only the first one is placed, the others go to a (typically empty)
+ * overflow array that is only searched on a full hash match.
+ * \{ */
+
+/** Average number of keys per displacement bucket. */
+#define GHASH_FROZEN_BUCKET_LOAD 3
+#define GHASH_FROZEN_PILOT_MAX (1u << 24)
+#define GHASH_FROZEN_SEED_TRIES 8
+/** Seeds tried in all before #GLU_ghash_freeze gives up, the buckets have
+ * been doubled a few times by then. */
+#define GHASH_FROZEN_SEED_TRIES_MAX (GHASH_FROZEN_SEED_TRIES * 6)
+
+typedef struct GHashFrozenEntry {
+	void *key;
+	void *val;
+	unsigned int hash;
+} GHashFrozenEntry;
+
+struct GHashFrozen {
+	GHashHashFP hashfp;
+	GHashCmpFP cmpfp;
+
+	/** One slot per key, indexed by the perfect hash. */
+	GHashFrozenEntry *entries;
+	unsigned int nentries;
+
+	unsigned int *pilots;
+	unsigned int nbuckets;
+	unsigned int seed;
+
+	GHashFrozenEntry *overflow;
+	unsigned int noverflow;
+};
+
+LOOM_INLINE unsigned int ghash_frozen_bucket_index(const unsigned int hash,
+												   const unsigned int seed,
+												   const unsigned int nbuckets)
+{
+	unsigned int h = (hash ^ seed) * 0x9e3779b1u;
+	h ^= h >> 15;
+	return (unsigned int)(((uint64_t)h * nbuckets) >> 32);
+}
+
+LOOM_INLINE unsigned int ghash_frozen_slot_index(const unsigned int hash,
+												 const unsigned int seed,
+												 const unsigned int pilot,
+												 const unsigned int nentries)
+{
+	uint64_t x = ((uint64_t)(hash ^ seed) << 32) | pilot;
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdull;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ull;
+	x ^= x >> 33;
+	return (unsigned int)(((x >> 32) * nentries) >> 32);
+}
+
+static int ghash_frozen_entry_hash_cmp(const void *a, const void *b)
+{
+	const unsigned int ha = ((const GHashFrozenEntry *)a)->hash;
+	const unsigned int hb = ((const GHashFrozenEntry *)b)->hash;
+	return (ha < hb) ? -1 : (ha > hb);
+}
+
+/**
+ * Search a pilot below \a pilot_max for every bucket using \a fgh->seed,
+ * \a items must hold #GHashFrozen.nentries items with unique hashes.
+ * \return false when a bucket ran out of pilots, retry with another seed.
+ */
+static bool ghash_frozen_build(GHashFrozen *fgh,
+							   const GHashFrozenEntry *items,
+							   const unsigned int pilot_max)
+{
+	const unsigned int nentries = fgh->nentries;
+	const unsigned int nbuckets = fgh->nbuckets;
+
+	unsigned int *bucket_start = MEM_callocN(
+		sizeof(*bucket_start) * (nbuckets + 1), __func__);
+	unsigned int *bucket_items = MEM_mallocN(sizeof(*bucket_items) * nentries,
+											 __func__);
+	unsigned int *bucket_order = MEM_mallocN(sizeof(*bucket_order) * nbuckets,
+											 __func__);
+	unsigned int *taken = MEM_callocN(sizeof(*taken) * ((nentries + 31) / 32),
+									  __func__);
+	unsigned int *slots = NULL;
+	unsigned int bucket_size_max = 0;
+	bool ok = true;
+	unsigned int i;
+
+	/* Counting sort of the items by bucket. */
+	for (i = 0; i < nentries; i++) {
+		bucket_start[ghash_frozen_bucket_index(
+						 items[i].hash, fgh->seed, nbuckets) +
+					 1]++;
+	}
+	for (i = 0; i < nbuckets; i++) {
+		bucket_size_max = MAX2(bucket_size_max, bucket_start[i + 1]);
+		bucket_start[i + 1] += bucket_start[i];
+	}
+	{
+		unsigned int *fill = MEM_mallocN(sizeof(*fill) * nbuckets, __func__);
+		memcpy(fill, bucket_start, sizeof(*fill) * nbuckets);
+		for (i = 0; i < nentries; i++) {
+			const unsigned int b = ghash_frozen_bucket_index(
+				items[i].hash, fgh->seed, nbuckets);
+			bucket_items[fill[b]++] = i;
+		}
+		MEM_freeN(fill);
+	}
+
+	/* Counting sort of the buckets by size, largest first. */
+	{
+		unsigned int *size_start = MEM_callocN(
+			sizeof(*size_start) * (bucket_size_max + 2), __func__);
+		for (i = 0; i < nbuckets; i++) {
+			const unsigned int size = bucket_start[i + 1] - bucket_start[i];
+			size_start[bucket_size_max - size + 1]++;
+		}
+		for (i = 0; i <= bucket_size_max; i++) {
+			size_start[i + 1] += size_start[i];
+		}
+		for (i = 0; i < nbuckets; i++) {
+			const unsigned int size = bucket_start[i + 1] - bucket_start[i];
+			bucket_order[size_start[bucket_size_max - size]++] = i;
+		}
+		MEM_freeN(size_start);
+	}
+
+	slots = MEM_mallocN(sizeof(*slots) * MAX2(bucket_size_max, 1u), __func__);
+
+	for (i = 0; i < nbuckets && ok; i++) {
+		const unsigned int b = bucket_order[i];
+		const unsigned int *b_items = &bucket_items[bucket_start[b]];
+		const unsigned int b_size = bucket_start[b + 1] - bucket_start[b];
+		unsigned int pilot;
+
+		if (b_size == 0) {
+			/* Sorted by size, only empty buckets remain. */
+			break;
+		}
+
+		for (pilot = 0; pilot < pilot_max; pilot++) {
+			unsigned int k;
+			for (k = 0; k < b_size; k++) {
+				const unsigned int slot = ghash_frozen_slot_index(
+					items[b_items[k]].hash, fgh->seed, pilot, nentries);
+				unsigned int j;
+				if (taken[slot >> 5] & (1u << (slot & 31))) {
+					break;
+				}
+				for (j = 0; j < k && slots[j] != slot; j++) {
+					/* pass */
+				}
+				if (j != k) {
+					break;
+				}
+				slots[k] = slot;
+			}
+			if (k == b_size) {
+				break;
+			}
+		}
+
+		if (pilot == pilot_max) {
+			ok = false;
+			break;
+		}
+
+		fgh->pilots[b] = pilot;
+		for (unsigned int k = 0; k < b_size; k++) {
+			taken[slots[k] >> 5] |= (1u << (slots[k] & 31));
+			fgh->entries[slots[k]] = items[b_items[k]];
+		}
+	}
+
+	MEM_freeN(slots);
+	MEM_freeN(taken);
+	MEM_freeN(bucket_order);
+	MEM_freeN(bucket_items);
+	MEM_freeN(bucket_start);
+
+	return ok;
+}
+
+GHashFrozen *GLU_ghash_freeze(const GHash *gh)
+{
+	return GLU_ghash_internal_freeze_ex(gh, GHASH_FROZEN_PILOT_MAX);
+}
+
+GHashFrozen *GLU_ghash_internal_freeze_ex(const GHash *gh,
+										  const unsigned int pilot_max)
+{
+	GHashFrozen *fgh = MEM_callocN(sizeof(*fgh), __func__);
+	GHashFrozenEntry *items;
+	unsigned int nitems = 0, nunique = 0;
+	unsigned int i;
+
+	LOOM_assert((gh->flag & GHASH_FLAG_IS_GSET) == 0);
+
+	fgh->hashfp = gh->hashfp;
+	fgh->cmpfp = gh->cmpfp;
+
+	if (gh->nentries == 0) {
+		return fgh;
+	}
+
+	items = MEM_mallocN(sizeof(*items) * gh->nentries, __func__);
+	for (i = 0; i < gh->nbuckets; i++) {
+		for (Entry *e = gh->buckets[i]; e; e = e->next) {
+			items[nitems].key = e->key;
+			items[nitems].val = ((GHashEntry *)e)->val;
+			items[nitems].hash = ghash_entryhash(gh, e);
+			nitems++;
+		}
+	}
+	LOOM_assert(nitems == gh->nentries);
+
+	/* Keys sharing a hash become adjacent, keep the first of each run. */
+	qsort(items, nitems, sizeof(*items), ghash_frozen_entry_hash_cmp);
+	fgh->overflow = MEM_mallocN(sizeof(*fgh->overflow) * nitems, __func__);
+	for (i = 0; i < nitems; i++) {
+		if (i && items[i].hash == items[nunique - 1].hash) {
+			fgh->overflow[fgh->noverflow++] = items[i];
+		}
+		else {
+			items[nunique++] = items[i];
+		}
+	}
+	if (fgh->noverflow) {
+		fgh->overflow = MEM_reallocN(fgh->overflow,
+									 sizeof(*fgh->overflow) * fgh->noverflow);
+	}
+	else {
+		MEM_SAFE_FREE(fgh->overflow);
+	}
+
+	fgh->nentries = nunique;
+	fgh->entries = MEM_mallocN(sizeof(*fgh->entries) * nunique, __func__);
+	fgh->nbuckets = MAX2(nunique / GHASH_FROZEN_BUCKET_LOAD, 1u);
+	fgh->pilots = MEM_mallocN(sizeof(*fgh->pilots) * fgh->nbuckets, __func__);
+
+	for (i = 0; i < GHASH_FROZEN_SEED_TRIES_MAX; i++) {
+		fgh->seed = 0x5eedu + i * 0x9e3779b9u;
+		if (ghash_frozen_build(fgh, items, pilot_max)) {
+			break;
+		}
+		/* Smaller buckets are always easier to place. */
+		if (i % GHASH_FROZEN_SEED_TRIES == GHASH_FROZEN_SEED_TRIES - 1 &&
+			fgh->nbuckets < nunique) {
+			fgh->nbuckets = MIN2(fgh->nbuckets * 2, nunique);
+			fgh->pilots = MEM_reallocN(fgh->pilots,
+									   sizeof(*fgh->pilots) * fgh->nbuckets);
+		}
+	}
+
+	MEM_freeN(items);
+	if (i == GHASH_FROZEN_SEED_TRIES_MAX) {
+		GLU_ghash_frozen_free(fgh, NULL, NULL);
+		return NULL;
+	}
+	return fgh;
+}
+
+LOOM_INLINE const GHashFrozenEntry *ghash_frozen_lookup_entry(
+	const GHashFrozen *fgh, const void *key)
+{
+	const GHashFrozenEntry *fe;
+	unsigned int hash, i;
+
+	if (UNLIKELY(fgh->nentries == 0)) {
+		return NULL;
+	}
+
+	hash = fgh->hashfp(key);
+	fe = &fgh->entries[ghash_frozen_slot_index(
+		hash,
+		fgh->seed,
+		fgh->pilots[ghash_frozen_bucket_index(hash, fgh->seed, fgh->nbuckets)],
+		fgh->nentries)];
+
+	if (fe->hash != hash) {
+		return NULL;
+	}
+	if (fgh->cmpfp(key, fe->key) == false) {
+		return fe;
+	}
+	for (i = 0; i < fgh->noverflow; i++) {
+		fe = &fgh->overflow[i];
+		if (fe->hash == hash && fgh->cmpfp(key, fe->key) == false) {
+			return fe;
+		}
+	}
+	return NULL;
+}
+
+void *GLU_ghash_frozen_lookup(const GHashFrozen *fgh, const void *key)
+{
+	const GHashFrozenEntry *fe = ghash_frozen_lookup_entry(fgh, key);
+	return fe ? fe->val : NULL;
+}
+
+void *GLU_ghash_frozen_lookup_default(const GHashFrozen *fgh,
+									  const void *key,
+									  void *val_default)
+{
+	const GHashFrozenEntry *fe = ghash_frozen_lookup_entry(fgh, key);
+	return fe ? fe->val : val_default;
+}
+
+bool GLU_ghash_frozen_haskey(const GHashFrozen *fgh, const void *key)
+{
+	return (ghash_frozen_lookup_entry(fgh, key) != NULL);
+}
+
+unsigned int GLU_ghash_frozen_len(const GHashFrozen *fgh)
+{
+	return fgh->nentries + fgh->noverflow;
+}
+
+size_t GLU_ghash_frozen_calc_memory(const GHashFrozen *fgh)
+{
+	return sizeof(*fgh) + sizeof(*fgh->entries) * fgh->nentries +
+		   sizeof(*fgh->pilots) * fgh->nbuckets +
+		   sizeof(*fgh->overflow) * fgh->noverflow;
+}
+
+void GLU_ghash_frozen_free(GHashFrozen *fgh,
+						   GHashKeyFreeFP keyfreefp,
+						   GHashValFreeFP valfreefp)
+{
+	if (keyfreefp || valfreefp) {
+		for (unsigned int pass = 0; pass < 2; pass++) {
+			GHashFrozenEntry *entries = pass ? fgh->overflow : fgh->entries;
+			const unsigned int len = pass ? fgh->noverflow : fgh->nentries;
+			for (unsigned int i = 0; i < len; i++) {
+				if (keyfreefp) {
+					keyfreefp(entries[i].key);
+				}
+				if (valfreefp) {
+					valfreefp(entries[i].val);
+				}
+			}
+		}
+	}
+
+	MEM_SAFE_FREE(fgh->entries);
+	MEM_SAFE_FREE(fgh->pilots);
+	MEM_SAFE_FREE(fgh->overflow);
+	MEM_freeN(fgh);
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name GSet Public API
  * \{ */
@@ -947,6 +1431,11 @@ unsigned int GLU_gset_len(const GSet *gs)
 	return ((GHash *)gs)->nentries;
 }
 
+size_t GLU_gset_calc_memory(const GSet *gs)
+{
+	return GLU_ghash_calc_memory((const GHash *)gs);
+}
+
 void GLU_gset_insert(GSet *gs, void *key)
 {
 	const unsigned int hash = ghash_keyhash((GHash *)gs, key);
@@ -1041,6 +1530,11 @@ void GLU_gset_flag_clear(GSet *gs, unsigned int flag)
 	((GHash *)gs)->flag &= ~flag;
 }
 
+void GLU_gset_reserve(GSet *gs, const unsigned int nentries_reserve)
+{
+	GLU_ghash_reserve((GHash *)gs, nentries_reserve);
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -1056,6 +1550,32 @@ void *GLU_gset_lookup(const GSet *gs, const void *key)
 	return e ? e->key : NULL;
 }
 
+void *GLU_gset_lookup_ex(const GSet *gs,
+						 const unsigned int hash,
+						 GHashLookupCmpFP cmpfp,
+						 const void *user_data)
+{
+	Entry *e = ghash_lookup_entry_hash(
+		(const GHash *)gs, hash, cmpfp, user_data);
+	return e ? e->key : NULL;
+}
+
+void GLU_gset_lookup_batch(const GSet *gs,
+						   const void *const *keys,
+						   const unsigned int n,
+						   void **r_keys)
+{
+	Entry *entries[GHASH_LOOKUP_BATCH];
+
+	for (unsigned int start = 0; start < n; start += GHASH_LOOKUP_BATCH) {
+		const unsigned int len = MIN2(n - start, (unsigned int)GHASH_LOOKUP_BATCH);
+		ghash_lookup_entry_batch((const GHash *)gs, keys + start, len, entries);
+		for (unsigned int i = 0; i < len; i++) {
+			r_keys[start + i] = entries[i] ? entries[i]->key : NULL;
+		}
+	}
+}
+
 void *GLU_gset_pop_key(GSet *gs, const void *key)
 {
 	const unsigned int hash = ghash_keyhash((GHash *)gs, key);
@@ -1070,3 +1590,198 @@ void *GLU_gset_pop_key(GSet *gs, const void *key)
 }
 
 /** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name GHash/GSet Internal API
+ * \{ */
+
+unsigned int GLU_ghash_internal_nbuckets(const GHash *gh)
+{
+	return gh->nbuckets;
+}
+
+unsigned int GLU_ghash_internal_flag(const GHash *gh)
+{
+	return gh->flag;
+}
+
+GSet *GLU_gset_internal_new_like(const GSet *gs,
+								 const char *info,
+								 const unsigned int nentries_reserve)
+{
+	const GHash *gh = (const GHash *)gs;
+	return (GSet *)ghash_new(
+		gh->hashfp, gh->cmpfp, info, nentries_reserve, gh->flag);
+}
+
+bool GLU_gset_internal_add_hash(GSet *gs, void *key, const unsigned int hash)
+{
+	GHash *gh = (GHash *)gs;
+	const unsigned int bucket_index = ghash_bucket_index(gh, hash);
+
+	LOOM_assert(hash == ghash_keyhash(gh, key));
+	if (ghash_lookup_entry_ex(gh, key, bucket_index)) {
+		return false;
+	}
+	ghash_insert_ex_keyonly(gh, key, bucket_index);
+	return true;
+}
+
+LOOM_INLINE Entry *gset_lookup_entry_hash(const GSet *gs,
+										  const void *key,
+										  const unsigned int hash)
+{
+	const GHash *gh = (const GHash *)gs;
+	LOOM_assert(hash == ghash_keyhash(gh, key));
+	return ghash_lookup_entry_ex(gh, key, ghash_bucket_index(gh, hash));
+}
+
+bool GLU_gset_internal_haskey_hash(const GSet *gs,
+								   const void *key,
+								   const unsigned int hash)
+{
+	return gset_lookup_entry_hash(gs, key, hash) != NULL;
+}
+
+void *GLU_gset_internal_lookup_hash(const GSet *gs,
+									const void *key,
+									const unsigned int hash)
+{
+	Entry *e = gset_lookup_entry_hash(gs, key, hash);
+	return e ? e->key : NULL;
+}
+
+bool GLU_gset_internal_remove_hash(GSet *gs,
+								   const void *key,
+								   const unsigned int hash,
+								   GSetKeyFreeFP keyfreefp)
+{
+	GHash *gh = (GHash *)gs;
+	LOOM_assert(hash == ghash_keyhash(gh, key));
+	Entry *e = ghash_remove_ex(
+		gh, key, keyfreefp, NULL, ghash_bucket_index(gh, hash));
+	if (e) {
+		GLU_mempool_free(gh->entrypool, e);
+		return true;
+	}
+	return false;
+}
+
+static void gset_probe_batch(const GHash *probe,
+							 const void *const *keys,
+							 const unsigned int n,
+							 const bool found,
+							 GSetProbeFP fn,
+							 void *userdata)
+{
+	Entry *entries[GHASH_LOOKUP_BATCH];
+
+	ghash_lookup_entry_batch(probe, keys, n, entries);
+	for (unsigned int i = 0; i < n; i++) {
+		if ((entries[i] != NULL) == found) {
+			fn(userdata, (void *)keys[i], entries[i] ? entries[i]->key : NULL);
+		}
+	}
+}
+
+void GLU_gset_internal_probe(const GSet *gs,
+							 const unsigned int bucket_begin,
+							 const unsigned int bucket_end,
+							 const GSet *probe,
+							 const bool found,
+							 GSetProbeFP fn,
+							 void *userdata)
+{
+	const GHash *gh = (const GHash *)gs;
+	const GHash *gh_probe = (const GHash *)probe;
+	const void *keys[GHASH_LOOKUP_BATCH];
+	unsigned int n = 0;
+
+	LOOM_assert(bucket_begin <= bucket_end && bucket_end <= gh->nbuckets);
+
+	for (unsigned int i = bucket_begin; i < bucket_end; i++) {
+		for (Entry *e = gh->buckets[i]; e; e = e->next) {
+			keys[n++] = e->key;
+			if (n == GHASH_LOOKUP_BATCH) {
+				gset_probe_batch(gh_probe, keys, n, found, fn, userdata);
+				n = 0;
+			}
+		}
+	}
+	if (n) {
+		gset_probe_batch(gh_probe, keys, n, found, fn, userdata);
+	}
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name GHash/GSet Debugging
+ * \{ */
+
+double GLU_ghash_calc_quality_ex(const GHash *gh, GHashQuality *r_quality)
+{
+	memset(r_quality, 0, sizeof(*r_quality));
+	r_quality->nentries = gh->nentries;
+	r_quality->nbuckets = gh->nbuckets;
+
+#ifdef GHASH_DEBUG_STATS
+	r_quality->stat_lookups = gh->stat_lookups;
+	r_quality->stat_cmps = gh->stat_cmps;
+#endif
+
+	if (gh->nentries == 0) {
+		r_quality->empty_buckets = gh->nbuckets;
+		return 1.0;
+	}
+
+	const double load = (double)gh->nentries / (double)gh->nbuckets;
+	/* Sum of the squared deviation from the load and of the probes needed to
+	 * find every entry (the n-th entry of a chain takes n compares). */
+	double sum_variance = 0.0;
+	double sum_probes = 0.0;
+
+	/* Only the chains are walked, keys are never hashed again. */
+	for (unsigned int i = 0; i < gh->nbuckets; i++) {
+		unsigned int count = 0;
+		for (const Entry *e = gh->buckets[i]; e; e = e->next) {
+			count++;
+		}
+
+		const unsigned int slot = MIN2(count, GHASH_QUALITY_HISTOGRAM_LEN - 1);
+		r_quality->chain_histogram[slot]++;
+		if (count == 0) {
+			r_quality->empty_buckets++;
+		}
+		r_quality->probe_max = MAX2(r_quality->probe_max, count);
+		sum_variance += ((double)count - load) * ((double)count - load);
+		sum_probes += (double)count * (double)(count + 1) / 2.0;
+	}
+
+	r_quality->load = load;
+	r_quality->variance = sum_variance / (double)gh->nbuckets;
+	r_quality->probe_mean = sum_probes / (double)gh->nentries;
+
+	/* The mean probe length of a uniform hash is `1 + (n - 1) / (2 * m)`, the
+	 * quality is the ratio against it (1.0 is ideal, larger is worse). */
+	return r_quality->probe_mean /
+		   (1.0 + (double)(gh->nentries - 1) / (2.0 * (double)gh->nbuckets));
+}
+
+double GLU_ghash_calc_quality(const GHash *gh)
+{
+	GHashQuality quality;
+	return GLU_ghash_calc_quality_ex(gh, &quality);
+}
+
+double GLU_gset_calc_quality_ex(const GSet *gs, GHashQuality *r_quality)
+{
+	return GLU_ghash_calc_quality_ex((const GHash *)gs, r_quality);
+}
+
+double GLU_gset_calc_quality(const GSet *gs)
+{
+	return GLU_ghash_calc_quality((const GHash *)gs);
+}
+
+/** \} */
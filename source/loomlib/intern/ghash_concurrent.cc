@@ -0,0 +1,580 @@
+#include "guardedalloc/mem_guardedalloc.h"
+
+#include "atomic/atomic_ops.h"
+
+#include "loomlib/loomlib_assert.h"
+#include "loomlib/loomlib_ghash_concurrent.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+/* -------------------------------------------------------------------- */
+/** \name Structs & Constants
+ *
+ * Readers never lock, they announce themselves in one of the reader slots
+ * (a counter per epoch parity) and walk the bucket chains with acquire loads.
+ *
+ * Writers lock the stripe of the key's hash. Bucket counts are powers of two
+ * never smaller than the number of stripes, so every bucket belongs to a
+ * single stripe.
+ *
+ * Each entry carries two `next` links, one per bucket generation. Growing
+ * locks all stripes, links the live entries into the new buckets through the
+ * link the current generation doesn't use and publishes the new buckets.
+ * Readers still walking the old buckets follow the untouched links. The old
+ * buckets are freed after a grace period, which also guarantees the link is
+ * unused again by the time the next resize needs it.
+ *
+ * Removed entries are retired and freed in batches after a grace period.
+ * \{ */
+
+#define CGHASH_STRIPES 64
+#define CGHASH_READER_SLOTS 64
+#define CGHASH_RETIRE_BATCH 256
+#define CGHASH_MAX_BUCKETS (1u << 30)
+
+#define CGHASH_LIMIT_GROW(_nbkt) (((_nbkt) * 3) / 4)
+
+typedef struct CGHashEntry {
+	std::atomic<CGHashEntry *> next[2];
+	/** Accessed with `atomic_ops`, #GLU_cghash_ensure_p hands out `&val`. */
+	void *key;
+	void *val;
+	unsigned int hash;
+} CGHashEntry;
+
+typedef struct CGHashBuckets {
+	std::atomic<CGHashEntry *> *buckets;
+	unsigned int nbuckets;
+	unsigned int limit_grow;
+	/** Which #CGHashEntry.next link this generation uses. */
+	int link;
+} CGHashBuckets;
+
+typedef struct CGHashRetired {
+	struct CGHashRetired *next;
+	/** Optional, NULL when only the key/value are released. */
+	CGHashEntry *e;
+	void *key;
+	void *val;
+	GHashKeyFreeFP keyfreefp;
+	GHashValFreeFP valfreefp;
+} CGHashRetired;
+
+struct alignas(64) CGHashStripe {
+	std::mutex mutex;
+};
+
+struct alignas(64) CGHashReaderSlot {
+	std::atomic<unsigned int> count[2];
+};
+
+struct CGHash {
+	GHashHashFP hashfp;
+	GHashCmpFP cmpfp;
+
+	std::atomic<CGHashBuckets *> buckets;
+	std::atomic<unsigned int> nentries;
+
+	CGHashStripe stripes[CGHASH_STRIPES];
+
+	mutable CGHashReaderSlot readers[CGHASH_READER_SLOTS];
+	std::atomic<unsigned int> epoch;
+	/** Serializes grace periods. */
+	std::mutex sync_mutex;
+	/** Serializes growing the buckets. */
+	std::mutex resize_mutex;
+
+	std::mutex retire_mutex;
+	CGHashRetired *retired;
+	unsigned int nretired;
+};
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Internal Utility API
+ * \{ */
+
+static unsigned int cghash_keyhash(const CGHash *cgh, const void *key)
+{
+	/* Bucket indices are masked, spread the bits of weak hashes. */
+	unsigned int hash = cgh->hashfp(key);
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bu;
+	hash ^= hash >> 13;
+	return hash;
+}
+
+static std::mutex &cghash_stripe(CGHash *cgh, const unsigned int hash)
+{
+	return cgh->stripes[hash & (CGHASH_STRIPES - 1)].mutex;
+}
+
+static CGHashBuckets *cghash_buckets_alloc(const unsigned int nbuckets,
+										   const int link)
+{
+	CGHashBuckets *b = static_cast<CGHashBuckets *>(
+		MEM_mallocN(sizeof(*b), "CGHashBuckets"));
+	b->buckets = static_cast<std::atomic<CGHashEntry *> *>(
+		MEM_mallocN(sizeof(*b->buckets) * nbuckets, "CGHashBuckets buckets"));
+	for (unsigned int i = 0; i < nbuckets; i++) {
+		new (&b->buckets[i]) std::atomic<CGHashEntry *>(nullptr);
+	}
+	b->nbuckets = nbuckets;
+	b->limit_grow = CGHASH_LIMIT_GROW(nbuckets);
+	b->link = link;
+	return b;
+}
+
+static void cghash_buckets_free(CGHashBuckets *b)
+{
+	MEM_freeN(b->buckets);
+	MEM_freeN(b);
+}
+
+static unsigned int cghash_nbuckets_for(const unsigned int nentries)
+{
+	unsigned int nbuckets = CGHASH_STRIPES;
+	while (CGHASH_LIMIT_GROW(nbuckets) < nentries &&
+		   nbuckets < CGHASH_MAX_BUCKETS) {
+		nbuckets <<= 1;
+	}
+	return nbuckets;
+}
+
+/**
+ * Walk the chain of \a hash, safe for readers (without any lock) and for
+ * writers (holding the stripe of \a hash).
+ */
+static CGHashEntry *cghash_lookup_entry(const CGHash *cgh,
+										const CGHashBuckets *b,
+										const void *key,
+										const unsigned int hash)
+{
+	const int link = b->link;
+	CGHashEntry *e = b->buckets[hash & (b->nbuckets - 1)].load(
+		std::memory_order_acquire);
+	for (; e; e = e->next[link].load(std::memory_order_acquire)) {
+		if (e->hash == hash && !cgh->cmpfp(key, atomic_load_ptr(&e->key))) {
+			return e;
+		}
+	}
+	return nullptr;
+}
+
+/**
+ * Link a new entry in front of its chain, the stripe of \a hash must be
+ * locked.
+ */
+static CGHashEntry *cghash_insert_entry(CGHash *cgh,
+										CGHashBuckets *b,
+										void *key,
+										void *val,
+										const unsigned int hash)
+{
+	CGHashEntry *e = MEM_new<CGHashEntry>("CGHashEntry");
+	std::atomic<CGHashEntry *> &head = b->buckets[hash & (b->nbuckets - 1)];
+
+	e->key = key;
+	e->val = val;
+	e->hash = hash;
+	e->next[b->link].store(head.load(std::memory_order_relaxed),
+						   std::memory_order_relaxed);
+	e->next[b->link ^ 1].store(nullptr, std::memory_order_relaxed);
+
+	/* Publishes the fully initialized entry to readers. */
+	head.store(e, std::memory_order_release);
+	cgh->nentries.fetch_add(1, std::memory_order_relaxed);
+	return e;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Grace Periods & Reclamation
+ * \{ */
+
+static unsigned int cghash_reader_slot()
+{
+	static std::atomic<unsigned int> slot_next(0);
+	thread_local const unsigned int slot =
+		slot_next.fetch_add(1, std::memory_order_relaxed) % CGHASH_READER_SLOTS;
+	return slot;
+}
+
+static std::atomic<unsigned int> &cghash_read_begin(const CGHash *cgh)
+{
+	CGHashReaderSlot &slot = cgh->readers[cghash_reader_slot()];
+	const unsigned int parity = cgh->epoch.load(std::memory_order_seq_cst) & 1;
+	std::atomic<unsigned int> &count = slot.count[parity];
+	count.fetch_add(1, std::memory_order_seq_cst);
+	return count;
+}
+
+static void cghash_read_end(std::atomic<unsigned int> &count)
+{
+	count.fetch_sub(1, std::memory_order_release);
+}
+
+/**
+ * Wait until every reader that started before this call is done.
+ *
+ * The epoch is flipped twice, a reader may have sampled the epoch before the
+ * first flip and announced itself after the first wait, the second wait
+ * covers it.
+ */
+static void cghash_synchronize(CGHash *cgh)
+{
+	std::lock_guard<std::mutex> lock(cgh->sync_mutex);
+
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	for (int phase = 0; phase < 2; phase++) {
+		const unsigned int parity =
+			cgh->epoch.fetch_add(1, std::memory_order_seq_cst) & 1;
+		for (CGHashReaderSlot &slot : cgh->readers) {
+			while (slot.count[parity].load(std::memory_order_acquire) != 0) {
+				std::this_thread::yield();
+			}
+		}
+	}
+}
+
+static void cghash_retired_free(CGHashRetired *r)
+{
+	while (r) {
+		CGHashRetired *r_next = r->next;
+		if (r->keyfreefp) {
+			r->keyfreefp(r->key);
+		}
+		if (r->valfreefp) {
+			r->valfreefp(r->val);
+		}
+		if (r->e) {
+			MEM_delete(r->e);
+		}
+		MEM_freeN(r);
+		r = r_next;
+	}
+}
+
+static void cghash_retire(CGHash *cgh,
+						  CGHashEntry *e,
+						  void *key,
+						  void *val,
+						  GHashKeyFreeFP keyfreefp,
+						  GHashValFreeFP valfreefp)
+{
+	CGHashRetired *r = static_cast<CGHashRetired *>(
+		MEM_mallocN(sizeof(*r), "CGHashRetired"));
+	CGHashRetired *batch = nullptr;
+
+	r->e = e;
+	r->key = key;
+	r->val = val;
+	r->keyfreefp = keyfreefp;
+	r->valfreefp = valfreefp;
+
+	{
+		std::lock_guard<std::mutex> lock(cgh->retire_mutex);
+		r->next = cgh->retired;
+		cgh->retired = r;
+		if (++cgh->nretired >= CGHASH_RETIRE_BATCH) {
+			batch = cgh->retired;
+			cgh->retired = nullptr;
+			cgh->nretired = 0;
+		}
+	}
+
+	if (batch) {
+		cghash_synchronize(cgh);
+		cghash_retired_free(batch);
+	}
+}
+
+/**
+ * Grow the buckets so they fit at least \a nentries, only writers are
+ * blocked while the entries are relinked.
+ */
+static void cghash_grow(CGHash *cgh, const unsigned int nentries)
+{
+	std::lock_guard<std::mutex> resize_lock(cgh->resize_mutex);
+
+	CGHashBuckets *b_old = cgh->buckets.load(std::memory_order_acquire);
+	if (nentries <= b_old->limit_grow || b_old->nbuckets >= CGHASH_MAX_BUCKETS) {
+		/* Another thread grew the buckets meanwhile. */
+		return;
+	}
+
+	CGHashBuckets *b_new =
+		cghash_buckets_alloc(cghash_nbuckets_for(nentries), b_old->link ^ 1);
+	const unsigned int mask = b_new->nbuckets - 1;
+
+	for (CGHashStripe &stripe : cgh->stripes) {
+		stripe.mutex.lock();
+	}
+
+	for (unsigned int i = 0; i < b_old->nbuckets; i++) {
+		CGHashEntry *e = b_old->buckets[i].load(std::memory_order_relaxed);
+		while (e) {
+			CGHashEntry *e_next =
+				e->next[b_old->link].load(std::memory_order_relaxed);
+			std::atomic<CGHashEntry *> &head = b_new->buckets[e->hash & mask];
+			e->next[b_new->link].store(head.load(std::memory_order_relaxed),
+									   std::memory_order_relaxed);
+			head.store(e, std::memory_order_relaxed);
+			e = e_next;
+		}
+	}
+
+	cgh->buckets.store(b_new, std::memory_order_release);
+
+	for (CGHashStripe &stripe : cgh->stripes) {
+		stripe.mutex.unlock();
+	}
+
+	/* Readers may still walk the old buckets, the resize mutex is held until
+	 * they are done so the link they follow is free for the next resize. */
+	cghash_synchronize(cgh);
+	cghash_buckets_free(b_old);
+}
+
+static void cghash_grow_check(CGHash *cgh)
+{
+	const unsigned int nentries = cgh->nentries.load(std::memory_order_relaxed);
+
+	/* Called without a stripe lock, another thread may grow and free the
+	 * buckets meanwhile, read their limit as a reader. */
+	std::atomic<unsigned int> &count = cghash_read_begin(cgh);
+	const unsigned int limit_grow =
+		cgh->buckets.load(std::memory_order_acquire)->limit_grow;
+	cghash_read_end(count);
+
+	if (nentries > limit_grow) {
+		cghash_grow(cgh, nentries);
+	}
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Concurrent GHash Public API
+ * \{ */
+
+CGHash *GLU_cghash_new_ex(GHashHashFP hash_fp,
+						  GHashCmpFP cmp_fp,
+						  const char *info,
+						  const unsigned int nentries_reserve)
+{
+	CGHash *cgh = MEM_new<CGHash>(info);
+
+	cgh->hashfp = hash_fp;
+	cgh->cmpfp = cmp_fp;
+	cgh->buckets.store(
+		cghash_buckets_alloc(cghash_nbuckets_for(nentries_reserve), 0));
+	cgh->nentries.store(0);
+	for (CGHashReaderSlot &slot : cgh->readers) {
+		slot.count[0].store(0);
+		slot.count[1].store(0);
+	}
+	cgh->epoch.store(0);
+	cgh->retired = nullptr;
+	cgh->nretired = 0;
+
+	return cgh;
+}
+
+CGHash *GLU_cghash_new(GHashHashFP hash_fp,
+					   GHashCmpFP cmp_fp,
+					   const char *info)
+{
+	return GLU_cghash_new_ex(hash_fp, cmp_fp, info, 0);
+}
+
+void GLU_cghash_free(CGHash *cgh,
+					 GHashKeyFreeFP keyfreefp,
+					 GHashValFreeFP valfreefp)
+{
+	CGHashBuckets *b = cgh->buckets.load();
+
+	cghash_retired_free(cgh->retired);
+
+	for (unsigned int i = 0; i < b->nbuckets; i++) {
+		CGHashEntry *e = b->buckets[i].load(std::memory_order_relaxed);
+		while (e) {
+			CGHashEntry *e_next = e->next[b->link].load(std::memory_order_relaxed);
+			if (keyfreefp) {
+				keyfreefp(e->key);
+			}
+			if (valfreefp) {
+				valfreefp(e->val);
+			}
+			MEM_delete(e);
+			e = e_next;
+		}
+	}
+
+	cghash_buckets_free(b);
+	MEM_delete(cgh);
+}
+
+bool GLU_cghash_insert(CGHash *cgh, void *key, void *val)
+{
+	const unsigned int hash = cghash_keyhash(cgh, key);
+	{
+		std::lock_guard<std::mutex> lock(cghash_stripe(cgh, hash));
+		CGHashBuckets *b = cgh->buckets.load(std::memory_order_acquire);
+		if (cghash_lookup_entry(cgh, b, key, hash)) {
+			return false;
+		}
+		cghash_insert_entry(cgh, b, key, val, hash);
+	}
+	cghash_grow_check(cgh);
+	return true;
+}
+
+bool GLU_cghash_reinsert(CGHash *cgh,
+						 void *key,
+						 void *val,
+						 GHashKeyFreeFP keyfreefp,
+						 GHashValFreeFP valfreefp)
+{
+	const unsigned int hash = cghash_keyhash(cgh, key);
+	void *key_old = nullptr, *val_old = nullptr;
+	bool added;
+	{
+		std::lock_guard<std::mutex> lock(cghash_stripe(cgh, hash));
+		CGHashBuckets *b = cgh->buckets.load(std::memory_order_acquire);
+		CGHashEntry *e = cghash_lookup_entry(cgh, b, key, hash);
+		if (e == nullptr) {
+			cghash_insert_entry(cgh, b, key, val, hash);
+			added = true;
+		}
+		else {
+			added = false;
+			key_old = e->key;
+			val_old = e->val;
+			atomic_store_ptr(&e->key, key);
+			atomic_store_ptr(&e->val, val);
+		}
+	}
+
+	if (added) {
+		cghash_grow_check(cgh);
+		return true;
+	}
+	if (keyfreefp || valfreefp) {
+		cghash_retire(cgh, nullptr, key_old, val_old, keyfreefp, valfreefp);
+	}
+	return false;
+}
+
+void *GLU_cghash_lookup(const CGHash *cgh, const void *key)
+{
+	return GLU_cghash_lookup_default(cgh, key, nullptr);
+}
+
+void *GLU_cghash_lookup_default(const CGHash *cgh,
+								const void *key,
+								void *val_default)
+{
+	const unsigned int hash = cghash_keyhash(cgh, key);
+	std::atomic<unsigned int> &count = cghash_read_begin(cgh);
+
+	const CGHashBuckets *b = cgh->buckets.load(std::memory_order_acquire);
+	const CGHashEntry *e = cghash_lookup_entry(cgh, b, key, hash);
+	void *val = e ? atomic_load_ptr(&e->val) : val_default;
+
+	cghash_read_end(count);
+	return val;
+}
+
+bool GLU_cghash_haskey(const CGHash *cgh, const void *key)
+{
+	const unsigned int hash = cghash_keyhash(cgh, key);
+	std::atomic<unsigned int> &count = cghash_read_begin(cgh);
+
+	const CGHashBuckets *b = cgh->buckets.load(std::memory_order_acquire);
+	const bool found = cghash_lookup_entry(cgh, b, key, hash) != nullptr;
+
+	cghash_read_end(count);
+	return found;
+}
+
+bool GLU_cghash_ensure_p(CGHash *cgh, void *key, void ***r_val)
+{
+	const unsigned int hash = cghash_keyhash(cgh, key);
+	{
+		std::lock_guard<std::mutex> lock(cghash_stripe(cgh, hash));
+		CGHashBuckets *b = cgh->buckets.load(std::memory_order_acquire);
+		CGHashEntry *e = cghash_lookup_entry(cgh, b, key, hash);
+		if (e) {
+			*r_val = &e->val;
+			return true;
+		}
+		/* Entries never move while linked, the slot outlives the lock. */
+		e = cghash_insert_entry(cgh, b, key, nullptr, hash);
+		*r_val = &e->val;
+	}
+	cghash_grow_check(cgh);
+	return false;
+}
+
+bool GLU_cghash_remove(CGHash *cgh,
+					   const void *key,
+					   GHashKeyFreeFP keyfreefp,
+					   GHashValFreeFP valfreefp)
+{
+	const unsigned int hash = cghash_keyhash(cgh, key);
+	CGHashEntry *e;
+	{
+		std::lock_guard<std::mutex> lock(cghash_stripe(cgh, hash));
+		CGHashBuckets *b = cgh->buckets.load(std::memory_order_acquire);
+		std::atomic<CGHashEntry *> *link =
+			&b->buckets[hash & (b->nbuckets - 1)];
+
+		for (e = link->load(std::memory_order_relaxed); e;
+			 e = link->load(std::memory_order_relaxed)) {
+			if (e->hash == hash && !cgh->cmpfp(key, e->key)) {
+				break;
+			}
+			link = &e->next[b->link];
+		}
+		if (e == nullptr) {
+			return false;
+		}
+
+		/* The removed entry keeps its links, readers standing on it can still
+		 * finish walking the chain. */
+		link->store(e->next[b->link].load(std::memory_order_relaxed),
+					std::memory_order_release);
+		cgh->nentries.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	cghash_retire(cgh, e, e->key, e->val, keyfreefp, valfreefp);
+	return true;
+}
+
+unsigned int GLU_cghash_len(const CGHash *cgh)
+{
+	return cgh->nentries.load(std::memory_order_relaxed);
+}
+
+void GLU_cghash_reclaim(CGHash *cgh)
+{
+	CGHashRetired *batch;
+	{
+		std::lock_guard<std::mutex> lock(cgh->retire_mutex);
+		batch = cgh->retired;
+		cgh->retired = nullptr;
+		cgh->nretired = 0;
+	}
+
+	if (batch) {
+		cghash_synchronize(cgh);
+		cghash_retired_free(batch);
+	}
+}
+
+/** \} */
@@ -0,0 +1,445 @@
+#include "guardedalloc/mem_guardedalloc.h"
+
+#include "loomlib/loomlib_endian_defines.h"
+#include "loomlib/loomlib_ghash.h"
+#include "loomlib/loomlib_ghash_mmap.h"
+#include "loomlib/loomlib_utildefines.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef WIN32
+#	define WIN32_LEAN_AND_MEAN
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+/* -------------------------------------------------------------------- */
+/** \name Structs & Constants
+ *
+ * Layout, every section starts at an 8 byte aligned offset:
+ *
+ * - #GHashMMapHeader.
+ * - `nbuckets + 1` bucket offsets (uint32), the entries of bucket `i` are
+ *   `entries[buckets[i]]` up to (excluding) `entries[buckets[i + 1]]`.
+ * - `nentries` #GHashMMapEntry, grouped by bucket.
+ * - The string blob, NULL terminated strings referenced by offset.
+ * \{ */
+
+#define GHASH_MMAP_MAGIC "LOOMGHM"
+#define GHASH_MMAP_VERSION 1
+/** Written in the byte order of the writer, to detect foreign tables. */
+#define GHASH_MMAP_BYTE_ORDER 0x01020304u
+/** Offset stored for NULL string values. */
+#define GHASH_MMAP_NULL_OFFSET UINT64_MAX
+
+typedef struct GHashMMapHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	uint16_t key_type;
+	uint16_t val_type;
+	uint32_t nentries;
+	/** Always a power of two. */
+	uint32_t nbuckets;
+	uint32_t _pad;
+	uint64_t buckets_offset;
+	uint64_t entries_offset;
+	uint64_t strings_offset;
+	uint64_t strings_size;
+} GHashMMapHeader;
+
+LOOM_STATIC_ASSERT(sizeof(GHashMMapHeader) == 64, "Invalid header size");
+
+typedef struct GHashMMapEntry {
+	/** The integer key or the offset of the key string. */
+	uint64_t key;
+	/** The integer value or the offset of the value string. */
+	uint64_t val;
+	uint32_t hash;
+	uint32_t _pad;
+} GHashMMapEntry;
+
+LOOM_STATIC_ASSERT(sizeof(GHashMMapEntry) == 24, "Invalid entry size");
+
+LOOM_INLINE uint64_t ghash_mmap_align(uint64_t offset)
+{
+	return (offset + 7) & ~(uint64_t)7;
+}
+
+/** The hash has to be the same on every platform, #GLU_ghashutil_inthash_p
+ * depends on the size of a pointer. */
+LOOM_INLINE unsigned int ghash_mmap_inthash(uint64_t key)
+{
+	return GLU_ghashutil_combine_hash(
+		GLU_ghashutil_uinthash((unsigned int)(key & 0xffffffff)),
+		GLU_ghashutil_uinthash((unsigned int)(key >> 32)));
+}
+
+/** Integer keys and values are stored as the sign extended `int` of the
+ * pointer, `(uintptr_t)` would give negative numbers different bits on 32 and
+ * 64 bit platforms. */
+LOOM_INLINE uint64_t ghash_mmap_int_write(const void *ptr)
+{
+	return (uint64_t)(int64_t)POINTER_AS_INT(ptr);
+}
+
+LOOM_INLINE void *ghash_mmap_int_read(const uint64_t value)
+{
+	return POINTER_FROM_INT((int)(int64_t)value);
+}
+
+LOOM_INLINE unsigned int ghash_mmap_keyhash(const unsigned short key_type,
+											const void *key)
+{
+	return (key_type == GHASH_MMAP_KEY_STR)
+			   ? GLU_ghashutil_strhash_p(key)
+			   : ghash_mmap_inthash(ghash_mmap_int_write(key));
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Writer
+ * \{ */
+
+void *GLU_ghash_mmap_write(const GHash *gh,
+						   eGHashMMapKeyType key_type,
+						   eGHashMMapValType val_type,
+						   size_t *r_size)
+{
+	const unsigned int nentries = GLU_ghash_len(gh);
+	unsigned int nbuckets = 1;
+	while (nbuckets < nentries) {
+		nbuckets <<= 1;
+	}
+
+	unsigned int *hashes = MEM_mallocN(sizeof(*hashes) * MAX2(nentries, 1),
+									   "GHashMMap::hashes");
+	uint32_t *bucket_fill = MEM_callocN(sizeof(*bucket_fill) * (nbuckets + 1),
+										"GHashMMap::bucket_fill");
+
+	/* First pass, hash the keys, count the entries of each bucket and the
+	 * size of the string blob. */
+	uint64_t strings_size = 0;
+	GHashIterator gh_iter;
+	unsigned int i;
+	GHASH_ITER_INDEX (gh_iter, (GHash *)gh, i) {
+		const void *key = GLU_ghash_iterator_get_key(&gh_iter);
+		const void *val = GLU_ghash_iterator_get_value(&gh_iter);
+
+		hashes[i] = ghash_mmap_keyhash(key_type, key);
+		bucket_fill[(hashes[i] & (nbuckets - 1)) + 1]++;
+
+		if (key_type == GHASH_MMAP_KEY_STR) {
+			strings_size += strlen(key) + 1;
+		}
+		if (val_type == GHASH_MMAP_VAL_STR && val != NULL) {
+			strings_size += strlen(val) + 1;
+		}
+	}
+
+	GHashMMapHeader header = {0};
+	memcpy(header.magic, GHASH_MMAP_MAGIC, sizeof(GHASH_MMAP_MAGIC));
+	header.version = GHASH_MMAP_VERSION;
+	header.byte_order = GHASH_MMAP_BYTE_ORDER;
+	header.key_type = (uint16_t)key_type;
+	header.val_type = (uint16_t)val_type;
+	header.nentries = nentries;
+	header.nbuckets = nbuckets;
+	header.buckets_offset = sizeof(GHashMMapHeader);
+	header.entries_offset = ghash_mmap_align(
+		header.buckets_offset + sizeof(uint32_t) * (nbuckets + 1));
+	header.strings_offset = ghash_mmap_align(
+		header.entries_offset + sizeof(GHashMMapEntry) * nentries);
+	header.strings_size = strings_size;
+
+	const size_t size = (size_t)(header.strings_offset + strings_size);
+	char *data = MEM_callocN(size, "GHashMMap::data");
+	memcpy(data, &header, sizeof(header));
+
+	/* Prefix sum, the bucket offsets are stored as they are. */
+	uint32_t *buckets = (uint32_t *)(data + header.buckets_offset);
+	for (i = 0; i < nbuckets; i++) {
+		bucket_fill[i + 1] += bucket_fill[i];
+	}
+	memcpy(buckets, bucket_fill, sizeof(uint32_t) * (nbuckets + 1));
+
+	/* Second pass, place the entries, #bucket_fill is reused as the insert
+	 * position of each bucket. */
+	GHashMMapEntry *entries = (GHashMMapEntry *)(data + header.entries_offset);
+	char *strings = data + header.strings_offset;
+	uint64_t strings_len = 0;
+	GHASH_ITER_INDEX (gh_iter, (GHash *)gh, i) {
+		const void *key = GLU_ghash_iterator_get_key(&gh_iter);
+		const void *val = GLU_ghash_iterator_get_value(&gh_iter);
+		GHashMMapEntry *entry =
+			&entries[bucket_fill[hashes[i] & (nbuckets - 1)]++];
+
+		entry->hash = hashes[i];
+		if (key_type == GHASH_MMAP_KEY_STR) {
+			const size_t len = strlen(key) + 1;
+			memcpy(strings + strings_len, key, len);
+			entry->key = strings_len;
+			strings_len += len;
+		}
+		else {
+			entry->key = ghash_mmap_int_write(key);
+		}
+		if (val_type == GHASH_MMAP_VAL_STR) {
+			if (val != NULL) {
+				const size_t len = strlen(val) + 1;
+				memcpy(strings + strings_len, val, len);
+				entry->val = strings_len;
+				strings_len += len;
+			}
+			else {
+				entry->val = GHASH_MMAP_NULL_OFFSET;
+			}
+		}
+		else {
+			entry->val = ghash_mmap_int_write(val);
+		}
+	}
+	LOOM_assert(strings_len == strings_size);
+
+	MEM_freeN(bucket_fill);
+	MEM_freeN(hashes);
+
+	*r_size = size;
+	return data;
+}
+
+static FILE *ghash_mmap_fopen(const char *filepath, const char *mode)
+{
+#ifdef _MSC_VER
+	FILE *file;
+	return (fopen_s(&file, filepath, mode) == 0) ? file : NULL;
+#else
+	return fopen(filepath, mode);
+#endif
+}
+
+bool GLU_ghash_mmap_write_file(const GHash *gh,
+							   eGHashMMapKeyType key_type,
+							   eGHashMMapValType val_type,
+							   const char *filepath)
+{
+	FILE *file = ghash_mmap_fopen(filepath, "wb");
+	if (file == NULL) {
+		return false;
+	}
+
+	size_t size;
+	void *data = GLU_ghash_mmap_write(gh, key_type, val_type, &size);
+	bool ok = (fwrite(data, 1, size, file) == size);
+	ok &= (fclose(file) == 0);
+	MEM_freeN(data);
+	return ok;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Reader
+ * \{ */
+
+bool GLU_ghash_mmap_init(GHashMMap *r_map, const void *data, size_t size)
+{
+	memset(r_map, 0, sizeof(*r_map));
+
+	if (size < sizeof(GHashMMapHeader)) {
+		return false;
+	}
+	const GHashMMapHeader *header = data;
+	if (!STREQ(header->magic, GHASH_MMAP_MAGIC) ||
+		header->version != GHASH_MMAP_VERSION ||
+		header->byte_order != GHASH_MMAP_BYTE_ORDER) {
+		return false;
+	}
+	if ((header->key_type != GHASH_MMAP_KEY_STR &&
+		 header->key_type != GHASH_MMAP_KEY_INT) ||
+		(header->val_type != GHASH_MMAP_VAL_INT &&
+		 header->val_type != GHASH_MMAP_VAL_STR)) {
+		return false;
+	}
+	if (header->nbuckets == 0 ||
+		(header->nbuckets & (header->nbuckets - 1)) != 0) {
+		return false;
+	}
+	/* Every section has to fit, the checks are ordered like the layout. */
+	const uint64_t buckets_size =
+		sizeof(uint32_t) * ((uint64_t)header->nbuckets + 1);
+	const uint64_t entries_size =
+		sizeof(GHashMMapEntry) * (uint64_t)header->nentries;
+	if (header->buckets_offset < sizeof(GHashMMapHeader) ||
+		header->entries_offset < header->buckets_offset + buckets_size ||
+		header->strings_offset < header->entries_offset + entries_size ||
+		header->strings_offset + header->strings_size > size) {
+		return false;
+	}
+
+	const char *bytes = data;
+	const uint32_t *buckets = (const uint32_t *)(bytes + header->buckets_offset);
+	if (buckets[header->nbuckets] != header->nentries) {
+		return false;
+	}
+
+	r_map->data = data;
+	r_map->size = size;
+	r_map->buckets = buckets;
+	r_map->entries = (const GHashMMapEntry *)(bytes + header->entries_offset);
+	r_map->strings = bytes + header->strings_offset;
+	r_map->nentries = header->nentries;
+	r_map->bucket_mask = header->nbuckets - 1;
+	r_map->key_type = header->key_type;
+	r_map->val_type = header->val_type;
+	return true;
+}
+
+bool GLU_ghash_mmap_file_open(GHashMMap *r_map, const char *filepath)
+{
+	const void *data = NULL;
+	size_t size = 0;
+
+	memset(r_map, 0, sizeof(*r_map));
+
+#ifdef WIN32
+	HANDLE file = CreateFileA(filepath,
+							  GENERIC_READ,
+							  FILE_SHARE_READ,
+							  NULL,
+							  OPEN_EXISTING,
+							  FILE_ATTRIBUTE_NORMAL,
+							  NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER file_size;
+	if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+		HANDLE mapping =
+			CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping != NULL) {
+			/* The view keeps the mapping alive. */
+			data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			size = (size_t)file_size.QuadPart;
+			CloseHandle(mapping);
+		}
+	}
+	CloseHandle(file);
+#else
+	int file = open(filepath, O_RDONLY);
+	if (file == -1) {
+		return false;
+	}
+	struct stat st;
+	if (fstat(file, &st) == 0 && st.st_size > 0) {
+		void *mapped = mmap(
+			NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (mapped != MAP_FAILED) {
+			data = mapped;
+			size = (size_t)st.st_size;
+		}
+	}
+	close(file);
+#endif
+
+	if (data == NULL) {
+		return false;
+	}
+	if (!GLU_ghash_mmap_init(r_map, data, size)) {
+		r_map->data = data;
+		r_map->size = size;
+		r_map->is_file = true;
+		GLU_ghash_mmap_file_close(r_map);
+		return false;
+	}
+	r_map->is_file = true;
+	return true;
+}
+
+void GLU_ghash_mmap_file_close(GHashMMap *map)
+{
+	if (map->is_file) {
+#ifdef WIN32
+		UnmapViewOfFile(map->data);
+#else
+		munmap((void *)map->data, map->size);
+#endif
+	}
+	memset(map, 0, sizeof(*map));
+}
+
+static const GHashMMapEntry *ghash_mmap_lookup_entry(const GHashMMap *map,
+													 const void *key)
+{
+	if (map->nentries == 0) {
+		return NULL;
+	}
+
+	const unsigned int hash = ghash_mmap_keyhash(map->key_type, key);
+	const unsigned int bucket_index = hash & map->bucket_mask;
+	const GHashMMapEntry *entry = &map->entries[map->buckets[bucket_index]];
+	const GHashMMapEntry *entry_end =
+		&map->entries[map->buckets[bucket_index + 1]];
+
+	if (map->key_type == GHASH_MMAP_KEY_STR) {
+		for (; entry != entry_end; entry++) {
+			if (entry->hash == hash &&
+				STREQ(map->strings + entry->key, (const char *)key)) {
+				return entry;
+			}
+		}
+	}
+	else {
+		const uint64_t key_int = ghash_mmap_int_write(key);
+		for (; entry != entry_end; entry++) {
+			if (entry->key == key_int) {
+				return entry;
+			}
+		}
+	}
+	return NULL;
+}
+
+LOOM_INLINE void *ghash_mmap_entry_value(const GHashMMap *map,
+										 const GHashMMapEntry *entry)
+{
+	if (map->val_type == GHASH_MMAP_VAL_STR) {
+		return (entry->val != GHASH_MMAP_NULL_OFFSET)
+				   ? (void *)(map->strings + entry->val)
+				   : NULL;
+	}
+	return ghash_mmap_int_read(entry->val);
+}
+
+void *GLU_ghash_mmap_lookup(const GHashMMap *map, const void *key)
+{
+	const GHashMMapEntry *entry = ghash_mmap_lookup_entry(map, key);
+	return entry ? ghash_mmap_entry_value(map, entry) : NULL;
+}
+
+void *GLU_ghash_mmap_lookup_default(const GHashMMap *map,
+									const void *key,
+									void *val_default)
+{
+	const GHashMMapEntry *entry = ghash_mmap_lookup_entry(map, key);
+	return entry ? ghash_mmap_entry_value(map, entry) : val_default;
+}
+
+bool GLU_ghash_mmap_haskey(const GHashMMap *map, const void *key)
+{
+	return ghash_mmap_lookup_entry(map, key) != NULL;
+}
+
+unsigned int GLU_ghash_mmap_len(const GHashMMap *map)
+{
+	return map->nentries;
+}
+
+/** \} */
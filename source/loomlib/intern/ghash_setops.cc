@@ -0,0 +1,240 @@
+#include "guardedalloc/mem_guardedalloc.h"
+
+#include "loomlib/loomlib_assert.h"
+#include "loomlib/loomlib_vector.hh"
+
+#define GHASH_INTERNAL_API
+#include "loomlib/loomlib_ghash.h"
+
+#include <algorithm>
+#include <thread>
+
+/* -------------------------------------------------------------------- */
+/** \name Structs & Constants
+ *
+ * The work of every operation is finding which keys of one set are in the
+ * other, done by #GLU_gset_internal_probe over ranges of buckets. The keys
+ * are collected first and the sets changed afterwards, so the lookups can
+ * run on several threads while the inserts and removals stay serial.
+ * \{ */
+
+#define GSET_PARALLEL_THREADS_MAX 16
+/** Sets losing more than 1 / #GSET_REBUILD_FACTOR of their keys are built
+ * again from the remaining ones, see #gset_remove_keys. */
+#define GSET_REBUILD_FACTOR 4
+
+using loom::Vector;
+
+typedef struct GSetProbeKeys {
+	Vector<void *> keys;
+	/** Collect the keys of the probed set instead of the iterated one. */
+	bool use_probe_key;
+} GSetProbeKeys;
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Internal Utility API
+ * \{ */
+
+static void gset_probe_collect_fn(void *userdata, void *key, void *probe_key)
+{
+	GSetProbeKeys *data = static_cast<GSetProbeKeys *>(userdata);
+	data->keys.Append(data->use_probe_key ? probe_key : key);
+}
+
+/**
+ * Collect the keys of \a gs that are in \a probe (or aren't, see \a found).
+ * \param use_probe_key: Collect the matching keys of \a probe instead.
+ */
+static void gset_probe_collect(const GSet *gs,
+							   const GSet *probe,
+							   const bool found,
+							   const bool use_probe_key,
+							   Vector<void *> &r_keys)
+{
+	const unsigned int nbuckets = GLU_ghash_internal_nbuckets(
+		(const GHash *)gs);
+	unsigned int nthreads = 1;
+	if (GLU_gset_len(gs) > GSET_PARALLEL_MIN) {
+		nthreads = std::clamp(std::thread::hardware_concurrency(),
+							  1u,
+							  (unsigned int)GSET_PARALLEL_THREADS_MAX);
+	}
+
+	GSetProbeKeys results[GSET_PARALLEL_THREADS_MAX];
+	std::thread threads[GSET_PARALLEL_THREADS_MAX];
+	auto probe_range = [&](const unsigned int t) {
+		const unsigned int begin = (unsigned int)((uint64_t)nbuckets * t /
+												  nthreads);
+		const unsigned int end = (unsigned int)((uint64_t)nbuckets * (t + 1) /
+												nthreads);
+		results[t].use_probe_key = use_probe_key;
+		GLU_gset_internal_probe(
+			gs, begin, end, probe, found, gset_probe_collect_fn, &results[t]);
+	};
+
+	/* The calling thread takes the first range. */
+	for (unsigned int t = 1; t < nthreads; t++) {
+		threads[t] = std::thread(probe_range, t);
+	}
+	probe_range(0);
+	for (unsigned int t = 1; t < nthreads; t++) {
+		threads[t].join();
+	}
+
+	if (nthreads == 1) {
+		r_keys = std::move(results[0].keys);
+		return;
+	}
+	size_t len = 0;
+	for (unsigned int t = 0; t < nthreads; t++) {
+		len += results[t].keys.Size();
+	}
+	r_keys.Reserve(len);
+	for (unsigned int t = 0; t < nthreads; t++) {
+		r_keys.Extend(results[t].keys.AsSpan());
+	}
+}
+
+/**
+ * Remove \a keys (keys of \a gs) from \a gs, which keeps the keys of \a gs
+ * that are (or aren't, see \a keep_found) in \a probe. Removing many keys one
+ * at a time costs more than building the set again from the ones that stay,
+ * so past a quarter of the set it's rebuilt instead.
+ */
+static void gset_remove_keys(GSet *gs,
+							 const GSet *probe,
+							 const bool keep_found,
+							 const Vector<void *> &keys,
+							 GSetKeyFreeFP keyfreefp)
+{
+	if (keys.Size() * GSET_REBUILD_FACTOR < GLU_gset_len(gs)) {
+		/* Shrinking while removing could resize the table several times,
+		 * leave it for the next insert or reserve. */
+		GHash *gh = (GHash *)gs;
+		const bool allow_shrink = GLU_ghash_internal_flag(gh) &
+								  GHASH_FLAG_ALLOW_SHRINK;
+		GLU_gset_flag_clear(gs, GHASH_FLAG_ALLOW_SHRINK);
+		for (size_t i = 0; i < keys.Size(); i++) {
+			GLU_gset_remove(gs, keys[i], keyfreefp);
+		}
+		if (allow_shrink) {
+			GLU_gset_flag_set(gs, GHASH_FLAG_ALLOW_SHRINK);
+		}
+		return;
+	}
+
+	Vector<void *> keep;
+	gset_probe_collect(gs, probe, keep_found, false, keep);
+	GLU_gset_clear_ex(gs, NULL, (unsigned int)keep.Size());
+	if (keyfreefp) {
+		for (size_t i = 0; i < keys.Size(); i++) {
+			keyfreefp(keys[i]);
+		}
+	}
+	for (size_t i = 0; i < keep.Size(); i++) {
+		GLU_gset_insert(gs, keep[i]);
+	}
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name GSet Set Operations API
+ * \{ */
+
+GSet *GLU_gset_union_new(const GSet *a, const GSet *b, const char *info)
+{
+	const GSet *large = (GLU_gset_len(a) >= GLU_gset_len(b)) ? a : b;
+	const GSet *small = (large == a) ? b : a;
+
+	/* Only the keys of the smaller set are looked up. */
+	Vector<void *> keys;
+	gset_probe_collect(small, large, false, false, keys);
+
+	GSet *gs = GLU_gset_internal_new_like(
+		large, info, GLU_gset_len(large) + (unsigned int)keys.Size());
+	GSET_FOREACH_BEGIN (void *, key, (GSet *)large) {
+		GLU_gset_insert(gs, key);
+	}
+	GSET_FOREACH_END();
+	for (size_t i = 0; i < keys.Size(); i++) {
+		GLU_gset_insert(gs, keys[i]);
+	}
+	return gs;
+}
+
+GSet *GLU_gset_intersect_new(const GSet *a, const GSet *b, const char *info)
+{
+	Vector<void *> keys;
+	if (GLU_gset_len(a) <= GLU_gset_len(b)) {
+		gset_probe_collect(a, b, true, false, keys);
+	}
+	else {
+		gset_probe_collect(b, a, true, true, keys);
+	}
+
+	GSet *gs = GLU_gset_internal_new_like(a, info, (unsigned int)keys.Size());
+	for (size_t i = 0; i < keys.Size(); i++) {
+		GLU_gset_insert(gs, keys[i]);
+	}
+	return gs;
+}
+
+GSet *GLU_gset_difference_new(const GSet *a, const GSet *b, const char *info)
+{
+	/* Every key of the result has to be inserted, iterating \a a finds them
+	 * directly whichever set is smaller. */
+	Vector<void *> keys;
+	gset_probe_collect(a, b, false, false, keys);
+
+	GSet *gs = GLU_gset_internal_new_like(a, info, (unsigned int)keys.Size());
+	for (size_t i = 0; i < keys.Size(); i++) {
+		GLU_gset_insert(gs, keys[i]);
+	}
+	return gs;
+}
+
+void GLU_gset_union(GSet *a, const GSet *b)
+{
+	Vector<void *> keys;
+	gset_probe_collect(b, a, false, false, keys);
+
+	GLU_gset_reserve(a, GLU_gset_len(a) + (unsigned int)keys.Size());
+	for (size_t i = 0; i < keys.Size(); i++) {
+		GLU_gset_insert(a, keys[i]);
+	}
+}
+
+void GLU_gset_intersect(GSet *a, const GSet *b, GSetKeyFreeFP keyfreefp)
+{
+	Vector<void *> keys;
+	if (keyfreefp == NULL && GLU_gset_len(b) < GLU_gset_len(a)) {
+		/* Only the keys that stay are needed, build \a a again from them. */
+		gset_probe_collect(b, a, true, true, keys);
+
+		GLU_gset_clear_ex(a, NULL, (unsigned int)keys.Size());
+		for (size_t i = 0; i < keys.Size(); i++) {
+			GLU_gset_insert(a, keys[i]);
+		}
+		return;
+	}
+
+	gset_probe_collect(a, b, false, false, keys);
+	gset_remove_keys(a, b, true, keys, keyfreefp);
+}
+
+void GLU_gset_difference(GSet *a, const GSet *b, GSetKeyFreeFP keyfreefp)
+{
+	Vector<void *> keys;
+	if (GLU_gset_len(b) <= GLU_gset_len(a)) {
+		gset_probe_collect(b, a, true, true, keys);
+	}
+	else {
+		gset_probe_collect(a, b, true, false, keys);
+	}
+	gset_remove_keys(a, b, false, keys, keyfreefp);
+}
+
+/** \} */
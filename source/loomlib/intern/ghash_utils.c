@@ -2,8 +2,11 @@
 
 #include "loomlib/loomlib_ghash.h"
 #include "loomlib/loomlib_hash_mm2a.h"
+#include "loomlib/loomlib_hash_xxh3.h"
 #include "loomlib/loomlib_utildefines.h"
 
+#include <limits.h>
+#include <stdint.h>
 #include <string.h>
 
 /* -------------------------------------------------------------------- */
@@ -14,12 +17,18 @@ unsigned int GLU_ghashutil_ptrhash(const void *key)
 {
 	/* Based Python3.7's pointer hashing function. */
 
-	unsigned int y = (unsigned int)key;
+	uintptr_t p = (uintptr_t)key;
+#if UINTPTR_MAX > UINT_MAX
+	/* Fold the upper bits in, otherwise pointers that only differ above bit
+	 * 32 (separate heap arenas, mapped files) collide. */
+	p ^= p >> 32;
+#endif
+	unsigned int y = (unsigned int)p;
 	/* bottom 3 or 4 bits are likely to be 0; rotate y by 4 to avoid
 	 * excessive hash collisions for dictionaries and sets */
 
 	/* NOTE: Unlike Python `sizeof(uint)` is used instead of `sizeof(void *)`,
-	 * Otherwise casting to 'uint' ignores the upper bits on 64bit platforms. */
+	 * the pointer has been folded into 32 bits above. */
 	return (unsigned int)(y >> 4) |
 		   ((unsigned int)y << (sizeof(unsigned int[8]) - 4));
 }
@@ -82,6 +91,14 @@ unsigned int GLU_ghashutil_inthash_p_murmur(const void *ptr)
 	return GLU_hash_mm2((const unsigned char *)&key, sizeof(key), 0);
 }
 
+unsigned int GLU_ghashutil_inthash_p_xxh3(const void *ptr)
+{
+	uint64_t key = (uint64_t)(uintptr_t)ptr;
+
+	return (unsigned int)GLU_hash_xxh3_64(
+		(const unsigned char *)&key, sizeof(key), 0);
+}
+
 unsigned int GLU_ghashutil_inthash_p_simple(const void *ptr)
 {
 	return POINTER_AS_UINT(ptr);
@@ -129,6 +146,13 @@ unsigned int GLU_ghashutil_strhash_p_murmur(const void *ptr)
 	return GLU_hash_mm2(key, strlen((const char *)key) + 1, 0);
 }
 
+unsigned int GLU_ghashutil_strhash_p_xxh3(const void *ptr)
+{
+	const unsigned char *key = ptr;
+
+	return (unsigned int)GLU_hash_xxh3_64(key, strlen((const char *)key), 0);
+}
+
 bool GLU_ghashutil_strcmp(const void *a, const void *b)
 {
 	return (a == b) ? false : !STREQ(a, b);
@@ -0,0 +1,802 @@
+#include "loomlib/loomlib_assert.h"
+#include "loomlib/loomlib_hash_xxh3.h"
+
+#include <string.h>
+
+#if defined(__AVX2__)
+#	include <immintrin.h>
+#	define XXH3_USE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	include <emmintrin.h>
+#	define XXH3_USE_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#	include <stdlib.h>
+#	if defined(_M_X64)
+#		include <intrin.h>
+#	endif
+#endif
+
+/* -------------------------------------------------------------------- */
+/** \name Constants
+ * \{ */
+
+#define PRIME32_1 0x9E3779B1U
+#define PRIME32_2 0x85EBCA77U
+#define PRIME32_3 0xC2B2AE3DU
+
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+
+#define PRIME_MX1 0x165667919E3779F9ULL
+#define PRIME_MX2 0x9FB21C651E98DF25ULL
+
+#define XXH3_SECRET_SIZE 192
+#define XXH3_SECRET_SIZE_MIN 136
+#define XXH3_STRIPE_LEN 64
+#define XXH3_SECRET_CONSUME_RATE 8
+#define XXH3_SECRET_LASTACC_START 7
+#define XXH3_SECRET_MERGEACCS_START 11
+#define XXH3_MIDSIZE_MAX 240
+#define XXH3_MIDSIZE_STARTOFFSET 3
+#define XXH3_MIDSIZE_LASTOFFSET 17
+/* Stripes per block (each stripe consumes 8 more bytes of secret). */
+#define XXH3_BLOCK_STRIPES \
+	((XXH3_SECRET_SIZE - XXH3_STRIPE_LEN) / XXH3_SECRET_CONSUME_RATE)
+#define XXH3_BUFFER_SIZE 256
+#define XXH3_BUFFER_STRIPES (XXH3_BUFFER_SIZE / XXH3_STRIPE_LEN)
+
+LOOM_STATIC_ASSERT(sizeof(((HashXXH3 *)NULL)->secret) == XXH3_SECRET_SIZE,
+				   "Invalid secret size");
+LOOM_STATIC_ASSERT(sizeof(((HashXXH3 *)NULL)->buffer) == XXH3_BUFFER_SIZE,
+				   "Invalid buffer size");
+
+static const unsigned char xxh3_secret_default[XXH3_SECRET_SIZE] = {
+	0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c,
+	0xf7, 0x21, 0xad, 0x1c, 0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb,
+	0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f, 0xcb, 0x79, 0xe6, 0x4e,
+	0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+	0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6,
+	0x81, 0x3a, 0x26, 0x4c, 0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb,
+	0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3, 0x71, 0x64, 0x48, 0x97,
+	0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+	0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7,
+	0xc7, 0x0b, 0x4f, 0x1d, 0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31,
+	0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64, 0xea, 0xc5, 0xac, 0x83,
+	0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+	0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26,
+	0x29, 0xd4, 0x68, 0x9e, 0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc,
+	0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce, 0x45, 0xcb, 0x3a, 0x8f,
+	0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Integer Utilities
+ * \{ */
+
+LOOM_INLINE uint32_t xxh_swap32(uint32_t x)
+{
+#if defined(_MSC_VER)
+	return _byteswap_ulong(x);
+#elif defined(__GNUC__)
+	return __builtin_bswap32(x);
+#else
+	return ((x << 24) & 0xff000000) | ((x << 8) & 0x00ff0000) |
+		   ((x >> 8) & 0x0000ff00) | ((x >> 24) & 0x000000ff);
+#endif
+}
+
+LOOM_INLINE uint64_t xxh_swap64(uint64_t x)
+{
+#if defined(_MSC_VER)
+	return _byteswap_uint64(x);
+#elif defined(__GNUC__)
+	return __builtin_bswap64(x);
+#else
+	return ((uint64_t)xxh_swap32((uint32_t)x) << 32) |
+		   xxh_swap32((uint32_t)(x >> 32));
+#endif
+}
+
+LOOM_INLINE uint32_t xxh_read32(const unsigned char *p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+#ifdef __BIG_ENDIAN__
+	v = xxh_swap32(v);
+#endif
+	return v;
+}
+
+LOOM_INLINE uint64_t xxh_read64(const unsigned char *p)
+{
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+#ifdef __BIG_ENDIAN__
+	v = xxh_swap64(v);
+#endif
+	return v;
+}
+
+LOOM_INLINE void xxh_write64(unsigned char *p, uint64_t v)
+{
+#ifdef __BIG_ENDIAN__
+	v = xxh_swap64(v);
+#endif
+	memcpy(p, &v, sizeof(v));
+}
+
+LOOM_INLINE uint64_t xxh_rotl64(uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+LOOM_INLINE Hash128 xxh_mul128(uint64_t a, uint64_t b)
+{
+	Hash128 r;
+#if defined(__SIZEOF_INT128__)
+	const unsigned __int128 product = (unsigned __int128)a * b;
+	r.low = (uint64_t)product;
+	r.high = (uint64_t)(product >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+	r.low = _umul128(a, b, &r.high);
+#else
+	const uint64_t lo_lo = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+	const uint64_t hi_lo = (a >> 32) * (b & 0xFFFFFFFF);
+	const uint64_t lo_hi = (a & 0xFFFFFFFF) * (b >> 32);
+	const uint64_t hi_hi = (a >> 32) * (b >> 32);
+	const uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+	r.high = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+	r.low = (cross << 32) | (lo_lo & 0xFFFFFFFF);
+#endif
+	return r;
+}
+
+LOOM_INLINE uint64_t xxh_mul128_fold64(uint64_t a, uint64_t b)
+{
+	const Hash128 product = xxh_mul128(a, b);
+	return product.low ^ product.high;
+}
+
+LOOM_INLINE uint64_t xxh64_avalanche(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= PRIME64_2;
+	h ^= h >> 29;
+	h *= PRIME64_3;
+	h ^= h >> 32;
+	return h;
+}
+
+LOOM_INLINE uint64_t xxh3_avalanche(uint64_t h)
+{
+	h ^= h >> 37;
+	h *= PRIME_MX1;
+	h ^= h >> 32;
+	return h;
+}
+
+LOOM_INLINE uint64_t xxh3_rrmxmx(uint64_t h, uint64_t len)
+{
+	h ^= xxh_rotl64(h, 49) ^ xxh_rotl64(h, 24);
+	h *= PRIME_MX2;
+	h ^= (h >> 35) + len;
+	h *= PRIME_MX2;
+	return h ^ (h >> 28);
+}
+
+LOOM_INLINE uint64_t xxh3_mix16(const unsigned char *data,
+								const unsigned char *secret,
+								uint64_t seed)
+{
+	return xxh_mul128_fold64(xxh_read64(data) ^ (xxh_read64(secret) + seed),
+							 xxh_read64(data + 8) ^
+								 (xxh_read64(secret + 8) - seed));
+}
+
+LOOM_INLINE Hash128 xxh3_mix32(Hash128 acc,
+							   const unsigned char *data_a,
+							   const unsigned char *data_b,
+							   const unsigned char *secret,
+							   uint64_t seed)
+{
+	acc.low += xxh3_mix16(data_a, secret, seed);
+	acc.low ^= xxh_read64(data_b) + xxh_read64(data_b + 8);
+	acc.high += xxh3_mix16(data_b, secret + 16, seed);
+	acc.high ^= xxh_read64(data_a) + xxh_read64(data_a + 8);
+	return acc;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Long Input Accumulation
+ *
+ * Inputs larger than #XXH3_MIDSIZE_MAX are consumed in 64 byte stripes by
+ * eight 64 bit lanes, this is where the vector paths are.
+ * \{ */
+
+static void xxh3_accumulate(uint64_t acc[8],
+							const unsigned char *data,
+							const unsigned char *secret,
+							size_t nstripes)
+{
+#if defined(XXH3_USE_AVX2)
+	__m256i xacc[2];
+	xacc[0] = _mm256_loadu_si256((const __m256i *)acc);
+	xacc[1] = _mm256_loadu_si256((const __m256i *)(acc + 4));
+	for (size_t n = 0; n < nstripes; n++) {
+		const unsigned char *stripe = data + n * XXH3_STRIPE_LEN;
+		const unsigned char *key = secret + n * XXH3_SECRET_CONSUME_RATE;
+		for (int i = 0; i < 2; i++) {
+			const __m256i data_vec =
+				_mm256_loadu_si256((const __m256i *)(stripe + 32 * i));
+			const __m256i key_vec =
+				_mm256_loadu_si256((const __m256i *)(key + 32 * i));
+			const __m256i data_key = _mm256_xor_si256(data_vec, key_vec);
+			const __m256i data_key_lo = _mm256_srli_epi64(data_key, 32);
+			const __m256i product = _mm256_mul_epu32(data_key, data_key_lo);
+			/* Lanes are swapped in pairs, `acc[i ^ 1] += data[i]`. */
+			const __m256i data_swap =
+				_mm256_shuffle_epi32(data_vec, _MM_SHUFFLE(1, 0, 3, 2));
+			xacc[i] = _mm256_add_epi64(_mm256_add_epi64(xacc[i], data_swap),
+									   product);
+		}
+	}
+	_mm256_storeu_si256((__m256i *)acc, xacc[0]);
+	_mm256_storeu_si256((__m256i *)(acc + 4), xacc[1]);
+#elif defined(XXH3_USE_SSE2)
+	__m128i xacc[4];
+	for (int i = 0; i < 4; i++) {
+		xacc[i] = _mm_loadu_si128((const __m128i *)(acc + 2 * i));
+	}
+	for (size_t n = 0; n < nstripes; n++) {
+		const unsigned char *stripe = data + n * XXH3_STRIPE_LEN;
+		const unsigned char *key = secret + n * XXH3_SECRET_CONSUME_RATE;
+		for (int i = 0; i < 4; i++) {
+			const __m128i data_vec =
+				_mm_loadu_si128((const __m128i *)(stripe + 16 * i));
+			const __m128i key_vec =
+				_mm_loadu_si128((const __m128i *)(key + 16 * i));
+			const __m128i data_key = _mm_xor_si128(data_vec, key_vec);
+			const __m128i data_key_lo =
+				_mm_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1));
+			const __m128i product = _mm_mul_epu32(data_key, data_key_lo);
+			const __m128i data_swap =
+				_mm_shuffle_epi32(data_vec, _MM_SHUFFLE(1, 0, 3, 2));
+			xacc[i] =
+				_mm_add_epi64(_mm_add_epi64(xacc[i], data_swap), product);
+		}
+	}
+	for (int i = 0; i < 4; i++) {
+		_mm_storeu_si128((__m128i *)(acc + 2 * i), xacc[i]);
+	}
+#else
+	for (size_t n = 0; n < nstripes; n++) {
+		const unsigned char *stripe = data + n * XXH3_STRIPE_LEN;
+		const unsigned char *key = secret + n * XXH3_SECRET_CONSUME_RATE;
+		for (int i = 0; i < 8; i++) {
+			const uint64_t data_val = xxh_read64(stripe + 8 * i);
+			const uint64_t data_key = data_val ^ xxh_read64(key + 8 * i);
+			acc[i ^ 1] += data_val;
+			acc[i] += (data_key & 0xFFFFFFFF) * (data_key >> 32);
+		}
+	}
+#endif
+}
+
+static void xxh3_scramble(uint64_t acc[8], const unsigned char *secret)
+{
+#if defined(XXH3_USE_AVX2)
+	const __m256i prime32 = _mm256_set1_epi32((int)PRIME32_1);
+	for (int i = 0; i < 2; i++) {
+		__m256i acc_vec = _mm256_loadu_si256((const __m256i *)(acc + 4 * i));
+		acc_vec = _mm256_xor_si256(acc_vec, _mm256_srli_epi64(acc_vec, 47));
+		const __m256i data_key = _mm256_xor_si256(
+			acc_vec, _mm256_loadu_si256((const __m256i *)(secret + 32 * i)));
+		const __m256i data_key_hi = _mm256_srli_epi64(data_key, 32);
+		const __m256i prod_lo = _mm256_mul_epu32(data_key, prime32);
+		const __m256i prod_hi = _mm256_mul_epu32(data_key_hi, prime32);
+		_mm256_storeu_si256(
+			(__m256i *)(acc + 4 * i),
+			_mm256_add_epi64(prod_lo, _mm256_slli_epi64(prod_hi, 32)));
+	}
+#elif defined(XXH3_USE_SSE2)
+	const __m128i prime32 = _mm_set1_epi32((int)PRIME32_1);
+	for (int i = 0; i < 4; i++) {
+		__m128i acc_vec = _mm_loadu_si128((const __m128i *)(acc + 2 * i));
+		acc_vec = _mm_xor_si128(acc_vec, _mm_srli_epi64(acc_vec, 47));
+		const __m128i data_key = _mm_xor_si128(
+			acc_vec, _mm_loadu_si128((const __m128i *)(secret + 16 * i)));
+		const __m128i data_key_hi =
+			_mm_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1));
+		const __m128i prod_lo = _mm_mul_epu32(data_key, prime32);
+		const __m128i prod_hi = _mm_mul_epu32(data_key_hi, prime32);
+		_mm_storeu_si128((__m128i *)(acc + 2 * i),
+						 _mm_add_epi64(prod_lo, _mm_slli_epi64(prod_hi, 32)));
+	}
+#else
+	for (int i = 0; i < 8; i++) {
+		uint64_t acc64 = acc[i];
+		acc64 ^= acc64 >> 47;
+		acc64 ^= xxh_read64(secret + 8 * i);
+		acc64 *= PRIME32_1;
+		acc[i] = acc64;
+	}
+#endif
+}
+
+static void xxh3_acc_init(uint64_t acc[8])
+{
+	acc[0] = PRIME32_3;
+	acc[1] = PRIME64_1;
+	acc[2] = PRIME64_2;
+	acc[3] = PRIME64_3;
+	acc[4] = PRIME64_4;
+	acc[5] = PRIME32_2;
+	acc[6] = PRIME64_5;
+	acc[7] = PRIME32_1;
+}
+
+/**
+ * Accumulate \a nstripes, scrambling whenever a block of secret is used up.
+ * \a r_stripes is the stripe position in the current block.
+ * \return The end of the consumed data.
+ */
+static const unsigned char *xxh3_consume_stripes(uint64_t acc[8],
+												 uint32_t *r_stripes,
+												 const unsigned char *data,
+												 size_t nstripes,
+												 const unsigned char *secret)
+{
+	while (nstripes >= XXH3_BLOCK_STRIPES - *r_stripes) {
+		const size_t n = XXH3_BLOCK_STRIPES - *r_stripes;
+		xxh3_accumulate(
+			acc, data, secret + *r_stripes * XXH3_SECRET_CONSUME_RATE, n);
+		xxh3_scramble(acc, secret + XXH3_SECRET_SIZE - XXH3_STRIPE_LEN);
+		data += n * XXH3_STRIPE_LEN;
+		nstripes -= n;
+		*r_stripes = 0;
+	}
+	if (nstripes) {
+		xxh3_accumulate(
+			acc, data, secret + *r_stripes * XXH3_SECRET_CONSUME_RATE, nstripes);
+		data += nstripes * XXH3_STRIPE_LEN;
+		*r_stripes += (uint32_t)nstripes;
+	}
+	return data;
+}
+
+static void xxh3_hash_long(uint64_t acc[8],
+						   const unsigned char *data,
+						   size_t len,
+						   const unsigned char *secret)
+{
+	uint32_t stripes = 0;
+
+	xxh3_acc_init(acc);
+	/* Keep the last (partial) stripe, it is always mixed in by itself. */
+	xxh3_consume_stripes(
+		acc, &stripes, data, (len - 1) / XXH3_STRIPE_LEN, secret);
+	xxh3_accumulate(acc,
+					data + len - XXH3_STRIPE_LEN,
+					secret + XXH3_SECRET_SIZE - XXH3_STRIPE_LEN -
+						XXH3_SECRET_LASTACC_START,
+					1);
+}
+
+static uint64_t xxh3_merge_accs(const uint64_t acc[8],
+								const unsigned char *secret,
+								uint64_t start)
+{
+	uint64_t result = start;
+	for (int i = 0; i < 4; i++) {
+		result += xxh_mul128_fold64(acc[2 * i] ^ xxh_read64(secret + 16 * i),
+									acc[2 * i + 1] ^
+										xxh_read64(secret + 16 * i + 8));
+	}
+	return xxh3_avalanche(result);
+}
+
+LOOM_INLINE uint64_t xxh3_long_end_64(const uint64_t acc[8],
+									  const unsigned char *secret,
+									  uint64_t len)
+{
+	return xxh3_merge_accs(
+		acc, secret + XXH3_SECRET_MERGEACCS_START, len * PRIME64_1);
+}
+
+LOOM_INLINE Hash128 xxh3_long_end_128(const uint64_t acc[8],
+									  const unsigned char *secret,
+									  uint64_t len)
+{
+	Hash128 h;
+	h.low = xxh3_merge_accs(
+		acc, secret + XXH3_SECRET_MERGEACCS_START, len * PRIME64_1);
+	h.high = xxh3_merge_accs(acc,
+							 secret + XXH3_SECRET_SIZE - XXH3_STRIPE_LEN -
+								 XXH3_SECRET_MERGEACCS_START,
+							 ~(len * PRIME64_2));
+	return h;
+}
+
+static void xxh3_init_secret(unsigned char secret[XXH3_SECRET_SIZE],
+							 uint64_t seed)
+{
+	for (int i = 0; i < XXH3_SECRET_SIZE / 16; i++) {
+		xxh_write64(secret + 16 * i,
+					xxh_read64(xxh3_secret_default + 16 * i) + seed);
+		xxh_write64(secret + 16 * i + 8,
+					xxh_read64(xxh3_secret_default + 16 * i + 8) - seed);
+	}
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name 64 bit Hash
+ * \{ */
+
+static uint64_t xxh3_64_short(const unsigned char *data,
+							  size_t len,
+							  uint64_t seed)
+{
+	const unsigned char *secret = xxh3_secret_default;
+
+	if (len > 8) {
+		const uint64_t bitflip1 =
+			(xxh_read64(secret + 24) ^ xxh_read64(secret + 32)) + seed;
+		const uint64_t bitflip2 =
+			(xxh_read64(secret + 40) ^ xxh_read64(secret + 48)) - seed;
+		const uint64_t lo = xxh_read64(data) ^ bitflip1;
+		const uint64_t hi = xxh_read64(data + len - 8) ^ bitflip2;
+		return xxh3_avalanche(len + xxh_swap64(lo) + hi +
+							  xxh_mul128_fold64(lo, hi));
+	}
+	if (len >= 4) {
+		seed ^= (uint64_t)xxh_swap32((uint32_t)seed) << 32;
+		const uint64_t bitflip =
+			(xxh_read64(secret + 8) ^ xxh_read64(secret + 16)) - seed;
+		const uint64_t input = xxh_read32(data + len - 4) +
+							   ((uint64_t)xxh_read32(data) << 32);
+		return xxh3_rrmxmx(input ^ bitflip, len);
+	}
+	if (len > 0) {
+		const uint32_t combined =
+			((uint32_t)data[0] << 16) | ((uint32_t)data[len >> 1] << 24) |
+			((uint32_t)data[len - 1] << 0) | ((uint32_t)len << 8);
+		const uint64_t bitflip =
+			(xxh_read32(secret) ^ xxh_read32(secret + 4)) + seed;
+		return xxh64_avalanche((uint64_t)combined ^ bitflip);
+	}
+	return xxh64_avalanche(seed ^ xxh_read64(secret + 56) ^
+						   xxh_read64(secret + 64));
+}
+
+static uint64_t xxh3_64_mid(const unsigned char *data,
+							size_t len,
+							uint64_t seed)
+{
+	const unsigned char *secret = xxh3_secret_default;
+	uint64_t acc = len * PRIME64_1;
+
+	if (len <= 128) {
+		if (len > 32) {
+			if (len > 64) {
+				if (len > 96) {
+					acc += xxh3_mix16(data + 48, secret + 96, seed);
+					acc += xxh3_mix16(data + len - 64, secret + 112, seed);
+				}
+				acc += xxh3_mix16(data + 32, secret + 64, seed);
+				acc += xxh3_mix16(data + len - 48, secret + 80, seed);
+			}
+			acc += xxh3_mix16(data + 16, secret + 32, seed);
+			acc += xxh3_mix16(data + len - 32, secret + 48, seed);
+		}
+		acc += xxh3_mix16(data, secret, seed);
+		acc += xxh3_mix16(data + len - 16, secret + 16, seed);
+		return xxh3_avalanche(acc);
+	}
+
+	const size_t nrounds = len / 16;
+	for (size_t i = 0; i < 8; i++) {
+		acc += xxh3_mix16(data + 16 * i, secret + 16 * i, seed);
+	}
+	acc = xxh3_avalanche(acc);
+	for (size_t i = 8; i < nrounds; i++) {
+		acc += xxh3_mix16(data + 16 * i,
+						  secret + 16 * (i - 8) + XXH3_MIDSIZE_STARTOFFSET,
+						  seed);
+	}
+	acc += xxh3_mix16(data + len - 16,
+					  secret + XXH3_SECRET_SIZE_MIN - XXH3_MIDSIZE_LASTOFFSET,
+					  seed);
+	return xxh3_avalanche(acc);
+}
+
+uint64_t GLU_hash_xxh3_64(const unsigned char *data, size_t len, uint64_t seed)
+{
+	if (len <= 16) {
+		return xxh3_64_short(data, len, seed);
+	}
+	if (len <= XXH3_MIDSIZE_MAX) {
+		return xxh3_64_mid(data, len, seed);
+	}
+
+	uint64_t acc[8];
+	if (seed == 0) {
+		xxh3_hash_long(acc, data, len, xxh3_secret_default);
+		return xxh3_long_end_64(acc, xxh3_secret_default, len);
+	}
+	unsigned char secret[XXH3_SECRET_SIZE];
+	xxh3_init_secret(secret, seed);
+	xxh3_hash_long(acc, data, len, secret);
+	return xxh3_long_end_64(acc, secret, len);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name 128 bit Hash
+ * \{ */
+
+static Hash128 xxh3_128_short(const unsigned char *data,
+							  size_t len,
+							  uint64_t seed)
+{
+	const unsigned char *secret = xxh3_secret_default;
+	Hash128 h;
+
+	if (len > 8) {
+		const uint64_t bitflipl =
+			(xxh_read64(secret + 32) ^ xxh_read64(secret + 40)) - seed;
+		const uint64_t bitfliph =
+			(xxh_read64(secret + 48) ^ xxh_read64(secret + 56)) + seed;
+		const uint64_t lo = xxh_read64(data);
+		uint64_t hi = xxh_read64(data + len - 8);
+		Hash128 m = xxh_mul128(lo ^ hi ^ bitflipl, PRIME64_1);
+		m.low += (uint64_t)(len - 1) << 54;
+		hi ^= bitfliph;
+		m.high += hi + (hi & 0xFFFFFFFF) * (PRIME32_2 - 1);
+		m.low ^= xxh_swap64(m.high);
+		h = xxh_mul128(m.low, PRIME64_2);
+		h.high += m.high * PRIME64_2;
+		h.low = xxh3_avalanche(h.low);
+		h.high = xxh3_avalanche(h.high);
+		return h;
+	}
+	if (len >= 4) {
+		seed ^= (uint64_t)xxh_swap32((uint32_t)seed) << 32;
+		const uint64_t input = xxh_read32(data) +
+							   ((uint64_t)xxh_read32(data + len - 4) << 32);
+		const uint64_t bitflip =
+			(xxh_read64(secret + 16) ^ xxh_read64(secret + 24)) + seed;
+		Hash128 m = xxh_mul128(input ^ bitflip, PRIME64_1 + (len << 2));
+		m.high += m.low << 1;
+		m.low ^= m.high >> 3;
+		m.low ^= m.low >> 35;
+		m.low *= PRIME_MX2;
+		m.low ^= m.low >> 28;
+		m.high = xxh3_avalanche(m.high);
+		return m;
+	}
+	if (len > 0) {
+		const uint32_t combinedl =
+			((uint32_t)data[0] << 16) | ((uint32_t)data[len >> 1] << 24) |
+			((uint32_t)data[len - 1] << 0) | ((uint32_t)len << 8);
+		const uint32_t swapped = xxh_swap32(combinedl);
+		const uint32_t combinedh = (swapped << 13) | (swapped >> 19);
+		const uint64_t bitflipl =
+			(xxh_read32(secret) ^ xxh_read32(secret + 4)) + seed;
+		const uint64_t bitfliph =
+			(xxh_read32(secret + 8) ^ xxh_read32(secret + 12)) - seed;
+		h.low = xxh64_avalanche((uint64_t)combinedl ^ bitflipl);
+		h.high = xxh64_avalanche((uint64_t)combinedh ^ bitfliph);
+		return h;
+	}
+	h.low = xxh64_avalanche(seed ^ xxh_read64(secret + 64) ^
+							xxh_read64(secret + 72));
+	h.high = xxh64_avalanche(seed ^ xxh_read64(secret + 80) ^
+							 xxh_read64(secret + 88));
+	return h;
+}
+
+static Hash128 xxh3_128_mid(const unsigned char *data,
+							size_t len,
+							uint64_t seed)
+{
+	const unsigned char *secret = xxh3_secret_default;
+	Hash128 acc;
+	acc.low = len * PRIME64_1;
+	acc.high = 0;
+
+	if (len <= 128) {
+		if (len > 32) {
+			if (len > 64) {
+				if (len > 96) {
+					acc = xxh3_mix32(
+						acc, data + 48, data + len - 64, secret + 96, seed);
+				}
+				acc = xxh3_mix32(
+					acc, data + 32, data + len - 48, secret + 64, seed);
+			}
+			acc = xxh3_mix32(acc, data + 16, data + len - 32, secret + 32, seed);
+		}
+		acc = xxh3_mix32(acc, data, data + len - 16, secret, seed);
+	}
+	else {
+		const size_t nrounds = len / 32;
+		for (size_t i = 0; i < 4; i++) {
+			acc = xxh3_mix32(
+				acc, data + 32 * i, data + 32 * i + 16, secret + 32 * i, seed);
+		}
+		acc.low = xxh3_avalanche(acc.low);
+		acc.high = xxh3_avalanche(acc.high);
+		for (size_t i = 4; i < nrounds; i++) {
+			acc = xxh3_mix32(acc,
+							 data + 32 * i,
+							 data + 32 * i + 16,
+							 secret + XXH3_MIDSIZE_STARTOFFSET + 32 * (i - 4),
+							 seed);
+		}
+		acc = xxh3_mix32(acc,
+						 data + len - 16,
+						 data + len - 32,
+						 secret + XXH3_SECRET_SIZE_MIN -
+							 XXH3_MIDSIZE_LASTOFFSET - 16,
+						 0ULL - seed);
+	}
+
+	Hash128 h;
+	h.low = xxh3_avalanche(acc.low + acc.high);
+	h.high = 0ULL - xxh3_avalanche((acc.low * PRIME64_1) +
+								   (acc.high * PRIME64_4) +
+								   ((len - seed) * PRIME64_2));
+	return h;
+}
+
+Hash128 GLU_hash_xxh3_128(const unsigned char *data, size_t len, uint64_t seed)
+{
+	if (len <= 16) {
+		return xxh3_128_short(data, len, seed);
+	}
+	if (len <= XXH3_MIDSIZE_MAX) {
+		return xxh3_128_mid(data, len, seed);
+	}
+
+	uint64_t acc[8];
+	if (seed == 0) {
+		xxh3_hash_long(acc, data, len, xxh3_secret_default);
+		return xxh3_long_end_128(acc, xxh3_secret_default, len);
+	}
+	unsigned char secret[XXH3_SECRET_SIZE];
+	xxh3_init_secret(secret, seed);
+	xxh3_hash_long(acc, data, len, secret);
+	return xxh3_long_end_128(acc, secret, len);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Streaming
+ *
+ * Data is buffered until more than #XXH3_BUFFER_SIZE bytes have been added,
+ * from then on whole stripes are accumulated as they come in. The buffer
+ * always keeps the last bytes so #GLU_hash_xxh3_end can mix the final stripe
+ * (or fall back to the one-shot hash for short inputs).
+ * \{ */
+
+void GLU_hash_xxh3_init(HashXXH3 *xxh, uint64_t seed)
+{
+	xxh3_acc_init(xxh->acc);
+	xxh3_init_secret(xxh->secret, seed);
+	xxh->seed = seed;
+	xxh->size = 0;
+	xxh->buffer_len = 0;
+	xxh->nstripes = 0;
+}
+
+void GLU_hash_xxh3_add(HashXXH3 *xxh, const unsigned char *data, size_t len)
+{
+	const unsigned char *data_end = data + len;
+
+	xxh->size += len;
+
+	if (len <= XXH3_BUFFER_SIZE - xxh->buffer_len) {
+		memcpy(xxh->buffer + xxh->buffer_len, data, len);
+		xxh->buffer_len += (uint32_t)len;
+		return;
+	}
+
+	/* There is more data than fits, so the buffer can be consumed whole. */
+	if (xxh->buffer_len) {
+		const size_t fill = XXH3_BUFFER_SIZE - xxh->buffer_len;
+		memcpy(xxh->buffer + xxh->buffer_len, data, fill);
+		data += fill;
+		xxh3_consume_stripes(xxh->acc,
+							 &xxh->nstripes,
+							 xxh->buffer,
+							 XXH3_BUFFER_STRIPES,
+							 xxh->secret);
+		xxh->buffer_len = 0;
+	}
+
+	/* Consume large inputs in place, except the last (partial) stripe. */
+	if ((size_t)(data_end - data) > XXH3_BUFFER_SIZE) {
+		const size_t nstripes =
+			(size_t)(data_end - 1 - data) / XXH3_STRIPE_LEN;
+		data = xxh3_consume_stripes(
+			xxh->acc, &xxh->nstripes, data, nstripes, xxh->secret);
+		/* Keep the previous stripe around for #GLU_hash_xxh3_end. */
+		memcpy(xxh->buffer + XXH3_BUFFER_SIZE - XXH3_STRIPE_LEN,
+			   data - XXH3_STRIPE_LEN,
+			   XXH3_STRIPE_LEN);
+	}
+
+	memcpy(xxh->buffer, data, (size_t)(data_end - data));
+	xxh->buffer_len = (uint32_t)(data_end - data);
+}
+
+void GLU_hash_xxh3_add_int(HashXXH3 *xxh, int data)
+{
+	GLU_hash_xxh3_add(xxh, (const unsigned char *)&data, sizeof(data));
+}
+
+/** Finish the stripes of a long input on a copy of the accumulators. */
+static void xxh3_end_long(const HashXXH3 *xxh, uint64_t acc[8])
+{
+	unsigned char last_stripe[XXH3_STRIPE_LEN];
+	const unsigned char *last_stripe_p;
+
+	memcpy(acc, xxh->acc, sizeof(xxh->acc));
+	if (xxh->buffer_len >= XXH3_STRIPE_LEN) {
+		uint32_t nstripes = xxh->nstripes;
+		xxh3_consume_stripes(acc,
+							 &nstripes,
+							 xxh->buffer,
+							 (xxh->buffer_len - 1) / XXH3_STRIPE_LEN,
+							 xxh->secret);
+		last_stripe_p = xxh->buffer + xxh->buffer_len - XXH3_STRIPE_LEN;
+	}
+	else {
+		/* The stripe straddles the end of the previously consumed data. */
+		const size_t catchup = XXH3_STRIPE_LEN - xxh->buffer_len;
+		memcpy(last_stripe, xxh->buffer + XXH3_BUFFER_SIZE - catchup, catchup);
+		memcpy(last_stripe + catchup, xxh->buffer, xxh->buffer_len);
+		last_stripe_p = last_stripe;
+	}
+	xxh3_accumulate(acc,
+					last_stripe_p,
+					xxh->secret + XXH3_SECRET_SIZE - XXH3_STRIPE_LEN -
+						XXH3_SECRET_LASTACC_START,
+					1);
+}
+
+uint64_t GLU_hash_xxh3_end(const HashXXH3 *xxh)
+{
+	if (xxh->size > XXH3_MIDSIZE_MAX) {
+		uint64_t acc[8];
+		xxh3_end_long(xxh, acc);
+		return xxh3_long_end_64(acc, xxh->secret, xxh->size);
+	}
+	return GLU_hash_xxh3_64(xxh->buffer, (size_t)xxh->size, xxh->seed);
+}
+
+Hash128 GLU_hash_xxh3_end_128(const HashXXH3 *xxh)
+{
+	if (xxh->size > XXH3_MIDSIZE_MAX) {
+		uint64_t acc[8];
+		xxh3_end_long(xxh, acc);
+		return xxh3_long_end_128(acc, xxh->secret, xxh->size);
+	}
+	return GLU_hash_xxh3_128(xxh->buffer, (size_t)xxh->size, xxh->seed);
+}
+
+/** \} */
@@ -1,7 +1,9 @@
 #include "guardedalloc/mem_guardedalloc.h"
 
 #include "loomlib/loomlib_assert.h"
+#include "loomlib/loomlib_ghash.h"
 #include "loomlib/loomlib_listbase.h"
+#include "loomlib/loomlib_mempool.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -811,6 +813,199 @@ void GLU_listbase_rotate_last(ListBase *lb, void *vlink)
 	((Link *)lb->last)->next = nullptr;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Sorting
+ *
+ * A bottom-up merge sort on the `next` links, `prev` is restored in one pass
+ * at the end. Sorted runs of 2^i links wait in bin `i`, each new link is
+ * merged up through the occupied bins like a binary counter increment. This
+ * needs no allocation and no counting pass, the bins hold any list that fits
+ * in memory.
+ * \{ */
+
+#define LISTBASE_SORT_BINS 64
+
+/** Merge two sorted `next` chains, \a a goes first on ties (stable). */
+template<typename Cmp> static Link *listbase_merge(Link *a, Link *b, Cmp cmp)
+{
+	Link head;
+	Link *tail = &head;
+	while (a && b) {
+		/* Merging waits on loading the links it follows, start loading the
+		 * link after the new head of either run one step ahead. */
+		if (cmp(a, b) <= 0) {
+			tail->next = a;
+			a = a->next;
+			if (a) {
+				LOOM_PREFETCH(a->next);
+			}
+		}
+		else {
+			tail->next = b;
+			b = b->next;
+			if (b) {
+				LOOM_PREFETCH(b->next);
+			}
+		}
+		tail = tail->next;
+	}
+	tail->next = a ? a : b;
+	return head.next;
+}
+
+template<typename Cmp> static void listbase_sort(ListBase *listbase, Cmp cmp)
+{
+	Link *bins[LISTBASE_SORT_BINS] = {nullptr};
+	int bins_used = 0;
+
+	if (listbase->first == listbase->last) {
+		return;
+	}
+
+	Link *link = static_cast<Link *>(listbase->first);
+	while (link) {
+		Link *next = link->next;
+		link->next = nullptr;
+
+		/* Bin `i` holds older links than the carry, merge it in first. */
+		Link *carry = link;
+		int i = 0;
+		for (; bins[i]; i++) {
+			carry = listbase_merge(bins[i], carry, cmp);
+			bins[i] = nullptr;
+		}
+		LOOM_assert(i < LISTBASE_SORT_BINS);
+		bins[i] = carry;
+		bins_used = MAX2(bins_used, i + 1);
+
+		link = next;
+	}
+
+	Link *sorted = nullptr;
+	for (int i = 0; i < bins_used; i++) {
+		if (bins[i]) {
+			sorted = sorted ? listbase_merge(bins[i], sorted, cmp) : bins[i];
+		}
+	}
+
+	Link *prev = nullptr;
+	listbase->first = sorted;
+	for (link = sorted; link; link = link->next) {
+		link->prev = prev;
+		prev = link;
+	}
+	listbase->last = prev;
+}
+
+void GLU_listbase_sort(ListBase *listbase,
+					   int (*cmp)(const void *, const void *))
+{
+	listbase_sort(listbase, cmp);
+}
+
+void GLU_listbase_sort_r(ListBase *listbase,
+						 int (*cmp)(void *, const void *, const void *),
+						 void *thunk)
+{
+	listbase_sort(listbase, [cmp, thunk](const Link *a, const Link *b) {
+		return cmp(thunk, a, b);
+	});
+}
+
+void GLU_listbase_insert_sorted(ListBase *listbase,
+								void *vlink,
+								int (*cmp)(const void *, const void *))
+{
+	Link *prevlink = static_cast<Link *>(listbase->last);
+
+	/* Links that belong at the end, the common case when adding links in
+	 * nearly sorted order, are placed without walking the list. */
+	while (prevlink && cmp(prevlink, vlink) > 0) {
+		prevlink = prevlink->prev;
+	}
+	if (prevlink) {
+		GLU_insertlinkafter(listbase, prevlink, vlink);
+	}
+	else {
+		GLU_addhead(listbase, vlink);
+	}
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Defragment
+ * \{ */
+
+void *GLU_listbase_defragment(ListBase *listbase,
+							  const size_t link_size,
+							  const bool free_links,
+							  GHash **r_old_to_new)
+{
+	LOOM_assert(link_size >= sizeof(Link));
+
+	const int len = GLU_listbase_count(listbase);
+	if (r_old_to_new) {
+		*r_old_to_new = GLU_ghash_ptr_new_ex(__func__, (unsigned int)len);
+	}
+	if (len == 0) {
+		return nullptr;
+	}
+
+	char *block = static_cast<char *>(
+		MEM_malloc_arrayN((size_t)len, link_size, __func__));
+
+	Link *link = static_cast<Link *>(listbase->first);
+	Link *prev = nullptr;
+	for (int i = 0; i < len; i++) {
+		Link *next = link->next;
+		Link *link_new = reinterpret_cast<Link *>(block + link_size * i);
+		memcpy(link_new, link, link_size);
+		link_new->prev = prev;
+		if (prev) {
+			prev->next = link_new;
+		}
+		if (r_old_to_new) {
+			GLU_ghash_insert(*r_old_to_new, link, link_new);
+		}
+		if (free_links) {
+			MEM_freeN(link);
+		}
+		prev = link_new;
+		link = next;
+	}
+	prev->next = nullptr;
+
+	listbase->first = block;
+	listbase->last = prev;
+	return block;
+}
+
+void GLU_listbase_defragment_free(ListBase *listbase, void *block)
+{
+	/* A link is in the block when its address is, the list may have been
+	 * reordered or had links removed and added since. */
+	const size_t block_size = block ? MEM_allocN_len(block) : 0;
+	const char *block_end = static_cast<const char *>(block) + block_size;
+
+	Link *link = static_cast<Link *>(listbase->first);
+	while (link) {
+		Link *next = link->next;
+		if (!((char *)link >= static_cast<char *>(block) &&
+			  (char *)link < block_end))
+		{
+			MEM_freeN(link);
+		}
+		link = next;
+	}
+	if (block) {
+		MEM_freeN(block);
+	}
+	GLU_listbase_clear(listbase);
+}
+
+/** \} */
+
 LinkData *GLU_genericNodeN(void *data)
 {
 	LinkData *ld;
@@ -825,3 +1020,64 @@ LinkData *GLU_genericNodeN(void *data)
 
 	return ld;
 }
+
+/* -------------------------------------------------------------------- */
+/** \name Pooled Generic Nodes
+ * \{ */
+
+/** Nodes per pool chunk, about 4KiB of #LinkData. */
+#define LISTBASE_NODE_POOL_CHUNK 170
+
+MemPool *GLU_genericNode_pool_create(const unsigned int nodes_reserve)
+{
+	return GLU_mempool_create(sizeof(LinkData),
+							  nodes_reserve,
+							  LISTBASE_NODE_POOL_CHUNK,
+							  LOOM_MEMPOOL_NOP);
+}
+
+LinkData *GLU_genericNode_pooled(MemPool *pool, void *data)
+{
+	if (data == nullptr) {
+		return nullptr;
+	}
+
+	LinkData *ld = static_cast<LinkData *>(GLU_mempool_alloc(pool));
+	ld->next = ld->prev = nullptr;
+	ld->data = data;
+
+	return ld;
+}
+
+LinkData *GLU_addtail_pooled(ListBase *listbase, MemPool *pool, void *data)
+{
+	LinkData *ld = GLU_genericNode_pooled(pool, data);
+	if (ld) {
+		GLU_addtail(listbase, ld);
+	}
+	return ld;
+}
+
+void GLU_freelist_pooled(ListBase *listbase, MemPool *pool)
+{
+	Link *link = static_cast<Link *>(listbase->first);
+	while (link) {
+		Link *next = link->next;
+		GLU_mempool_free(pool, link);
+		link = next;
+	}
+
+	GLU_listbase_clear(listbase);
+}
+
+void GLU_freelist_pooled_all(ListBase *listbase, MemPool *pool)
+{
+	LOOM_assert(GLU_mempool_len(pool) ==
+				(size_t)GLU_listbase_count(listbase));
+	/* Keeping every chunk would thread all their slots onto the free list
+	 * again, only the first one is kept. */
+	GLU_mempool_clear_ex(pool, 0);
+	GLU_listbase_clear(listbase);
+}
+
+/** \} */
@@ -0,0 +1,270 @@
+#include "guardedalloc/mem_guardedalloc.h"
+
+#include "loomlib/loomlib_assert.h"
+#include "loomlib/loomlib_ghash.h"
+#include "loomlib/loomlib_listbase.h"
+#include "loomlib/loomlib_listbase_index.h"
+
+#include <string.h>
+
+/* -------------------------------------------------------------------- */
+/** \name Structs & Constants
+ *
+ * Every table remembers the #ListBaseIndex.version it was built at, bumping
+ * the version makes all of them stale at once without touching them.
+ * \{ */
+
+typedef enum eListBaseIndexKeyType {
+	/** A NULL terminated string stored in the link. */
+	LB_INDEX_KEY_STRING = 0,
+	/** A pointer to a NULL terminated string. */
+	LB_INDEX_KEY_STRING_PTR = 1,
+	/** A pointer, compared by address. */
+	LB_INDEX_KEY_PTR = 2,
+} eListBaseIndexKeyType;
+
+typedef struct ListBaseIndexKey {
+	struct ListBaseIndexKey *next, *prev;
+
+	/** Key to link, the first link of equal keys. */
+	GHash *ghash;
+	int offset;
+	eListBaseIndexKeyType type;
+	unsigned int version;
+} ListBaseIndexKey;
+
+struct ListBaseIndex {
+	const ListBase *listbase;
+	unsigned int version;
+	/** The ends of the list when it was last checked, see
+	 * #listbase_index_validate. */
+	const void *first, *last;
+
+	/** The links in order, for index access. */
+	Link **links;
+	int links_len;
+	unsigned int links_version;
+
+	/** Link to index, stored in the pointer. */
+	GHash *link_indices;
+	unsigned int link_indices_version;
+
+	/** #ListBaseIndexKey, one per key type and offset looked up. */
+	ListBase keys;
+};
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Internal Utility API
+ * \{ */
+
+/** Notice links added or removed at either end of the list. */
+static void listbase_index_validate(ListBaseIndex *index)
+{
+	if (index->first != index->listbase->first ||
+		index->last != index->listbase->last)
+	{
+		index->first = index->listbase->first;
+		index->last = index->listbase->last;
+		index->version++;
+	}
+}
+
+static void listbase_index_ensure_links(ListBaseIndex *index)
+{
+	listbase_index_validate(index);
+	if (index->links_version == index->version) {
+		return;
+	}
+
+	const int len = GLU_listbase_count(index->listbase);
+	MEM_SAFE_FREE(index->links);
+	if (len) {
+		index->links = static_cast<Link **>(
+			MEM_mallocN(sizeof(*index->links) * len, __func__));
+	}
+	int i = 0;
+	LISTBASE_FOREACH (Link *, link, index->listbase) {
+		index->links[i++] = link;
+	}
+	index->links_len = len;
+	index->links_version = index->version;
+}
+
+static void listbase_index_ensure_link_indices(ListBaseIndex *index)
+{
+	listbase_index_ensure_links(index);
+	if (index->link_indices_version == index->version) {
+		return;
+	}
+
+	if (index->link_indices) {
+		GLU_ghash_clear_ex(index->link_indices, NULL, NULL, index->links_len);
+	}
+	else {
+		index->link_indices = GLU_ghash_ptr_new_ex(__func__, index->links_len);
+	}
+	for (int i = 0; i < index->links_len; i++) {
+		GLU_ghash_insert(
+			index->link_indices, index->links[i], POINTER_FROM_INT(i));
+	}
+	index->link_indices_version = index->version;
+}
+
+LOOM_INLINE const void *listbase_index_key_get(const Link *link,
+											   const int offset,
+											   const eListBaseIndexKeyType type)
+{
+	const char *member = ((const char *)link) + offset;
+	switch (type) {
+		case LB_INDEX_KEY_STRING:
+			return member;
+		case LB_INDEX_KEY_STRING_PTR:
+		case LB_INDEX_KEY_PTR:
+			return *((const void *const *)member);
+	}
+	LOOM_assert_unreachable();
+	return nullptr;
+}
+
+/** \return The table of \a type at \a offset, built for the current list. */
+static GHash *listbase_index_ensure_key(ListBaseIndex *index,
+										const int offset,
+										const eListBaseIndexKeyType type)
+{
+	listbase_index_validate(index);
+
+	ListBaseIndexKey *key = nullptr;
+	LISTBASE_FOREACH (ListBaseIndexKey *, key_iter, &index->keys) {
+		if (key_iter->offset == offset && key_iter->type == type) {
+			key = key_iter;
+			break;
+		}
+	}
+	if (key && key->version == index->version) {
+		return key->ghash;
+	}
+
+	const int len = GLU_listbase_count(index->listbase);
+	if (key == nullptr) {
+		key = MEM_cnew<ListBaseIndexKey>(__func__);
+		key->offset = offset;
+		key->type = type;
+		key->ghash = (type == LB_INDEX_KEY_PTR) ?
+						 GLU_ghash_ptr_new_ex(__func__, len) :
+						 GLU_ghash_str_new_ex(__func__, len);
+		GLU_addtail(&index->keys, key);
+	}
+	else {
+		GLU_ghash_clear_ex(key->ghash, NULL, NULL, len);
+	}
+
+	LISTBASE_FOREACH (Link *, link, index->listbase) {
+		const void *member = listbase_index_key_get(link, offset, type);
+		if (member == nullptr && type == LB_INDEX_KEY_STRING_PTR) {
+			continue;
+		}
+		void **val;
+		/* Keep the first link, as the linear search finds it. */
+		if (!GLU_ghash_ensure_p(key->ghash, (void *)member, &val)) {
+			*val = link;
+		}
+	}
+	key->version = index->version;
+	return key->ghash;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name ListBase Index API
+ * \{ */
+
+ListBaseIndex *GLU_listbase_index_new(const ListBase *listbase)
+{
+	ListBaseIndex *index = MEM_cnew<ListBaseIndex>(__func__);
+	index->listbase = listbase;
+	/* Tables start at version 0, as never built. */
+	index->version = 1;
+	index->first = listbase->first;
+	index->last = listbase->last;
+	return index;
+}
+
+void GLU_listbase_index_free(ListBaseIndex *index)
+{
+	LISTBASE_FOREACH_MUTABLE (ListBaseIndexKey *, key, &index->keys) {
+		GLU_ghash_free(key->ghash, NULL, NULL);
+		MEM_freeN(key);
+	}
+	if (index->link_indices) {
+		GLU_ghash_free(index->link_indices, NULL, NULL);
+	}
+	MEM_SAFE_FREE(index->links);
+	MEM_freeN(index);
+}
+
+void GLU_listbase_index_tag_dirty(ListBaseIndex *index)
+{
+	index->version++;
+}
+
+int GLU_listbase_index_count(ListBaseIndex *index)
+{
+	listbase_index_ensure_links(index);
+	return index->links_len;
+}
+
+void *GLU_listbase_index_findlink(ListBaseIndex *index, const int number)
+{
+	listbase_index_ensure_links(index);
+	if (number < 0 || number >= index->links_len) {
+		return nullptr;
+	}
+	return index->links[number];
+}
+
+int GLU_listbase_index_findindex(ListBaseIndex *index, const void *vlink)
+{
+	if (vlink == nullptr) {
+		return -1;
+	}
+	listbase_index_ensure_link_indices(index);
+	void **val = GLU_ghash_lookup_p(index->link_indices, vlink);
+	return val ? POINTER_AS_INT(*val) : -1;
+}
+
+void *GLU_listbase_index_findstring(ListBaseIndex *index,
+									const char *id,
+									const int offset)
+{
+	if (id == nullptr) {
+		return nullptr;
+	}
+	GHash *ghash = listbase_index_ensure_key(
+		index, offset, LB_INDEX_KEY_STRING);
+	return GLU_ghash_lookup(ghash, (void *)id);
+}
+
+void *GLU_listbase_index_findstring_ptr(ListBaseIndex *index,
+										const char *id,
+										const int offset)
+{
+	if (id == nullptr) {
+		return nullptr;
+	}
+	GHash *ghash = listbase_index_ensure_key(
+		index, offset, LB_INDEX_KEY_STRING_PTR);
+	return GLU_ghash_lookup(ghash, (void *)id);
+}
+
+void *GLU_listbase_index_findptr(ListBaseIndex *index,
+								 const void *ptr,
+								 const int offset)
+{
+	GHash *ghash = listbase_index_ensure_key(index, offset, LB_INDEX_KEY_PTR);
+	return GLU_ghash_lookup(ghash, (void *)ptr);
+}
+
+/** \} */
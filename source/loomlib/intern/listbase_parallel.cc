@@ -0,0 +1,143 @@
+#include "guardedalloc/mem_guardedalloc.h"
+
+#include "loomlib/loomlib_listbase.h"
+#include "loomlib/loomlib_vector.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <string.h>
+#include <thread>
+
+/* -------------------------------------------------------------------- */
+/** \name Structs & Constants
+ * \{ */
+
+#define LISTBASE_PARALLEL_THREADS_MAX 64
+/** Chunks per thread, fewer make for less contention on the counter, more
+ * for a better balance when the work per link varies. */
+#define LISTBASE_PARALLEL_CHUNKS_PER_THREAD 8
+/** Each thread's chunk of user data gets its own cache lines. */
+#define LISTBASE_PARALLEL_CHUNK_ALIGN 64
+
+using loom::Vector;
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Internal Utility API
+ * \{ */
+
+static int listbase_parallel_threads_num(
+	const ListBaseParallelSettings *settings)
+{
+	int threads_num = settings->threads_num;
+	if (threads_num <= 0) {
+		threads_num = (int)std::thread::hardware_concurrency();
+	}
+	return std::clamp(threads_num, 1, LISTBASE_PARALLEL_THREADS_MAX);
+}
+
+static void listbase_parallel_foreach_serial(
+	const ListBase *listbase,
+	ListBaseParallelFunc func,
+	const ListBaseParallelSettings *settings)
+{
+	int index;
+	LISTBASE_FOREACH_INDEX (Link *, link, listbase, index) {
+		func(settings->userdata, link, index, settings->userdata_chunk);
+	}
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name ListBase Parallel API
+ * \{ */
+
+void GLU_listbase_parallel_settings_init(ListBaseParallelSettings *settings)
+{
+	memset(settings, 0, sizeof(*settings));
+	settings->min_iter_per_thread = 1024;
+}
+
+void GLU_listbase_parallel_foreach(const ListBase *listbase,
+								   ListBaseParallelFunc func,
+								   const ListBaseParallelSettings *settings)
+{
+	void *userdata = settings->userdata;
+	const int min_iter = MAX2(settings->min_iter_per_thread, 1);
+	int threads_num = listbase_parallel_threads_num(settings);
+	if (threads_num == 1 ||
+		GLU_listbase_count_at_most(listbase, min_iter * 2) < min_iter * 2)
+	{
+		listbase_parallel_foreach_serial(listbase, func, settings);
+		return;
+	}
+
+	/* The only walk of the list, the threads index into the array. */
+	Vector<Link *> links;
+	LISTBASE_FOREACH (Link *, link, listbase) {
+		links.Append(link);
+	}
+	const int len = (int)links.Size();
+	threads_num = MIN2(threads_num, len / min_iter);
+	const int chunk_len = MAX2(
+		len / (threads_num * LISTBASE_PARALLEL_CHUNKS_PER_THREAD), 1);
+
+	/* One copy of the user data chunk per thread. */
+	const size_t chunk_size = settings->userdata_chunk_size;
+	const size_t align = LISTBASE_PARALLEL_CHUNK_ALIGN;
+	const size_t chunk_stride = (chunk_size + align - 1) & ~(align - 1);
+	char *chunks = nullptr;
+	if (settings->userdata_chunk && chunk_size) {
+		chunks = static_cast<char *>(
+			MEM_mallocN_aligned(chunk_stride * threads_num, align, __func__));
+		for (int t = 0; t < threads_num; t++) {
+			memcpy(chunks + chunk_stride * t,
+				   settings->userdata_chunk,
+				   chunk_size);
+		}
+	}
+
+	std::atomic<int> next(0);
+	auto worker = [&](const int t) {
+		void *chunk = chunks ? chunks + chunk_stride * t : nullptr;
+		for (;;) {
+			const int begin = next.fetch_add(chunk_len,
+											 std::memory_order_relaxed);
+			if (begin >= len) {
+				break;
+			}
+			const int end = MIN2(begin + chunk_len, len);
+			for (int i = begin; i < end; i++) {
+				func(userdata, links[i], i, chunk);
+			}
+		}
+	};
+
+	std::thread threads[LISTBASE_PARALLEL_THREADS_MAX];
+	/* The calling thread works as thread 0. */
+	for (int t = 1; t < threads_num; t++) {
+		threads[t] = std::thread(worker, t);
+	}
+	worker(0);
+	for (int t = 1; t < threads_num; t++) {
+		threads[t].join();
+	}
+
+	if (chunks) {
+		for (int t = 0; t < threads_num; t++) {
+			void *chunk = chunks + chunk_stride * t;
+			if (settings->func_reduce) {
+				settings->func_reduce(
+					userdata, settings->userdata_chunk, chunk);
+			}
+			if (settings->func_free) {
+				settings->func_free(userdata, chunk);
+			}
+		}
+		MEM_freeN(chunks);
+	}
+}
+
+/** \} */
@@ -0,0 +1,101 @@
+#include "guardedalloc/mem_guardedalloc.h"
+
+#include "loomlib/loomlib_assert.h"
+#include "loomlib/loomlib_memarena.h"
+
+#include <stdint.h>
+#include <string.h>
+
+typedef struct MemBuf {
+	struct MemBuf *next;
+	size_t size;
+} MemBuf;
+
+struct MemArena {
+	const char *name;
+	/** The first buffer is the one in use. */
+	MemBuf *bufs;
+	unsigned char *curbuf;
+	size_t cursize;
+	size_t bufsize;
+	size_t align;
+};
+
+LOOM_INLINE size_t memarena_padding(const void *ptr, const size_t align)
+{
+	return (align - ((uintptr_t)ptr & (align - 1))) & (align - 1);
+}
+
+static void memarena_buf_add(MemArena *ma, const size_t size)
+{
+	MemBuf *buf = MEM_mallocN(sizeof(*buf) + size, ma->name);
+	buf->size = size;
+	buf->next = ma->bufs;
+	ma->bufs = buf;
+	ma->curbuf = (unsigned char *)(buf + 1);
+	ma->cursize = size;
+}
+
+MemArena *GLU_memarena_new(size_t bufsize, const char *name)
+{
+	MemArena *ma = MEM_callocN(sizeof(*ma), "MemArena");
+	ma->name = name;
+	ma->bufsize = bufsize;
+	ma->align = 8;
+	return ma;
+}
+
+void GLU_memarena_free(MemArena *ma)
+{
+	for (MemBuf *buf = ma->bufs, *buf_next; buf; buf = buf_next) {
+		buf_next = buf->next;
+		MEM_freeN(buf);
+	}
+	MEM_freeN(ma);
+}
+
+void GLU_memarena_use_align(MemArena *ma, size_t align)
+{
+	/* Must be a power of two. */
+	LOOM_assert(align != 0 && (align & (align - 1)) == 0);
+	ma->align = align;
+}
+
+void *GLU_memarena_alloc(MemArena *ma, size_t size)
+{
+	size_t padding = memarena_padding(ma->curbuf, ma->align);
+
+	if (ma->curbuf == NULL || size + padding > ma->cursize) {
+		memarena_buf_add(ma, MAX2(ma->bufsize, size + ma->align));
+		padding = memarena_padding(ma->curbuf, ma->align);
+	}
+
+	void *ptr = ma->curbuf + padding;
+	ma->curbuf += padding + size;
+	ma->cursize -= padding + size;
+	return ptr;
+}
+
+void *GLU_memarena_calloc(MemArena *ma, size_t size)
+{
+	void *ptr = GLU_memarena_alloc(ma, size);
+	memset(ptr, 0, size);
+	return ptr;
+}
+
+void GLU_memarena_clear(MemArena *ma)
+{
+	if (ma->bufs == NULL) {
+		return;
+	}
+
+	/* Keep the last buffer added, the others are freed. */
+	MemBuf *keep = ma->bufs;
+	for (MemBuf *buf = keep->next, *buf_next; buf; buf = buf_next) {
+		buf_next = buf->next;
+		MEM_freeN(buf);
+	}
+	keep->next = NULL;
+	ma->curbuf = (unsigned char *)(keep + 1);
+	ma->cursize = keep->size;
+}
@@ -213,6 +213,7 @@ MemPool *GLU_mempool_create(size_t elem_size,
 
 	pool->flag = flag;
 	pool->free = NULL;
+	pool->totused = 0;
 
 	pool->maxchunks = mempool_maxchunks(elem_num, per_chunk);
 
@@ -323,6 +324,16 @@ size_t GLU_mempool_len(const MemPool *pool)
 	return pool->totused;
 }
 
+size_t GLU_mempool_calc_memory(const MemPool *pool)
+{
+	size_t nchunks = 0;
+	for (const MemPoolChunk *mpchunk = pool->chunks; mpchunk;
+		 mpchunk = mpchunk->next) {
+		nchunks++;
+	}
+	return sizeof(*pool) + nchunks * (sizeof(MemPoolChunk) + pool->csize);
+}
+
 void *GLU_mempool_findelem(MemPool *pool, size_t index)
 {
 	LOOM_assert(pool->flag & LOOM_MEMPOOL_ALLOW_ITER);
@@ -0,0 +1,1272 @@
+#include "loomlib/loomlib_assert.h"
+#include "loomlib/loomlib_string.h"
+
+#include "string_numeric_tables.h"
+
+#include <float.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#	include <intrin.h>
+#endif
+
+/* -------------------------------------------------------------------- */
+/** \name Internal Utility API
+ * \{ */
+
+static const char num_digit_pairs[201] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+LOOM_INLINE bool num_is_digit(const char c)
+{
+	return (unsigned char)(c - '0') < 10;
+}
+
+LOOM_INLINE uint64_t num_umul128(const uint64_t a,
+								 const uint64_t b,
+								 uint64_t *r_high)
+{
+#if defined(__SIZEOF_INT128__)
+	const unsigned __int128 product = (unsigned __int128)a * b;
+	*r_high = (uint64_t)(product >> 64);
+	return (uint64_t)product;
+#elif defined(_MSC_VER) && defined(_M_X64)
+	return _umul128(a, b, r_high);
+#else
+	const uint64_t lo_lo = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+	const uint64_t hi_lo = (a >> 32) * (b & 0xFFFFFFFF);
+	const uint64_t lo_hi = (a & 0xFFFFFFFF) * (b >> 32);
+	const uint64_t hi_hi = (a >> 32) * (b >> 32);
+	const uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+	*r_high = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+	return (cross << 32) | (lo_lo & 0xFFFFFFFF);
+#endif
+}
+
+/** \return The number of bits of \a v, zero for zero. */
+LOOM_INLINE int num_bitlen64(const uint64_t v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return v ? 64 - __builtin_clzll(v) : 0;
+#elif defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	return _BitScanReverse64(&index, v) ? (int)index + 1 : 0;
+#else
+	int len = 0;
+	for (uint64_t x = v; x; x >>= 1) {
+		len++;
+	}
+	return len;
+#endif
+}
+
+/** \return The number of decimal digits of \a v, one for zero. */
+LOOM_INLINE unsigned int num_uint64_len(uint64_t v)
+{
+	unsigned int len = 1;
+	for (;;) {
+		if (v < 10) {
+			return len;
+		}
+		if (v < 100) {
+			return len + 1;
+		}
+		if (v < 1000) {
+			return len + 2;
+		}
+		if (v < 10000) {
+			return len + 3;
+		}
+		v /= 10000;
+		len += 4;
+	}
+}
+
+/** Write the digits of \a v so they end right before \a end, two at a time.
+ * \return The first digit. */
+LOOM_INLINE char *num_write_uint64(char *end, uint64_t v)
+{
+	while (v >= 100) {
+		const unsigned int pair = (unsigned int)(v % 100);
+		v /= 100;
+		end -= 2;
+		memcpy(end, num_digit_pairs + pair * 2, 2);
+	}
+	if (v >= 10) {
+		end -= 2;
+		memcpy(end, num_digit_pairs + v * 2, 2);
+	}
+	else {
+		*--end = (char)('0' + v);
+	}
+	return end;
+}
+
+/** Copy the \a len bytes of \a buf and a terminator when they fit. */
+static size_t num_chars_copy(char *__restrict dst,
+							 const size_t maxncpy,
+							 const char *__restrict buf,
+							 const size_t len)
+{
+	if (len >= maxncpy) {
+		if (maxncpy) {
+			dst[0] = '\0';
+		}
+		return 0;
+	}
+	memcpy(dst, buf, len);
+	dst[len] = '\0';
+	return len;
+}
+
+/** \return The number of bytes of the case insensitive \a word at the start
+ * of \a str, zero when it isn't there. */
+static size_t num_match_word(const char *str, const size_t len, const char *word)
+{
+	size_t i = 0;
+	for (; word[i]; i++) {
+		if (i >= len || (str[i] | 0x20) != word[i]) {
+			return 0;
+		}
+	}
+	return i;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Integer To Chars
+ * \{ */
+
+size_t GLU_uint_to_chars(char *dst, size_t maxncpy, uint64_t value)
+{
+	const size_t len = num_uint64_len(value);
+	if (len >= maxncpy) {
+		if (maxncpy) {
+			dst[0] = '\0';
+		}
+		return 0;
+	}
+	num_write_uint64(dst + len, value);
+	dst[len] = '\0';
+	return len;
+}
+
+size_t GLU_int_to_chars(char *dst, size_t maxncpy, int64_t value)
+{
+	if (value >= 0) {
+		return GLU_uint_to_chars(dst, maxncpy, (uint64_t)value);
+	}
+	const uint64_t magnitude = (uint64_t)0 - (uint64_t)value;
+	const size_t len = num_uint64_len(magnitude) + 1;
+	if (len >= maxncpy) {
+		if (maxncpy) {
+			dst[0] = '\0';
+		}
+		return 0;
+	}
+	dst[0] = '-';
+	num_write_uint64(dst + len, magnitude);
+	dst[len] = '\0';
+	return len;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Shortest Float To Chars
+ *
+ * Ryu (Ulf Adams, 2018): the interval of decimals that round to the value is
+ * computed with the 125 bit powers of five, then digits are removed while
+ * both ends of the interval still differ, which leaves the shortest decimal
+ * closest to the value. No big numbers, no loop per bit of the input.
+ * \{ */
+
+#define NUM_DOUBLE_MANTISSA_BITS 52
+#define NUM_DOUBLE_BIAS 1023
+#define NUM_FLOAT_MANTISSA_BITS 23
+#define NUM_FLOAT_BIAS 127
+
+/** The upper halves of the double tables are enough for floats. */
+#define NUM_FLOAT_POW5_INV_BITCOUNT (NUM_POW5_INV_BITCOUNT - 64)
+#define NUM_FLOAT_POW5_BITCOUNT (NUM_POW5_BITCOUNT - 64)
+
+typedef struct NumShortest {
+	uint64_t mantissa;
+	int32_t exponent;
+} NumShortest;
+
+/** \return The number of bits of `5^e`, one for zero (for 0 <= e <= 3528). */
+LOOM_INLINE int32_t num_pow5bits(const int32_t e)
+{
+	return (int32_t)(((uint32_t)e * 1217359) >> 19) + 1;
+}
+
+/** \return `floor(log10(2^e))` (for 0 <= e <= 1650). */
+LOOM_INLINE uint32_t num_log10_pow2(const int32_t e)
+{
+	return ((uint32_t)e * 78913) >> 18;
+}
+
+/** \return `floor(log10(5^e))` (for 0 <= e <= 2620). */
+LOOM_INLINE uint32_t num_log10_pow5(const int32_t e)
+{
+	return ((uint32_t)e * 732923) >> 20;
+}
+
+LOOM_INLINE uint32_t num_pow5_factor(uint64_t v)
+{
+	uint32_t count = 0;
+	while (v % 5 == 0) {
+		v /= 5;
+		count++;
+	}
+	return count;
+}
+
+LOOM_INLINE bool num_multiple_of_pow5(const uint64_t v, const uint32_t p)
+{
+	return num_pow5_factor(v) >= p;
+}
+
+LOOM_INLINE bool num_multiple_of_pow2(const uint64_t v, const uint32_t p)
+{
+	return (v & (((uint64_t)1 << p) - 1)) == 0;
+}
+
+/** \return `(m * mul) >> j` for the 128 bit \a mul, with 64 < j < 128. */
+LOOM_INLINE uint64_t num_mul_shift64(const uint64_t m,
+									 const uint64_t mul[2],
+									 const int32_t j)
+{
+	uint64_t high0, high1;
+	num_umul128(m, mul[0], &high0);
+	const uint64_t low1 = num_umul128(m, mul[1], &high1);
+	const uint64_t sum = high0 + low1;
+	if (sum < high0) {
+		high1++;
+	}
+	const int32_t dist = j - 64;
+	LOOM_assert(dist > 0 && dist < 64);
+	return (high1 << (64 - dist)) | (sum >> dist);
+}
+
+/** \return `(m * factor) >> shift` for the 64 bit \a factor, shift > 32. */
+LOOM_INLINE uint32_t num_mul_shift32(const uint32_t m,
+									 const uint64_t factor,
+									 const int32_t shift)
+{
+	const uint64_t bits0 = (uint64_t)m * (uint32_t)factor;
+	const uint64_t bits1 = (uint64_t)m * (uint32_t)(factor >> 32);
+	return (uint32_t)(((bits0 >> 32) + bits1) >> (shift - 32));
+}
+
+static NumShortest num_shortest_double(const uint64_t ieee_mantissa,
+									   const uint32_t ieee_exponent)
+{
+	int32_t e2;
+	uint64_t m2;
+	if (ieee_exponent == 0) {
+		e2 = 1 - NUM_DOUBLE_BIAS - NUM_DOUBLE_MANTISSA_BITS - 2;
+		m2 = ieee_mantissa;
+	}
+	else {
+		e2 = (int32_t)ieee_exponent - NUM_DOUBLE_BIAS -
+			 NUM_DOUBLE_MANTISSA_BITS - 2;
+		m2 = ((uint64_t)1 << NUM_DOUBLE_MANTISSA_BITS) | ieee_mantissa;
+	}
+	/* Round half to even when reading back, so even values own the ends of
+	 * their interval. */
+	const bool accept_bounds = (m2 & 1) == 0;
+
+	/* The value and the ends of its interval are (mv, mp, mm) * 2^e2, the
+	 * lower end is closer when the value is a power of two. */
+	const uint64_t mv = 4 * m2;
+	const uint32_t mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+	const uint64_t mp = mv + 2;
+	const uint64_t mm = mv - 1 - mm_shift;
+
+	/* Convert to a power of ten: (vr, vp, vm) * 10^e10. */
+	uint64_t vr, vp, vm;
+	int32_t e10;
+	bool vm_is_trailing_zeros = false;
+	bool vr_is_trailing_zeros = false;
+	if (e2 >= 0) {
+		const uint32_t q = num_log10_pow2(e2) - (e2 > 3);
+		e10 = (int32_t)q;
+		const int32_t k = NUM_POW5_INV_BITCOUNT + num_pow5bits((int32_t)q) - 1;
+		const int32_t i = -e2 + (int32_t)q + k;
+		vr = num_mul_shift64(mv, NUM_POW5_INV_SPLIT[q], i);
+		vp = num_mul_shift64(mp, NUM_POW5_INV_SPLIT[q], i);
+		vm = num_mul_shift64(mm, NUM_POW5_INV_SPLIT[q], i);
+		if (q <= 21) {
+			/* Only one of mp, mv and mm can be a multiple of 5, if any. */
+			if (mv % 5 == 0) {
+				vr_is_trailing_zeros = num_multiple_of_pow5(mv, q);
+			}
+			else if (accept_bounds) {
+				vm_is_trailing_zeros = num_multiple_of_pow5(mm, q);
+			}
+			else {
+				vp -= num_multiple_of_pow5(mp, q);
+			}
+		}
+	}
+	else {
+		const uint32_t q = num_log10_pow5(-e2) - (-e2 > 1);
+		e10 = (int32_t)q + e2;
+		const int32_t i = -e2 - (int32_t)q;
+		const int32_t k = num_pow5bits(i) - NUM_POW5_BITCOUNT;
+		const int32_t j = (int32_t)q - k;
+		vr = num_mul_shift64(mv, NUM_POW5_SPLIT[i], j);
+		vp = num_mul_shift64(mp, NUM_POW5_SPLIT[i], j);
+		vm = num_mul_shift64(mm, NUM_POW5_SPLIT[i], j);
+		if (q <= 1) {
+			/* mv has at least q trailing zero bits, so vr has q trailing
+			 * decimal zeros. */
+			vr_is_trailing_zeros = true;
+			if (accept_bounds) {
+				vm_is_trailing_zeros = mm_shift == 1;
+			}
+			else {
+				vp--;
+			}
+		}
+		else if (q < 63) {
+			vr_is_trailing_zeros = num_multiple_of_pow2(mv, q);
+		}
+	}
+
+	/* Remove digits while the ends of the interval differ. */
+	int32_t removed = 0;
+	uint8_t last_removed_digit = 0;
+	uint64_t output;
+	if (vm_is_trailing_zeros || vr_is_trailing_zeros) {
+		/* The general case, which is rare (about 0.7%). */
+		while (vp / 10 > vm / 10) {
+			vm_is_trailing_zeros &= vm % 10 == 0;
+			vr_is_trailing_zeros &= last_removed_digit == 0;
+			last_removed_digit = (uint8_t)(vr % 10);
+			vr /= 10;
+			vp /= 10;
+			vm /= 10;
+			removed++;
+		}
+		if (vm_is_trailing_zeros) {
+			while (vm % 10 == 0) {
+				vr_is_trailing_zeros &= last_removed_digit == 0;
+				last_removed_digit = (uint8_t)(vr % 10);
+				vr /= 10;
+				vp /= 10;
+				vm /= 10;
+				removed++;
+			}
+		}
+		if (vr_is_trailing_zeros && last_removed_digit == 5 && vr % 2 == 0) {
+			/* Round to even when the exact value is .....50..0. */
+			last_removed_digit = 4;
+		}
+		output = vr + ((vr == vm && (!accept_bounds || !vm_is_trailing_zeros)) ||
+					   last_removed_digit >= 5);
+	}
+	else {
+		/* The common case, two digits at a time first. */
+		bool round_up = false;
+		if (vp / 100 > vm / 100) {
+			round_up = vr % 100 >= 50;
+			vr /= 100;
+			vp /= 100;
+			vm /= 100;
+			removed += 2;
+		}
+		while (vp / 10 > vm / 10) {
+			round_up = vr % 10 >= 5;
+			vr /= 10;
+			vp /= 10;
+			vm /= 10;
+			removed++;
+		}
+		output = vr + (vr == vm || round_up);
+	}
+
+	NumShortest result;
+	result.mantissa = output;
+	result.exponent = e10 + removed;
+	return result;
+}
+
+static NumShortest num_shortest_float(const uint32_t ieee_mantissa,
+									  const uint32_t ieee_exponent)
+{
+	int32_t e2;
+	uint32_t m2;
+	if (ieee_exponent == 0) {
+		e2 = 1 - NUM_FLOAT_BIAS - NUM_FLOAT_MANTISSA_BITS - 2;
+		m2 = ieee_mantissa;
+	}
+	else {
+		e2 = (int32_t)ieee_exponent - NUM_FLOAT_BIAS - NUM_FLOAT_MANTISSA_BITS -
+			 2;
+		m2 = ((uint32_t)1 << NUM_FLOAT_MANTISSA_BITS) | ieee_mantissa;
+	}
+	const bool accept_bounds = (m2 & 1) == 0;
+
+	const uint32_t mv = 4 * m2;
+	const uint32_t mp = mv + 2;
+	const uint32_t mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+	const uint32_t mm = mv - 1 - mm_shift;
+
+	uint32_t vr, vp, vm;
+	int32_t e10;
+	bool vm_is_trailing_zeros = false;
+	bool vr_is_trailing_zeros = false;
+	uint8_t last_removed_digit = 0;
+	if (e2 >= 0) {
+		const uint32_t q = num_log10_pow2(e2);
+		e10 = (int32_t)q;
+		const int32_t k = NUM_FLOAT_POW5_INV_BITCOUNT + num_pow5bits((int32_t)q) -
+						  1;
+		const int32_t i = -e2 + (int32_t)q + k;
+		const uint64_t inv = NUM_POW5_INV_SPLIT[q][1] + 1;
+		vr = num_mul_shift32(mv, inv, i);
+		vp = num_mul_shift32(mp, inv, i);
+		vm = num_mul_shift32(mm, inv, i);
+		if (q != 0 && (vp - 1) / 10 <= vm / 10) {
+			/* The loop below won't remove a digit, but the last removed one
+			 * is needed for rounding. */
+			const int32_t l = NUM_FLOAT_POW5_INV_BITCOUNT +
+							  num_pow5bits((int32_t)(q - 1)) - 1;
+			last_removed_digit = (uint8_t)(num_mul_shift32(
+											   mv,
+											   NUM_POW5_INV_SPLIT[q - 1][1] + 1,
+											   -e2 + (int32_t)q - 1 + l) %
+										   10);
+		}
+		if (q <= 9) {
+			if (mv % 5 == 0) {
+				vr_is_trailing_zeros = num_multiple_of_pow5(mv, q);
+			}
+			else if (accept_bounds) {
+				vm_is_trailing_zeros = num_multiple_of_pow5(mm, q);
+			}
+			else {
+				vp -= num_multiple_of_pow5(mp, q);
+			}
+		}
+	}
+	else {
+		const uint32_t q = num_log10_pow5(-e2);
+		e10 = (int32_t)q + e2;
+		const int32_t i = -e2 - (int32_t)q;
+		const int32_t k = num_pow5bits(i) - NUM_FLOAT_POW5_BITCOUNT;
+		int32_t j = (int32_t)q - k;
+		const uint64_t pow5 = NUM_POW5_SPLIT[i][1];
+		vr = num_mul_shift32(mv, pow5, j);
+		vp = num_mul_shift32(mp, pow5, j);
+		vm = num_mul_shift32(mm, pow5, j);
+		if (q != 0 && (vp - 1) / 10 <= vm / 10) {
+			j = (int32_t)q - 1 - (num_pow5bits(i + 1) - NUM_FLOAT_POW5_BITCOUNT);
+			last_removed_digit = (uint8_t)(num_mul_shift32(
+											   mv, NUM_POW5_SPLIT[i + 1][1], j) %
+										   10);
+		}
+		if (q <= 1) {
+			vr_is_trailing_zeros = true;
+			if (accept_bounds) {
+				vm_is_trailing_zeros = mm_shift == 1;
+			}
+			else {
+				vp--;
+			}
+		}
+		else if (q < 31) {
+			vr_is_trailing_zeros = num_multiple_of_pow2(mv, q - 1);
+		}
+	}
+
+	int32_t removed = 0;
+	uint32_t output;
+	if (vm_is_trailing_zeros || vr_is_trailing_zeros) {
+		while (vp / 10 > vm / 10) {
+			vm_is_trailing_zeros &= vm % 10 == 0;
+			vr_is_trailing_zeros &= last_removed_digit == 0;
+			last_removed_digit = (uint8_t)(vr % 10);
+			vr /= 10;
+			vp /= 10;
+			vm /= 10;
+			removed++;
+		}
+		if (vm_is_trailing_zeros) {
+			while (vm % 10 == 0) {
+				vr_is_trailing_zeros &= last_removed_digit == 0;
+				last_removed_digit = (uint8_t)(vr % 10);
+				vr /= 10;
+				vp /= 10;
+				vm /= 10;
+				removed++;
+			}
+		}
+		if (vr_is_trailing_zeros && last_removed_digit == 5 && vr % 2 == 0) {
+			last_removed_digit = 4;
+		}
+		output = vr + ((vr == vm && (!accept_bounds || !vm_is_trailing_zeros)) ||
+					   last_removed_digit >= 5);
+	}
+	else {
+		while (vp / 10 > vm / 10) {
+			last_removed_digit = (uint8_t)(vr % 10);
+			vr /= 10;
+			vp /= 10;
+			vm /= 10;
+			removed++;
+		}
+		output = vr + (vr == vm || last_removed_digit >= 5);
+	}
+
+	NumShortest result;
+	result.mantissa = output;
+	result.exponent = e10 + removed;
+	return result;
+}
+
+/**
+ * Print `mantissa * 10^exponent` in fixed notation when the decimal exponent
+ * is in [-4, 16), else in scientific notation with at least two exponent
+ * digits, the choices of `repr` in Python (but without a trailing ".0").
+ * \return The number of bytes written, no terminator.
+ */
+static size_t num_format_decimal(char *buf,
+								 const bool sign,
+								 const uint64_t mantissa,
+								 const int32_t exponent)
+{
+	char digits[20];
+	const int32_t olength = (int32_t)num_uint64_len(mantissa);
+	num_write_uint64(digits + olength, mantissa);
+	const int32_t sci_exponent = exponent + olength - 1;
+
+	char *p = buf;
+	if (sign) {
+		*p++ = '-';
+	}
+	if (sci_exponent < -4 || sci_exponent >= 16) {
+		*p++ = digits[0];
+		if (olength > 1) {
+			*p++ = '.';
+			memcpy(p, digits + 1, (size_t)olength - 1);
+			p += olength - 1;
+		}
+		*p++ = 'e';
+		*p++ = (sci_exponent < 0) ? '-' : '+';
+		uint32_t e = (uint32_t)((sci_exponent < 0) ? -sci_exponent :
+													 sci_exponent);
+		if (e >= 100) {
+			*p++ = (char)('0' + e / 100);
+			e %= 100;
+		}
+		memcpy(p, num_digit_pairs + e * 2, 2);
+		p += 2;
+	}
+	else if (exponent >= 0) {
+		memcpy(p, digits, (size_t)olength);
+		p += olength;
+		memset(p, '0', (size_t)exponent);
+		p += exponent;
+	}
+	else if (sci_exponent >= 0) {
+		const int32_t int_len = sci_exponent + 1;
+		memcpy(p, digits, (size_t)int_len);
+		p += int_len;
+		*p++ = '.';
+		memcpy(p, digits + int_len, (size_t)(olength - int_len));
+		p += olength - int_len;
+	}
+	else {
+		*p++ = '0';
+		*p++ = '.';
+		memset(p, '0', (size_t)(-sci_exponent - 1));
+		p += -sci_exponent - 1;
+		memcpy(p, digits, (size_t)olength);
+		p += olength;
+	}
+	return (size_t)(p - buf);
+}
+
+/** Print zero, infinity or not a number. */
+static size_t num_format_special(char *buf,
+								 const bool sign,
+								 const bool exponent_max,
+								 const bool mantissa)
+{
+	const char *str;
+	if (!exponent_max) {
+		str = sign ? "-0" : "0";
+	}
+	else if (mantissa) {
+		str = "nan";
+	}
+	else {
+		str = sign ? "-inf" : "inf";
+	}
+	const size_t len = strlen(str);
+	memcpy(buf, str, len);
+	return len;
+}
+
+size_t GLU_double_to_chars(char *dst, size_t maxncpy, double value)
+{
+	char buf[GLU_DOUBLE_CHARS_SIZE];
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	const bool sign = (bits >> 63) != 0;
+	const uint64_t ieee_mantissa = bits & (((uint64_t)1 << 52) - 1);
+	const uint32_t ieee_exponent = (uint32_t)(bits >> 52) & 0x7FF;
+
+	size_t len;
+	if (ieee_exponent == 0x7FF || (ieee_exponent == 0 && ieee_mantissa == 0)) {
+		len = num_format_special(
+			buf, sign, ieee_exponent == 0x7FF, ieee_mantissa != 0);
+	}
+	else {
+		const NumShortest dec = num_shortest_double(ieee_mantissa, ieee_exponent);
+		len = num_format_decimal(buf, sign, dec.mantissa, dec.exponent);
+	}
+	return num_chars_copy(dst, maxncpy, buf, len);
+}
+
+size_t GLU_float_to_chars(char *dst, size_t maxncpy, float value)
+{
+	char buf[GLU_FLOAT_CHARS_SIZE];
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	const bool sign = (bits >> 31) != 0;
+	const uint32_t ieee_mantissa = bits & (((uint32_t)1 << 23) - 1);
+	const uint32_t ieee_exponent = (bits >> 23) & 0xFF;
+
+	size_t len;
+	if (ieee_exponent == 0xFF || (ieee_exponent == 0 && ieee_mantissa == 0)) {
+		len = num_format_special(
+			buf, sign, ieee_exponent == 0xFF, ieee_mantissa != 0);
+	}
+	else {
+		const NumShortest dec = num_shortest_float(ieee_mantissa, ieee_exponent);
+		len = num_format_decimal(buf, sign, dec.mantissa, dec.exponent);
+	}
+	return num_chars_copy(dst, maxncpy, buf, len);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Chars To Integer
+ * \{ */
+
+size_t GLU_chars_to_uint(const char *str, size_t len, uint64_t *r_value)
+{
+	size_t i = 0;
+	while (i < len && str[i] == '0') {
+		i++;
+	}
+	const size_t significant = i;
+
+	/* Up to 19 digits can't overflow, a 20th one might. */
+	uint64_t value = 0;
+	const size_t fast_end = (len - i > 19) ? i + 19 : len;
+	for (; i < fast_end && num_is_digit(str[i]); i++) {
+		value = value * 10 + (uint64_t)(str[i] - '0');
+	}
+	if (i < len && num_is_digit(str[i])) {
+		const uint64_t digit = (uint64_t)(str[i] - '0');
+		if (i - significant != 19 || value > (UINT64_MAX - digit) / 10) {
+			return 0;
+		}
+		value = value * 10 + digit;
+		i++;
+		if (i < len && num_is_digit(str[i])) {
+			return 0;
+		}
+	}
+
+	if (i == 0) {
+		return 0;
+	}
+	*r_value = value;
+	return i;
+}
+
+size_t GLU_chars_to_int(const char *str, size_t len, int64_t *r_value)
+{
+	const bool negative = len && str[0] == '-';
+	const size_t sign_len = (len && (str[0] == '-' || str[0] == '+')) ? 1 : 0;
+
+	uint64_t magnitude;
+	const size_t digits_len = GLU_chars_to_uint(
+		str + sign_len, len - sign_len, &magnitude);
+	if (digits_len == 0) {
+		return 0;
+	}
+	if (negative) {
+		if (magnitude > (uint64_t)INT64_MAX + 1) {
+			return 0;
+		}
+		*r_value = (int64_t)((uint64_t)0 - magnitude);
+	}
+	else {
+		if (magnitude > (uint64_t)INT64_MAX) {
+			return 0;
+		}
+		*r_value = (int64_t)magnitude;
+	}
+	return sign_len + digits_len;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Chars To Float
+ *
+ * Most inputs are settled by rounding both ends of an interval that holds
+ * the exact value, computed from the first 19 digits and the 125 bit powers
+ * of five. Only when the ends round differently, which takes the value to be
+ * within about 2^-60 of half way between two floats, the decimal is compared
+ * exactly with the half way point using big integers.
+ * \{ */
+
+typedef struct NumFormat {
+	/** The significand bits, including the implicit one. */
+	int32_t mantissa_bits;
+	/** The exponents of the normal numbers. */
+	int32_t exponent_min;
+	int32_t exponent_max;
+	/** Decimals below `10^decimal_min` round to zero, from
+	 * `10^(decimal_max - 1)` on they round to infinity. */
+	int32_t decimal_min;
+	int32_t decimal_max;
+} NumFormat;
+
+static const NumFormat num_format_double = {53, -1022, 1023, -324, 310};
+static const NumFormat num_format_float = {24, -126, 127, -46, 40};
+
+/** Digits past this many can only matter as being there (nonzero or not),
+ * the exact half way points between doubles have at most 767 significant
+ * digits. */
+#define NUM_BIG_DIGITS 800
+/** Enough for the largest product of #num_compare_half_way. */
+#define NUM_BIG_LIMBS 100
+
+typedef struct NumDecimal {
+	/** The first (up to) 19 significant digits. */
+	uint64_t mantissa;
+	int32_t ndigits;
+	/** The value is `mantissa * 10^exponent`, unless truncated. */
+	int32_t exponent;
+	/** There are nonzero digits past the ones in #mantissa. */
+	bool truncated;
+
+	/** The digits, kept for the exact comparison. */
+	const char *int_begin, *int_end;
+	const char *frac_begin, *frac_end;
+	int32_t exponent_explicit;
+} NumDecimal;
+
+typedef struct NumBig {
+	uint32_t limbs[NUM_BIG_LIMBS];
+	int len;
+} NumBig;
+
+/**
+ * Parse `digits[.digits][(e|E)[+|-]digits]`, with at least one digit before
+ * or after the point.
+ * \return The number of bytes parsed, zero when there is no number.
+ */
+static size_t num_parse_decimal(const char *str, const size_t len, NumDecimal *dec)
+{
+	const char *p = str, *end = str + len;
+
+	dec->int_begin = p;
+	while (p < end && num_is_digit(*p)) {
+		p++;
+	}
+	dec->int_end = dec->frac_begin = dec->frac_end = p;
+	if (p < end && *p == '.') {
+		dec->frac_begin = ++p;
+		while (p < end && num_is_digit(*p)) {
+			p++;
+		}
+		dec->frac_end = p;
+	}
+	if (dec->int_begin == dec->int_end && dec->frac_begin == dec->frac_end) {
+		return 0;
+	}
+
+	int32_t exponent = 0;
+	if (p < end && (*p | 0x20) == 'e') {
+		const char *q = p + 1;
+		const bool negative = q < end && *q == '-';
+		if (q < end && (*q == '-' || *q == '+')) {
+			q++;
+		}
+		/* Without digits the 'e' is not part of the number. */
+		if (q < end && num_is_digit(*q)) {
+			for (; q < end && num_is_digit(*q); q++) {
+				/* Far past any float, but can't overflow with the digits. */
+				if (exponent < 100000000) {
+					exponent = exponent * 10 + (*q - '0');
+				}
+			}
+			exponent = negative ? -exponent : exponent;
+			p = q;
+		}
+	}
+	dec->exponent_explicit = exponent;
+
+	uint64_t mantissa = 0;
+	int32_t ndigits = 0;
+	bool truncated = false;
+	for (const char *d = dec->int_begin; d < dec->int_end; d++) {
+		if (ndigits < 19) {
+			if (ndigits || *d != '0') {
+				mantissa = mantissa * 10 + (uint64_t)(*d - '0');
+				ndigits++;
+			}
+		}
+		else {
+			truncated |= *d != '0';
+			exponent++;
+		}
+	}
+	for (const char *d = dec->frac_begin; d < dec->frac_end; d++) {
+		if (ndigits < 19) {
+			if (ndigits || *d != '0') {
+				mantissa = mantissa * 10 + (uint64_t)(*d - '0');
+				ndigits++;
+			}
+			exponent--;
+		}
+		else {
+			truncated |= *d != '0';
+		}
+	}
+	dec->mantissa = mantissa;
+	dec->ndigits = ndigits;
+	dec->exponent = exponent;
+	dec->truncated = truncated;
+	return (size_t)(p - str);
+}
+
+static void num_big_set(NumBig *big, const uint64_t value)
+{
+	big->len = 0;
+	for (uint64_t v = value; v; v >>= 32) {
+		big->limbs[big->len++] = (uint32_t)v;
+	}
+}
+
+/** `big = big * mul + add`. */
+static void num_big_mul_add(NumBig *big, const uint32_t mul, const uint32_t add)
+{
+	uint64_t carry = add;
+	for (int i = 0; i < big->len; i++) {
+		const uint64_t t = (uint64_t)big->limbs[i] * mul + carry;
+		big->limbs[i] = (uint32_t)t;
+		carry = t >> 32;
+	}
+	if (carry) {
+		LOOM_assert(big->len < NUM_BIG_LIMBS);
+		big->limbs[big->len++] = (uint32_t)carry;
+	}
+}
+
+static void num_big_mul_pow5(NumBig *big, int32_t e)
+{
+	static const uint32_t pow5[14] = {1,
+									  5,
+									  25,
+									  125,
+									  625,
+									  3125,
+									  15625,
+									  78125,
+									  390625,
+									  1953125,
+									  9765625,
+									  48828125,
+									  244140625,
+									  1220703125};
+	for (; e >= 13; e -= 13) {
+		num_big_mul_add(big, pow5[13], 0);
+	}
+	num_big_mul_add(big, pow5[e], 0);
+}
+
+static void num_big_shift_left(NumBig *big, const int32_t shift)
+{
+	if (big->len == 0 || shift == 0) {
+		return;
+	}
+	const int words = shift / 32, bits = shift % 32;
+	LOOM_assert(big->len + words + 1 <= NUM_BIG_LIMBS);
+
+	big->limbs[big->len] = 0;
+	for (int i = big->len; i >= 0; i--) {
+		uint32_t limb = big->limbs[i] << bits;
+		if (bits && i > 0) {
+			limb |= big->limbs[i - 1] >> (32 - bits);
+		}
+		big->limbs[i + words] = limb;
+	}
+	memset(big->limbs, 0, sizeof(*big->limbs) * (size_t)words);
+	big->len += words + 1;
+	while (big->len && big->limbs[big->len - 1] == 0) {
+		big->len--;
+	}
+}
+
+static int num_big_compare(const NumBig *a, const NumBig *b)
+{
+	if (a->len != b->len) {
+		return (a->len < b->len) ? -1 : 1;
+	}
+	for (int i = a->len - 1; i >= 0; i--) {
+		if (a->limbs[i] != b->limbs[i]) {
+			return (a->limbs[i] < b->limbs[i]) ? -1 : 1;
+		}
+	}
+	return 0;
+}
+
+/** Read up to #NUM_BIG_DIGITS significant digits of \a dec into \a big, a
+ * final 1 stands for any nonzero digits after them.
+ * \return The power of ten of the last digit. */
+static int32_t num_big_set_decimal(NumBig *big, const NumDecimal *dec)
+{
+	static const uint32_t pow10[10] = {
+		1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+	int32_t exponent = dec->exponent_explicit;
+	int32_t ndigits = 0;
+	uint32_t chunk = 0;
+	int chunk_len = 0;
+	bool truncated = false;
+
+	num_big_set(big, 0);
+	for (int part = 0; part < 2; part++) {
+		const char *begin = part ? dec->frac_begin : dec->int_begin;
+		const char *end = part ? dec->frac_end : dec->int_end;
+		for (const char *d = begin; d < end; d++) {
+			if (ndigits == NUM_BIG_DIGITS) {
+				truncated |= *d != '0';
+				exponent += !part;
+				continue;
+			}
+			exponent -= part;
+			if (ndigits == 0 && *d == '0') {
+				continue;
+			}
+			chunk = chunk * 10 + (uint32_t)(*d - '0');
+			ndigits++;
+			if (++chunk_len == 9) {
+				num_big_mul_add(big, pow10[9], chunk);
+				chunk = 0;
+				chunk_len = 0;
+			}
+		}
+	}
+	if (truncated) {
+		chunk = chunk * 10 + 1;
+		chunk_len++;
+		exponent--;
+	}
+	num_big_mul_add(big, pow10[chunk_len], chunk);
+	return exponent;
+}
+
+/** \return The significand of the finite \a bits, with the power of two
+ * it is multiplied with in \a r_exponent. */
+static uint64_t num_bits_significand(const uint64_t bits,
+									 const NumFormat *fmt,
+									 int32_t *r_exponent)
+{
+	const int32_t frac_bits = fmt->mantissa_bits - 1;
+	const int32_t biased = (int32_t)(bits >> frac_bits);
+	const uint64_t frac = bits & (((uint64_t)1 << frac_bits) - 1);
+	if (biased == 0) {
+		*r_exponent = fmt->exponent_min - frac_bits;
+		return frac;
+	}
+	*r_exponent = biased + fmt->exponent_min - 1 - frac_bits;
+	return frac | ((uint64_t)1 << frac_bits);
+}
+
+/** Compare \a dec exactly with `(2 * m + 1) * 2^(e - 1)`, half way between
+ * `m * 2^e` and `(m + 1) * 2^e`. */
+static int num_compare_half_way(const NumDecimal *dec,
+								const uint64_t m,
+								const int32_t e)
+{
+	NumBig x, h;
+	const int32_t x_exponent = num_big_set_decimal(&x, dec);
+	num_big_set(&h, 2 * m + 1);
+
+	/* x * 5^x_exponent * 2^x_exponent against h * 2^(e - 1), with the powers
+	 * of five and two each moved to one side. */
+	if (x_exponent >= 0) {
+		num_big_mul_pow5(&x, x_exponent);
+	}
+	else {
+		num_big_mul_pow5(&h, -x_exponent);
+	}
+	const int32_t shift = x_exponent - (e - 1);
+	if (shift >= 0) {
+		num_big_shift_left(&x, shift);
+	}
+	else {
+		num_big_shift_left(&h, -shift);
+	}
+	return num_big_compare(&x, &h);
+}
+
+/** \return The bits of `n * 2^e` rounded half to even, \a n is 192 bits
+ * (low word first) and not zero. */
+static uint64_t num_round_bits(const uint64_t n[3],
+							   const int32_t e,
+							   const NumFormat *fmt)
+{
+	const int word = n[2] ? 2 : (n[1] ? 1 : 0);
+	const int32_t nbits = word * 64 + num_bitlen64(n[word]);
+	const int32_t top = nbits - 1 + e;
+	const int32_t frac_bits = fmt->mantissa_bits - 1;
+	const uint64_t inf = (uint64_t)(fmt->exponent_max - fmt->exponent_min + 2)
+						 << frac_bits;
+
+	if (top > fmt->exponent_max) {
+		return inf;
+	}
+	int32_t keep = fmt->mantissa_bits;
+	if (top < fmt->exponent_min) {
+		/* Subnormal, fewer bits are kept. */
+		keep -= fmt->exponent_min - top;
+		if (keep < 0) {
+			return 0;
+		}
+	}
+
+	uint64_t m;
+	const int32_t shift = nbits - keep;
+	if (shift <= 0) {
+		m = n[0] << -shift;
+	}
+	else {
+		const int w = shift / 64, off = shift % 64;
+		m = n[w] >> off;
+		if (off && w < 2) {
+			m |= n[w + 1] << (64 - off);
+		}
+		if (keep < 64) {
+			m &= ((uint64_t)1 << keep) - 1;
+		}
+
+		const int32_t half = shift - 1;
+		const int hw = half / 64, hoff = half % 64;
+		const bool half_bit = (n[hw] >> hoff) & 1;
+		bool sticky = (n[hw] & (((uint64_t)1 << hoff) - 1)) != 0;
+		for (int i = 0; i < hw; i++) {
+			sticky |= n[i] != 0;
+		}
+		if (half_bit && (sticky || (m & 1))) {
+			/* A carry out of the significand bumps the exponent, up to the
+			 * bits of infinity. */
+			m++;
+		}
+	}
+
+	if (top < fmt->exponent_min) {
+		return m;
+	}
+	return ((uint64_t)(top - fmt->exponent_min + 1) << frac_bits) + m -
+		   ((uint64_t)1 << frac_bits);
+}
+
+/** 64 x 128 bit multiplication, to 192 bits. */
+LOOM_INLINE void num_mul_64x128(const uint64_t a,
+								const uint64_t b[2],
+								uint64_t r[3])
+{
+	uint64_t high0, high1;
+	r[0] = num_umul128(a, b[0], &high0);
+	const uint64_t low1 = num_umul128(a, b[1], &high1);
+	r[1] = high0 + low1;
+	r[2] = high1 + (r[1] < high0);
+}
+
+static uint64_t num_decimal_to_bits(const NumDecimal *dec, const NumFormat *fmt)
+{
+	const uint64_t inf = (uint64_t)(fmt->exponent_max - fmt->exponent_min + 2)
+						 << (fmt->mantissa_bits - 1);
+	if (dec->mantissa == 0) {
+		return 0;
+	}
+	const int32_t magnitude = dec->exponent + dec->ndigits;
+	if (magnitude <= fmt->decimal_min) {
+		return 0;
+	}
+	if (magnitude >= fmt->decimal_max) {
+		return inf;
+	}
+
+	/* 5^q is in [pow5, pow5 + 1) * 2^pow5_exponent. */
+	const int32_t q = dec->exponent;
+	uint64_t pow5[2], pow5_up[2];
+	int32_t pow5_exponent;
+	if (q >= 0) {
+		pow5[0] = NUM_POW5_SPLIT[q][0];
+		pow5[1] = NUM_POW5_SPLIT[q][1];
+		pow5_exponent = num_pow5bits(q) - NUM_POW5_BITCOUNT;
+	}
+	else {
+		pow5[0] = NUM_POW5_INV_SPLIT[-q][0] - 1;
+		pow5[1] = NUM_POW5_INV_SPLIT[-q][1] - (pow5[0] == UINT64_MAX);
+		pow5_exponent = -(num_pow5bits(-q) - 1 + NUM_POW5_INV_BITCOUNT);
+	}
+	/* Smaller powers fit the table exactly. */
+	const bool pow5_exact = q >= 0 && num_pow5bits(q) <= NUM_POW5_BITCOUNT;
+	pow5_up[0] = pow5[0] + !pow5_exact;
+	pow5_up[1] = pow5[1] + (pow5_up[0] < pow5[0]);
+
+	uint64_t lo[3], hi[3];
+	num_mul_64x128(dec->mantissa, pow5, lo);
+	num_mul_64x128(dec->mantissa + dec->truncated, pow5_up, hi);
+	const uint64_t bits_lo = num_round_bits(lo, pow5_exponent + q, fmt);
+	const uint64_t bits_hi = num_round_bits(hi, pow5_exponent + q, fmt);
+	if (LIKELY(bits_lo == bits_hi)) {
+		return bits_lo;
+	}
+
+	/* Walk up from the low end while the value is past the half way point to
+	 * the next float, a tie goes to the even one. */
+	uint64_t bits = bits_lo;
+	while (bits < bits_hi) {
+		int32_t e;
+		const uint64_t m = num_bits_significand(bits, fmt, &e);
+		const int cmp = num_compare_half_way(dec, m, e);
+		if (cmp < 0 || (cmp == 0 && (m & 1) == 0)) {
+			break;
+		}
+		bits++;
+	}
+	return bits;
+}
+
+/**
+ * Parse the sign, "inf", "infinity" and "nan" and fill \a dec for the rest.
+ * \return The bytes parsed, zero when there is no number.
+ */
+static size_t num_parse_float(const char *str,
+							  const size_t len,
+							  bool *r_sign,
+							  int *r_special,
+							  NumDecimal *dec)
+{
+	const size_t sign_len = (len && (str[0] == '-' || str[0] == '+')) ? 1 : 0;
+	*r_sign = sign_len && str[0] == '-';
+	*r_special = 0;
+
+	const char *p = str + sign_len;
+	const size_t rest = len - sign_len;
+	size_t word_len;
+	if ((word_len = num_match_word(p, rest, "infinity")) ||
+		(word_len = num_match_word(p, rest, "inf")))
+	{
+		*r_special = 1;
+		return sign_len + word_len;
+	}
+	if ((word_len = num_match_word(p, rest, "nan"))) {
+		*r_special = 2;
+		return sign_len + word_len;
+	}
+
+	const size_t number_len = num_parse_decimal(p, rest, dec);
+	return number_len ? sign_len + number_len : 0;
+}
+
+/** Products and quotients of exact doubles are rounded once, when the
+ * arithmetic isn't done at a higher precision. */
+#if !defined(FLT_EVAL_METHOD) || FLT_EVAL_METHOD == 0
+#	define NUM_EXACT_DOUBLE_ARITHMETIC
+#endif
+
+size_t GLU_chars_to_double(const char *str, size_t len, double *r_value)
+{
+	bool sign;
+	int special;
+	NumDecimal dec;
+	const size_t parsed = num_parse_float(str, len, &sign, &special, &dec);
+	if (parsed == 0) {
+		return 0;
+	}
+
+	uint64_t bits;
+	if (special) {
+		bits = (special == 1) ? UINT64_C(0x7FF0000000000000) :
+								UINT64_C(0x7FF8000000000000);
+	}
+#ifdef NUM_EXACT_DOUBLE_ARITHMETIC
+	else if (!dec.truncated && dec.mantissa <= ((uint64_t)1 << 53) &&
+			 dec.exponent >= -22 && dec.exponent <= 22)
+	{
+		/* Both the digits and the power of ten are exact doubles. */
+		static const double pow10[23] = {
+			1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+		double value = (double)dec.mantissa;
+		value = (dec.exponent < 0) ? value / pow10[-dec.exponent] :
+									 value * pow10[dec.exponent];
+		*r_value = sign ? -value : value;
+		return parsed;
+	}
+#endif
+	else {
+		bits = num_decimal_to_bits(&dec, &num_format_double);
+	}
+
+	bits |= (uint64_t)sign << 63;
+	memcpy(r_value, &bits, sizeof(bits));
+	return parsed;
+}
+
+size_t GLU_chars_to_float(const char *str, size_t len, float *r_value)
+{
+	bool sign;
+	int special;
+	NumDecimal dec;
+	const size_t parsed = num_parse_float(str, len, &sign, &special, &dec);
+	if (parsed == 0) {
+		return 0;
+	}
+
+	uint32_t bits;
+	if (special) {
+		bits = (special == 1) ? 0x7F800000u : 0x7FC00000u;
+	}
+	else {
+		bits = (uint32_t)num_decimal_to_bits(&dec, &num_format_float);
+	}
+
+	bits |= (uint32_t)sign << 31;
+	memcpy(r_value, &bits, sizeof(bits));
+	return parsed;
+}
+
+/** \} */
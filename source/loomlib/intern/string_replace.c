@@ -0,0 +1,394 @@
+#include "guardedalloc/mem_guardedalloc.h"
+
+#include "loomlib/loomlib_assert.h"
+#include "loomlib/loomlib_string.h"
+#include "loomlib/loomlib_string_replace.h"
+
+#include <string.h>
+
+/* -------------------------------------------------------------------- */
+/** \name Structs
+ *
+ * The automaton is a complete DFA (every failure transition resolved at build
+ * time) over byte classes, every byte that occurs in a pattern has a class of
+ * its own and all other bytes share class 0, which keeps the transition table
+ * at `nstates * nclasses` entries instead of `nstates * 256`.
+ * \{ */
+
+typedef struct StrReplacePattern {
+	const char *str;
+	size_t len;
+	const char *replacement;
+	size_t replacement_len;
+} StrReplacePattern;
+
+typedef struct StrReplaceState {
+	/** Length of the pattern prefix the state stands for. */
+	int depth;
+	/** The longest pattern that is a suffix of the state or -1. */
+	int match;
+} StrReplaceState;
+
+struct StrReplacer {
+	StrReplacePattern *patterns;
+	int npatterns;
+	/** All pattern and replacement strings. */
+	char *strings;
+
+	/* The automaton, unused with a single pattern. */
+	int nstates;
+	int nclasses;
+	unsigned char byte_class[256];
+	/** `nstates * nclasses` transitions, state 0 is the root. */
+	int *delta;
+	StrReplaceState *states;
+	/** The first bytes of the patterns, skipped to from the root. */
+	StrCharClass first;
+};
+
+typedef struct StrReplaceOut {
+	StrReplaceWriteFn write_fn;
+	void *user_data;
+	/** When NULL (and no #write_fn) only the length is counted. */
+	char *dst;
+	size_t len;
+} StrReplaceOut;
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Internal Utility API
+ * \{ */
+
+LOOM_INLINE void str_replace_emit(StrReplaceOut *out,
+								  const char *data,
+								  size_t len)
+{
+	if (out->write_fn) {
+		if (len) {
+			out->write_fn(out->user_data, data, len);
+		}
+	}
+	else if (out->dst) {
+		memcpy(out->dst + out->len, data, len);
+	}
+	out->len += len;
+}
+
+static void str_replace_scan_single(const char *str,
+									const char *pattern,
+									const size_t pattern_len,
+									const char *replacement,
+									const size_t replacement_len,
+									StrReplaceOut *out)
+{
+	const char *end = str + GLU_strlen(str);
+	const char *lit = str;
+
+	if ((size_t)(end - str) >= pattern_len) {
+		const char *last = end - pattern_len;
+		const char *p = str;
+		while (p <= last) {
+			const char *q = GLU_memchr(p, pattern[0], (size_t)(last - p) + 1);
+			if (q == NULL) {
+				break;
+			}
+			if (memcmp(q + 1, pattern + 1, pattern_len - 1) == 0) {
+				str_replace_emit(out, lit, (size_t)(q - lit));
+				str_replace_emit(out, replacement, replacement_len);
+				lit = p = q + pattern_len;
+			}
+			else {
+				p = q + 1;
+			}
+		}
+	}
+
+	str_replace_emit(out, lit, (size_t)(end - lit));
+}
+
+/**
+ * Leftmost-longest replacement with the automaton.
+ *
+ * A match is kept pending until no later match can start at or before it,
+ * which is known once the start of the current state (the earliest start of
+ * any match still to come) moves past it. Matches overlapping the committed
+ * one are dropped by restarting from its end.
+ *
+ * The restart reads again the bytes between the end of the committed match
+ * and the current byte, less than the longest pattern, so a string of \a n
+ * bytes costs O(n * longest pattern) at worst, not O(n). Recovering the
+ * matches that start past the committed one without the rescan needs the
+ * matches ending at every byte, which the DFA does not keep.
+ */
+static void str_replace_scan_multi(const StrReplacer *rep,
+								   const char *str,
+								   StrReplaceOut *out)
+{
+	const unsigned char *s = (const unsigned char *)str;
+	const int nclasses = rep->nclasses;
+	size_t i = 0, lit = 0;
+	int state = 0;
+
+	int pending = -1;
+	size_t pending_start = 0;
+
+	for (;;) {
+		if (state == 0 && pending < 0) {
+			i += GLU_strcspn_class(str + i, &rep->first);
+		}
+
+		const unsigned char c = s[i];
+		if (c != '\0') {
+			state = rep->delta[state * nclasses + rep->byte_class[c]];
+			i++;
+
+			const int match = rep->states[state].match;
+			if (match >= 0) {
+				const size_t start = i - rep->patterns[match].len;
+				if (pending < 0 || start <= pending_start) {
+					pending = match;
+					pending_start = start;
+				}
+			}
+			if (pending < 0 ||
+				i - (size_t)rep->states[state].depth <= pending_start)
+			{
+				continue;
+			}
+		}
+		else if (pending < 0) {
+			break;
+		}
+
+		const StrReplacePattern *pattern = &rep->patterns[pending];
+		str_replace_emit(out, str + lit, pending_start - lit);
+		str_replace_emit(out, pattern->replacement, pattern->replacement_len);
+		lit = i = pending_start + pattern->len;
+		state = 0;
+		pending = -1;
+	}
+
+	str_replace_emit(out, str + lit, i - lit);
+}
+
+static void str_replace_scan(const StrReplacer *rep,
+							 const char *str,
+							 StrReplaceOut *out)
+{
+	if (rep->npatterns == 1) {
+		const StrReplacePattern *pattern = &rep->patterns[0];
+		str_replace_scan_single(str,
+								pattern->str,
+								pattern->len,
+								pattern->replacement,
+								pattern->replacement_len,
+								out);
+	}
+	else {
+		str_replace_scan_multi(rep, str, out);
+	}
+}
+
+static void str_replacer_build_automaton(StrReplacer *rep)
+{
+	size_t total_len = 0;
+	char first_chars[257] = {'\0'};
+	int nfirst = 0;
+
+	memset(rep->byte_class, 0, sizeof(rep->byte_class));
+	rep->nclasses = 1;
+	for (int i = 0; i < rep->npatterns; i++) {
+		const StrReplacePattern *pattern = &rep->patterns[i];
+		for (size_t j = 0; j < pattern->len; j++) {
+			const unsigned char c = (unsigned char)pattern->str[j];
+			if (rep->byte_class[c] == 0) {
+				rep->byte_class[c] = (unsigned char)rep->nclasses++;
+			}
+		}
+		total_len += pattern->len;
+
+		if (pattern->len && !strchr(first_chars, pattern->str[0])) {
+			first_chars[nfirst++] = pattern->str[0];
+			first_chars[nfirst] = '\0';
+		}
+	}
+	GLU_str_charclass_init(&rep->first, first_chars);
+
+	const int nclasses = rep->nclasses;
+	const size_t max_states = total_len + 1;
+	/* Zero is the root, which is never a child, so it marks missing edges
+	 * while the trie is built. */
+	int *delta = MEM_calloc_arrayN(
+		max_states * nclasses, sizeof(*delta), "StrReplacer::delta");
+	StrReplaceState *states = MEM_malloc_arrayN(
+		max_states, sizeof(*states), "StrReplacer::states");
+	int nstates = 1;
+	states[0].depth = 0;
+	states[0].match = -1;
+
+	for (int i = 0; i < rep->npatterns; i++) {
+		const StrReplacePattern *pattern = &rep->patterns[i];
+		int state = 0;
+		for (size_t j = 0; j < pattern->len; j++) {
+			int *edge = &delta[state * nclasses +
+							   rep->byte_class[(unsigned char)pattern->str[j]]];
+			if (*edge == 0) {
+				states[nstates].depth = states[state].depth + 1;
+				states[nstates].match = -1;
+				*edge = nstates++;
+			}
+			state = *edge;
+		}
+		if (pattern->len && states[state].match < 0) {
+			states[state].match = i;
+		}
+	}
+
+	/* Breadth first, so the failure state of a state (always shallower) has
+	 * all its transitions resolved before they are copied. */
+	int *fail = MEM_malloc_arrayN(nstates, sizeof(*fail), __func__);
+	int *queue = MEM_malloc_arrayN(nstates, sizeof(*queue), __func__);
+	int queue_head = 0, queue_tail = 0;
+	queue[queue_tail++] = 0;
+	fail[0] = 0;
+
+	while (queue_head < queue_tail) {
+		const int state = queue[queue_head++];
+		int *row = &delta[state * nclasses];
+		const int *fail_row = &delta[fail[state] * nclasses];
+
+		for (int c = 0; c < nclasses; c++) {
+			const int child = row[c];
+			if (child == 0) {
+				row[c] = (state == 0) ? 0 : fail_row[c];
+				continue;
+			}
+			fail[child] = (state == 0) ? 0 : fail_row[c];
+			if (states[child].match < 0) {
+				states[child].match = states[fail[child]].match;
+			}
+			queue[queue_tail++] = child;
+		}
+	}
+
+	MEM_freeN(queue);
+	MEM_freeN(fail);
+
+	rep->delta = delta;
+	rep->states = states;
+	rep->nstates = nstates;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name String Replace API
+ * \{ */
+
+StrReplacer *GLU_str_replacer_new(const char *const *patterns,
+								  const char *const *replacements,
+								  int npatterns)
+{
+	StrReplacer *rep = MEM_callocN(sizeof(*rep), __func__);
+
+	size_t strings_len = 0;
+	for (int i = 0; i < npatterns; i++) {
+		LOOM_assert(patterns[i][0] != '\0');
+		strings_len += GLU_strlen(patterns[i]) + GLU_strlen(replacements[i]) + 2;
+	}
+
+	rep->npatterns = npatterns;
+	rep->patterns = MEM_malloc_arrayN(
+		MAX2(npatterns, 1), sizeof(*rep->patterns), "StrReplacer::patterns");
+	rep->strings = MEM_mallocN(MAX2(strings_len, 1), "StrReplacer::strings");
+
+	char *s = rep->strings;
+	for (int i = 0; i < npatterns; i++) {
+		StrReplacePattern *pattern = &rep->patterns[i];
+		pattern->str = s;
+		pattern->len = GLU_strcpy_rlen(s, patterns[i]);
+		s += pattern->len + 1;
+		pattern->replacement = s;
+		pattern->replacement_len = GLU_strcpy_rlen(s, replacements[i]);
+		s += pattern->replacement_len + 1;
+	}
+
+	if (npatterns != 1) {
+		str_replacer_build_automaton(rep);
+	}
+
+	return rep;
+}
+
+void GLU_str_replacer_free(StrReplacer *rep)
+{
+	MEM_SAFE_FREE(rep->delta);
+	MEM_SAFE_FREE(rep->states);
+	MEM_freeN(rep->strings);
+	MEM_freeN(rep->patterns);
+	MEM_freeN(rep);
+}
+
+size_t GLU_str_replacer_len(const StrReplacer *rep, const char *str)
+{
+	StrReplaceOut out = {NULL, NULL, NULL, 0};
+	str_replace_scan(rep, str, &out);
+	return out.len;
+}
+
+size_t GLU_str_replacer_write(const StrReplacer *rep,
+							  const char *__restrict str,
+							  char *__restrict dst)
+{
+	StrReplaceOut out = {NULL, NULL, dst, 0};
+	str_replace_scan(rep, str, &out);
+	dst[out.len] = '\0';
+	return out.len;
+}
+
+char *GLU_str_replacer_applyN(const StrReplacer *rep, const char *str)
+{
+	char *dst = MEM_mallocN(GLU_str_replacer_len(rep, str) + 1, __func__);
+	GLU_str_replacer_write(rep, str, dst);
+	return dst;
+}
+
+void GLU_str_replacer_stream(const StrReplacer *rep,
+							 const char *str,
+							 StrReplaceWriteFn write_fn,
+							 void *user_data)
+{
+	StrReplaceOut out = {write_fn, user_data, NULL, 0};
+	str_replace_scan(rep, str, &out);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name String Transform
+ * \{ */
+
+char *GLU_str_replaceN(const char *__restrict str,
+					   const char *__restrict substr_old,
+					   const char *__restrict substr_new)
+{
+	const size_t oldlen = GLU_strlen(substr_old);
+	const size_t newlen = GLU_strlen(substr_new);
+
+	if (oldlen == 0) {
+		return GLU_strdup(str);
+	}
+
+	StrReplaceOut out = {NULL, NULL, NULL, 0};
+	str_replace_scan_single(str, substr_old, oldlen, substr_new, newlen, &out);
+
+	out.dst = MEM_mallocN(out.len + 1, __func__);
+	out.len = 0;
+	str_replace_scan_single(str, substr_old, oldlen, substr_new, newlen, &out);
+	out.dst[out.len] = '\0';
+
+	return out.dst;
+}
+
+/** \} */
@@ -0,0 +1,801 @@
+#include "guardedalloc/mem_guardedalloc.h"
+
+#include "loomlib/loomlib_assert.h"
+#include "loomlib/loomlib_string.h"
+#include "loomlib/loomlib_string_search.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/* -------------------------------------------------------------------- */
+/** \name Platform
+ *
+ * The byte filter kernels follow #GLU_str_simd_level_get, so the level set
+ * for the other string functions applies to them as well.
+ * \{ */
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+	defined(_M_IX86)
+#	define STR_SIMD_X86
+#	include <immintrin.h>
+#	if defined(_MSC_VER)
+#		include <intrin.h>
+#	endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#	define STR_TARGET(_isa) __attribute__((target(_isa)))
+#else
+#	define STR_TARGET(_isa)
+#endif
+
+#ifdef STR_SIMD_X86
+LOOM_INLINE unsigned int str_ctz32(uint32_t x)
+{
+#	if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, x);
+	return (unsigned int)index;
+#	else
+	return (unsigned int)__builtin_ctz(x);
+#	endif
+}
+
+LOOM_INLINE unsigned int str_ctz64(uint64_t x)
+{
+#	if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanForward64(&index, x);
+	return (unsigned int)index;
+#	elif defined(_MSC_VER)
+	return ((uint32_t)x) ? str_ctz32((uint32_t)x) :
+						   32 + str_ctz32((uint32_t)(x >> 32));
+#	else
+	return (unsigned int)__builtin_ctzll(x);
+#	endif
+}
+
+/** \return The index of the highest set bit. */
+LOOM_INLINE unsigned int str_bsr32(uint32_t x)
+{
+#	if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanReverse(&index, x);
+	return (unsigned int)index;
+#	else
+	return 31u - (unsigned int)__builtin_clz(x);
+#	endif
+}
+
+LOOM_INLINE unsigned int str_bsr64(uint64_t x)
+{
+#	if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanReverse64(&index, x);
+	return (unsigned int)index;
+#	elif defined(_MSC_VER)
+	return (x >> 32) ? 32 + str_bsr32((uint32_t)(x >> 32)) :
+					   str_bsr32((uint32_t)x);
+#	else
+	return 63u - (unsigned int)__builtin_clzll(x);
+#	endif
+}
+#endif
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Structs
+ * \{ */
+
+/**
+ * The needle's first and last byte, each in both cases when the case is
+ * ignored (otherwise the same byte twice).
+ */
+typedef struct StrBytePair {
+	unsigned char first[2];
+	unsigned char last[2];
+	/** The distance of the last byte from the first. */
+	size_t last_offset;
+} StrBytePair;
+
+/** A Two-Way critical factorization of the needle. */
+typedef struct StrTwoWay {
+	/** The start of the right half. */
+	size_t suffix;
+	/** The period of the needle when it is periodic, else the shift used on
+	 * a mismatch in the left half. */
+	size_t period;
+	bool periodic;
+} StrTwoWay;
+
+struct StrNeedle {
+	const unsigned char *str;
+	size_t len;
+	bool fold;
+	StrBytePair pair;
+	/** The factorizations are computed on demand by the plain functions,
+	 * #GLU_str_needle_new computes both. */
+	bool prepared;
+	StrTwoWay fwd, rev;
+};
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Byte Filter Kernels
+ *
+ * Find the next position whose byte matches the needle's first byte and
+ * whose byte at the needle's length matches its last, which rules out most
+ * positions for a single vector compare each (and few candidates are left
+ * to compare in full for any needle that isn't made of common bytes).
+ *
+ * The find kernels return the first position below \a npos that passes,
+ * \a npos when none does, the rfind kernels one past the last that passes,
+ * 0 when none does. The haystack must have `npos + pair->last_offset` bytes.
+ * \{ */
+
+LOOM_INLINE bool str_pair_test(const unsigned char *hay,
+							   const size_t i,
+							   const StrBytePair *pair)
+{
+	const unsigned char a = hay[i], b = hay[i + pair->last_offset];
+	return (a == pair->first[0] || a == pair->first[1]) &&
+		   (b == pair->last[0] || b == pair->last[1]);
+}
+
+static size_t str_pair_find_scalar(const unsigned char *hay,
+								   const size_t npos,
+								   const StrBytePair *pair)
+{
+	for (size_t i = 0; i < npos; i++) {
+		if (str_pair_test(hay, i, pair)) {
+			return i;
+		}
+	}
+	return npos;
+}
+
+static size_t str_pair_rfind_scalar(const unsigned char *hay,
+									size_t npos,
+									const StrBytePair *pair)
+{
+	for (; npos; npos--) {
+		if (str_pair_test(hay, npos - 1, pair)) {
+			break;
+		}
+	}
+	return npos;
+}
+
+#ifdef STR_SIMD_X86
+
+STR_TARGET("sse2")
+LOOM_INLINE uint32_t str_pair_mask_sse2(const unsigned char *hay,
+										const size_t i,
+										const StrBytePair *pair)
+{
+	const __m128i a = _mm_loadu_si128((const __m128i *)(hay + i));
+	const __m128i b = _mm_loadu_si128(
+		(const __m128i *)(hay + i + pair->last_offset));
+	const __m128i match = _mm_and_si128(
+		_mm_or_si128(_mm_cmpeq_epi8(a, _mm_set1_epi8((char)pair->first[0])),
+					 _mm_cmpeq_epi8(a, _mm_set1_epi8((char)pair->first[1]))),
+		_mm_or_si128(_mm_cmpeq_epi8(b, _mm_set1_epi8((char)pair->last[0])),
+					 _mm_cmpeq_epi8(b, _mm_set1_epi8((char)pair->last[1]))));
+	return (uint32_t)_mm_movemask_epi8(match);
+}
+
+STR_TARGET("sse2")
+static size_t str_pair_find_sse2(const unsigned char *hay,
+								 const size_t npos,
+								 const StrBytePair *pair)
+{
+	size_t i = 0;
+	for (; i + 16 <= npos; i += 16) {
+		const uint32_t mask = str_pair_mask_sse2(hay, i, pair);
+		if (mask) {
+			return i + str_ctz32(mask);
+		}
+	}
+	return i + str_pair_find_scalar(hay + i, npos - i, pair);
+}
+
+STR_TARGET("sse2")
+static size_t str_pair_rfind_sse2(const unsigned char *hay,
+								  size_t npos,
+								  const StrBytePair *pair)
+{
+	for (; npos >= 16; npos -= 16) {
+		const uint32_t mask = str_pair_mask_sse2(hay, npos - 16, pair);
+		if (mask) {
+			return npos - 15 + str_bsr32(mask);
+		}
+	}
+	return str_pair_rfind_scalar(hay, npos, pair);
+}
+
+STR_TARGET("avx2")
+LOOM_INLINE uint32_t str_pair_mask_avx2(const unsigned char *hay,
+										const size_t i,
+										const StrBytePair *pair)
+{
+	const __m256i a = _mm256_loadu_si256((const __m256i *)(hay + i));
+	const __m256i b = _mm256_loadu_si256(
+		(const __m256i *)(hay + i + pair->last_offset));
+	const __m256i match = _mm256_and_si256(
+		_mm256_or_si256(
+			_mm256_cmpeq_epi8(a, _mm256_set1_epi8((char)pair->first[0])),
+			_mm256_cmpeq_epi8(a, _mm256_set1_epi8((char)pair->first[1]))),
+		_mm256_or_si256(
+			_mm256_cmpeq_epi8(b, _mm256_set1_epi8((char)pair->last[0])),
+			_mm256_cmpeq_epi8(b, _mm256_set1_epi8((char)pair->last[1]))));
+	return (uint32_t)_mm256_movemask_epi8(match);
+}
+
+STR_TARGET("avx2")
+static size_t str_pair_find_avx2(const unsigned char *hay,
+								 const size_t npos,
+								 const StrBytePair *pair)
+{
+	size_t i = 0;
+	for (; i + 32 <= npos; i += 32) {
+		const uint32_t mask = str_pair_mask_avx2(hay, i, pair);
+		if (mask) {
+			return i + str_ctz32(mask);
+		}
+	}
+	return i + str_pair_find_sse2(hay + i, npos - i, pair);
+}
+
+STR_TARGET("avx2")
+static size_t str_pair_rfind_avx2(const unsigned char *hay,
+								  size_t npos,
+								  const StrBytePair *pair)
+{
+	for (; npos >= 32; npos -= 32) {
+		const uint32_t mask = str_pair_mask_avx2(hay, npos - 32, pair);
+		if (mask) {
+			return npos - 31 + str_bsr32(mask);
+		}
+	}
+	return str_pair_rfind_sse2(hay, npos, pair);
+}
+
+#	define STR_TARGET_AVX512 STR_TARGET("avx512f,avx512bw")
+
+STR_TARGET_AVX512
+LOOM_INLINE uint64_t str_pair_mask_avx512(const unsigned char *hay,
+										  const size_t i,
+										  const StrBytePair *pair)
+{
+	const __m512i a = _mm512_loadu_si512((const void *)(hay + i));
+	const __m512i b = _mm512_loadu_si512(
+		(const void *)(hay + i + pair->last_offset));
+	return (_mm512_cmpeq_epi8_mask(a, _mm512_set1_epi8((char)pair->first[0])) |
+			_mm512_cmpeq_epi8_mask(a, _mm512_set1_epi8((char)pair->first[1]))) &
+		   (_mm512_cmpeq_epi8_mask(b, _mm512_set1_epi8((char)pair->last[0])) |
+			_mm512_cmpeq_epi8_mask(b, _mm512_set1_epi8((char)pair->last[1])));
+}
+
+STR_TARGET_AVX512
+static size_t str_pair_find_avx512(const unsigned char *hay,
+								   const size_t npos,
+								   const StrBytePair *pair)
+{
+	size_t i = 0;
+	for (; i + 64 <= npos; i += 64) {
+		const uint64_t mask = str_pair_mask_avx512(hay, i, pair);
+		if (mask) {
+			return i + str_ctz64(mask);
+		}
+	}
+	return i + str_pair_find_avx2(hay + i, npos - i, pair);
+}
+
+STR_TARGET_AVX512
+static size_t str_pair_rfind_avx512(const unsigned char *hay,
+									size_t npos,
+									const StrBytePair *pair)
+{
+	for (; npos >= 64; npos -= 64) {
+		const uint64_t mask = str_pair_mask_avx512(hay, npos - 64, pair);
+		if (mask) {
+			return npos - 63 + str_bsr64(mask);
+		}
+	}
+	return str_pair_rfind_avx2(hay, npos, pair);
+}
+
+#endif /* STR_SIMD_X86 */
+
+typedef struct StrPairFuncs {
+	size_t (*find)(const unsigned char *hay,
+				   const size_t npos,
+				   const StrBytePair *pair);
+	size_t (*rfind)(const unsigned char *hay,
+					size_t npos,
+					const StrBytePair *pair);
+} StrPairFuncs;
+
+static const StrPairFuncs str_pair_funcs[] = {
+	[STR_SIMD_SCALAR] = {str_pair_find_scalar, str_pair_rfind_scalar},
+#ifdef STR_SIMD_X86
+	[STR_SIMD_SSE2] = {str_pair_find_sse2, str_pair_rfind_sse2},
+	[STR_SIMD_AVX2] = {str_pair_find_avx2, str_pair_rfind_avx2},
+	[STR_SIMD_AVX512] = {str_pair_find_avx512, str_pair_rfind_avx512},
+#endif
+};
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Two-Way
+ *
+ * Crochemore and Perrin's string matching, linear time and constant space.
+ * The needle is split at a critical factorization, the right half is
+ * compared first left to right and then the left half right to left, a
+ * mismatch shifts by at least the number of bytes matched in the right half
+ * or by the period, so no byte of the haystack is compared more than twice.
+ *
+ * The same code searches backwards by reading both strings reversed,
+ * the constant \a fold and \a reverse arguments are folded away where the
+ * functions are inlined.
+ * \{ */
+
+LOOM_INLINE unsigned char str_fold(const unsigned char c)
+{
+	return ((unsigned char)(c - 'A') < 26) ? (unsigned char)(c | 0x20) : c;
+}
+
+LOOM_INLINE unsigned char str_at(const unsigned char *s,
+								 const size_t len,
+								 const size_t i,
+								 const bool fold,
+								 const bool reverse)
+{
+	const unsigned char c = s[reverse ? len - 1 - i : i];
+	return fold ? str_fold(c) : c;
+}
+
+/**
+ * The maximal suffix of the needle for the byte order or (with \a inverse)
+ * its opposite.
+ * \return The index before the suffix, SIZE_MAX for the whole needle.
+ */
+LOOM_INLINE size_t str_max_suffix(const unsigned char *x,
+								  const size_t n,
+								  const bool inverse,
+								  const bool fold,
+								  const bool reverse,
+								  size_t *r_period)
+{
+	size_t max_suffix = SIZE_MAX, j = 0, k = 1, p = 1;
+	while (j + k < n) {
+		const unsigned char a = str_at(x, n, j + k, fold, reverse);
+		const unsigned char b = str_at(x, n, max_suffix + k, fold, reverse);
+		if (inverse ? (a > b) : (a < b)) {
+			j += k;
+			k = 1;
+			p = j - max_suffix;
+		}
+		else if (a == b) {
+			if (k != p) {
+				k++;
+			}
+			else {
+				j += p;
+				k = 1;
+			}
+		}
+		else {
+			max_suffix = j++;
+			k = p = 1;
+		}
+	}
+	*r_period = p;
+	return max_suffix;
+}
+
+LOOM_INLINE void str_two_way_init(StrTwoWay *tw,
+								  const unsigned char *x,
+								  const size_t n,
+								  const bool fold,
+								  const bool reverse)
+{
+	size_t period, period_inv;
+	const size_t max_suffix = str_max_suffix(
+		x, n, false, fold, reverse, &period);
+	const size_t max_suffix_inv = str_max_suffix(
+		x, n, true, fold, reverse, &period_inv);
+
+	/* The later of the two is a critical factorization. */
+	if (max_suffix_inv + 1 < max_suffix + 1) {
+		tw->suffix = max_suffix + 1;
+		tw->period = period;
+	}
+	else {
+		tw->suffix = max_suffix_inv + 1;
+		tw->period = period_inv;
+	}
+
+	tw->periodic = true;
+	for (size_t i = 0; i < tw->suffix; i++) {
+		if (str_at(x, n, i, fold, reverse) !=
+			str_at(x, n, i + tw->period, fold, reverse))
+		{
+			tw->periodic = false;
+			break;
+		}
+	}
+	if (!tw->periodic) {
+		tw->period = MAX2(tw->suffix, n - tw->suffix) + 1;
+	}
+}
+
+/**
+ * The shift after a mismatch at \a i in the right half. A mismatch at its
+ * first byte only shifts by one, the positions up to the next occurrence of
+ * that byte would all fail the same way so they are skipped with
+ * #GLU_memchr when it applies (searching forwards, case sensitive).
+ * \return The next position, past `m - n` when there is none.
+ */
+LOOM_INLINE size_t str_two_way_skip(const unsigned char *x,
+									const size_t n,
+									const unsigned char *y,
+									const size_t m,
+									const size_t j,
+									const size_t i,
+									const size_t suffix,
+									const bool fold,
+									const bool reverse)
+{
+	if (fold || reverse || i != suffix) {
+		return j + i - suffix + 1;
+	}
+	const unsigned char *p = GLU_memchr(
+		y + j + suffix + 1, x[suffix], m - n - j);
+	return p ? (size_t)(p - y) - suffix : m;
+}
+
+/**
+ * Search \a y (\a m bytes) for \a x (\a n bytes) from position \a j on.
+ * \return The position of the first occurrence, SIZE_MAX when there is none.
+ */
+LOOM_INLINE size_t str_two_way_search(const StrTwoWay *tw,
+									  const unsigned char *x,
+									  const size_t n,
+									  const unsigned char *y,
+									  const size_t m,
+									  size_t j,
+									  const bool fold,
+									  const bool reverse)
+{
+	const size_t suffix = tw->suffix, period = tw->period;
+
+	if (tw->periodic) {
+		/* The prefix matched by the last shift by the period is known to
+		 * match again and is skipped. */
+		size_t memory = 0;
+		while (j <= m - n) {
+			size_t i = MAX2(suffix, memory);
+			while (i < n && str_at(x, n, i, fold, reverse) ==
+								str_at(y, m, i + j, fold, reverse))
+			{
+				i++;
+			}
+			if (i >= n) {
+				i = suffix - 1;
+				while (memory < i + 1 && str_at(x, n, i, fold, reverse) ==
+											 str_at(y, m, i + j, fold, reverse))
+				{
+					i--;
+				}
+				if (i + 1 < memory + 1) {
+					return j;
+				}
+				j += period;
+				memory = n - period;
+			}
+			else {
+				j = str_two_way_skip(x, n, y, m, j, i, suffix, fold, reverse);
+				memory = 0;
+			}
+		}
+	}
+	else {
+		while (j <= m - n) {
+			size_t i = suffix;
+			while (i < n && str_at(x, n, i, fold, reverse) ==
+								str_at(y, m, i + j, fold, reverse))
+			{
+				i++;
+			}
+			if (i >= n) {
+				i = suffix - 1;
+				while (i != SIZE_MAX && str_at(x, n, i, fold, reverse) ==
+											str_at(y, m, i + j, fold, reverse))
+				{
+					i--;
+				}
+				if (i == SIZE_MAX) {
+					return j;
+				}
+				j += period;
+			}
+			else {
+				j = str_two_way_skip(x, n, y, m, j, i, suffix, fold, reverse);
+			}
+		}
+	}
+	return SIZE_MAX;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Search
+ * \{ */
+
+static void str_needle_init(StrNeedle *nd,
+							const unsigned char *str,
+							const size_t len,
+							const bool fold)
+{
+	nd->str = str;
+	nd->len = len;
+	nd->fold = fold;
+	nd->prepared = false;
+
+	if (len) {
+		const unsigned char first = str[0], last = str[len - 1];
+		nd->pair.first[0] = nd->pair.first[1] = first;
+		nd->pair.last[0] = nd->pair.last[1] = last;
+		if (fold) {
+			nd->pair.first[0] = str_fold(first);
+			nd->pair.first[1] = (unsigned char)(nd->pair.first[0] - 'a') < 26 ?
+									(unsigned char)(nd->pair.first[0] ^ 0x20) :
+									first;
+			nd->pair.last[0] = str_fold(last);
+			nd->pair.last[1] = (unsigned char)(nd->pair.last[0] - 'a') < 26 ?
+								   (unsigned char)(nd->pair.last[0] ^ 0x20) :
+								   last;
+		}
+		nd->pair.last_offset = len - 1;
+	}
+}
+
+/* Specialized for the case folding, with \a reverse constant at each call. */
+
+LOOM_INLINE void str_needle_two_way_init(const StrNeedle *nd,
+										 StrTwoWay *tw,
+										 const bool reverse)
+{
+	if (nd->fold) {
+		str_two_way_init(tw, nd->str, nd->len, true, reverse);
+	}
+	else {
+		str_two_way_init(tw, nd->str, nd->len, false, reverse);
+	}
+}
+
+LOOM_INLINE size_t str_needle_two_way_search(const StrNeedle *nd,
+											 const StrTwoWay *tw,
+											 const unsigned char *hay,
+											 const size_t hay_len,
+											 const size_t start,
+											 const bool reverse)
+{
+	if (nd->fold) {
+		return str_two_way_search(
+			tw, nd->str, nd->len, hay, hay_len, start, true, reverse);
+	}
+	return str_two_way_search(
+		tw, nd->str, nd->len, hay, hay_len, start, false, reverse);
+}
+
+static void str_needle_prepare(StrNeedle *nd)
+{
+	str_needle_two_way_init(nd, &nd->fwd, false);
+	str_needle_two_way_init(nd, &nd->rev, true);
+	nd->prepared = true;
+}
+
+/** Whether the bytes between the first and the last match. */
+LOOM_INLINE bool str_needle_verify(const StrNeedle *nd, const unsigned char *p)
+{
+	if (!nd->fold) {
+		return memcmp(p + 1, nd->str + 1, nd->len - 2) == 0;
+	}
+	for (size_t i = 1; i + 1 < nd->len; i++) {
+		if (str_fold(p[i]) != str_fold(nd->str[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static const unsigned char *str_needle_find(const StrNeedle *nd,
+											const unsigned char *hay,
+											const size_t hay_len)
+{
+	const size_t n = nd->len;
+	if (n == 0) {
+		return hay;
+	}
+	if (n > hay_len) {
+		return NULL;
+	}
+	if (n == 1 && !nd->fold) {
+		return GLU_memchr(hay, nd->str[0], hay_len);
+	}
+
+	/* Filter and compare the candidates, until comparing them costs more
+	 * than the filter saves (many candidates and long partial matches, e.g.
+	 * repetitive text) when the rest is left to Two-Way. That bounds the
+	 * whole search to linear time. */
+	const StrPairFuncs *funcs = &str_pair_funcs[GLU_str_simd_level_get()];
+	const size_t npos = hay_len - n + 1;
+	size_t i = 0, work = 0;
+	for (;;) {
+		i += funcs->find(hay + i, npos - i, &nd->pair);
+		if (i == npos) {
+			return NULL;
+		}
+		if (n <= 2 || str_needle_verify(nd, hay + i)) {
+			return hay + i;
+		}
+		i++;
+		work += n;
+		if (work > 256 + 8 * i) {
+			break;
+		}
+	}
+
+	StrTwoWay tw_local;
+	const StrTwoWay *tw = &nd->fwd;
+	if (!nd->prepared) {
+		str_needle_two_way_init(nd, &tw_local, false);
+		tw = &tw_local;
+	}
+	const size_t j = str_needle_two_way_search(nd, tw, hay, hay_len, i, false);
+	return (j != SIZE_MAX) ? hay + j : NULL;
+}
+
+static const unsigned char *str_needle_rfind(const StrNeedle *nd,
+											 const unsigned char *hay,
+											 const size_t hay_len)
+{
+	const size_t n = nd->len;
+	if (n == 0) {
+		return hay + hay_len;
+	}
+	if (n > hay_len) {
+		return NULL;
+	}
+
+	/* As #str_needle_find, from the end. */
+	const StrPairFuncs *funcs = &str_pair_funcs[GLU_str_simd_level_get()];
+	const size_t npos = hay_len - n + 1;
+	size_t end = npos, work = 0;
+	for (;;) {
+		end = funcs->rfind(hay, end, &nd->pair);
+		if (end == 0) {
+			return NULL;
+		}
+		end--;
+		if (n <= 2 || str_needle_verify(nd, hay + end)) {
+			return hay + end;
+		}
+		work += n;
+		if (work > 256 + 8 * (npos - end)) {
+			break;
+		}
+	}
+
+	StrTwoWay tw_local;
+	const StrTwoWay *tw = &nd->rev;
+	if (!nd->prepared) {
+		str_needle_two_way_init(nd, &tw_local, true);
+		tw = &tw_local;
+	}
+	/* Positions count from the end of both strings, the ones from \a end on
+	 * are done. */
+	const size_t j = str_needle_two_way_search(
+		nd, tw, hay, hay_len, npos - end, true);
+	return (j != SIZE_MAX) ? hay + (hay_len - n - j) : NULL;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name String Search API
+ * \{ */
+
+char *GLU_strstr(const char *haystack, const char *needle)
+{
+	StrNeedle nd;
+	str_needle_init(
+		&nd, (const unsigned char *)needle, GLU_strlen(needle), false);
+	return (char *)str_needle_find(
+		&nd, (const unsigned char *)haystack, GLU_strlen(haystack));
+}
+
+char *GLU_strcasestr(const char *haystack, const char *needle)
+{
+	StrNeedle nd;
+	str_needle_init(
+		&nd, (const unsigned char *)needle, GLU_strlen(needle), true);
+	return (char *)str_needle_find(
+		&nd, (const unsigned char *)haystack, GLU_strlen(haystack));
+}
+
+char *GLU_strrstr(const char *haystack, const char *needle)
+{
+	StrNeedle nd;
+	str_needle_init(
+		&nd, (const unsigned char *)needle, GLU_strlen(needle), false);
+	return (char *)str_needle_rfind(
+		&nd, (const unsigned char *)haystack, GLU_strlen(haystack));
+}
+
+void *GLU_memmem(const void *haystack,
+				 size_t haystack_len,
+				 const void *needle,
+				 size_t needle_len)
+{
+	StrNeedle nd;
+	str_needle_init(&nd, needle, needle_len, false);
+	return (void *)str_needle_find(&nd, haystack, haystack_len);
+}
+
+void *GLU_memrmem(const void *haystack,
+				  size_t haystack_len,
+				  const void *needle,
+				  size_t needle_len)
+{
+	StrNeedle nd;
+	str_needle_init(&nd, needle, needle_len, false);
+	return (void *)str_needle_rfind(&nd, haystack, haystack_len);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name String Needle API
+ * \{ */
+
+StrNeedle *GLU_str_needle_new(const char *needle, size_t needle_len, int flag)
+{
+	/* The needle is stored after the struct. */
+	StrNeedle *nd = MEM_mallocN(sizeof(*nd) + MAX2(needle_len, 1), __func__);
+	unsigned char *str = (unsigned char *)(nd + 1);
+	memcpy(str, needle, needle_len);
+
+	str_needle_init(nd, str, needle_len, (flag & STR_NEEDLE_IGNORE_CASE) != 0);
+	str_needle_prepare(nd);
+	return nd;
+}
+
+void GLU_str_needle_free(StrNeedle *nd)
+{
+	MEM_freeN(nd);
+}
+
+const char *GLU_str_needle_find(const StrNeedle *nd,
+								const char *haystack,
+								size_t haystack_len)
+{
+	return (const char *)str_needle_find(
+		nd, (const unsigned char *)haystack, haystack_len);
+}
+
+const char *GLU_str_needle_rfind(const StrNeedle *nd,
+								 const char *haystack,
+								 size_t haystack_len)
+{
+	return (const char *)str_needle_rfind(
+		nd, (const unsigned char *)haystack, haystack_len);
+}
+
+/** \} */
@@ -0,0 +1,855 @@
+#include "atomic/atomic_ops.h"
+
+#include "loomlib/loomlib_assert.h"
+#include "loomlib/loomlib_string.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/* -------------------------------------------------------------------- */
+/** \name Platform
+ *
+ * Every kernel is compiled for its own instruction set (target attributes on
+ * GCC/Clang, MSVC doesn't need them) and picked at runtime from CPUID, the
+ * build itself only needs to target the baseline.
+ *
+ * Kernels scan with aligned loads and discard the bytes before the start, an
+ * aligned load never crosses a page so reading past the terminator is safe.
+ * AddressSanitizer still reports those bytes, the kernels that read them are
+ * marked #ATTR_NO_SANITIZE_ADDRESS.
+ * \{ */
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+	defined(_M_IX86)
+#	define STR_SIMD_X86
+#	include <immintrin.h>
+#	if defined(_MSC_VER)
+#		include <intrin.h>
+#	else
+#		include <cpuid.h>
+#	endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#	define STR_TARGET(_isa) __attribute__((target(_isa)))
+#else
+#	define STR_TARGET(_isa)
+#endif
+
+#define STR_PAGE_SIZE 4096
+
+LOOM_INLINE unsigned int str_ctz32(uint32_t x)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, x);
+	return (unsigned int)index;
+#else
+	return (unsigned int)__builtin_ctz(x);
+#endif
+}
+
+LOOM_INLINE unsigned int str_ctz64(uint64_t x)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanForward64(&index, x);
+	return (unsigned int)index;
+#elif defined(_MSC_VER)
+	return ((uint32_t)x) ? str_ctz32((uint32_t)x) :
+						   32 + str_ctz32((uint32_t)(x >> 32));
+#else
+	return (unsigned int)__builtin_ctzll(x);
+#endif
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Character Class
+ *
+ * The class is a 16x16 bit matrix indexed by the low and high nibble of a
+ * byte. Each low nibble has a byte of bits for the high nibbles 0-7 and
+ * another one for 8-15, which lets PSHUFB look up 16/32/64 bytes at once.
+ * \{ */
+
+void GLU_str_charclass_init(StrCharClass *cls, const char *chars)
+{
+	memset(cls, 0, sizeof(*cls));
+	/* The terminator always ends a scan. */
+	cls->lut_lo[0] |= 1;
+
+	for (const unsigned char *c = (const unsigned char *)chars; *c; c++) {
+		const unsigned int lo = *c & 0x0f, hi = *c >> 4;
+		if (hi < 8) {
+			cls->lut_lo[lo] |= (unsigned char)(1u << hi);
+		}
+		else {
+			cls->lut_hi[lo] |= (unsigned char)(1u << (hi - 8));
+		}
+	}
+}
+
+LOOM_INLINE bool str_charclass_test(const StrCharClass *cls, unsigned char c)
+{
+	const unsigned int lo = c & 0x0f, hi = c >> 4;
+	return ((hi < 8 ? cls->lut_lo[lo] : cls->lut_hi[lo]) >> (hi & 7)) & 1;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Scalar Kernels
+ * \{ */
+
+/* Reads whole aligned words, past the terminator too. */
+ATTR_NO_SANITIZE_ADDRESS
+static size_t str_strlen_scalar(const char *str)
+{
+	const char *char_ptr;
+	const uintptr_t *longword_ptr;
+	uintptr_t longword, himagic, lomagic;
+
+	/* Handle the first few characters by reading one character at a time,
+	 * until the pointer is aligned on a longword boundary. */
+	for (char_ptr = str; ((uintptr_t)char_ptr & (sizeof(longword) - 1)) != 0;
+		 ++char_ptr) {
+		if (*char_ptr == '\0') {
+			return char_ptr - str;
+		}
+	}
+
+	/* `(x - 0x01..01) & ~x & 0x80..80` is non zero exactly when one of the
+	 * bytes of `x` is zero. */
+	himagic = (uintptr_t)0x8080808080808080ULL;
+	lomagic = (uintptr_t)0x0101010101010101ULL;
+
+	for (longword_ptr = (const uintptr_t *)char_ptr;; longword_ptr++) {
+		longword = *longword_ptr;
+		if (((longword - lomagic) & ~longword & himagic) != 0) {
+			const char *cp = (const char *)longword_ptr;
+			while (*cp) {
+				cp++;
+			}
+			return cp - str;
+		}
+	}
+}
+
+static size_t str_strnlen_scalar(const char *str, size_t maxn)
+{
+	const char *char_ptr;
+
+	for (char_ptr = str; char_ptr != str + maxn; char_ptr++) {
+		if (!*char_ptr) {
+			break;
+		}
+	}
+
+	return char_ptr - str;
+}
+
+static const void *str_memchr_scalar(const void *buf, int c, size_t len)
+{
+	const unsigned char *p = buf;
+	for (const unsigned char *end = p + len; p != end; p++) {
+		if (*p == (unsigned char)c) {
+			return p;
+		}
+	}
+	return NULL;
+}
+
+static size_t str_strcspn_class_scalar(const char *str, const StrCharClass *cls)
+{
+	const unsigned char *p = (const unsigned char *)str;
+	while (!str_charclass_test(cls, *p)) {
+		p++;
+	}
+	return (const char *)p - str;
+}
+
+static size_t str_strncpy_rlen_scalar(char *__restrict dst,
+									  const char *__restrict src,
+									  const size_t maxncpy)
+{
+	const size_t srclen = str_strnlen_scalar(src, maxncpy - 1);
+	memcpy(dst, src, srclen);
+	dst[srclen] = '\0';
+	return srclen;
+}
+
+/** \} */
+
+#ifdef STR_SIMD_X86
+
+/* -------------------------------------------------------------------- */
+/** \name SSE2 Kernels
+ * \{ */
+
+STR_TARGET("sse2")
+ATTR_NO_SANITIZE_ADDRESS
+static size_t str_strlen_sse2(const char *str)
+{
+	const size_t offset = (uintptr_t)str & 15;
+	const char *p = str - offset;
+	const __m128i zero = _mm_setzero_si128();
+
+	uint32_t mask = (uint32_t)_mm_movemask_epi8(
+		_mm_cmpeq_epi8(_mm_load_si128((const __m128i *)p), zero));
+	mask >>= offset;
+	if (mask) {
+		return str_ctz32(mask);
+	}
+	for (;;) {
+		p += 16;
+		mask = (uint32_t)_mm_movemask_epi8(
+			_mm_cmpeq_epi8(_mm_load_si128((const __m128i *)p), zero));
+		if (mask) {
+			return (size_t)(p - str) + str_ctz32(mask);
+		}
+	}
+}
+
+STR_TARGET("sse2")
+ATTR_NO_SANITIZE_ADDRESS
+static size_t str_strnlen_sse2(const char *str, size_t maxn)
+{
+	if (maxn == 0) {
+		return 0;
+	}
+
+	const size_t offset = (uintptr_t)str & 15;
+	const char *p = str - offset;
+	const __m128i zero = _mm_setzero_si128();
+
+	uint32_t mask = (uint32_t)_mm_movemask_epi8(
+		_mm_cmpeq_epi8(_mm_load_si128((const __m128i *)p), zero));
+	mask >>= offset;
+	if (mask) {
+		return MIN2(str_ctz32(mask), maxn);
+	}
+	for (;;) {
+		p += 16;
+		if ((size_t)(p - str) >= maxn) {
+			return maxn;
+		}
+		mask = (uint32_t)_mm_movemask_epi8(
+			_mm_cmpeq_epi8(_mm_load_si128((const __m128i *)p), zero));
+		if (mask) {
+			return MIN2((size_t)(p - str) + str_ctz32(mask), maxn);
+		}
+	}
+}
+
+STR_TARGET("sse2")
+ATTR_NO_SANITIZE_ADDRESS
+static const void *str_memchr_sse2(const void *buf, int c, size_t len)
+{
+	if (len == 0) {
+		return NULL;
+	}
+
+	const unsigned char *start = buf;
+	const size_t offset = (uintptr_t)start & 15;
+	const unsigned char *p = start - offset;
+	const __m128i needle = _mm_set1_epi8((char)c);
+
+	uint32_t mask = (uint32_t)_mm_movemask_epi8(
+		_mm_cmpeq_epi8(_mm_load_si128((const __m128i *)p), needle));
+	mask >>= offset;
+	for (;;) {
+		if (mask) {
+			const size_t index = (size_t)(p - start) + str_ctz32(mask) +
+								 ((p < start) ? offset : 0);
+			return (index < len) ? start + index : NULL;
+		}
+		p += 16;
+		if ((size_t)(p - start) >= len) {
+			return NULL;
+		}
+		mask = (uint32_t)_mm_movemask_epi8(
+			_mm_cmpeq_epi8(_mm_load_si128((const __m128i *)p), needle));
+	}
+}
+
+STR_TARGET("sse2")
+ATTR_NO_SANITIZE_ADDRESS
+static size_t str_strncpy_rlen_sse2(char *__restrict dst,
+									const char *__restrict src,
+									const size_t maxncpy)
+{
+	const size_t n = maxncpy - 1;
+	const __m128i zero = _mm_setzero_si128();
+	size_t i = 0;
+
+	/* Copy whole vectors while scanning, unaligned loads are only used when
+	 * they can't touch the next page. */
+	while (i + 16 <= n) {
+		if (((uintptr_t)(src + i) & (STR_PAGE_SIZE - 1)) >
+			STR_PAGE_SIZE - 16) {
+			const size_t len = str_strnlen_sse2(src + i, 16);
+			memcpy(dst + i, src + i, len);
+			i += len;
+			if (len < 16) {
+				dst[i] = '\0';
+				return i;
+			}
+			continue;
+		}
+		const __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+		const uint32_t mask =
+			(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero));
+		if (mask) {
+			const size_t len = str_ctz32(mask);
+			memcpy(dst + i, src + i, len);
+			i += len;
+			dst[i] = '\0';
+			return i;
+		}
+		_mm_storeu_si128((__m128i *)(dst + i), v);
+		i += 16;
+	}
+
+	const size_t len = str_strnlen_sse2(src + i, n - i);
+	memcpy(dst + i, src + i, len);
+	i += len;
+	dst[i] = '\0';
+	return i;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name AVX2 Kernels
+ * \{ */
+
+STR_TARGET("avx2")
+ATTR_NO_SANITIZE_ADDRESS
+static size_t str_strlen_avx2(const char *str)
+{
+	const size_t offset = (uintptr_t)str & 31;
+	const char *p = str - offset;
+	const __m256i zero = _mm256_setzero_si256();
+
+	uint32_t mask = (uint32_t)_mm256_movemask_epi8(
+		_mm256_cmpeq_epi8(_mm256_load_si256((const __m256i *)p), zero));
+	mask >>= offset;
+	if (mask) {
+		return str_ctz32(mask);
+	}
+	for (;;) {
+		p += 32;
+		mask = (uint32_t)_mm256_movemask_epi8(
+			_mm256_cmpeq_epi8(_mm256_load_si256((const __m256i *)p), zero));
+		if (mask) {
+			return (size_t)(p - str) + str_ctz32(mask);
+		}
+	}
+}
+
+STR_TARGET("avx2")
+ATTR_NO_SANITIZE_ADDRESS
+static size_t str_strnlen_avx2(const char *str, size_t maxn)
+{
+	if (maxn == 0) {
+		return 0;
+	}
+
+	const size_t offset = (uintptr_t)str & 31;
+	const char *p = str - offset;
+	const __m256i zero = _mm256_setzero_si256();
+
+	uint32_t mask = (uint32_t)_mm256_movemask_epi8(
+		_mm256_cmpeq_epi8(_mm256_load_si256((const __m256i *)p), zero));
+	mask >>= offset;
+	if (mask) {
+		return MIN2(str_ctz32(mask), maxn);
+	}
+	for (;;) {
+		p += 32;
+		if ((size_t)(p - str) >= maxn) {
+			return maxn;
+		}
+		mask = (uint32_t)_mm256_movemask_epi8(
+			_mm256_cmpeq_epi8(_mm256_load_si256((const __m256i *)p), zero));
+		if (mask) {
+			return MIN2((size_t)(p - str) + str_ctz32(mask), maxn);
+		}
+	}
+}
+
+STR_TARGET("avx2")
+ATTR_NO_SANITIZE_ADDRESS
+static const void *str_memchr_avx2(const void *buf, int c, size_t len)
+{
+	if (len == 0) {
+		return NULL;
+	}
+
+	const unsigned char *start = buf;
+	const size_t offset = (uintptr_t)start & 31;
+	const unsigned char *p = start - offset;
+	const __m256i needle = _mm256_set1_epi8((char)c);
+
+	uint32_t mask = (uint32_t)_mm256_movemask_epi8(
+		_mm256_cmpeq_epi8(_mm256_load_si256((const __m256i *)p), needle));
+	mask >>= offset;
+	for (;;) {
+		if (mask) {
+			const size_t index = (size_t)(p - start) + str_ctz32(mask) +
+								 ((p < start) ? offset : 0);
+			return (index < len) ? start + index : NULL;
+		}
+		p += 32;
+		if ((size_t)(p - start) >= len) {
+			return NULL;
+		}
+		mask = (uint32_t)_mm256_movemask_epi8(
+			_mm256_cmpeq_epi8(_mm256_load_si256((const __m256i *)p), needle));
+	}
+}
+
+/** Mask of the bytes of \a v that are in the class. */
+STR_TARGET("avx2")
+LOOM_INLINE uint32_t str_charclass_mask_avx2(const __m256i v,
+											 const __m256i lut_lo,
+											 const __m256i lut_hi,
+											 const __m256i bits)
+{
+	const __m256i nibble = _mm256_set1_epi8(0x0f);
+	const __m256i lo = _mm256_and_si256(v, nibble);
+	const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble);
+	const __m256i row = _mm256_blendv_epi8(
+		_mm256_shuffle_epi8(lut_lo, lo),
+		_mm256_shuffle_epi8(lut_hi, lo),
+		_mm256_cmpgt_epi8(hi, _mm256_set1_epi8(7)));
+	const __m256i hit =
+		_mm256_and_si256(row, _mm256_shuffle_epi8(bits, hi));
+	return ~(uint32_t)_mm256_movemask_epi8(
+		_mm256_cmpeq_epi8(hit, _mm256_setzero_si256()));
+}
+
+STR_TARGET("avx2")
+ATTR_NO_SANITIZE_ADDRESS
+static size_t str_strcspn_class_avx2(const char *str, const StrCharClass *cls)
+{
+	const __m256i lut_lo = _mm256_broadcastsi128_si256(
+		_mm_loadu_si128((const __m128i *)cls->lut_lo));
+	const __m256i lut_hi = _mm256_broadcastsi128_si256(
+		_mm_loadu_si128((const __m128i *)cls->lut_hi));
+	const __m256i bits = _mm256_setr_epi8(
+		1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+		1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+
+	const size_t offset = (uintptr_t)str & 31;
+	const char *p = str - offset;
+
+	uint32_t mask = str_charclass_mask_avx2(
+		_mm256_load_si256((const __m256i *)p), lut_lo, lut_hi, bits);
+	mask >>= offset;
+	if (mask) {
+		return str_ctz32(mask);
+	}
+	for (;;) {
+		p += 32;
+		mask = str_charclass_mask_avx2(
+			_mm256_load_si256((const __m256i *)p), lut_lo, lut_hi, bits);
+		if (mask) {
+			return (size_t)(p - str) + str_ctz32(mask);
+		}
+	}
+}
+
+STR_TARGET("avx2")
+ATTR_NO_SANITIZE_ADDRESS
+static size_t str_strncpy_rlen_avx2(char *__restrict dst,
+									const char *__restrict src,
+									const size_t maxncpy)
+{
+	const size_t n = maxncpy - 1;
+	const __m256i zero = _mm256_setzero_si256();
+	size_t i = 0;
+
+	while (i + 32 <= n) {
+		if (((uintptr_t)(src + i) & (STR_PAGE_SIZE - 1)) >
+			STR_PAGE_SIZE - 32) {
+			const size_t len = str_strnlen_avx2(src + i, 32);
+			memcpy(dst + i, src + i, len);
+			i += len;
+			if (len < 32) {
+				dst[i] = '\0';
+				return i;
+			}
+			continue;
+		}
+		const __m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+		const uint32_t mask =
+			(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, zero));
+		if (mask) {
+			const size_t len = str_ctz32(mask);
+			memcpy(dst + i, src + i, len);
+			i += len;
+			dst[i] = '\0';
+			return i;
+		}
+		_mm256_storeu_si256((__m256i *)(dst + i), v);
+		i += 32;
+	}
+
+	const size_t len = str_strnlen_avx2(src + i, n - i);
+	memcpy(dst + i, src + i, len);
+	i += len;
+	dst[i] = '\0';
+	return i;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name AVX-512 Kernels
+ *
+ * Needs AVX-512BW for the byte compares into mask registers.
+ * \{ */
+
+#	define STR_TARGET_AVX512 STR_TARGET("avx512f,avx512bw")
+
+STR_TARGET_AVX512
+ATTR_NO_SANITIZE_ADDRESS
+static size_t str_strlen_avx512(const char *str)
+{
+	const size_t offset = (uintptr_t)str & 63;
+	const char *p = str - offset;
+	const __m512i zero = _mm512_setzero_si512();
+
+	uint64_t mask = _mm512_cmpeq_epi8_mask(
+		_mm512_load_si512((const void *)p), zero);
+	mask >>= offset;
+	if (mask) {
+		return str_ctz64(mask);
+	}
+	for (;;) {
+		p += 64;
+		mask = _mm512_cmpeq_epi8_mask(_mm512_load_si512((const void *)p),
+									  zero);
+		if (mask) {
+			return (size_t)(p - str) + str_ctz64(mask);
+		}
+	}
+}
+
+STR_TARGET_AVX512
+ATTR_NO_SANITIZE_ADDRESS
+static size_t str_strnlen_avx512(const char *str, size_t maxn)
+{
+	if (maxn == 0) {
+		return 0;
+	}
+
+	const size_t offset = (uintptr_t)str & 63;
+	const char *p = str - offset;
+	const __m512i zero = _mm512_setzero_si512();
+
+	uint64_t mask = _mm512_cmpeq_epi8_mask(
+		_mm512_load_si512((const void *)p), zero);
+	mask >>= offset;
+	if (mask) {
+		return MIN2(str_ctz64(mask), maxn);
+	}
+	for (;;) {
+		p += 64;
+		if ((size_t)(p - str) >= maxn) {
+			return maxn;
+		}
+		mask = _mm512_cmpeq_epi8_mask(_mm512_load_si512((const void *)p),
+									  zero);
+		if (mask) {
+			return MIN2((size_t)(p - str) + str_ctz64(mask), maxn);
+		}
+	}
+}
+
+STR_TARGET_AVX512
+ATTR_NO_SANITIZE_ADDRESS
+static const void *str_memchr_avx512(const void *buf, int c, size_t len)
+{
+	if (len == 0) {
+		return NULL;
+	}
+
+	const unsigned char *start = buf;
+	const size_t offset = (uintptr_t)start & 63;
+	const unsigned char *p = start - offset;
+	const __m512i needle = _mm512_set1_epi8((char)c);
+
+	uint64_t mask = _mm512_cmpeq_epi8_mask(
+		_mm512_load_si512((const void *)p), needle);
+	mask >>= offset;
+	for (;;) {
+		if (mask) {
+			const size_t index = (size_t)(p - start) + str_ctz64(mask) +
+								 ((p < start) ? offset : 0);
+			return (index < len) ? start + index : NULL;
+		}
+		p += 64;
+		if ((size_t)(p - start) >= len) {
+			return NULL;
+		}
+		mask = _mm512_cmpeq_epi8_mask(_mm512_load_si512((const void *)p),
+									  needle);
+	}
+}
+
+STR_TARGET_AVX512
+LOOM_INLINE uint64_t str_charclass_mask_avx512(const __m512i v,
+											   const __m512i lut_lo,
+											   const __m512i lut_hi,
+											   const __m512i bits)
+{
+	const __m512i nibble = _mm512_set1_epi8(0x0f);
+	const __m512i lo = _mm512_and_si512(v, nibble);
+	const __m512i hi = _mm512_and_si512(_mm512_srli_epi16(v, 4), nibble);
+	const __m512i row = _mm512_mask_blend_epi8(
+		_mm512_cmpgt_epi8_mask(hi, _mm512_set1_epi8(7)),
+		_mm512_shuffle_epi8(lut_lo, lo),
+		_mm512_shuffle_epi8(lut_hi, lo));
+	return _mm512_test_epi8_mask(row, _mm512_shuffle_epi8(bits, hi));
+}
+
+STR_TARGET_AVX512
+ATTR_NO_SANITIZE_ADDRESS
+static size_t str_strcspn_class_avx512(const char *str,
+									   const StrCharClass *cls)
+{
+	const __m512i lut_lo = _mm512_broadcast_i32x4(
+		_mm_loadu_si128((const __m128i *)cls->lut_lo));
+	const __m512i lut_hi = _mm512_broadcast_i32x4(
+		_mm_loadu_si128((const __m128i *)cls->lut_hi));
+	const __m512i bits = _mm512_broadcast_i32x4(_mm_setr_epi8(
+		1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128));
+
+	const size_t offset = (uintptr_t)str & 63;
+	const char *p = str - offset;
+
+	uint64_t mask = str_charclass_mask_avx512(
+		_mm512_load_si512((const void *)p), lut_lo, lut_hi, bits);
+	mask >>= offset;
+	if (mask) {
+		return str_ctz64(mask);
+	}
+	for (;;) {
+		p += 64;
+		mask = str_charclass_mask_avx512(
+			_mm512_load_si512((const void *)p), lut_lo, lut_hi, bits);
+		if (mask) {
+			return (size_t)(p - str) + str_ctz64(mask);
+		}
+	}
+}
+
+STR_TARGET_AVX512
+ATTR_NO_SANITIZE_ADDRESS
+static size_t str_strncpy_rlen_avx512(char *__restrict dst,
+									  const char *__restrict src,
+									  const size_t maxncpy)
+{
+	const size_t n = maxncpy - 1;
+	const __m512i zero = _mm512_setzero_si512();
+	size_t i = 0;
+
+	/* Masked loads never fault on the masked out bytes, so the tail and page
+	 * boundaries need no special handling. */
+	while (i < n) {
+		const size_t todo = MIN2(n - i, 64);
+		const uint64_t load_mask = (todo == 64) ? ~0ULL : ((1ULL << todo) - 1);
+		const __m512i v = _mm512_maskz_loadu_epi8(load_mask, src + i);
+		const uint64_t mask = _mm512_mask_cmpeq_epi8_mask(load_mask, v, zero);
+		if (mask) {
+			const size_t len = str_ctz64(mask);
+			_mm512_mask_storeu_epi8(dst + i, (1ULL << len) - 1, v);
+			i += len;
+			dst[i] = '\0';
+			return i;
+		}
+		_mm512_mask_storeu_epi8(dst + i, load_mask, v);
+		i += todo;
+	}
+
+	dst[i] = '\0';
+	return i;
+}
+
+/** \} */
+
+#endif /* STR_SIMD_X86 */
+
+/* -------------------------------------------------------------------- */
+/** \name Dispatch
+ * \{ */
+
+typedef struct StrSimdFuncs {
+	size_t (*strlen)(const char *str);
+	size_t (*strnlen)(const char *str, size_t maxn);
+	const void *(*memchr)(const void *buf, int c, size_t len);
+	size_t (*strcspn_class)(const char *str, const StrCharClass *cls);
+	size_t (*strncpy_rlen)(char *__restrict dst,
+						   const char *__restrict src,
+						   const size_t maxncpy);
+} StrSimdFuncs;
+
+static const StrSimdFuncs str_simd_funcs[] = {
+	[STR_SIMD_SCALAR] =
+		{
+			str_strlen_scalar,
+			str_strnlen_scalar,
+			str_memchr_scalar,
+			str_strcspn_class_scalar,
+			str_strncpy_rlen_scalar,
+		},
+#ifdef STR_SIMD_X86
+	/* No PSHUFB in SSE2, the class scan stays scalar. */
+	[STR_SIMD_SSE2] =
+		{
+			str_strlen_sse2,
+			str_strnlen_sse2,
+			str_memchr_sse2,
+			str_strcspn_class_scalar,
+			str_strncpy_rlen_sse2,
+		},
+	[STR_SIMD_AVX2] =
+		{
+			str_strlen_avx2,
+			str_strnlen_avx2,
+			str_memchr_avx2,
+			str_strcspn_class_avx2,
+			str_strncpy_rlen_avx2,
+		},
+	[STR_SIMD_AVX512] =
+		{
+			str_strlen_avx512,
+			str_strnlen_avx512,
+			str_memchr_avx512,
+			str_strcspn_class_avx512,
+			str_strncpy_rlen_avx512,
+		},
+#endif
+};
+
+static eStrSimdLevel str_simd_detect(void)
+{
+#ifdef STR_SIMD_X86
+	unsigned int regs1[4] = {0}, regs7[4] = {0};
+	unsigned long long xcr0 = 0;
+
+#	if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	const int max_leaf = info[0];
+	__cpuid(info, 1);
+	memcpy(regs1, info, sizeof(regs1));
+	if (max_leaf >= 7) {
+		__cpuidex(info, 7, 0);
+		memcpy(regs7, info, sizeof(regs7));
+	}
+	if (regs1[2] & (1u << 27)) {
+		xcr0 = _xgetbv(0);
+	}
+#	else
+	const unsigned int max_leaf = __get_cpuid_max(0, NULL);
+	__cpuid(1, regs1[0], regs1[1], regs1[2], regs1[3]);
+	if (max_leaf >= 7) {
+		__cpuid_count(7, 0, regs7[0], regs7[1], regs7[2], regs7[3]);
+	}
+	if (regs1[2] & (1u << 27)) {
+		unsigned int eax, edx;
+		__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		xcr0 = ((unsigned long long)edx << 32) | eax;
+	}
+#	endif
+
+	/* The OS has to save the YMM (and ZMM/opmask) state, not only the CPU
+	 * support the instructions. */
+	const bool os_avx = (xcr0 & 0x6) == 0x6;
+	const bool os_avx512 = (xcr0 & 0xe6) == 0xe6;
+
+	if (os_avx512 && (regs7[1] & (1u << 16)) && (regs7[1] & (1u << 30))) {
+		return STR_SIMD_AVX512;
+	}
+	if (os_avx && (regs1[2] & (1u << 28)) && (regs7[1] & (1u << 5))) {
+		return STR_SIMD_AVX2;
+	}
+	if (regs1[3] & (1u << 26)) {
+		return STR_SIMD_SSE2;
+	}
+#endif
+	return STR_SIMD_SCALAR;
+}
+
+/** An #eStrSimdLevel, -1 until detected. */
+static int32_t str_simd_level_supported = -1;
+/** Resolved on first use, racing threads store the same value but still go
+ * through atomics so the kernel table is never read half written. */
+static const StrSimdFuncs *str_simd = NULL;
+
+LOOM_INLINE const StrSimdFuncs *str_simd_get(void)
+{
+	const StrSimdFuncs *funcs = atomic_load_ptr((void *const *)&str_simd);
+	if (UNLIKELY(funcs == NULL)) {
+		GLU_str_simd_level_set(STR_SIMD_AVX512);
+		funcs = atomic_load_ptr((void *const *)&str_simd);
+	}
+	return funcs;
+}
+
+eStrSimdLevel GLU_str_simd_level_get(void)
+{
+	return (eStrSimdLevel)(str_simd_get() - str_simd_funcs);
+}
+
+eStrSimdLevel GLU_str_simd_level_set(eStrSimdLevel level)
+{
+	int32_t supported = atomic_load_int32(&str_simd_level_supported);
+	if (supported == -1) {
+		supported = (int32_t)str_simd_detect();
+		atomic_store_int32(&str_simd_level_supported, supported);
+	}
+	level = MIN2(level, (eStrSimdLevel)supported);
+	atomic_store_ptr((void **)&str_simd, (void *)&str_simd_funcs[level]);
+	return level;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Public API
+ * \{ */
+
+size_t GLU_strlen(const char *str)
+{
+	return str_simd_get()->strlen(str);
+}
+
+size_t GLU_strnlen(const char *str, size_t maxn)
+{
+	return str_simd_get()->strnlen(str, maxn);
+}
+
+void *GLU_memchr(const void *buf, int c, size_t len)
+{
+	return (void *)str_simd_get()->memchr(buf, c, len);
+}
+
+size_t GLU_strcspn_class(const char *str, const StrCharClass *cls)
+{
+	return str_simd_get()->strcspn_class(str, cls);
+}
+
+size_t GLU_strncpy_rlen(char *__restrict dst,
+						const char *__restrict src,
+						const size_t maxncpy)
+{
+	LOOM_assert(maxncpy != 0);
+	return str_simd_get()->strncpy_rlen(dst, src, maxncpy);
+}
+
+/** \} */
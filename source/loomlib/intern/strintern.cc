@@ -0,0 +1,386 @@
+#include "guardedalloc/mem_guardedalloc.h"
+
+#include "loomlib/loomlib_assert.h"
+#include "loomlib/loomlib_ghash.h"
+#include "loomlib/loomlib_hash_xxh3.h"
+#include "loomlib/loomlib_strintern.h"
+
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+
+#include <limits.h>
+#include <stddef.h>
+#include <string.h>
+
+/* -------------------------------------------------------------------- */
+/** \name Structs & Constants
+ *
+ * The strings are spread over shards by hash, each shard has its own lock,
+ * lookup set and arena. Lookups (the common case when interning) only take
+ * the shard lock shared, so threads interning known strings don't serialize.
+ *
+ * Every string is stored right behind its #StrInternEntry header, so the ID
+ * and length of an interned string are found from its pointer alone. The set
+ * stores the headers, whose #StrInternKey doubles as lookup key, so the hash
+ * is computed once per string and never again when the set grows.
+ *
+ * IDs index a table of pages, reached through directories of pages that
+ * cover every 32 bit ID. Both are allocated on first use and never moved, so
+ * #GLU_strintern_from_id doesn't lock.
+ * \{ */
+
+#define STRINTERN_SHARDS 16
+#define STRINTERN_CHUNK_SIZE (64 * 1024)
+/** Strings larger than this get a chunk of their own. */
+#define STRINTERN_CHUNK_LARGE (STRINTERN_CHUNK_SIZE / 4)
+#define STRINTERN_PAGE_BITS 16
+#define STRINTERN_PAGE_SIZE (1u << STRINTERN_PAGE_BITS)
+#define STRINTERN_DIR_BITS 10
+#define STRINTERN_DIR_SIZE (1u << STRINTERN_DIR_BITS)
+/** Enough directories for every 32 bit ID. */
+#define STRINTERN_MAX_DIRS \
+	(1u << (32 - STRINTERN_PAGE_BITS - STRINTERN_DIR_BITS))
+
+/** The string of an ID. */
+typedef std::atomic<const char *> StrInternSlot;
+/** A page of #STRINTERN_PAGE_SIZE slots, in a directory. */
+typedef std::atomic<StrInternSlot *> StrInternPageRef;
+
+typedef struct StrInternKey {
+	unsigned int hash;
+	unsigned int len;
+	const char *str;
+} StrInternKey;
+
+typedef struct StrInternEntry {
+	StrInternKey key;
+	unsigned int id;
+	/** The string (NULL terminated) follows the header. */
+	char str[1];
+} StrInternEntry;
+
+#define STRINTERN_ENTRY_SIZE(_len) (offsetof(StrInternEntry, str) + (_len) + 1)
+
+typedef struct StrInternChunk {
+	struct StrInternChunk *next;
+	size_t size;
+} StrInternChunk;
+
+struct alignas(64) StrInternShard {
+	std::shared_mutex lock;
+	GSet *set;
+
+	StrInternChunk *chunks;
+	/** Free space of the first chunk in #chunks. */
+	char *arena_cur;
+	char *arena_end;
+	size_t bytes_arena;
+	size_t bytes_strings;
+};
+
+struct StrIntern {
+	StrInternShard shards[STRINTERN_SHARDS];
+
+	std::atomic<unsigned int> nstrings;
+	/** Serializes allocating the directories and pages of #dirs. */
+	std::mutex pages_lock;
+	std::atomic<StrInternPageRef *> dirs[STRINTERN_MAX_DIRS];
+
+	const char *info;
+};
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Internal Utility API
+ * \{ */
+
+static unsigned int strintern_keyhash(const void *key)
+{
+	return static_cast<const StrInternKey *>(key)->hash;
+}
+
+static bool strintern_keycmp(const void *a, const void *b)
+{
+	const StrInternKey *key_a = static_cast<const StrInternKey *>(a);
+	const StrInternKey *key_b = static_cast<const StrInternKey *>(b);
+	return !(key_a->hash == key_b->hash && key_a->len == key_b->len &&
+			 memcmp(key_a->str, key_b->str, key_a->len) == 0);
+}
+
+LOOM_INLINE StrInternKey strintern_key(const char *str, size_t len)
+{
+	StrInternKey key;
+	key.hash = static_cast<unsigned int>(GLU_hash_xxh3_64(
+		reinterpret_cast<const unsigned char *>(str), len, 0));
+	key.len = static_cast<unsigned int>(len);
+	key.str = str;
+	return key;
+}
+
+LOOM_INLINE StrInternShard *strintern_shard(const StrIntern *si,
+											const unsigned int hash)
+{
+	/* The upper bits, the set uses the lower ones for its buckets. */
+	return const_cast<StrInternShard *>(&si->shards[hash >> 28]);
+}
+
+LOOM_INLINE const StrInternEntry *strintern_entry(const char *interned)
+{
+	return reinterpret_cast<const StrInternEntry *>(
+		interned - offsetof(StrInternEntry, str));
+}
+
+// Allocate \a size bytes from the arena of \a shard, the shard must be locked.
+static void *strintern_arena_alloc(StrIntern *si,
+								   StrInternShard *shard,
+								   size_t size)
+{
+	size = (size + alignof(StrInternEntry) - 1) & ~(alignof(StrInternEntry) - 1);
+
+	if (size > static_cast<size_t>(shard->arena_end - shard->arena_cur)) {
+		const size_t chunk_size = (size > STRINTERN_CHUNK_LARGE) ?
+									  sizeof(StrInternChunk) + size :
+									  STRINTERN_CHUNK_SIZE;
+		StrInternChunk *chunk = static_cast<StrInternChunk *>(
+			MEM_mallocN(chunk_size, si->info));
+		chunk->size = chunk_size;
+		shard->bytes_arena += chunk_size;
+
+		char *data = reinterpret_cast<char *>(chunk + 1);
+		if (size > STRINTERN_CHUNK_LARGE && shard->chunks) {
+			/* Keep filling the current chunk. */
+			chunk->next = shard->chunks->next;
+			shard->chunks->next = chunk;
+			return data;
+		}
+		chunk->next = shard->chunks;
+		shard->chunks = chunk;
+		shard->arena_cur = data;
+		shard->arena_end = reinterpret_cast<char *>(chunk) + chunk_size;
+	}
+
+	void *ptr = shard->arena_cur;
+	shard->arena_cur += size;
+	return ptr;
+}
+
+/** \return The page holding the slot of the IDs starting at
+ * `page_index << STRINTERN_PAGE_BITS`, NULL when it isn't allocated yet. */
+LOOM_INLINE StrInternSlot *strintern_page_get(const StrIntern *si,
+											  const unsigned int page_index)
+{
+	const unsigned int dir_index = page_index >> STRINTERN_DIR_BITS;
+	const StrInternPageRef *dir = si->dirs[dir_index].load(
+		std::memory_order_acquire);
+	if (dir == nullptr) {
+		return nullptr;
+	}
+	return dir[page_index & (STRINTERN_DIR_SIZE - 1)].load(
+		std::memory_order_acquire);
+}
+
+static void strintern_id_store(StrIntern *si,
+							   const unsigned int id,
+							   const char *str)
+{
+	const unsigned int page_index = id >> STRINTERN_PAGE_BITS;
+
+	StrInternSlot *page = strintern_page_get(si, page_index);
+	if (page == nullptr) {
+		std::lock_guard<std::mutex> guard(si->pages_lock);
+		std::atomic<StrInternPageRef *> &dir_ref =
+			si->dirs[page_index >> STRINTERN_DIR_BITS];
+		StrInternPageRef *dir = dir_ref.load(std::memory_order_relaxed);
+		if (dir == nullptr) {
+			dir = static_cast<StrInternPageRef *>(MEM_callocN(
+				sizeof(*dir) * STRINTERN_DIR_SIZE, "StrIntern::dir"));
+			dir_ref.store(dir, std::memory_order_release);
+		}
+		StrInternPageRef &page_ref = dir[page_index & (STRINTERN_DIR_SIZE - 1)];
+		page = page_ref.load(std::memory_order_relaxed);
+		if (page == nullptr) {
+			page = static_cast<StrInternSlot *>(MEM_callocN(
+				sizeof(*page) * STRINTERN_PAGE_SIZE, "StrIntern::page"));
+			page_ref.store(page, std::memory_order_release);
+		}
+	}
+	page[id & (STRINTERN_PAGE_SIZE - 1)].store(str, std::memory_order_release);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name String Interning API
+ * \{ */
+
+StrIntern *GLU_strintern_new(const char *info)
+{
+	StrIntern *si = MEM_new<StrIntern>(info);
+
+	si->info = info;
+	si->nstrings.store(0, std::memory_order_relaxed);
+	for (unsigned int i = 0; i < STRINTERN_MAX_DIRS; i++) {
+		si->dirs[i].store(nullptr, std::memory_order_relaxed);
+	}
+	for (int i = 0; i < STRINTERN_SHARDS; i++) {
+		StrInternShard *shard = &si->shards[i];
+		shard->set = GLU_gset_new(strintern_keyhash, strintern_keycmp, info);
+		shard->chunks = nullptr;
+		shard->arena_cur = nullptr;
+		shard->arena_end = nullptr;
+		shard->bytes_arena = 0;
+		shard->bytes_strings = 0;
+	}
+
+	return si;
+}
+
+void GLU_strintern_free(StrIntern *si)
+{
+	for (int i = 0; i < STRINTERN_SHARDS; i++) {
+		StrInternShard *shard = &si->shards[i];
+		GLU_gset_free(shard->set, nullptr);
+		for (StrInternChunk *chunk = shard->chunks, *chunk_next; chunk;
+			 chunk = chunk_next) {
+			chunk_next = chunk->next;
+			MEM_freeN(chunk);
+		}
+	}
+	for (unsigned int i = 0; i < STRINTERN_MAX_DIRS; i++) {
+		StrInternPageRef *dir = si->dirs[i].load(std::memory_order_relaxed);
+		if (dir == nullptr) {
+			continue;
+		}
+		for (unsigned int j = 0; j < STRINTERN_DIR_SIZE; j++) {
+			StrInternSlot *page = dir[j].load(std::memory_order_relaxed);
+			if (page) {
+				MEM_freeN(page);
+			}
+		}
+		MEM_freeN(dir);
+	}
+	MEM_delete(si);
+}
+
+const char *GLU_strintern_n(StrIntern *si, const char *str, size_t len)
+{
+	LOOM_assert(len < UINT_MAX);
+
+	const StrInternKey key = strintern_key(str, len);
+	StrInternShard *shard = strintern_shard(si, key.hash);
+
+	{
+		std::shared_lock<std::shared_mutex> guard(shard->lock);
+		const StrInternKey *found = static_cast<const StrInternKey *>(
+			GLU_gset_lookup(shard->set, &key));
+		if (found) {
+			return found->str;
+		}
+	}
+
+	std::unique_lock<std::shared_mutex> guard(shard->lock);
+	/* Another thread may have interned it in the meantime. */
+	const StrInternKey *found = static_cast<const StrInternKey *>(
+		GLU_gset_lookup(shard->set, &key));
+	if (found) {
+		return found->str;
+	}
+
+	StrInternEntry *entry = static_cast<StrInternEntry *>(
+		strintern_arena_alloc(si, shard, STRINTERN_ENTRY_SIZE(len)));
+	memcpy(entry->str, str, len);
+	entry->str[len] = '\0';
+	entry->key = key;
+	entry->key.str = entry->str;
+	entry->id = si->nstrings.fetch_add(1, std::memory_order_relaxed);
+	strintern_id_store(si, entry->id, entry->str);
+
+	GLU_gset_insert(shard->set, &entry->key);
+	shard->bytes_strings += len + 1;
+	return entry->str;
+}
+
+const char *GLU_strintern(StrIntern *si, const char *str)
+{
+	return GLU_strintern_n(si, str, strlen(str));
+}
+
+const char *GLU_strintern_find(const StrIntern *si, const char *str)
+{
+	const StrInternKey key = strintern_key(str, strlen(str));
+	StrInternShard *shard = strintern_shard(si, key.hash);
+
+	std::shared_lock<std::shared_mutex> guard(shard->lock);
+	const StrInternKey *found = static_cast<const StrInternKey *>(
+		GLU_gset_lookup(shard->set, &key));
+	return found ? found->str : nullptr;
+}
+
+unsigned int GLU_strintern_find_id(const StrIntern *si, const char *str)
+{
+	const char *interned = GLU_strintern_find(si, str);
+	return interned ? GLU_strintern_id(interned) : GLU_STRINTERN_ID_NONE;
+}
+
+unsigned int GLU_strintern_id(const char *interned)
+{
+	return strintern_entry(interned)->id;
+}
+
+size_t GLU_strintern_strlen(const char *interned)
+{
+	return strintern_entry(interned)->key.len;
+}
+
+const char *GLU_strintern_from_id(const StrIntern *si, unsigned int id)
+{
+	const StrInternSlot *page = strintern_page_get(si,
+												   id >> STRINTERN_PAGE_BITS);
+	if (page == nullptr) {
+		return nullptr;
+	}
+	return page[id & (STRINTERN_PAGE_SIZE - 1)].load(std::memory_order_acquire);
+}
+
+unsigned int GLU_strintern_len(const StrIntern *si)
+{
+	return si->nstrings.load(std::memory_order_relaxed);
+}
+
+void GLU_strintern_calc_memory(const StrIntern *si, StrInternMemStats *r_stats)
+{
+	memset(r_stats, 0, sizeof(*r_stats));
+	r_stats->nstrings = GLU_strintern_len(si);
+	r_stats->bytes_table = sizeof(*si);
+
+	for (int i = 0; i < STRINTERN_SHARDS; i++) {
+		StrInternShard *shard = const_cast<StrInternShard *>(&si->shards[i]);
+		std::shared_lock<std::shared_mutex> guard(shard->lock);
+
+		GHashQuality quality;
+		GLU_gset_calc_quality_ex(shard->set, &quality);
+		/* Bucket array and the key-only entries of a GSet. */
+		r_stats->bytes_table += quality.nbuckets * sizeof(void *) +
+								quality.nentries * sizeof(void *[2]);
+		r_stats->bytes_arena += shard->bytes_arena;
+		r_stats->bytes_strings += shard->bytes_strings;
+	}
+	for (unsigned int i = 0; i < STRINTERN_MAX_DIRS; i++) {
+		const StrInternPageRef *dir =
+			si->dirs[i].load(std::memory_order_relaxed);
+		if (dir == nullptr) {
+			continue;
+		}
+		r_stats->bytes_table += sizeof(*dir) * STRINTERN_DIR_SIZE;
+		for (unsigned int j = 0; j < STRINTERN_DIR_SIZE; j++) {
+			if (dir[j].load(std::memory_order_relaxed)) {
+				r_stats->bytes_table += sizeof(StrInternSlot) *
+										STRINTERN_PAGE_SIZE;
+			}
+		}
+	}
+}
+
+/** \} */
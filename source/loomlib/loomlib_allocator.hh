@@ -5,17 +5,31 @@
 #include "loomlib_assert.h"
 #include "loomlib_utildefines.h"
 
+#include <cstring>
+
 namespace loom {
 
 class GuardedAllocator {
    public:
 	void *allocate(size_t size, size_t alignment, const char *name)
 	{
-		/* Should we use MEM_mallocN, when alignment is small? If yes, how small
-		 * must alignment be? */
+		/* MEM_mallocN places its header in front of a block from malloc,
+		 * which leaves the data aligned to at least a pointer. Blocks from it
+		 * can be grown in place by #reallocate, aligned blocks can't. */
+		if (alignment <= sizeof(void *)) {
+			return MEM_mallocN(size, name);
+		}
 		return MEM_mallocN_aligned(size, alignment, name);
 	}
 
+	/** Resize a block from #allocate, keeping its contents up to the smaller
+	 * of both sizes. The block may move. */
+	void *reallocate(void *ptr, size_t size, size_t, const char *name)
+	{
+		/* Keeps the alignment the block was allocated with. */
+		return MEM_reallocN_id(ptr, size, name);
+	}
+
 	void deallocate(void *ptr)
 	{
 		MEM_freeN(ptr);
@@ -42,6 +56,27 @@ class RawAllocator {
 		return used_ptr;
 	}
 
+	void *reallocate(void *ptr, size_t size, size_t alignment, const char *)
+	{
+		MemHead *head = static_cast<MemHead *>(ptr) - 1;
+		const int old_offset = head->offset;
+		void *actual_ptr = realloc(POINTER_OFFSET(ptr, -old_offset),
+								   size + alignment + sizeof(MemHead));
+		void *used_ptr = reinterpret_cast<void *>(
+			reinterpret_cast<uintptr_t>(
+				POINTER_OFFSET(actual_ptr, alignment + sizeof(MemHead))) &
+			~(static_cast<uintptr_t>(alignment) - 1));
+		int offset = static_cast<int>((intptr_t)used_ptr -
+									  (intptr_t)actual_ptr);
+		/* The block moved to an address with a different alignment, the data
+		 * has to follow the new header position. */
+		if (offset != old_offset) {
+			memmove(used_ptr, POINTER_OFFSET(actual_ptr, old_offset), size);
+		}
+		(static_cast<MemHead *>(used_ptr) - 1)->offset = offset;
+		return used_ptr;
+	}
+
 	void deallocate(void *ptr)
 	{
 		MemHead *head = static_cast<MemHead *>(ptr) - 1;
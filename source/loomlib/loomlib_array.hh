@@ -58,13 +58,18 @@ class Array {
 		mSize = 0;
 	}
 
+	Array(NoExceptConstructor, _Allocator allocator = {}) noexcept
+		: Array(allocator)
+	{
+	}
+
 	// Create a new array that contains copies of all values.
 	template<typename U, LOOM_ENABLE_IF((std::is_convertible_v<U, _Tp>))>
 	Array(Span<U> values, _Allocator allocator = {}) : Array(allocator)
 	{
-		const size_t size = values.size();
+		const size_t size = values.Size();
 		mData = this->GetBufferForSize(size);
-		uninitialized_convert_n<U, _Tp>(values.data(), size, mData);
+		uninitialized_convert_n<U, _Tp>(values.Data(), size, mData);
 		mSize = size;
 	}
 
@@ -115,7 +120,8 @@ class Array {
 	 * This should be used very rarely. Note, that the normal size-constructor
 	 * also does not initialize the elements when _Tp is trivially
 	 * constructible. Therefore, it only makes sense to use this with non
-	 * trivially constructible types.
+	 * trivially constructible types, e.g. a struct of floats with default
+	 * member initializers that is about to be overwritten by a file read.
 	 *
 	 * Usage:
 	 *  Array<std::string> my_strings(10, NoInitialization()); */
@@ -127,7 +133,7 @@ class Array {
 		mSize = size;
 	}
 
-	Array(const Array &other) : Array(other.as_span(), other.mAllocator)
+	Array(const Array &other) : Array(other.AsSpan(), other.mAllocator)
 	{
 	}
 
@@ -149,7 +155,7 @@ class Array {
 	~Array()
 	{
 		destruct_n(mData, mSize);
-		this->deallocate_if_not_inline(mData);
+		this->DeallocateIfNotInline(mData);
 	}
 
 	Array &operator=(const Array &other)
@@ -297,17 +303,17 @@ class Array {
 
 	std::reverse_iterator<const _Tp *> ReverseBegin() const
 	{
-		return std::reverse_iterator<_Tp *>(this->End());
+		return std::reverse_iterator<const _Tp *>(this->End());
 	}
 	std::reverse_iterator<const _Tp *> ReverseEnd() const
 	{
-		return std::reverse_iterator<_Tp *>(this->Begin());
+		return std::reverse_iterator<const _Tp *>(this->Begin());
 	}
 
 	// Get an index range containing all valid indices for this array.
-	IndexRange IndexRange() const
+	loom::IndexRange IndexRange() const
 	{
-		return IndexRange(mSize);
+		return loom::IndexRange(mSize);
 	}
 
 	/** Sets the size to zero. This should only be used when you have manually
@@ -370,7 +376,7 @@ class Array {
 			return mInlineBuffer;
 		}
 		else {
-			return this->allocate(size);
+			return this->Allocate(size);
 		}
 	}
 
@@ -43,6 +43,19 @@
 #	define LOOM_NO_UNIQUE_ADDRESS [[no_unique_address]]
 #endif
 
+/**
+ * Exclude a function from AddressSanitizer, for vector kernels that read
+ * whole aligned blocks around their input: such loads can't fault but are
+ * reported as overflows.
+ */
+#if defined(_MSC_VER) && (_MSC_VER >= 1928)
+#	define ATTR_NO_SANITIZE_ADDRESS __declspec(no_sanitize_address)
+#elif defined(__GNUC__) || defined(__clang__)
+#	define ATTR_NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#else
+#	define ATTR_NO_SANITIZE_ADDRESS
+#endif
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "loomlib_compiler.h"
+#include "loomlib_utildefines.h"
+
+#include <stdarg.h>
+
+struct MemArena;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A string builder. Appended text goes into chunks that are never moved, a
+ * full chunk is followed by one at least as large as the whole string so far,
+ * so appending is amortized O(1) and the text is copied once more at most,
+ * when the result is taken.
+ */
+
+struct DynStr;
+
+typedef struct DynStr DynStr;
+
+/** Create a new, empty string builder. */
+DynStr *GLU_dynstr_new(void);
+
+/**
+ * Create a string builder whose chunks are allocated from \a ma, so that
+ * many short lived builders don't each allocate. The chunks are only freed
+ * with the arena.
+ */
+DynStr *GLU_dynstr_new_memarena(struct MemArena *ma);
+
+/** Reserve space for \a len more bytes, so they are appended in place. */
+void GLU_dynstr_reserve(DynStr *__restrict ds, size_t len);
+
+/** Append the NULL terminated string \a cstr. */
+void GLU_dynstr_append(DynStr *__restrict ds, const char *cstr);
+
+/** Append the first \a len bytes of \a cstr (or up to its NULL terminator). */
+void GLU_dynstr_nappend(DynStr *__restrict ds, const char *cstr, size_t len);
+
+/**
+ * Append a formatted string, printed straight into the builder's storage.
+ */
+void GLU_dynstr_appendf(DynStr *__restrict ds,
+						const char *ATTR_PRINTF_FORMAT_STRING format,
+						...);
+void GLU_dynstr_vappendf(DynStr *__restrict ds,
+						 const char *ATTR_PRINTF_FORMAT_STRING format,
+						 va_list args);
+
+/** \return The length of the string, without the NULL terminator. */
+size_t GLU_dynstr_get_len(const DynStr *ds);
+
+/**
+ * Copy the string into \a rets, which must fit #GLU_dynstr_get_len bytes and
+ * the NULL terminator.
+ */
+void GLU_dynstr_get_cstring_ex(const DynStr *__restrict ds,
+							   char *__restrict rets);
+
+/** \return A #MEM_mallocN'd copy of the string. */
+char *GLU_dynstr_get_cstring(const DynStr *ds);
+
+/**
+ * Take the string out of the builder, which is left empty. When the string is
+ * stored in one chunk (always after a large enough #GLU_dynstr_reserve) the
+ * chunk itself is returned without copying.
+ *
+ * \param r_len: Optionally the length of the string.
+ * \return The string, free with #MEM_freeN, or for a builder created with
+ * #GLU_dynstr_new_memarena memory of the arena.
+ */
+char *GLU_dynstr_steal(DynStr *ds, size_t *r_len);
+
+/** Empty the builder, without freeing it. */
+void GLU_dynstr_clear(DynStr *ds);
+
+/** Free the builder and its string. */
+void GLU_dynstr_free(DynStr *ds);
+
+#ifdef __cplusplus
+}
+#endif
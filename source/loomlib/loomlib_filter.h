@@ -0,0 +1,153 @@
+#pragma once
+
+#include "loomlib_ghash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -------------------------------------------------------------------- */
+/** \name Bloom Filter
+ *
+ * A blocked Bloom filter: a key only touches one 64 byte block (one cache
+ * line) and sets one bit in each of the block's eight 64 bit words, the bit
+ * tests of a lookup are done together (with AVX2 when the build has it).
+ * Keys are hashed with the same #GHashHashFP functions as a #GHash, so a
+ * filter can sit in front of a table whose lookups mostly miss.
+ *
+ * A miss is certain, a hit is only likely. Keys can't be removed.
+ * \{ */
+
+typedef struct GBloom GBloom;
+
+/**
+ * \param nentries_reserve: The number of keys the filter is sized for, more
+ * can be added but the false positive rate rises.
+ * \param fpp: The false positive probability wanted at \a nentries_reserve
+ * keys, e.g. 0.01.
+ */
+GBloom *GLU_bloom_new(GHashHashFP hashfp,
+					  unsigned int nentries_reserve,
+					  double fpp);
+
+void GLU_bloom_free(GBloom *bloom);
+
+/** Remove all keys, the size is kept. */
+void GLU_bloom_clear(GBloom *bloom);
+
+void GLU_bloom_add(GBloom *bloom, const void *key);
+
+/** \return false when \a key was certainly never added. */
+bool GLU_bloom_may_contain(const GBloom *bloom, const void *key);
+
+/** Same as #GLU_bloom_add and #GLU_bloom_may_contain with the hash of the
+ * key already computed. */
+void GLU_bloom_add_hash(GBloom *bloom, unsigned int hash);
+bool GLU_bloom_may_contain_hash(const GBloom *bloom, unsigned int hash);
+
+/** \return The false positive probability at \a nentries keys. */
+double GLU_bloom_calc_fpp(const GBloom *bloom, unsigned int nentries);
+
+/** \return The size of the bit array in bytes. */
+size_t GLU_bloom_size(const GBloom *bloom);
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Cuckoo Filter
+ *
+ * Stores a 16 bit fingerprint of each key in one of two buckets of four
+ * (partial-key cuckoo hashing), which unlike a Bloom filter allows removing
+ * keys. The false positive probability is about 0.012% (8 / 2^16),
+ * independent of the size. Up to about 95% of the slots can be filled.
+ * \{ */
+
+typedef struct GCuckoo GCuckoo;
+
+/**
+ * \param nentries_reserve: The number of keys the filter has room for.
+ */
+GCuckoo *GLU_cuckoo_new(GHashHashFP hashfp, unsigned int nentries_reserve);
+
+void GLU_cuckoo_free(GCuckoo *cuckoo);
+
+void GLU_cuckoo_clear(GCuckoo *cuckoo);
+
+/**
+ * Add a key, adding the same key twice stores it twice.
+ * \return false when the filter is full, the key isn't added then.
+ */
+bool GLU_cuckoo_add(GCuckoo *cuckoo, const void *key);
+
+/** \return false when \a key was certainly not added (or was removed). */
+bool GLU_cuckoo_may_contain(const GCuckoo *cuckoo, const void *key);
+
+/**
+ * Remove a key that was added, removing one that wasn't may remove another
+ * key sharing its fingerprint.
+ * \return false when no matching fingerprint was found.
+ */
+bool GLU_cuckoo_remove(GCuckoo *cuckoo, const void *key);
+
+bool GLU_cuckoo_add_hash(GCuckoo *cuckoo, unsigned int hash);
+bool GLU_cuckoo_may_contain_hash(const GCuckoo *cuckoo, unsigned int hash);
+bool GLU_cuckoo_remove_hash(GCuckoo *cuckoo, unsigned int hash);
+
+/** \return The number of keys stored. */
+unsigned int GLU_cuckoo_len(const GCuckoo *cuckoo);
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Filtered GSet
+ *
+ * A #GSet with a #GBloom in front of it, lookups of keys that aren't in the
+ * set mostly stop at the filter without walking a bucket chain. The filter
+ * is rebuilt from the set when the set outgrows it or when many keys have
+ * been removed (their bits stay set until then).
+ * \{ */
+
+typedef struct GSetBloom GSetBloom;
+
+/**
+ * \param fpp: The false positive probability of the filter, see
+ * #GLU_bloom_new.
+ */
+GSetBloom *GLU_gset_bloom_new_ex(GSetHashFP hashfp,
+								 GSetCmpFP cmpfp,
+								 const char *info,
+								 unsigned int nentries_reserve,
+								 double fpp);
+GSetBloom *GLU_gset_bloom_new(GSetHashFP hashfp,
+							  GSetCmpFP cmpfp,
+							  const char *info);
+
+void GLU_gset_bloom_free(GSetBloom *gsb, GSetKeyFreeFP keyfreefp);
+
+/** Same as #GLU_gset_add. */
+bool GLU_gset_bloom_add(GSetBloom *gsb, void *key);
+
+/** Same as #GLU_gset_haskey. */
+bool GLU_gset_bloom_haskey(const GSetBloom *gsb, const void *key);
+
+/** Same as #GLU_gset_lookup. */
+void *GLU_gset_bloom_lookup(const GSetBloom *gsb, const void *key);
+
+/** Same as #GLU_gset_remove. */
+bool GLU_gset_bloom_remove(GSetBloom *gsb,
+						   const void *key,
+						   GSetKeyFreeFP keyfreefp);
+
+unsigned int GLU_gset_bloom_len(const GSetBloom *gsb);
+
+/**
+ * The set itself, for iterating and the other read only functions. Adding or
+ * removing keys has to go through the GLU_gset_bloom functions.
+ */
+const GSet *GLU_gset_bloom_gset(const GSetBloom *gsb);
+
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
@@ -21,6 +21,9 @@ typedef void (*GHashKeyFreeFP)(void *key);
 typedef void (*GHashValFreeFP)(void *val);
 typedef void *(*GHashKeyCopyFP)(const void *key);
 typedef void *(*GHashValCopyFP)(const void *val);
+/** Compares a key of the table with \a user_data, see #GLU_ghash_lookup_ex.
+ * Returns false when equal, like #GHashCmpFP. */
+typedef bool (*GHashLookupCmpFP)(const void *user_data, const void *key);
 
 typedef struct GHash GHash;
 
@@ -161,6 +164,31 @@ void *GLU_ghash_lookup_default(const GHash *gh,
  */
 void **GLU_ghash_lookup_p(GHash *gh, const void *key);
 
+/**
+ * Lookup a value by something that isn't a key of \a gh, e.g. a string that
+ * isn't NULL terminated in a table of C strings.
+ * \param hash: The hash the table's hash function gives the matching key.
+ * \param cmpfp: Compares \a user_data with the keys of the bucket.
+ * \returns the value of the matching key or NULL.
+ */
+void *GLU_ghash_lookup_ex(const GHash *gh,
+						  unsigned int hash,
+						  GHashLookupCmpFP cmpfp,
+						  const void *user_data);
+
+/**
+ * Lookup the values of \a n independent \a keys in \a gh.
+ *
+ * Faster than calling #GLU_ghash_lookup in a loop on tables that don't fit in
+ * the cache: keys are hashed in groups first and the buckets and entries are
+ * prefetched, so the memory loads of different keys overlap.
+ * \param r_vals: Receives the value for each key or NULL.
+ */
+void GLU_ghash_lookup_batch(const GHash *gh,
+							const void *const *keys,
+							unsigned int n,
+							void **r_vals);
+
 /**
  * Ensure \a key is exists in \a gh.
  * This handles the common situation where the caller needs ensure a key is
@@ -207,10 +235,10 @@ bool GLU_ghash_remove(GHash *gh,
  * \param nentries_reserve: Optionally reserve the number of members that the
  * hash will hold.
  */
-void GLU_ghash_clear_exs(GHash *gh,
-						 GHashKeyFreeFP keyfree_fp,
-						 GHashValFreeFP valfree_fp,
-						 unsigned int nentries_reserve);
+void GLU_ghash_clear_ex(GHash *gh,
+						GHashKeyFreeFP keyfree_fp,
+						GHashValFreeFP valfree_fp,
+						unsigned int nentries_reserve);
 
 // Wraps #GLU_ghash_clear_ex with zero entries reserved.
 void GLU_ghash_clear(GHash *gh,
@@ -242,6 +270,12 @@ bool GLU_ghash_pop(GHash *gh,
 // \return Returns the size of the \a gh.
 unsigned int GLU_ghash_len(const GHash *gh);
 
+/**
+ * \return The number of bytes allocated for \a gh: the table, its buckets and
+ * the entry pool, see #GLU_ghash_frozen_calc_memory.
+ */
+size_t GLU_ghash_calc_memory(const GHash *gh);
+
 // Sets a GHash flag.
 void GLU_ghash_flag_set(GHash *gh, unsigned int flag);
 
@@ -327,6 +361,63 @@ LOOM_INLINE bool GLU_ghash_iterator_done(const GHashIterator *ghi)
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Frozen GHash
+ *
+ * Read-only snapshot of a GHash for tables that are built once and then only
+ * queried (name lookups, type registries). The keys are placed with a minimal
+ * perfect hash into one flat array of key/value/hash slots, so a lookup costs
+ * one hash, one slot load and one compare.
+ * \{ */
+
+typedef struct GHashFrozen GHashFrozen;
+
+/**
+ * Build a frozen table holding the current entries of \a gh, which is left
+ * untouched. Keys and values are shared, not copied, free \a gh without free
+ * callbacks when the frozen table takes ownership of them.
+ * \return A new frozen table using the hash and compare callbacks of \a gh,
+ * or NULL when no perfect hash was found within a bounded number of seeds
+ * (keep using \a gh then).
+ */
+GHashFrozen *GLU_ghash_freeze(const GHash *gh);
+
+/**
+ * Frees the frozen table.
+ * \param keyfreefp: Optional callback to free the key.
+ * \param valfreefp: Optional callback to free the value.
+ */
+void GLU_ghash_frozen_free(GHashFrozen *fgh,
+						   GHashKeyFreeFP keyfreefp,
+						   GHashValFreeFP valfreefp);
+
+/**
+ * Lookup the value of \a key in \a fgh.
+ * \returns the value for \a key or NULL.
+ */
+void *GLU_ghash_frozen_lookup(const GHashFrozen *fgh, const void *key);
+
+/**
+ * A version of #GLU_ghash_frozen_lookup which accepts a fallback argument.
+ */
+void *GLU_ghash_frozen_lookup_default(const GHashFrozen *fgh,
+									  const void *key,
+									  void *val_default);
+
+/** \return true if the \a key is in \a fgh. */
+bool GLU_ghash_frozen_haskey(const GHashFrozen *fgh, const void *key);
+
+// \return Returns the size of the \a fgh.
+unsigned int GLU_ghash_frozen_len(const GHashFrozen *fgh);
+
+/**
+ * \return The number of bytes allocated for \a fgh, to compare against the
+ * buckets and entry pool of the source GHash.
+ */
+size_t GLU_ghash_frozen_calc_memory(const GHashFrozen *fgh);
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name GSet Types
  * \{ */
@@ -379,6 +470,7 @@ GSet *GLU_gset_copy(const GSet *gs, GSetKeyCopyFP keycopyfp);
 
 // \return Returns the size of the \a gs.
 unsigned int GLU_gset_len(const GSet *gs);
+size_t GLU_gset_calc_memory(const GSet *gs);
 
 // Sets a GSet flag.
 void GLU_gset_flag_set(GSet *gs, unsigned int flag);
@@ -480,6 +572,21 @@ void GLU_gset_clear(GSet *gs, GSetKeyFreeFP keyfreefp);
  */
 void *GLU_gset_lookup(const GSet *gs, const void *key);
 
+/** Same as #GLU_ghash_lookup_ex, returning the matching key. */
+void *GLU_gset_lookup_ex(const GSet *gs,
+						 unsigned int hash,
+						 GHashLookupCmpFP cmpfp,
+						 const void *user_data);
+
+/**
+ * Set counterpart to #GLU_ghash_lookup_batch.
+ * \param r_keys: Receives the stored key for each key or NULL.
+ */
+void GLU_gset_lookup_batch(const GSet *gs,
+						   const void *const *keys,
+						   unsigned int n,
+						   void **r_keys);
+
 /**
  * Searches the gset to find the specified \a key and removes it.
  * \return Returns the pointer to the key if it's found, removing it from the
@@ -489,6 +596,55 @@ void *GLU_gset_pop_key(GSet *gs, const void *key);
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name GSet Set Operations
+ *
+ * Defined in `ghash_setops.cc`
+ *
+ * Both sets must use the same hash and compare callbacks. The smaller set is
+ * iterated where the result allows it, the keys of the other one are looked
+ * up in prefetched batches. Sets of more than #GSET_PARALLEL_MIN keys are
+ * iterated by several threads, only the (read only) lookups run in parallel.
+ *
+ * Keys are never copied, a new set shares its keys with the sets it was made
+ * from.
+ * \{ */
+
+#define GSET_PARALLEL_MIN 1000000
+
+/** Reserve room for \a nentries_reserve keys, same as #GLU_ghash_reserve. */
+void GLU_gset_reserve(GSet *gs, unsigned int nentries_reserve);
+
+/**
+ * \return A new set with the keys in \a a or \a b, a key in both is stored
+ * as the pointer of the larger set.
+ */
+GSet *GLU_gset_union_new(const GSet *a, const GSet *b, const char *info);
+
+/** \return A new set with the keys of \a a that are also in \a b. */
+GSet *GLU_gset_intersect_new(const GSet *a, const GSet *b, const char *info);
+
+/** \return A new set with the keys of \a a that aren't in \a b. */
+GSet *GLU_gset_difference_new(const GSet *a, const GSet *b, const char *info);
+
+/** Add the keys of \a b that aren't in \a a yet to \a a. */
+void GLU_gset_union(GSet *a, const GSet *b);
+
+/**
+ * Remove the keys of \a a that aren't in \a b.
+ * \param keyfreefp: Optional function to free the removed keys, without it
+ * only the keys of \a b are iterated when \a b is the smaller set.
+ */
+void GLU_gset_intersect(GSet *a, const GSet *b, GSetKeyFreeFP keyfreefp);
+
+/**
+ * Remove the keys of \a a that are in \a b.
+ * \param keyfreefp: Optional function to free the removed keys.
+ */
+void GLU_gset_difference(GSet *a, const GSet *b, GSetKeyFreeFP keyfreefp);
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name GSet Iterator
  * \{ */
@@ -562,6 +718,50 @@ LOOM_INLINE bool GLU_gset_iterator_done(const GSetIterator *gsi)
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name GHash/GSet Debugging
+ *
+ * Measure how well the hash callbacks distribute the actual keys. Only the
+ * bucket chains are walked (no hashing, no allocation), so this is cheap
+ * enough to be sampled in release builds.
+ * \{ */
+
+// Chains of this length or longer share the last histogram slot.
+#define GHASH_QUALITY_HISTOGRAM_LEN 16
+
+typedef struct GHashQuality {
+	unsigned int nentries;
+	unsigned int nbuckets;
+	// Entries per bucket.
+	double load;
+	unsigned int empty_buckets;
+	// Number of buckets by chain length.
+	unsigned int chain_histogram[GHASH_QUALITY_HISTOGRAM_LEN];
+	/** Variance of the chain lengths against #load, a uniform hash gives
+	 * about #load as well. */
+	double variance;
+	// Mean compares needed to find a key that is in the hash.
+	double probe_mean;
+	// Length of the longest chain, the worst case compares of a lookup.
+	unsigned int probe_max;
+	/** Lookups and #GHashCmpFP calls since creation, only counted when
+	 * `ghash.c` is built with `GHASH_DEBUG_STATS` (zero otherwise). */
+	unsigned long long stat_lookups;
+	unsigned long long stat_cmps;
+} GHashQuality;
+
+/**
+ * Measure the distribution of the entries in \a gh.
+ * \return The mean probe length relative to a perfectly uniform hash, 1.0 is
+ * ideal, larger values mean clustering.
+ */
+double GLU_ghash_calc_quality_ex(const GHash *gh, GHashQuality *r_quality);
+double GLU_ghash_calc_quality(const GHash *gh);
+double GLU_gset_calc_quality_ex(const GSet *gs, GHashQuality *r_quality);
+double GLU_gset_calc_quality(const GSet *gs);
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name GHash/GSet Utils
  *
@@ -592,6 +792,9 @@ unsigned int GLU_ghashutil_strhash_n(const char *key, unsigned int n);
 
 unsigned int GLU_ghashutil_strhash_p(const void *ptr);
 unsigned int GLU_ghashutil_strhash_p_murmur(const void *ptr);
+/** Uses the low bits of #GLU_hash_xxh3_64, much faster than
+ * #GLU_ghashutil_strhash_p on long strings. */
+unsigned int GLU_ghashutil_strhash_p_xxh3(const void *ptr);
 
 bool GLU_ghashutil_strcmp(const void *a, const void *b);
 
@@ -599,6 +802,7 @@ bool GLU_ghashutil_strcmp(const void *a, const void *b);
 unsigned int GLU_ghashutil_uinthash(unsigned int key);
 unsigned int GLU_ghashutil_inthash_p(const void *ptr);
 unsigned int GLU_ghashutil_inthash_p_murmur(const void *ptr);
+unsigned int GLU_ghashutil_inthash_p_xxh3(const void *ptr);
 unsigned int GLU_ghashutil_inthash_p_simple(const void *ptr);
 
 bool GLU_ghashutil_intcmp(const void *a, const void *b);
@@ -651,6 +855,72 @@ GSet *GLU_gset_int_new(const char *info);
 
 /** \} */
 
+#ifdef GHASH_INTERNAL_API
+/* -------------------------------------------------------------------- */
+/** \name GHash/GSet Internal API
+ *
+ * For the parts of the implementation outside of `ghash.c`.
+ * \{ */
+
+/**
+ * Called for the keys visited by #GLU_gset_internal_probe.
+ * \param probe_key: The matching key of the probed set, NULL when not found.
+ */
+typedef void (*GSetProbeFP)(void *userdata, void *key, void *probe_key);
+
+unsigned int GLU_ghash_internal_nbuckets(const GHash *gh);
+
+/** \return The `GHASH_FLAG_*` bits set on \a gh. */
+unsigned int GLU_ghash_internal_flag(const GHash *gh);
+
+/**
+ * #GLU_ghash_freeze with the pilots searched per bucket limited to
+ * \a pilot_max, small limits make the search fail for testing.
+ */
+GHashFrozen *GLU_ghash_internal_freeze_ex(const GHash *gh,
+										  unsigned int pilot_max);
+
+/** \return An empty set with the callbacks and flags of \a gs. */
+GSet *GLU_gset_internal_new_like(const GSet *gs,
+								 const char *info,
+								 unsigned int nentries_reserve);
+
+/**
+ * #GLU_gset_add, #GLU_gset_haskey, #GLU_gset_lookup and #GLU_gset_remove
+ * with the hash of \a key already known, for wrappers that need the hash
+ * themselves.
+ * \param hash: What the hash function of \a gs gives for \a key.
+ */
+bool GLU_gset_internal_add_hash(GSet *gs, void *key, unsigned int hash);
+bool GLU_gset_internal_haskey_hash(const GSet *gs,
+								   const void *key,
+								   unsigned int hash);
+void *GLU_gset_internal_lookup_hash(const GSet *gs,
+									const void *key,
+									unsigned int hash);
+bool GLU_gset_internal_remove_hash(GSet *gs,
+								   const void *key,
+								   unsigned int hash,
+								   GSetKeyFreeFP keyfreefp);
+
+/**
+ * Look up the keys in the buckets `[bucket_begin, bucket_end)` of \a gs in
+ * \a probe, in batches of prefetched lookups. Neither set is changed, so
+ * disjoint bucket ranges can be probed from several threads.
+ * \param found: Call \a fn for the keys that are in \a probe, or for the
+ * ones that aren't.
+ */
+void GLU_gset_internal_probe(const GSet *gs,
+							 unsigned int bucket_begin,
+							 unsigned int bucket_end,
+							 const GSet *probe,
+							 bool found,
+							 GSetProbeFP fn,
+							 void *userdata);
+
+/** \} */
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "loomlib_ghash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -------------------------------------------------------------------- */
+/** \name Concurrent GHash Types
+ *
+ * A hash map that can be shared between threads, meant for lookup-heavy
+ * workloads (shared caches, registries).
+ *
+ * - Lookups never take a lock, they are wait-free with respect to writers and
+ *   to resizing.
+ * - Writers (insert, remove) are serialized per lock stripe, writers touching
+ *   different stripes proceed in parallel.
+ * - Growing the bucket array only blocks writers, readers keep using the old
+ *   bucket array until they are done.
+ * - Removed entries (and keys/values replaced by #GLU_cghash_reinsert) are
+ *   released only once no reader can still reference them.
+ *
+ * The same hash and comparison callbacks as #GHash are used, so the
+ * `GLU_ghashutil_*` helpers can be passed directly.
+ * \{ */
+
+typedef struct CGHash CGHash;
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Concurrent GHash API
+ * \{ */
+
+/**
+ * Creates a new, empty concurrent GHash.
+ * \param hash_fp: Hash callback.
+ * \param cmp_fp: Comparison callback.
+ * \param info: Identifier string for the CGHash.
+ * \param nentries_reserve: Optionally reserve the number of members that the
+ * hash will hold, growing the buckets is the only operation that blocks all
+ * writers. \return An empty CGHash.
+ */
+CGHash *GLU_cghash_new_ex(GHashHashFP hash_fp,
+						  GHashCmpFP cmp_fp,
+						  const char *info,
+						  unsigned int nentries_reserve);
+
+/**
+ * Same as calling #GLU_cghash_new_ex(...,0).
+ */
+CGHash *GLU_cghash_new(GHashHashFP hash_fp,
+					   GHashCmpFP cmp_fp,
+					   const char *info);
+
+/**
+ * Frees the CGHash and its members, no other thread may access the hash
+ * while (or after) it is being freed.
+ * \param keyfreefp: Optional callback to free the key.
+ * \param valfreefp: Optional callback to free the value.
+ */
+void GLU_cghash_free(CGHash *cgh,
+					 GHashKeyFreeFP keyfreefp,
+					 GHashValFreeFP valfreefp);
+
+/**
+ * Insert a key/value pair into the \a cgh, unlike #GLU_ghash_insert
+ * duplicates are checked for since callers cannot know whether another
+ * thread inserted the same key.
+ * \return true if the key was added, false if it was already present (in
+ * which case nothing is changed).
+ */
+bool GLU_cghash_insert(CGHash *cgh, void *key, void *val);
+
+/**
+ * Inserts a new value to a key that may already be in the CGHash.
+ *
+ * Avoids #GLU_cghash_remove, #GLU_cghash_insert calls (double lookups).
+ * The previous key and value are freed once no reader can access them
+ * anymore. \returns true if a new key has been added.
+ */
+bool GLU_cghash_reinsert(CGHash *cgh,
+						 void *key,
+						 void *val,
+						 GHashKeyFreeFP keyfreefp,
+						 GHashValFreeFP valfreefp);
+
+/**
+ * Lookup the value of \a key in \a cgh, this never blocks.
+ * \returns the value for \a key or NULL.
+ */
+void *GLU_cghash_lookup(const CGHash *cgh, const void *key);
+
+/**
+ * A version of #GLU_cghash_lookup which accepts a fallback argument.
+ */
+void *GLU_cghash_lookup_default(const CGHash *cgh,
+								const void *key,
+								void *val_default);
+
+/**
+ * \return true if the \a key is in \a cgh.
+ */
+bool GLU_cghash_haskey(const CGHash *cgh, const void *key);
+
+/**
+ * Ensure \a key is exists in \a cgh.
+ *
+ * This handles the common situation where the caller needs ensure a key is
+ * added to \a cgh, constructing a new value in the case the key isn't found.
+ * Otherwise use the existing value.
+ *
+ * \note The value slot stays valid until the key is removed. Until the
+ * caller stores the new value, concurrent lookups of \a key return NULL, use
+ * #GLU_cghash_insert instead when that is not acceptable.
+ *
+ * \returns true when the value didn't need to be added.
+ */
+bool GLU_cghash_ensure_p(CGHash *cgh, void *key, void ***r_val);
+
+/**
+ * Remove \a key from \a cgh, the key and value are freed once no reader can
+ * access them anymore.
+ * \param keyfreefp: Optional callback to free the key.
+ * \param valfreefp: Optional callback to free the value.
+ * \return true if \a key was removed from \a cgh.
+ */
+bool GLU_cghash_remove(CGHash *cgh,
+					   const void *key,
+					   GHashKeyFreeFP keyfreefp,
+					   GHashValFreeFP valfreefp);
+
+/**
+ * \return size of the CGHash, a snapshot when other threads are writing.
+ */
+unsigned int GLU_cghash_len(const CGHash *cgh);
+
+/**
+ * Wait for all readers that started before this call and release every
+ * entry removed so far, this is otherwise done in batches by writers.
+ */
+void GLU_cghash_reclaim(CGHash *cgh);
+
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
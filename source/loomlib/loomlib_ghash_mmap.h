@@ -0,0 +1,134 @@
+#pragma once
+
+#include "loomlib_ghash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -------------------------------------------------------------------- */
+/** \name Mapped GHash Types
+ *
+ * A serialized, read-only hash table that is queried in place. The writer
+ * flattens a string or integer keyed GHash into a single buffer (or file),
+ * the reader only validates the header, there is no parsing and no allocation
+ * when a table is opened, so large dictionaries can simply be mmap'ed.
+ *
+ * The buffer holds a header, a bucket offset array, a flat array of entries
+ * grouped by bucket and a blob with the key (and value) strings. Everything
+ * is addressed by offsets, the format is written in the byte order of the
+ * writer and tables of the other byte order are rejected.
+ * \{ */
+
+typedef enum eGHashMMapKeyType {
+	/** Keys are NULL terminated strings, see #GLU_ghash_str_new. */
+	GHASH_MMAP_KEY_STR = 1,
+	/** Keys are integers stored in the pointer, see #GLU_ghash_int_new. */
+	GHASH_MMAP_KEY_INT = 2,
+} eGHashMMapKeyType;
+
+typedef enum eGHashMMapValType {
+	/** Values are integers stored in the pointer (#POINTER_FROM_INT). */
+	GHASH_MMAP_VAL_INT = 1,
+	/** Values are NULL terminated strings, lookups return a pointer into the
+	 * mapped memory. */
+	GHASH_MMAP_VAL_STR = 2,
+} eGHashMMapValType;
+
+/**
+ * A table opened with #GLU_ghash_mmap_init or #GLU_ghash_mmap_file_open, it
+ * only references the mapped memory. The members are private.
+ */
+typedef struct GHashMMap {
+	const void *data;
+	size_t size;
+
+	const unsigned int *buckets;
+	const struct GHashMMapEntry *entries;
+	const char *strings;
+	unsigned int nentries;
+	unsigned int bucket_mask;
+	unsigned short key_type;
+	unsigned short val_type;
+	/** The memory was mapped by #GLU_ghash_mmap_file_open. */
+	bool is_file;
+} GHashMMap;
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Mapped GHash Writer
+ * \{ */
+
+/**
+ * Serialize \a gh into a newly allocated buffer, \a gh is left untouched.
+ * \param key_type: How the keys of \a gh are to be interpreted.
+ * \param val_type: How the values of \a gh are to be interpreted.
+ * \param r_size: The size of the returned buffer in bytes.
+ * \return The buffer, to be freed with #MEM_freeN.
+ */
+void *GLU_ghash_mmap_write(const GHash *gh,
+						   eGHashMMapKeyType key_type,
+						   eGHashMMapValType val_type,
+						   size_t *r_size);
+
+/**
+ * Same as #GLU_ghash_mmap_write, but the table is written to \a filepath.
+ * \return false when the file could not be written.
+ */
+bool GLU_ghash_mmap_write_file(const GHash *gh,
+							   eGHashMMapKeyType key_type,
+							   eGHashMMapValType val_type,
+							   const char *filepath);
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Mapped GHash Reader
+ * \{ */
+
+/**
+ * Open a table stored in \a data, the memory is referenced (not copied) and
+ * has to outlive \a r_map. Only the header is checked, the rest of the data
+ * is trusted.
+ * \return false when \a data does not hold a table of this format.
+ */
+bool GLU_ghash_mmap_init(GHashMMap *r_map, const void *data, size_t size);
+
+/**
+ * Map \a filepath into memory and open the table it holds.
+ * \return false when the file could not be mapped or is not a valid table.
+ */
+bool GLU_ghash_mmap_file_open(GHashMMap *r_map, const char *filepath);
+
+/**
+ * Unmap a table opened with #GLU_ghash_mmap_file_open, does nothing for
+ * tables opened with #GLU_ghash_mmap_init.
+ */
+void GLU_ghash_mmap_file_close(GHashMMap *map);
+
+/**
+ * Lookup the value of \a key in \a map, keys are passed like they are to
+ * the GHash the table was written from.
+ * \returns the value for \a key or NULL.
+ */
+void *GLU_ghash_mmap_lookup(const GHashMMap *map, const void *key);
+
+/**
+ * A version of #GLU_ghash_mmap_lookup which accepts a fallback argument.
+ */
+void *GLU_ghash_mmap_lookup_default(const GHashMMap *map,
+									const void *key,
+									void *val_default);
+
+/** \return true if the \a key is in \a map. */
+bool GLU_ghash_mmap_haskey(const GHashMMap *map, const void *key);
+
+// \return Returns the size of the \a map.
+unsigned int GLU_ghash_mmap_len(const GHashMMap *map);
+
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
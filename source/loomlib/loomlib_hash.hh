@@ -0,0 +1,65 @@
+#pragma once
+
+#include "loomlib_ghash.h"
+#include "loomlib_utildefines.h"
+
+#include <string>
+#include <type_traits>
+
+namespace loom {
+
+/** Hash functor used by the C++ hash containers. The hashes match the
+ * `GLU_ghashutil_*` callbacks, so values hash the same way as in a #GHash.
+ *
+ * Types without a specialization below have to provide a `Hash()` method. */
+template<typename _Key, typename = void> struct DefaultHash {
+	unsigned int operator()(const _Key &value) const
+	{
+		return value.Hash();
+	}
+};
+
+template<typename _Key>
+struct DefaultHash<_Key,
+				   std::enable_if_t<std::is_integral_v<_Key> ||
+									std::is_enum_v<_Key>>> {
+	unsigned int operator()(const _Key &value) const
+	{
+		const uint64_t key = static_cast<uint64_t>(value);
+		if constexpr (sizeof(_Key) <= sizeof(unsigned int)) {
+			return GLU_ghashutil_uinthash(static_cast<unsigned int>(key));
+		}
+		else {
+			return GLU_ghashutil_combine_hash(
+				GLU_ghashutil_uinthash(static_cast<unsigned int>(key)),
+				GLU_ghashutil_uinthash(static_cast<unsigned int>(key >> 32)));
+		}
+	}
+};
+
+/** Pointers are hashed by address, like #GLU_ghashutil_ptrhash. */
+template<typename _Tp> struct DefaultHash<_Tp *> {
+	unsigned int operator()(const _Tp *value) const
+	{
+		return GLU_ghashutil_ptrhash(value);
+	}
+};
+
+template<> struct DefaultHash<std::string> {
+	unsigned int operator()(const std::string &value) const
+	{
+		return GLU_ghashutil_strhash_n(value.c_str(),
+									   static_cast<unsigned int>(value.size()));
+	}
+};
+
+/** Equality functor used by the C++ hash containers. */
+template<typename _Key> struct DefaultEquality {
+	template<typename A, typename B>
+	bool operator()(const A &a, const B &b) const
+	{
+		return a == b;
+	}
+};
+
+}  // namespace loom
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "loomlib_compiler.h"
+#include "loomlib_utildefines.h"
+
+struct HashXXH3;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * 64 and 128 bit hashes producing the same values as XXH3 (xxHash 0.8), the
+ * bulk of long inputs is mixed with SSE2/AVX2 when the compiler targets
+ * them. Much faster than #GLU_hash_mm2 on anything but tiny keys and wide
+ * enough for tables that outgrow 32 bit hashes.
+ */
+
+typedef struct Hash128 {
+	uint64_t low;
+	uint64_t high;
+} Hash128;
+
+/** Streaming state, see #GLU_hash_xxh3_init. The members are private. */
+typedef struct HashXXH3 {
+	uint64_t acc[8];
+	unsigned char secret[192];
+	unsigned char buffer[256];
+	uint64_t seed;
+	uint64_t size;
+	uint32_t buffer_len;
+	uint32_t nstripes;
+} HashXXH3;
+
+void GLU_hash_xxh3_init(struct HashXXH3 *xxh, uint64_t seed);
+void GLU_hash_xxh3_add(struct HashXXH3 *xxh,
+					   const unsigned char *data,
+					   size_t len);
+void GLU_hash_xxh3_add_int(struct HashXXH3 *xxh, int data);
+
+/** The hash of all data added so far, more data can still be added. */
+uint64_t GLU_hash_xxh3_end(const struct HashXXH3 *xxh);
+Hash128 GLU_hash_xxh3_end_128(const struct HashXXH3 *xxh);
+
+// Non-incremental versions, quicker for small keys.
+uint64_t GLU_hash_xxh3_64(const unsigned char *data, size_t len, uint64_t seed);
+Hash128 GLU_hash_xxh3_128(const unsigned char *data, size_t len, uint64_t seed);
+
+#ifdef __cplusplus
+}
+#endif
@@ -15,8 +15,10 @@
  * Allowing us to keep track of 'alive' objects in our program/scene.
  */
 
+struct GHash;
 struct ListBase;
 struct Link;
+struct MemPool;
 
 #ifdef __cplusplus
 extern "C" {
@@ -291,6 +293,65 @@ void GLU_duplicatelist(struct ListBase *dst, const struct ListBase *src);
  */
 void GLU_listbase_reverse(struct ListBase *listbase);
 
+/**
+ * Sort the links of \a listbase, a stable merge sort that relinks in place
+ * without allocating, O(n log n).
+ *
+ * \note Large lists of links scattered in memory (around a million and more)
+ * can sort faster as an array of pointers, merging lists waits on the memory
+ * latency of every link it follows.
+ * \param cmp: Returns a negative value, zero or a positive value when the
+ * first link goes before, with or after the second (like qsort).
+ */
+void GLU_listbase_sort(struct ListBase *listbase,
+					   int (*cmp)(const void *, const void *));
+
+/**
+ * Same as #GLU_listbase_sort, passing \a thunk to \a cmp as first argument.
+ */
+void GLU_listbase_sort_r(struct ListBase *listbase,
+						 int (*cmp)(void *, const void *, const void *),
+						 void *thunk);
+
+/**
+ * Insert \a vlink into the sorted \a listbase, after the links comparing
+ * equal to it. The search starts at the tail, so adding links in nearly
+ * sorted order only compares a few links each.
+ */
+void GLU_listbase_insert_sorted(struct ListBase *listbase,
+								void *vlink,
+								int (*cmp)(const void *, const void *));
+
+/**
+ * Copy the links of \a listbase into one allocation in list order and relink
+ * them there, so walking the list reads memory front to back instead of
+ * jumping between separately allocated links. The copies are shallow, any
+ * data the links point to is shared with (and now owned by) the copies.
+ *
+ * The links can't be freed one at a time afterwards (#GLU_freelistN,
+ * #GLU_remlink followed by #MEM_freeN), the list has to be freed with
+ * #GLU_listbase_defragment_free. Links can still be added, they are freed
+ * separately.
+ *
+ * \param link_size: The size of every link, all links must be the same type.
+ * \param free_links: Free the old links with #MEM_freeN, pass false when they
+ * are owned elsewhere (e.g. an earlier defragmented block).
+ * \param r_old_to_new: Optionally returns a pointer #GHash from each old link
+ * to its copy, to patch references to the links kept outside the list. When
+ * \a free_links is set the keys are only addresses, they can't be read.
+ * \return The allocation holding the links, NULL when the list is empty.
+ */
+void *GLU_listbase_defragment(struct ListBase *listbase,
+							  size_t link_size,
+							  bool free_links,
+							  struct GHash **r_old_to_new);
+
+/**
+ * Free a list made by #GLU_listbase_defragment, \a block as a unit and any
+ * links added to the list since then one at a time.
+ */
+void GLU_listbase_defragment_free(struct ListBase *listbase, void *block);
+
 /**
  * \param vlink: Link to make first.
  */
@@ -339,6 +400,106 @@ LOOM_INLINE bool GLU_listbase_equal(const struct ListBase *a,
  */
 struct LinkData *GLU_genericNodeN(void *data);
 
+/* -------------------------------------------------------------------- */
+/** \name Pooled Generic Nodes
+ *
+ * #LinkData nodes allocated from a #MemPool instead of one allocation each,
+ * for temporary lists of pointers. The pool belongs to the owner of the
+ * lists, one pool can back several lists. Nodes must be freed with the
+ * functions here, never with #MEM_freeN (#GLU_freelistN).
+ * \{ */
+
+/**
+ * \param nodes_reserve: The number of nodes to allocate room for up front.
+ */
+struct MemPool *GLU_genericNode_pool_create(unsigned int nodes_reserve);
+
+/** Same as #GLU_genericNodeN, the node is allocated from \a pool. */
+struct LinkData *GLU_genericNode_pooled(struct MemPool *pool, void *data);
+
+/** Append a node from \a pool holding \a data to \a listbase. */
+struct LinkData *GLU_addtail_pooled(struct ListBase *listbase,
+									struct MemPool *pool,
+									void *data);
+
+/** Give the nodes of \a listbase back to \a pool, one at a time. */
+void GLU_freelist_pooled(struct ListBase *listbase, struct MemPool *pool);
+
+/**
+ * Empty \a listbase by clearing \a pool as a whole, without visiting the
+ * nodes. Only valid when \a pool holds no nodes of other lists.
+ *
+ * The chunks of \a pool past the first are freed, so the cost is in the
+ * number of chunks rather than nodes, and any reserve of the pool is dropped.
+ */
+void GLU_freelist_pooled_all(struct ListBase *listbase, struct MemPool *pool);
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Parallel Iteration
+ *
+ * Defined in `listbase_parallel.cc`
+ *
+ * The list is walked once to gather its links into an array, then the
+ * threads take chunks of the array until all links are done, so links that
+ * take longer to process don't leave the other threads waiting. The list
+ * must not change while it is iterated.
+ * \{ */
+
+/**
+ * \param userdata: #ListBaseParallelSettings.userdata.
+ * \param link: The link to process.
+ * \param index: The position of \a link in the list.
+ * \param userdata_chunk: The copy of #ListBaseParallelSettings.userdata_chunk
+ * of the calling thread, NULL when there is none.
+ */
+typedef void (*ListBaseParallelFunc)(void *userdata,
+									 struct Link *link,
+									 int index,
+									 void *userdata_chunk);
+/** Merge the chunk of one thread into \a chunk_join. */
+typedef void (*ListBaseParallelReduceFunc)(void *userdata,
+										   void *chunk_join,
+										   void *chunk);
+/** Free what the chunk of one thread owns, not the chunk itself. */
+typedef void (*ListBaseParallelFreeFunc)(void *userdata, void *chunk);
+
+typedef struct ListBaseParallelSettings {
+	/** Passed to all callbacks. */
+	void *userdata;
+	/**
+	 * Optional data every thread gets its own copy of (copied byte by byte),
+	 * for results that would otherwise need locking. Once done the copies are
+	 * merged back into this one by #func_reduce, in thread order.
+	 */
+	void *userdata_chunk;
+	size_t userdata_chunk_size;
+	ListBaseParallelReduceFunc func_reduce;
+	ListBaseParallelFreeFunc func_free;
+	/**
+	 * Every thread gets at least this many links, lists shorter than twice
+	 * this run on the calling thread using #userdata_chunk directly (neither
+	 * #func_reduce nor #func_free are called then). Defaults to 1024, lower it
+	 * when each link takes long to process.
+	 */
+	int min_iter_per_thread;
+	/** The number of threads to use, 0 uses all hardware threads. */
+	int threads_num;
+} ListBaseParallelSettings;
+
+void GLU_listbase_parallel_settings_init(ListBaseParallelSettings *settings);
+
+/**
+ * Call \a func for every link of \a listbase, from several threads. The
+ * calling thread is one of them.
+ */
+void GLU_listbase_parallel_foreach(const struct ListBase *listbase,
+								   ListBaseParallelFunc func,
+								   const ListBaseParallelSettings *settings);
+
+/** \} */
+
 /**
  * Does a full loop on the list, with any value acting as first
  * (handy for cycling items)
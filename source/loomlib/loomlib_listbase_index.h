@@ -0,0 +1,67 @@
+#pragma once
+
+#include "loomlib_listbase.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -------------------------------------------------------------------- */
+/** \name ListBase Index
+ *
+ * Lookup tables on the side of a #ListBase, for code that calls
+ * #GLU_findlink, #GLU_findindex, #GLU_findstring or #GLU_findptr in a loop
+ * over the same list. Each table (the array of links for index access, and a
+ * #GHash per looked up string or pointer member) is built on its first use
+ * and answers the same as the linear functions, including returning the
+ * first of several matching links.
+ *
+ * The list itself is unchanged, so the index can't see every change made to
+ * it. Adding or removing links at either end is noticed, any other change
+ * (inserting or removing links in the middle, reordering, changing an indexed
+ * member) must be followed by #GLU_listbase_index_tag_dirty. Tables are
+ * rebuilt when next used after a change, not when it is made.
+ * \{ */
+
+typedef struct ListBaseIndex ListBaseIndex;
+
+/**
+ * \param listbase: The list to index, it has to outlive the index.
+ */
+ListBaseIndex *GLU_listbase_index_new(const struct ListBase *listbase);
+
+void GLU_listbase_index_free(ListBaseIndex *index);
+
+/** Mark all tables as out of date, after a change to the list. */
+void GLU_listbase_index_tag_dirty(ListBaseIndex *index);
+
+/** Same as #GLU_listbase_count, O(1) once built. */
+int GLU_listbase_index_count(ListBaseIndex *index);
+
+/** Same as #GLU_findlink, O(1) once built. */
+void *GLU_listbase_index_findlink(ListBaseIndex *index, int number);
+
+/** Same as #GLU_findindex, O(1) once built. */
+int GLU_listbase_index_findindex(ListBaseIndex *index, const void *vlink);
+
+/** Same as #GLU_findstring, a string stored in the link at \a offset. */
+void *GLU_listbase_index_findstring(ListBaseIndex *index,
+									const char *id,
+									int offset);
+
+/** Same as #GLU_findstring_ptr, a pointer to a string at \a offset. Links
+ * with a NULL string are skipped. */
+void *GLU_listbase_index_findstring_ptr(ListBaseIndex *index,
+										const char *id,
+										int offset);
+
+/** Same as #GLU_findptr, a pointer stored in the link at \a offset. */
+void *GLU_listbase_index_findptr(ListBaseIndex *index,
+								 const void *ptr,
+								 int offset);
+
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
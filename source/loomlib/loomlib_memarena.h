@@ -0,0 +1,46 @@
+#pragma once
+
+#include "loomlib_compiler.h"
+#include "loomlib_utildefines.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct MemArena;
+
+typedef struct MemArena MemArena;
+
+/** The default buffer size for #GLU_memarena_new. */
+#define LOOM_MEMARENA_STD_BUFSIZE ((size_t)1 << 14)
+
+/**
+ * Create an arena, a bump allocator for many small allocations that are all
+ * freed at once. Allocations are never freed one by one.
+ * \param bufsize The size of the buffers the arena allocates from, larger
+ * allocations get a buffer of their own.
+ * \param name The identifier of the buffer allocations.
+ */
+MemArena *GLU_memarena_new(size_t bufsize, const char *name);
+
+/** Free the arena and every allocation made from it. */
+void GLU_memarena_free(MemArena *ma);
+
+/** Set the alignment of the allocations, a power of two (default 8). */
+void GLU_memarena_use_align(MemArena *ma, size_t align);
+
+/** Allocate \a size bytes from the arena. */
+void *GLU_memarena_alloc(MemArena *ma, size_t size);
+
+/** Same as #GLU_memarena_alloc but the memory is zeroed. */
+void *GLU_memarena_calloc(MemArena *ma, size_t size);
+
+/**
+ * Free every allocation made from the arena, keeping the most recent buffer
+ * for reuse.
+ */
+void GLU_memarena_clear(MemArena *ma);
+
+#ifdef __cplusplus
+}
+#endif
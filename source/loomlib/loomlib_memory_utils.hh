@@ -5,6 +5,7 @@
 #include "loomlib_assert.h"
 #include "loomlib_utildefines.h"
 
+#include <cstring>
 #include <memory>
 #include <new>
 #include <type_traits>
@@ -26,6 +27,18 @@ template<typename T>
 inline constexpr bool is_trivially_move_constructible_extended_v =
 	is_trivial_extended_v<T> || std::is_trivially_move_constructible_v<T>;
 
+/** A type is trivially relocatable when moving a value to another address and
+ * destructing the original is the same as copying its bytes, so arrays of it
+ * can be moved with #memcpy or grown with #MEM_reallocN. That holds for most
+ * types that don't point into themselves, even with non-trivial move
+ * constructors and destructors (e.g. an owning pointer). Specialize this for
+ * such types to opt them in. */
+template<typename T>
+inline constexpr bool is_trivially_relocatable_extended_v =
+	is_trivial_extended_v<T> ||
+	(std::is_trivially_move_constructible_v<T> &&
+	 std::is_trivially_destructible_v<T>);
+
 /** Call the destructor on n consecutive values. For trivially destructible
  * types, this does nothing.
  *
@@ -227,6 +240,12 @@ template<typename T> void initialized_relocate_n(T *src, size_t n, T *dst)
  */
 template<typename T> void uninitialized_relocate_n(T *src, size_t n, T *dst)
 {
+	if constexpr (is_trivially_relocatable_extended_v<T>) {
+		if (n) {
+			memcpy(static_cast<void *>(dst), src, sizeof(T) * n);
+		}
+		return;
+	}
 	uninitialized_move_n(src, n, dst);
 	destruct_n(src, n);
 }
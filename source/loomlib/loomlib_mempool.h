@@ -70,6 +70,11 @@ void GLU_mempool_discard(MemPool *pool);
  * \return Return the number of elements currently allocated in the mempool. */
 size_t GLU_mempool_len(const MemPool *pool);
 
+/** Get the memory allocated by the mempool.
+ * \param pool The mempool we want to measure.
+ * \return Returns the bytes of the pool and all of its chunks, used or not. */
+size_t GLU_mempool_calc_memory(const MemPool *pool);
+
 /** Find the element in the given position in the mempool.
  * \param pool The mempool to search in.
  * \param index The index of the element we want to get.
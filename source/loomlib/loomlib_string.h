@@ -17,9 +17,10 @@
  * function that do not use memory allocations or deallocations as well for
  * the sake of consistency in the code.
  *
- * \note The perfomance of #GLU_strlen is yet to be tested but it is expected to
- * perform better than #strlen in most cases as it uses a faster compare
- * method than #strlen.
+ * \note #GLU_strlen, #GLU_strnlen, #GLU_memchr, #GLU_strcspn_class,
+ * #GLU_strncpy_rlen and the substring search functions pick an
+ * SSE2/AVX2/AVX-512 implementation at runtime from what the CPU supports,
+ * see #GLU_str_simd_level_get.
  */
 
 #ifdef __cplusplus
@@ -57,13 +58,13 @@ char *GLU_strdupcat(const char *__restrict str1, const char *__restrict str2);
 
 /**
  * Return the length of the null-terminated string STR. Scan for
- * the null terminator quickly by testing four bytes at a time.
+ * the null terminator quickly by testing a vector of bytes at a time.
  */
 size_t GLU_strlen(const char *string);
 
 /**
- * Return the length of the fixed-size string STR. Scan for
- * the null terminator quickly by testing four bytes at a time.
+ * Return the length of the fixed-size string STR, at most \a maxn. Scan for
+ * the null terminator quickly by testing a vector of bytes at a time.
  */
 size_t GLU_strnlen(const char *string, size_t maxn);
 
@@ -120,6 +121,109 @@ size_t GLU_strcpy_rlen(char *__restrict dst, const char *__restrict src);
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name String Search
+ * \{ */
+
+/**
+ * A set of bytes to scan for with #GLU_strcspn_class, the NULL terminator is
+ * always part of it. Build it once with #GLU_str_charclass_init and reuse it,
+ * the members are private.
+ */
+typedef struct StrCharClass {
+	/** Indexed by the low nibble, one bit per high nibble 0-7. */
+	unsigned char lut_lo[16];
+	/** Indexed by the low nibble, one bit per high nibble 8-15. */
+	unsigned char lut_hi[16];
+} StrCharClass;
+
+/**
+ * Same as #memchr.
+ * \return The first occurrence of \a c in the first \a len bytes of \a buf
+ * or NULL.
+ */
+void *GLU_memchr(const void *buf, int c, size_t len);
+
+/**
+ * \param chars: A NULL terminated string of the bytes in the class.
+ */
+void GLU_str_charclass_init(StrCharClass *cls, const char *chars);
+
+/**
+ * Same as #strcspn with a prebuilt set of rejected bytes.
+ * \return The index of the first byte of \a str in \a cls, the length of the
+ * string when there is none.
+ */
+size_t GLU_strcspn_class(const char *str, const StrCharClass *cls);
+
+/**
+ * Same as #strstr, in linear time whatever the strings (Two-Way), typical
+ * needles are found by filtering their first and last byte a vector at a
+ * time. To search for the same needle many times see #GLU_str_needle_new.
+ * \return The first occurrence of \a needle in \a haystack or NULL,
+ * \a haystack when \a needle is empty.
+ */
+char *GLU_strstr(const char *haystack, const char *needle);
+
+/**
+ * Same as #GLU_strstr, ignoring the case of ASCII letters.
+ */
+char *GLU_strcasestr(const char *haystack, const char *needle);
+
+/**
+ * \return The last occurrence of \a needle in \a haystack or NULL, the end
+ * of \a haystack when \a needle is empty.
+ */
+char *GLU_strrstr(const char *haystack, const char *needle);
+
+/**
+ * Same as #GLU_strstr for buffers that may hold NULL bytes.
+ * \return The first occurrence of the \a needle_len bytes of \a needle in
+ * the first \a haystack_len bytes of \a haystack or NULL.
+ */
+void *GLU_memmem(const void *haystack,
+				 size_t haystack_len,
+				 const void *needle,
+				 size_t needle_len);
+
+/**
+ * Same as #GLU_memmem for the last occurrence, \a haystack + \a haystack_len
+ * when \a needle is empty.
+ */
+void *GLU_memrmem(const void *haystack,
+				  size_t haystack_len,
+				  const void *needle,
+				  size_t needle_len);
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name String SIMD Dispatch
+ * \{ */
+
+typedef enum eStrSimdLevel {
+	STR_SIMD_SCALAR = 0,
+	STR_SIMD_SSE2,
+	STR_SIMD_AVX2,
+	/** AVX-512F and AVX-512BW. */
+	STR_SIMD_AVX512,
+} eStrSimdLevel;
+
+/**
+ * \return The instruction set the string functions currently use, detected
+ * on the first call of any of them.
+ */
+eStrSimdLevel GLU_str_simd_level_get(void);
+
+/**
+ * Use at most \a level for the string functions, for testing and
+ * benchmarking. Not thread safe, call it before any other thread uses them.
+ * \return The level used, lower than \a level when the CPU lacks it.
+ */
+eStrSimdLevel GLU_str_simd_level_set(eStrSimdLevel level);
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name String Transform
  * \{ */
@@ -129,12 +233,10 @@ size_t GLU_strcpy_rlen(char *__restrict dst, const char *__restrict src);
  * Returns a copy of the c-string \a str into a newly #MEM_mallocN'd
  * and returns it.
  *
- * \note A rather wasteful string-replacement utility, though this shall do for
- * now. Feel free to replace this with an even safe + nicer alternative. \remark
- * Time complexity should be O ( |str| + |substr_old| ) to detect the duplicates
- * and O ( |str| ) <= actual_complexity <= O ( |str| * |substr_new| /
- * |substr_old| ) to create the new string. It is safe to assume that the
- * complexity will never exceed : O ( |str| * |substr_new| + |substr_old| )!
+ * Occurrences don't overlap, the string is searched left to right and
+ * the search resumes after each replaced occurrence. The output is counted
+ * before it is written, so the only allocation is the result. See
+ * #GLU_str_replacer_new to replace several patterns at once.
  *
  * \param str: The string to replace occurrences of substr_old in.
  * \param substr_old: The text in the string to find and replace.
@@ -214,6 +316,60 @@ char *GLU_sprintfN(const char *__restrict format, ...);
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Number Conversion
+ *
+ * Numbers to and from text without a format string, an allocation or the
+ * locale (the decimal point is always '.').
+ *
+ * The to_chars functions write a NULL terminated string into \a dst and
+ * return its length, or write an empty string and return zero when it
+ * doesn't fit in \a maxncpy bytes. The *_CHARS_SIZE buffers always fit.
+ *
+ * The chars_to functions parse a number at the start of the first \a len
+ * bytes of \a str (no leading white space) and return the number of bytes
+ * parsed, zero when there is no number or an integer is out of range, in
+ * which case \a r_value is left as it was.
+ * \{ */
+
+#define GLU_INT_CHARS_SIZE 21
+/** "-2.2250738585072014e-308" and a terminator. */
+#define GLU_DOUBLE_CHARS_SIZE 25
+/** "-1000000000000000" (1e15 in fixed notation) and a terminator. */
+#define GLU_FLOAT_CHARS_SIZE 18
+
+size_t GLU_int_to_chars(char *dst, size_t maxncpy, int64_t value);
+size_t GLU_uint_to_chars(char *dst, size_t maxncpy, uint64_t value);
+
+/**
+ * Print the shortest decimal that reads back as \a value, the closest to it
+ * when there are several (Ryu). Fixed notation is used for decimal exponents
+ * from -4 to 15, e.g. "0.001", "1234.5" or "100", scientific notation
+ * otherwise, e.g. "1e+16" or "2.5e-07". Also "inf", "-inf", "nan" and "-0".
+ */
+size_t GLU_double_to_chars(char *dst, size_t maxncpy, double value);
+/** Same as #GLU_double_to_chars, shortest as a float. */
+size_t GLU_float_to_chars(char *dst, size_t maxncpy, float value);
+
+/**
+ * Parse an optional '+' or '-' followed by decimal digits.
+ */
+size_t GLU_chars_to_int(const char *str, size_t len, int64_t *r_value);
+/** Same as #GLU_chars_to_int, without a sign. */
+size_t GLU_chars_to_uint(const char *str, size_t len, uint64_t *r_value);
+
+/**
+ * Parse `[+|-]digits[.digits][(e|E)[+|-]digits]` (with digits before or after
+ * the point), "inf", "infinity" or "nan" (in any case), correctly rounded
+ * half to even whatever the number of digits. Values out of range are
+ * rounded to infinity or zero, as with #strtod.
+ */
+size_t GLU_chars_to_double(const char *str, size_t len, double *r_value);
+/** Same as #GLU_chars_to_double, rounded to a float once. */
+size_t GLU_chars_to_float(const char *str, size_t len, float *r_value);
+
+/** \} */
+
 #ifdef __cplusplus
 }
 #endif
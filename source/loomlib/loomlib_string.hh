@@ -0,0 +1,406 @@
+#pragma once
+
+#include "loomlib_utildefines.h"
+
+#include "loomlib_allocator.hh"
+#include "loomlib_memory_utils.hh"
+#include "loomlib_string.h"
+#include "loomlib_string_ref.hh"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+namespace loom {
+
+/** An owning, always NULL terminated string.
+ *
+ * Strings of up to #InlineCapacity bytes are stored in the object itself,
+ * which covers most identifiers and names without a heap allocation. Longer
+ * ones are allocated with the #GuardedAllocator, so the buffer can be handed
+ * to and taken from the C API (#Release, #Adopt) without copying. Moving a
+ * string with a heap buffer only moves the pointer. */
+class String {
+   public:
+	using value_type = char;
+	using iterator = char *;
+	using const_iterator = const char *;
+	using size_type = size_t;
+
+	// The number of bytes stored without allocating, not counting the NULL.
+	static constexpr size_t InlineCapacity = 15;
+
+   private:
+	// Points to #mInline when the string is stored inline.
+	char *mData;
+	size_t mSize;
+	union {
+		// The bytes allocated for #mData minus the terminator, when on the heap.
+		size_t mCapacity;
+		char mInline[InlineCapacity + 1];
+	};
+
+	LOOM_NO_UNIQUE_ADDRESS GuardedAllocator mAllocator;
+
+   public:
+	// Create an empty string.
+	String() noexcept : mData(mInline), mSize(0)
+	{
+		mInline[0] = '\0';
+	}
+
+	String(NoExceptConstructor) noexcept : String()
+	{
+	}
+
+	String(const StringRef str) : String()
+	{
+		this->Assign(str);
+	}
+
+	String(const char *str) : String(StringRef(str))
+	{
+	}
+
+	String(const char *str, const size_t size) : String(StringRef(str, size))
+	{
+	}
+
+	String(const std::string &str) : String(StringRef(str))
+	{
+	}
+
+	String(const String &other) : String(StringRef(other))
+	{
+	}
+
+	String(String &&other) noexcept : mSize(other.mSize)
+	{
+		if (other.IsInline()) {
+			mData = mInline;
+			memcpy(mInline, other.mInline, sizeof(mInline));
+		}
+		else {
+			/* Steal the buffer. */
+			mData = other.mData;
+			mCapacity = other.mCapacity;
+		}
+		other.mData = other.mInline;
+		other.mSize = 0;
+		other.mInline[0] = '\0';
+	}
+
+	~String()
+	{
+		if (!this->IsInline()) {
+			mAllocator.deallocate(mData);
+		}
+	}
+
+	/** Reuses the buffer when the string fits. */
+	String &operator=(const String &other)
+	{
+		if (this != &other) {
+			this->Assign(other);
+		}
+		return *this;
+	}
+
+	String &operator=(String &&other) noexcept
+	{
+		return move_assign_container(*this, std::move(other));
+	}
+
+	String &operator=(const StringRef str)
+	{
+		this->Assign(str);
+		return *this;
+	}
+
+	String &operator=(const char *str)
+	{
+		this->Assign(str);
+		return *this;
+	}
+
+	/** Take ownership of a string allocated with the MEM_* functions, such as
+	 * the result of #GLU_strdup or #GLU_sprintfN, without copying it. */
+	static String Adopt(char *str)
+	{
+		String result;
+		const size_t size = GLU_strlen(str);
+		if (size <= InlineCapacity) {
+			memcpy(result.mInline, str, size + 1);
+			MEM_freeN(str);
+		}
+		else {
+			result.mData = str;
+			result.mCapacity = MEM_allocN_len(str) - 1;
+		}
+		result.mSize = size;
+		return result;
+	}
+
+	/** Take the buffer out of the string, which is left empty. It is only
+	 * copied when the string is stored inline.
+	 * \return The NULL terminated string, free with #MEM_freeN. */
+	char *Release()
+	{
+		char *str;
+		if (this->IsInline()) {
+			str = GLU_strdupn(mInline, mSize);
+		}
+		else {
+			str = mData;
+			mData = mInline;
+		}
+		mSize = 0;
+		mInline[0] = '\0';
+		return str;
+	}
+
+	/** Conversion to #StringRef is implied, the string stays NULL terminated
+	 * through any change. */
+	operator StringRefNull() const
+	{
+		return StringRefNull(mData, mSize);
+	}
+
+	StringRefNull Ref() const
+	{
+		return *this;
+	}
+
+	// Returns the number of bytes, without the NULL terminator.
+	size_t Size() const
+	{
+		return mSize;
+	}
+
+	// Returns true if the size is zero.
+	bool IsEmpty() const
+	{
+		return mSize == 0;
+	}
+
+	// Returns the number of bytes that fit without a reallocation.
+	size_t Capacity() const
+	{
+		return this->IsInline() ? InlineCapacity : mCapacity;
+	}
+
+	// Returns true when the string is stored in the object itself.
+	bool IsInline() const
+	{
+		return mData == mInline;
+	}
+
+	// Returns the NULL terminated string.
+	const char *CStr() const
+	{
+		return mData;
+	}
+
+	const char *Data() const
+	{
+		return mData;
+	}
+
+	/** The bytes can be changed in place, up to #Size (the terminator must
+	 * stay). */
+	char *Data()
+	{
+		return mData;
+	}
+
+	const char *Begin() const
+	{
+		return mData;
+	}
+	const char *End() const
+	{
+		return mData + mSize;
+	}
+	char *Begin()
+	{
+		return mData;
+	}
+	char *End()
+	{
+		return mData + mSize;
+	}
+
+	/** Access a byte in the string. This invokes undefined behavior when the
+	 * index is out of bounds. */
+	char operator[](const size_t index) const
+	{
+		LOOM_assert(index < mSize);
+		return mData[index];
+	}
+
+	char &operator[](const size_t index)
+	{
+		LOOM_assert(index < mSize);
+		return mData[index];
+	}
+
+	/** Make sure that enough memory is allocated to hold \a min_capacity bytes,
+	 * without the NULL terminator. */
+	void Reserve(const size_t min_capacity)
+	{
+		if (min_capacity > this->Capacity()) {
+			this->ReallocToAtLeast(min_capacity);
+		}
+	}
+
+	/** Change the size of the string, new bytes are set to \a fill. */
+	void Resize(const size_t new_size, const char fill = '\0')
+	{
+		if (new_size > mSize) {
+			this->Reserve(new_size);
+			memset(mData + mSize, fill, new_size - mSize);
+		}
+		mSize = new_size;
+		mData[mSize] = '\0';
+	}
+
+	/** Make the string empty, the buffer is kept. */
+	void Clear()
+	{
+		mSize = 0;
+		mData[0] = '\0';
+	}
+
+	/** Replace the contents with \a str, the buffer is reused when it fits.
+	 * \a str may point into this string. */
+	void Assign(const StringRef str)
+	{
+		if (str.Size() > this->Capacity()) {
+			String copy;
+			copy.ReallocToAtLeast(str.Size());
+			copy.Assign(str);
+			*this = std::move(copy);
+			return;
+		}
+		memmove(mData, str.Data(), str.Size());
+		mSize = str.Size();
+		mData[mSize] = '\0';
+	}
+
+	String &Append(const StringRef str)
+	{
+		if (mSize + str.Size() > this->Capacity()) {
+			/* Keep \a str valid when it points into this string. */
+			String grown;
+			grown.ReallocToAtLeast(std::max(mSize + str.Size(),
+											this->Capacity() * 2));
+			memcpy(grown.mData, mData, mSize);
+			memcpy(grown.mData + mSize, str.Data(), str.Size());
+			grown.mSize = mSize + str.Size();
+			grown.mData[grown.mSize] = '\0';
+			*this = std::move(grown);
+			return *this;
+		}
+		memmove(mData + mSize, str.Data(), str.Size());
+		mSize += str.Size();
+		mData[mSize] = '\0';
+		return *this;
+	}
+
+	String &Append(const char c)
+	{
+		if (mSize == this->Capacity()) {
+			this->ReallocToAtLeast(mSize + 1);
+		}
+		mData[mSize++] = c;
+		mData[mSize] = '\0';
+		return *this;
+	}
+
+	String &operator+=(const StringRef str)
+	{
+		return this->Append(str);
+	}
+
+	String &operator+=(const char c)
+	{
+		return this->Append(c);
+	}
+
+	/** Append a formatted string. The arguments may point into this string,
+	 * it's printed to a separate buffer first. */
+	String &Appendf(const char *ATTR_PRINTF_FORMAT_STRING format, ...)
+	{
+		va_list args;
+		va_start(args, format);
+		this->VAppendf(format, args);
+		va_end(args);
+		return *this;
+	}
+
+	String &VAppendf(const char *ATTR_PRINTF_FORMAT_STRING format,
+					 va_list args)
+	{
+		/* Short results (the common case) fit on the stack. */
+		char fixed[256];
+
+		va_list args_copy;
+		va_copy(args_copy, args);
+		const int len = vsnprintf(fixed, sizeof(fixed), format, args_copy);
+		va_end(args_copy);
+
+		if (len < 0) {
+			LOOM_assert_unreachable();
+			return *this;
+		}
+		if (static_cast<size_t>(len) < sizeof(fixed)) {
+			return this->Append(StringRef(fixed, static_cast<size_t>(len)));
+		}
+
+		/* Print again into a buffer of the size now known. */
+		char *buffer = static_cast<char *>(
+			mAllocator.allocate(static_cast<size_t>(len) + 1, alignof(char), AT));
+		vsnprintf(buffer, static_cast<size_t>(len) + 1, format, args);
+		this->Append(StringRef(buffer, static_cast<size_t>(len)));
+		mAllocator.deallocate(buffer);
+		return *this;
+	}
+
+	unsigned int Hash() const
+	{
+		return this->Ref().Hash();
+	}
+
+	friend String operator+(const StringRef a, const StringRef b)
+	{
+		String result;
+		result.Reserve(a.Size() + b.Size());
+		result.Append(a);
+		result.Append(b);
+		return result;
+	}
+
+   private:
+	void ReallocToAtLeast(const size_t min_capacity)
+	{
+		if (this->Capacity() >= min_capacity) {
+			return;
+		}
+
+		/* At least double, so appending a byte at a time stays amortized
+		 * constant time. */
+		const size_t new_capacity = std::max(min_capacity,
+											 this->Capacity() * 2);
+		char *new_data = static_cast<char *>(
+			mAllocator.allocate(new_capacity + 1, alignof(char), AT));
+		memcpy(new_data, mData, mSize + 1);
+
+		if (!this->IsInline()) {
+			mAllocator.deallocate(mData);
+		}
+		mData = new_data;
+		mCapacity = new_capacity;
+	}
+};
+
+}  // namespace loom
@@ -0,0 +1,288 @@
+#pragma once
+
+#include "loomlib_assert.h"
+#include "loomlib_ghash.h"
+#include "loomlib_string.h"
+#include "loomlib_utildefines.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace loom {
+
+/** A non-owning reference to a string, which doesn't have to be NULL
+ * terminated (see #StringRefNull for one that is). Cheap to copy, pass it by
+ * value.
+ *
+ * The hash matches #GLU_ghashutil_strhash_p, so a #StringRef can look up a
+ * #GHash or #GSet whose keys are C strings without copying it into a NULL
+ * terminated buffer, see #LookupIn. */
+class StringRef {
+   public:
+	using value_type = char;
+	using iterator = const char *;
+	using size_type = size_t;
+
+	/** Returned by the find functions when there is no match. */
+	static constexpr size_t NotFound = SIZE_MAX;
+
+   protected:
+	const char *mData = "";
+	size_t mSize = 0;
+
+   public:
+	// Create a reference to an empty string.
+	constexpr StringRef() = default;
+
+	constexpr StringRef(const char *str)
+		: mData(str), mSize(std::char_traits<char>::length(str))
+	{
+	}
+
+	constexpr StringRef(const char *str, const size_t size)
+		: mData(str), mSize(size)
+	{
+	}
+
+	constexpr StringRef(const char *begin, const char *end)
+		: mData(begin), mSize(static_cast<size_t>(end - begin))
+	{
+	}
+
+	StringRef(const std::string &str) : mData(str.data()), mSize(str.size())
+	{
+	}
+
+	// Returns the number of bytes, without a NULL terminator.
+	constexpr size_t Size() const
+	{
+		return mSize;
+	}
+
+	// Returns true if the size is zero.
+	constexpr bool IsEmpty() const
+	{
+		return mSize == 0;
+	}
+
+	// Returns the pointer to the first byte, it is not NULL terminated.
+	constexpr const char *Data() const
+	{
+		return mData;
+	}
+
+	constexpr const char *Begin() const
+	{
+		return mData;
+	}
+	constexpr const char *End() const
+	{
+		return mData + mSize;
+	}
+
+	/** Access a byte in the string. This invokes undefined behavior when the
+	 * index is out of bounds. */
+	constexpr char operator[](const size_t index) const
+	{
+		LOOM_assert(index < mSize);
+		return mData[index];
+	}
+
+	/** Returns a part of the string, clamped to its end. */
+	constexpr StringRef Slice(const size_t start, const size_t size) const
+	{
+		const size_t clamped_start = std::min(start, mSize);
+		return StringRef(mData + clamped_start,
+						 std::min(size, mSize - clamped_start));
+	}
+
+	/** Returns a new StringRef with n bytes removed from the beginning. */
+	constexpr StringRef DropFront(const size_t n) const
+	{
+		const size_t clamped_n = std::min(n, mSize);
+		return StringRef(mData + clamped_n, mSize - clamped_n);
+	}
+
+	/** Returns a new StringRef with n bytes removed from the end. */
+	constexpr StringRef DropBack(const size_t n) const
+	{
+		return StringRef(mData, mSize - std::min(n, mSize));
+	}
+
+	/** Returns a new StringRef that only contains the first n bytes. */
+	constexpr StringRef TakeFront(const size_t n) const
+	{
+		return StringRef(mData, std::min(n, mSize));
+	}
+
+	/** Returns a new StringRef that only contains the last n bytes. */
+	constexpr StringRef TakeBack(const size_t n) const
+	{
+		const size_t clamped_n = std::min(n, mSize);
+		return StringRef(mData + mSize - clamped_n, clamped_n);
+	}
+
+	constexpr bool StartsWith(const StringRef prefix) const
+	{
+		if (prefix.mSize > mSize) {
+			return false;
+		}
+		for (size_t i = 0; i < prefix.mSize; i++) {
+			if (mData[i] != prefix.mData[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	constexpr bool EndsWith(const StringRef suffix) const
+	{
+		return suffix.mSize <= mSize &&
+			   this->TakeBack(suffix.mSize).StartsWith(suffix);
+	}
+
+	/** Returns the index of the first occurrence of the byte at or after
+	 * \a pos, #NotFound when there is none. */
+	size_t Find(const char c, const size_t pos = 0) const
+	{
+		if (pos >= mSize) {
+			return NotFound;
+		}
+		const void *match = GLU_memchr(mData + pos, c, mSize - pos);
+		return match ? static_cast<size_t>(static_cast<const char *>(match) -
+											mData) :
+					   NotFound;
+	}
+
+	/** Returns the index of the first occurrence of \a str at or after \a pos,
+	 * #NotFound when there is none. */
+	size_t Find(const StringRef str, const size_t pos = 0) const
+	{
+		if (pos > mSize) {
+			return NotFound;
+		}
+		const void *match = GLU_memmem(
+			mData + pos, mSize - pos, str.mData, str.mSize);
+		return match ? static_cast<size_t>(static_cast<const char *>(match) -
+											mData) :
+					   NotFound;
+	}
+
+	/** Returns the index of the last occurrence of \a str, #NotFound when
+	 * there is none. */
+	size_t RFind(const StringRef str) const
+	{
+		const void *match = GLU_memrmem(mData, mSize, str.mData, str.mSize);
+		return match ? static_cast<size_t>(static_cast<const char *>(match) -
+											mData) :
+					   NotFound;
+	}
+
+	/** Copy the string into \a dst with a NULL terminator, truncated to fit
+	 * \a dst_maxncpy bytes (which must not be zero).
+	 * Returns the number of bytes copied, without the terminator. */
+	size_t Copy(char *dst, const size_t dst_maxncpy) const
+	{
+		LOOM_assert(dst_maxncpy != 0);
+		const size_t len = std::min(mSize, dst_maxncpy - 1);
+		memcpy(dst, mData, len);
+		dst[len] = '\0';
+		return len;
+	}
+
+	/** Same as #GLU_ghashutil_strhash_n with the size of the string, also
+	 * usable at compile time. */
+	constexpr unsigned int Hash() const
+	{
+		unsigned int h = 5381;
+		for (size_t i = 0; i < mSize && mData[i] != '\0'; i++) {
+			h = ((h << 5) + h) +
+				static_cast<unsigned int>(static_cast<signed char>(mData[i]));
+		}
+		return h;
+	}
+
+	/** Look up this string in a #GHash of C string keys
+	 * (#GLU_ghash_str_new), \return the value or NULL. */
+	void *LookupIn(const GHash *gh) const
+	{
+		return GLU_ghash_lookup_ex(gh, this->Hash(), GHashCmp, this);
+	}
+
+	/** Look up this string in a #GSet of C strings (#GLU_gset_str_new),
+	 * \return the matching key or NULL. */
+	void *LookupIn(const GSet *gs) const
+	{
+		return GLU_gset_lookup_ex(gs, this->Hash(), GHashCmp, this);
+	}
+
+	explicit operator std::string() const
+	{
+		return std::string(mData, mSize);
+	}
+
+   private:
+	/** #GHashLookupCmpFP comparing a #StringRef with a C string key. */
+	static bool GHashCmp(const void *user_data, const void *key)
+	{
+		const StringRef *ref = static_cast<const StringRef *>(user_data);
+		const char *str = static_cast<const char *>(key);
+		return !(strncmp(str, ref->mData, ref->mSize) == 0 &&
+				 str[ref->mSize] == '\0' &&
+				 memchr(ref->mData, '\0', ref->mSize) == nullptr);
+	}
+};
+
+/** A reference to a NULL terminated string, which can be passed to the C
+ * API as it is. */
+class StringRefNull : public StringRef {
+   public:
+	constexpr StringRefNull() = default;
+
+	constexpr StringRefNull(const char *str) : StringRef(str)
+	{
+	}
+
+	/** \a size must be the length of \a str, it saves computing it. */
+	constexpr StringRefNull(const char *str, const size_t size)
+		: StringRef(str, size)
+	{
+		LOOM_assert(str[size] == '\0');
+	}
+
+	StringRefNull(const std::string &str) : StringRef(str)
+	{
+	}
+
+	// Returns the NULL terminated string.
+	constexpr const char *CStr() const
+	{
+		return mData;
+	}
+};
+
+inline bool operator==(const StringRef a, const StringRef b)
+{
+	return a.Size() == b.Size() && memcmp(a.Data(), b.Data(), a.Size()) == 0;
+}
+
+inline bool operator!=(const StringRef a, const StringRef b)
+{
+	return !(a == b);
+}
+
+/** Byte wise order, a prefix comes first. */
+inline bool operator<(const StringRef a, const StringRef b)
+{
+	const int cmp = memcmp(a.Data(), b.Data(), std::min(a.Size(), b.Size()));
+	return (cmp != 0) ? (cmp < 0) : (a.Size() < b.Size());
+}
+
+inline std::ostream &operator<<(std::ostream &stream, const StringRef ref)
+{
+	return stream.write(ref.Data(), static_cast<std::streamsize>(ref.Size()));
+}
+
+}  // namespace loom
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "loomlib_compiler.h"
+#include "loomlib_utildefines.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -------------------------------------------------------------------- */
+/** \name String Replace Types
+ *
+ * Replaces every occurrence of a set of patterns, left to right. Where
+ * occurrences overlap the leftmost one wins, and of those starting at the
+ * same byte the longest one, the text of a replaced occurrence is not
+ * searched again.
+ *
+ * A single pattern is found by filtering its first byte with #GLU_memchr,
+ * several patterns with an Aho-Corasick automaton built once in
+ * #GLU_str_replacer_new. Neither allocates while replacing, the output size
+ * is counted in a first pass so the result is allocated exactly once.
+ *
+ * The automaton rescans the bytes read past a replaced occurrence, up to the
+ * length of the longest pattern per replacement, so the cost is
+ * O(n * longest pattern) in the worst case (e.g. "a" and "aaaaab" over a run
+ * of 'a'), close to O(n) when the patterns rarely share prefixes.
+ * \{ */
+
+typedef struct StrReplacer StrReplacer;
+
+/**
+ * Receives the output of #GLU_str_replacer_stream in pieces, \a data is not
+ * NULL terminated.
+ */
+typedef void (*StrReplaceWriteFn)(void *user_data, const char *data, size_t len);
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name String Replace API
+ * \{ */
+
+/**
+ * Build a replacer for \a npatterns patterns, the strings are copied.
+ *
+ * \param patterns: The non empty strings to find, when a pattern is repeated
+ * only its first replacement is used.
+ * \param replacements: The string to replace the pattern at the same index
+ * with.
+ */
+StrReplacer *GLU_str_replacer_new(const char *const *patterns,
+								  const char *const *replacements,
+								  int npatterns);
+
+void GLU_str_replacer_free(StrReplacer *rep);
+
+/**
+ * \return The length of the result of replacing in \a str, without the NULL
+ * terminator.
+ */
+size_t GLU_str_replacer_len(const StrReplacer *rep, const char *str);
+
+/**
+ * Write the result of replacing in \a str to \a dst, which must fit
+ * #GLU_str_replacer_len bytes and the NULL terminator.
+ * \return The length of the result.
+ */
+size_t GLU_str_replacer_write(const StrReplacer *rep,
+							  const char *__restrict str,
+							  char *__restrict dst);
+
+/**
+ * \return The result of replacing in \a str, free with #MEM_freeN.
+ */
+char *GLU_str_replacer_applyN(const StrReplacer *rep, const char *str);
+
+/**
+ * Pass the result of replacing in \a str to \a write_fn piece by piece,
+ * e.g. to write it to a file without holding it in memory.
+ */
+void GLU_str_replacer_stream(const StrReplacer *rep,
+							 const char *str,
+							 StrReplaceWriteFn write_fn,
+							 void *user_data);
+
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
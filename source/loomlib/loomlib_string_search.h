@@ -0,0 +1,61 @@
+#pragma once
+
+#include "loomlib_compiler.h"
+#include "loomlib_utildefines.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -------------------------------------------------------------------- */
+/** \name String Needle Types
+ *
+ * A needle prepared once for searching many haystacks, the Two-Way critical
+ * factorization (in both directions) and the byte filter are computed up
+ * front instead of on every search as #GLU_strstr does.
+ * \{ */
+
+typedef struct StrNeedle StrNeedle;
+
+typedef enum eStrNeedleFlag {
+	/** Ignore the case of ASCII letters. */
+	STR_NEEDLE_IGNORE_CASE = (1 << 0),
+} eStrNeedleFlag;
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name String Needle API
+ * \{ */
+
+/**
+ * Prepare the first \a needle_len bytes of \a needle for searching, they are
+ * copied and may hold NULL bytes.
+ * \param flag: A combination of #eStrNeedleFlag.
+ */
+StrNeedle *GLU_str_needle_new(const char *needle, size_t needle_len, int flag);
+
+void GLU_str_needle_free(StrNeedle *nd);
+
+/**
+ * \return The first occurrence of the needle in the first \a haystack_len
+ * bytes of \a haystack or NULL, \a haystack when the needle is empty.
+ */
+const char *GLU_str_needle_find(const StrNeedle *nd,
+								const char *haystack,
+								size_t haystack_len);
+
+/**
+ * \return The last occurrence of the needle in the first \a haystack_len
+ * bytes of \a haystack or NULL, the end of the haystack when the needle is
+ * empty.
+ */
+const char *GLU_str_needle_rfind(const StrNeedle *nd,
+								 const char *haystack,
+								 size_t haystack_len);
+
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "loomlib_compiler.h"
+#include "loomlib_utildefines.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -------------------------------------------------------------------- */
+/** \name String Interning Types
+ *
+ * Stores every distinct string once, in an arena owned by the table. An
+ * interned string is never moved or freed before the table itself, so two
+ * interned strings are equal exactly when their pointers are, no #STREQ or
+ * #GLU_ghashutil_strcmp needed.
+ *
+ * Every string also gets a 32-bit ID, assigned in interning order starting
+ * at zero, for compact storage in arrays and files.
+ *
+ * All functions may be called concurrently from multiple threads.
+ * \{ */
+
+typedef struct StrIntern StrIntern;
+
+/** Returned by #GLU_strintern_find_id for strings that are not interned. */
+#define GLU_STRINTERN_ID_NONE ((unsigned int)-1)
+
+typedef struct StrInternMemStats {
+	/** Number of distinct strings. */
+	unsigned int nstrings;
+	/** Bytes of string data, including the NULL terminators. */
+	size_t bytes_strings;
+	/** Bytes allocated for the arenas, including per-string headers and
+	 * unused space at the end of the arena chunks. */
+	size_t bytes_arena;
+	/** Bytes used by the lookup sets and the ID table. */
+	size_t bytes_table;
+} StrInternMemStats;
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name String Interning API
+ * \{ */
+
+/**
+ * Creates a new, empty string table.
+ * \param info: Identifier string for the allocations of the table.
+ */
+StrIntern *GLU_strintern_new(const char *info);
+
+/**
+ * Frees the table and every string interned in it.
+ */
+void GLU_strintern_free(StrIntern *si);
+
+/**
+ * Intern \a str, copying it into the table the first time it is seen.
+ * \return The interned string, valid until the table is freed.
+ */
+const char *GLU_strintern(StrIntern *si, const char *str);
+
+/**
+ * Same as #GLU_strintern, but only the first \a len bytes of \a str are used,
+ * \a str doesn't need to be NULL terminated.
+ */
+const char *GLU_strintern_n(StrIntern *si, const char *str, size_t len);
+
+/**
+ * Lookup \a str without interning it.
+ * \return The interned string or NULL.
+ */
+const char *GLU_strintern_find(const StrIntern *si, const char *str);
+
+/**
+ * Lookup the ID of \a str without interning it.
+ * \return The ID or #GLU_STRINTERN_ID_NONE.
+ */
+unsigned int GLU_strintern_find_id(const StrIntern *si, const char *str);
+
+/**
+ * \param interned: A string returned by #GLU_strintern (not a copy of it).
+ * \return The ID of the string.
+ */
+unsigned int GLU_strintern_id(const char *interned);
+
+/**
+ * \param interned: A string returned by #GLU_strintern (not a copy of it).
+ * \return The length of the string, without looking at its bytes.
+ */
+size_t GLU_strintern_strlen(const char *interned);
+
+/**
+ * \return The string of \a id or NULL when there is no such ID (yet).
+ */
+const char *GLU_strintern_from_id(const StrIntern *si, unsigned int id);
+
+/**
+ * \return The number of distinct strings interned so far.
+ */
+unsigned int GLU_strintern_len(const StrIntern *si);
+
+/**
+ * Measure the memory used by \a si, a snapshot when other threads are
+ * interning.
+ */
+void GLU_strintern_calc_memory(const StrIntern *si, StrInternMemStats *r_stats);
+
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
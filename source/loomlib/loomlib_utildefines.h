@@ -316,6 +316,10 @@
 #define STRINGIFY_APPEND(a, b) "" a #b
 #define STRINGIFY(x) STRINGIFY_APPEND("", x)
 
+/** Allocation name of the current source location, used by the C++
+ * containers. */
+#define AT __FILE__ ":" STRINGIFY(__LINE__)
+
 #if defined(_MSC_VER)
 #	define strcasecmp _stricmp
 #	define strncasecmp _strnicmp
@@ -376,6 +380,21 @@
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/* \name Prefetch Macros
+ * \{ */
+
+#if defined(__GNUC__) || defined(__clang__)
+#	define LOOM_PREFETCH(ptr) __builtin_prefetch(ptr)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#	include <intrin.h>
+#	define LOOM_PREFETCH(ptr) _mm_prefetch((const char *)(ptr), _MM_HINT_T0)
+#else
+#	define LOOM_PREFETCH(ptr) EXPR_NOP(ptr)
+#endif
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /* \name Flag Macros
  * \{ */
@@ -411,6 +411,51 @@ class Vector {
 		this->IncreaseSizeByUnchecked(n);
 	}
 
+	/** Insert n default constructed elements at the end of the vector and
+	 * return them, to be filled in place. If _Tp is trivially constructible,
+	 * the elements are not touched. */
+	MutableSpan<_Tp> AppendN(const size_t n)
+	{
+		this->Reserve(this->Size() + n);
+		_Tp *start = mEnd;
+		default_construct_n(start, n);
+		this->IncreaseSizeByUnchecked(n);
+		return MutableSpan<_Tp>(start, n);
+	}
+
+	/** Insert n uninitialized elements at the end of the vector and return
+	 * them. The caller is responsible for constructing the elements before the
+	 * vector is used again, same as with #IncreaseSizeByUnchecked. For trivial
+	 * types this is the same as #AppendN.
+	 *
+	 * Usage:
+	 *  MutableSpan<float> values = vector.ExtendUninitialized(len);
+	 *  read_floats(file, values.Data(), len); */
+	MutableSpan<_Tp> ExtendUninitialized(const size_t n)
+	{
+		this->Reserve(this->Size() + n);
+		_Tp *start = mEnd;
+		this->IncreaseSizeByUnchecked(n);
+		return MutableSpan<_Tp>(start, n);
+	}
+
+	/** Make sure that n more elements fit without a reallocation and return
+	 * the end of the vector, where they go. Construct any number of them up
+	 * to n and then add them with #IncreaseSizeByUnchecked, e.g. when the
+	 * number written is only known afterwards.
+	 *
+	 * Usage:
+	 *  int *cursor = vector.EnsureSpaceFor(len);
+	 *  const size_t written = parse_ints(text, cursor, len);
+	 *  vector.IncreaseSizeByUnchecked(written); */
+	_Tp *EnsureSpaceFor(const size_t n)
+	{
+		if (UNLIKELY(static_cast<size_t>(mCapacityEnd - mEnd) < n)) {
+			this->ReallocToAtLeast(this->Size() + n);
+		}
+		return mEnd;
+	}
+
 	/** Enlarges the size of the internal buffer that is considered to be
 	 * initialized. This invokes undefined behavior when the new size is larger
 	 * than the capacity. The method can be useful when you want to call
@@ -456,7 +501,7 @@ class Vector {
 	void ExtendEndUnchecked(const _Tp *start, size_t amount)
 	{
 		LOOM_assert(amount >= 0);
-		LOOM_assert(mBegin + amount <= mCapacityEnd);
+		LOOM_assert(mEnd + amount <= mCapacityEnd);
 		uninitialized_copy_n(start, amount, mEnd);
 		mEnd += amount;
 	}
@@ -758,12 +803,12 @@ class Vector {
 
 	std::reverse_iterator<const _Tp *> ReverseBegin() const
 	{
-		return std::reverse_iterator<_Tp *>(this->End());
+		return std::reverse_iterator<const _Tp *>(this->End());
 	}
 
 	std::reverse_iterator<const _Tp *> ReverseEnd() const
 	{
-		return std::reverse_iterator<_Tp *>(this->Begin());
+		return std::reverse_iterator<const _Tp *>(this->Begin());
 	}
 
 	/** Get the current capacity of the vector, i.e. the maximum number of
@@ -773,9 +818,9 @@ class Vector {
 		return static_cast<size_t>(mCapacityEnd - mBegin);
 	}
 
-	IndexRange IndexRange() const
+	loom::IndexRange IndexRange() const
 	{
-		return IndexRange(this->Size());
+		return loom::IndexRange(this->Size());
 	}
 
 	friend bool operator==(const Vector &a, const Vector &b)
@@ -815,6 +860,21 @@ class Vector {
 		const size_t new_capacity = std::max(min_capacity, min_new_capacity);
 		const size_t size = this->Size();
 
+		if constexpr (is_trivially_relocatable_extended_v<_Tp>) {
+			/* The elements don't have to be moved one by one, the allocator can
+			 * grow the buffer in place or move the bytes. */
+			if (!this->IsInline()) {
+				mBegin = static_cast<_Tp *>(mAllocator.reallocate(
+					mBegin,
+					static_cast<size_t>(new_capacity) * sizeof(_Tp),
+					alignof(_Tp),
+					AT));
+				mEnd = mBegin + size;
+				mCapacityEnd = mBegin + new_capacity;
+				return;
+			}
+		}
+
 		_Tp *new_array = static_cast<_Tp *>(mAllocator.allocate(
 			static_cast<size_t>(new_capacity) * sizeof(_Tp), alignof(_Tp), AT));
 		try {
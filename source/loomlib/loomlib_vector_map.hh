@@ -0,0 +1,195 @@
+#pragma once
+
+#include "loomlib_utildefines.h"
+
+#include "loomlib_allocator.hh"
+#include "loomlib_span.hh"
+#include "loomlib_vector.hh"
+#include "loomlib_vector_set.hh"
+
+namespace loom {
+
+/** An insertion ordered map, the ordered counterpart of #GHash.
+ *
+ * Keys are stored in a #VectorSet and values in a #Vector at the same index,
+ * so both can be iterated as dense spans. Removing a key moves the last
+ * key/value pair into its place. */
+template<
+	// Type of the keys stored in the map. It has to be movable.
+	typename _Key,
+	// Type of the values stored in the map. It has to be movable.
+	typename _Value,
+	// Hash functor, see #DefaultHash.
+	typename _Hash = DefaultHash<_Key>,
+	// Equality functor, see #DefaultEquality.
+	typename _IsEqual = DefaultEquality<_Key>,
+	/** The allocator used by this map. Should rarely be changed, except when
+	 * you don't want that MEM_* is used internally. */
+	typename _Allocator = GuardedAllocator>
+class VectorMap {
+   public:
+	using key_type = _Key;
+	using mapped_type = _Value;
+	using size_type = size_t;
+
+   private:
+	VectorSet<_Key, _Hash, _IsEqual, _Allocator> mKeys;
+	Vector<_Value, 0, _Allocator> mValues;
+
+   public:
+	VectorMap(_Allocator allocator = {}) noexcept
+		: mKeys(allocator), mValues(allocator)
+	{
+	}
+
+	// Return how many key/value pairs are currently stored in the map.
+	size_t Size() const
+	{
+		return mKeys.Size();
+	}
+
+	bool IsEmpty() const
+	{
+		return mKeys.IsEmpty();
+	}
+
+	// All keys, densely packed in insertion order.
+	Span<_Key> Keys() const
+	{
+		return mKeys.AsSpan();
+	}
+
+	// All values, in the same order as #Keys.
+	Span<_Value> Values() const
+	{
+		return mValues.AsSpan();
+	}
+
+	MutableSpan<_Value> Values()
+	{
+		return mValues.AsMutableSpan();
+	}
+
+	void Reserve(const size_t n)
+	{
+		mKeys.Reserve(n);
+		mValues.Reserve(n);
+	}
+
+	/** Add a key/value pair, nothing is done when the key exists already.
+	 * \return true when the pair has been added. */
+	bool Add(const _Key &key, const _Value &value)
+	{
+		return this->AddAs(key, value);
+	}
+
+	template<typename ForwardKey, typename ForwardValue>
+	bool AddAs(ForwardKey &&key, ForwardValue &&value)
+	{
+		if (!mKeys.AddAs(std::forward<ForwardKey>(key))) {
+			return false;
+		}
+		mValues.AppendAs(std::forward<ForwardValue>(value));
+		return true;
+	}
+
+	/** Add a key/value pair whose key is known not to be in the map yet. This
+	 * invokes undefined behavior when the key exists already. */
+	void AddNew(const _Key &key, const _Value &value)
+	{
+		mKeys.AddNew(key);
+		mValues.Append(value);
+	}
+
+	/** Add a key/value pair, overwriting the value when the key exists.
+	 * \return true when a new pair has been added. */
+	bool AddOverwrite(const _Key &key, const _Value &value)
+	{
+		const size_t index = mKeys.IndexOfOrAdd(key);
+		if (index == mValues.Size()) {
+			mValues.Append(value);
+			return true;
+		}
+		mValues[index] = value;
+		return false;
+	}
+
+	/** Return a pointer to the value of \a key, or nullptr when the key is not
+	 * in the map. */
+	const _Value *LookupPtr(const _Key &key) const
+	{
+		const size_t index = mKeys.IndexOfTry(key);
+		return (index != static_cast<size_t>(-1)) ? &mValues[index] : nullptr;
+	}
+
+	_Value *LookupPtr(const _Key &key)
+	{
+		const size_t index = mKeys.IndexOfTry(key);
+		return (index != static_cast<size_t>(-1)) ? &mValues[index] : nullptr;
+	}
+
+	/** Return the value of \a key. This invokes undefined behavior when the key
+	 * is not in the map. */
+	const _Value &Lookup(const _Key &key) const
+	{
+		return mValues[mKeys.IndexOf(key)];
+	}
+
+	_Value &Lookup(const _Key &key)
+	{
+		return mValues[mKeys.IndexOf(key)];
+	}
+
+	// Return a copy of the value of \a key, or \a default_value.
+	_Value LookupDefault(const _Key &key, const _Value &default_value) const
+	{
+		const _Value *value = this->LookupPtr(key);
+		return value ? *value : default_value;
+	}
+
+	/** Return the value of \a key, a default constructed value is added first
+	 * when the key is not in the map. */
+	_Value &LookupOrAddDefault(const _Key &key)
+	{
+		const size_t index = mKeys.IndexOfOrAdd(key);
+		if (index == mValues.Size()) {
+			mValues.AppendAs();
+		}
+		return mValues[index];
+	}
+
+	bool Contains(const _Key &key) const
+	{
+		return mKeys.Contains(key);
+	}
+
+	/** Return the index of \a key in #Keys and #Values, or -1 when it is not in
+	 * the map. */
+	size_t IndexOfTry(const _Key &key) const
+	{
+		return mKeys.IndexOfTry(key);
+	}
+
+	/** Remove the key/value pair, the last pair is moved into its place.
+	 * \return true when the key was in the map. */
+	bool Remove(const _Key &key)
+	{
+		const size_t index = mKeys.IndexOfTry(key);
+		if (index == static_cast<size_t>(-1)) {
+			return false;
+		}
+		mKeys.RemoveIndex(index);
+		mValues.RemoveAndReorder(index);
+		return true;
+	}
+
+	/** Afterwards the map is empty, but will still have memory to be refilled
+	 * again. */
+	void Clear()
+	{
+		mKeys.Clear();
+		mValues.Clear();
+	}
+};
+
+}  // namespace loom
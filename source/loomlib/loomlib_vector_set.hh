@@ -0,0 +1,510 @@
+#pragma once
+
+#include "loomlib_utildefines.h"
+
+#include "loomlib_allocator.hh"
+#include "loomlib_hash.hh"
+#include "loomlib_span.hh"
+#include "loomlib_vector.hh"
+
+#include <algorithm>
+#include <stdint.h>
+
+namespace loom {
+
+/** A set that keeps its keys in insertion order in one contiguous array.
+ *
+ * The keys live in a #Vector, iterating is a linear scan over #AsSpan. The
+ * lookup table is a separate open addressing (linear probing) array of 32-bit
+ * slots storing indices into the key array, the hash of every key is cached
+ * next to it so the table can be rebuilt and probed without hashing again.
+ *
+ * Removing a key moves the last key into its place, so the order is only
+ * preserved as long as no key is removed. */
+template<
+	// Type of the keys stored in the set. It has to be movable.
+	typename _Key,
+	// Hash functor, see #DefaultHash.
+	typename _Hash = DefaultHash<_Key>,
+	// Equality functor, see #DefaultEquality.
+	typename _IsEqual = DefaultEquality<_Key>,
+	/** The allocator used by this set. Should rarely be changed, except when
+	 * you don't want that MEM_* is used internally. */
+	typename _Allocator = GuardedAllocator>
+class VectorSet {
+   public:
+	using value_type = _Key;
+	using pointer = _Key *;
+	using const_pointer = const _Key *;
+	using reference = _Key &;
+	using const_reference = const _Key &;
+	using iterator = const _Key *;
+	using size_type = size_t;
+
+   private:
+	static constexpr uint32_t EmptySlot = UINT32_MAX;
+	// Smallest slot array, the table is only allocated with the first key.
+	static constexpr size_t MinSlots = 16;
+	// How many keys ahead the lookups of the set operations are prefetched.
+	static constexpr size_t PrefetchDistance = 8;
+
+	using IndexVector = Vector<size_t, 0, _Allocator>;
+
+	Vector<_Key, 0, _Allocator> mKeys;
+	// Cached hash of every key in #mKeys, at the same index.
+	Vector<unsigned int, 0, _Allocator> mHashes;
+	// Power of two sized, at most half full.
+	Vector<uint32_t, 0, _Allocator> mSlots;
+
+	LOOM_NO_UNIQUE_ADDRESS _Hash mHash;
+	LOOM_NO_UNIQUE_ADDRESS _IsEqual mIsEqual;
+
+   public:
+	VectorSet(_Allocator allocator = {}) noexcept
+		: mKeys(allocator), mHashes(allocator), mSlots(allocator)
+	{
+	}
+
+	// Create a set from the keys of a span, duplicates are skipped.
+	VectorSet(Span<_Key> keys, _Allocator allocator = {}) : VectorSet(allocator)
+	{
+		this->Reserve(keys.Size());
+		for (size_t i = 0; i < keys.Size(); i++) {
+			this->Add(keys[i]);
+		}
+	}
+
+	VectorSet(const std::initializer_list<_Key> &keys)
+		: VectorSet(Span<_Key>(keys))
+	{
+	}
+
+	// Get the key at the given index, in insertion order.
+	const _Key &operator[](const size_t index) const
+	{
+		LOOM_assert(index < this->Size());
+		return mKeys[index];
+	}
+
+	operator Span<_Key>() const
+	{
+		return mKeys.AsSpan();
+	}
+
+	// All keys, densely packed in insertion order.
+	Span<_Key> AsSpan() const
+	{
+		return mKeys.AsSpan();
+	}
+
+	const _Key *Data() const
+	{
+		return mKeys.Data();
+	}
+
+	const _Key *Begin() const
+	{
+		return mKeys.Begin();
+	}
+
+	const _Key *End() const
+	{
+		return mKeys.End();
+	}
+
+	// Return how many keys are currently stored in the set.
+	size_t Size() const
+	{
+		return mKeys.Size();
+	}
+
+	bool IsEmpty() const
+	{
+		return mKeys.IsEmpty();
+	}
+
+	/** Make sure that \a n keys can be added without growing the key array or
+	 * rebuilding the lookup table. */
+	void Reserve(const size_t n)
+	{
+		mKeys.Reserve(n);
+		mHashes.Reserve(n);
+		if (n * 2 > mSlots.Size()) {
+			this->Rehash(n);
+		}
+	}
+
+	/** Add the key to the set, nothing is done when it exists already.
+	 * \return true when the key has been added. */
+	bool Add(const _Key &key)
+	{
+		return this->AddAs(key);
+	}
+
+	bool Add(_Key &&key)
+	{
+		return this->AddAs(std::move(key));
+	}
+
+	template<typename ForwardKey> bool AddAs(ForwardKey &&key)
+	{
+		const unsigned int hash = mHash(key);
+		if (this->FindSlot(key, hash) != nullptr) {
+			return false;
+		}
+		this->AppendNew(std::forward<ForwardKey>(key), hash);
+		return true;
+	}
+
+	/** Add a key that is known not to be in the set yet. This invokes
+	 * undefined behavior when the key exists already. */
+	void AddNew(const _Key &key)
+	{
+		LOOM_assert(!this->Contains(key));
+		this->AppendNew(key, mHash(key));
+	}
+
+	void AddNew(_Key &&key)
+	{
+		LOOM_assert(!this->Contains(key));
+		const unsigned int hash = mHash(key);
+		this->AppendNew(std::move(key), hash);
+	}
+
+	/** Return the index of the key, adding it at the end when it doesn't exist
+	 * yet. */
+	size_t IndexOfOrAdd(const _Key &key)
+	{
+		const unsigned int hash = mHash(key);
+		const uint32_t *slot = this->FindSlot(key, hash);
+		if (slot != nullptr) {
+			return *slot;
+		}
+		this->AppendNew(key, hash);
+		return mKeys.Size() - 1;
+	}
+
+	// Return true when the key is in the set.
+	bool Contains(const _Key &key) const
+	{
+		return this->FindSlot(key, mHash(key)) != nullptr;
+	}
+
+	/** Return the index of the key in #AsSpan, or -1 when it is not in the
+	 * set. */
+	size_t IndexOfTry(const _Key &key) const
+	{
+		const uint32_t *slot = this->FindSlot(key, mHash(key));
+		return slot ? static_cast<size_t>(*slot) : static_cast<size_t>(-1);
+	}
+
+	/** Return the index of the key in #AsSpan. This invokes undefined behavior
+	 * when the key is not in the set. */
+	size_t IndexOf(const _Key &key) const
+	{
+		const size_t index = this->IndexOfTry(key);
+		LOOM_assert(index != static_cast<size_t>(-1));
+		return index;
+	}
+
+	/** Remove the key from the set, the last key is moved into its place.
+	 * \return true when the key was in the set. */
+	bool Remove(const _Key &key)
+	{
+		const size_t index = this->IndexOfTry(key);
+		if (index == static_cast<size_t>(-1)) {
+			return false;
+		}
+		this->RemoveIndex(index);
+		return true;
+	}
+
+	/** Remove the key at the given index, the last key is moved into its
+	 * place. This takes O(1) time. */
+	void RemoveIndex(const size_t index)
+	{
+		LOOM_assert(index < this->Size());
+		const size_t last_index = this->Size() - 1;
+
+		this->EraseSlot(this->SlotOfIndex(index));
+		if (index != last_index) {
+			*this->SlotOfIndex(last_index) = static_cast<uint32_t>(index);
+		}
+		mKeys.RemoveAndReorder(index);
+		mHashes.RemoveAndReorder(index);
+	}
+
+	/** Remove the last key from the set and return it. This invokes undefined
+	 * behavior when the set is empty. */
+	_Key PopLast()
+	{
+		LOOM_assert(!this->IsEmpty());
+		_Key key = std::move(mKeys.Last());
+		this->RemoveIndex(this->Size() - 1);
+		return key;
+	}
+
+	/** Afterwards the set has 0 keys, but will still have memory to be
+	 * refilled again. */
+	void Clear()
+	{
+		mKeys.Clear();
+		mHashes.Clear();
+		std::fill(mSlots.Begin(), mSlots.End(), EmptySlot);
+	}
+
+	/** Add the keys of \a other that aren't in the set yet, at the end in the
+	 * order of \a other. The cached hashes of \a other are reused, no key is
+	 * hashed. */
+	void UnionWith(const VectorSet &other)
+	{
+		this->Reserve(this->Size() + other.Size());
+		for (size_t i = 0; i < other.Size(); i++) {
+			if (i + PrefetchDistance < other.Size()) {
+				this->PrefetchSlot(other.mHashes[i + PrefetchDistance]);
+			}
+			if (this->FindSlot(other.mKeys[i], other.mHashes[i]) == nullptr) {
+				this->AppendNew(other.mKeys[i], other.mHashes[i]);
+			}
+		}
+	}
+
+	/** Remove the keys that aren't in \a other, the order of the remaining
+	 * keys is kept. Only the keys of the smaller set are looked up. */
+	void IntersectWith(const VectorSet &other)
+	{
+		if (other.Size() < this->Size()) {
+			const IndexVector indices = this->IndicesOf(other);
+			size_t next = 0;
+			this->RetainIf([&](const size_t index) {
+				if (next < indices.Size() && indices[next] == index) {
+					next++;
+					return true;
+				}
+				return false;
+			});
+			return;
+		}
+		this->RetainIf([&](const size_t index) {
+			if (index + PrefetchDistance < this->Size()) {
+				other.PrefetchSlot(mHashes[index + PrefetchDistance]);
+			}
+			return other.FindSlot(mKeys[index], mHashes[index]) != nullptr;
+		});
+	}
+
+	/** Remove the keys that are in \a other, the order of the remaining keys
+	 * is kept. Only the keys of the smaller set are looked up. */
+	void Subtract(const VectorSet &other)
+	{
+		if (other.Size() < this->Size()) {
+			const IndexVector indices = this->IndicesOf(other);
+			if (indices.IsEmpty()) {
+				return;
+			}
+			size_t next = 0;
+			this->RetainIf([&](const size_t index) {
+				if (next < indices.Size() && indices[next] == index) {
+					next++;
+					return false;
+				}
+				return true;
+			});
+			return;
+		}
+		this->RetainIf([&](const size_t index) {
+			if (index + PrefetchDistance < this->Size()) {
+				other.PrefetchSlot(mHashes[index + PrefetchDistance]);
+			}
+			return other.FindSlot(mKeys[index], mHashes[index]) == nullptr;
+		});
+	}
+
+	// Return the keys of this set followed by the new keys of \a other.
+	VectorSet Union(const VectorSet &other) const
+	{
+		VectorSet result = *this;
+		result.UnionWith(other);
+		return result;
+	}
+
+	// Return the keys that are in both sets, in the order of this set.
+	VectorSet Intersection(const VectorSet &other) const
+	{
+		VectorSet result;
+		if (other.Size() < this->Size()) {
+			const IndexVector indices = this->IndicesOf(other);
+			result.Reserve(indices.Size());
+			for (size_t i = 0; i < indices.Size(); i++) {
+				result.AppendNew(mKeys[indices[i]], mHashes[indices[i]]);
+			}
+			return result;
+		}
+		result.Reserve(this->Size());
+		for (size_t i = 0; i < this->Size(); i++) {
+			if (i + PrefetchDistance < this->Size()) {
+				other.PrefetchSlot(mHashes[i + PrefetchDistance]);
+			}
+			if (other.FindSlot(mKeys[i], mHashes[i]) != nullptr) {
+				result.AppendNew(mKeys[i], mHashes[i]);
+			}
+		}
+		return result;
+	}
+
+	// Return the keys of this set that aren't in \a other, in order.
+	VectorSet Difference(const VectorSet &other) const
+	{
+		VectorSet result = *this;
+		result.Subtract(other);
+		return result;
+	}
+
+   private:
+	void PrefetchSlot(const unsigned int hash) const
+	{
+		if (!mSlots.IsEmpty()) {
+			LOOM_PREFETCH(&mSlots[hash & this->SlotMask()]);
+		}
+	}
+
+	/** Return the sorted indices of the keys of \a keys that are in this
+	 * set. */
+	IndexVector IndicesOf(const VectorSet &keys) const
+	{
+		IndexVector indices;
+		for (size_t i = 0; i < keys.Size(); i++) {
+			if (i + PrefetchDistance < keys.Size()) {
+				this->PrefetchSlot(keys.mHashes[i + PrefetchDistance]);
+			}
+			const uint32_t *slot = this->FindSlot(keys.mKeys[i],
+												  keys.mHashes[i]);
+			if (slot != nullptr) {
+				indices.Append(*slot);
+			}
+		}
+		std::sort(indices.Begin(), indices.End());
+		return indices;
+	}
+
+	/** Keep the keys for whose index \a keep returns true, called in
+	 * increasing index order. The lookup table is rebuilt once. */
+	template<typename Predicate> void RetainIf(const Predicate &keep)
+	{
+		const size_t old_size = this->Size();
+		size_t new_size = 0;
+		for (size_t i = 0; i < old_size; i++) {
+			if (!keep(i)) {
+				continue;
+			}
+			if (new_size != i) {
+				mKeys[new_size] = std::move(mKeys[i]);
+				mHashes[new_size] = mHashes[i];
+			}
+			new_size++;
+		}
+		if (new_size == old_size) {
+			return;
+		}
+		while (mKeys.Size() > new_size) {
+			mKeys.RemoveLast();
+			mHashes.RemoveLast();
+		}
+		this->Rehash(new_size);
+	}
+
+	size_t SlotMask() const
+	{
+		return mSlots.Size() - 1;
+	}
+
+	/** Find the slot holding \a key, probing stops at the first empty slot.
+	 * \return nullptr when the key is not in the set. */
+	template<typename ForwardKey>
+	const uint32_t *FindSlot(const ForwardKey &key,
+							 const unsigned int hash) const
+	{
+		if (mSlots.IsEmpty()) {
+			return nullptr;
+		}
+		const size_t mask = this->SlotMask();
+		for (size_t i = hash & mask;; i = (i + 1) & mask) {
+			const uint32_t index = mSlots[i];
+			if (index == EmptySlot) {
+				return nullptr;
+			}
+			if (mHashes[index] == hash && mIsEqual(key, mKeys[index])) {
+				return &mSlots[i];
+			}
+		}
+	}
+
+	// Find the slot referencing the key at \a index, it has to exist.
+	uint32_t *SlotOfIndex(const size_t index)
+	{
+		const size_t mask = this->SlotMask();
+		for (size_t i = mHashes[index] & mask;; i = (i + 1) & mask) {
+			if (mSlots[i] == index) {
+				return &mSlots[i];
+			}
+			LOOM_assert(mSlots[i] != EmptySlot);
+		}
+	}
+
+	void InsertSlot(const unsigned int hash, const uint32_t index)
+	{
+		const size_t mask = this->SlotMask();
+		size_t i = hash & mask;
+		while (mSlots[i] != EmptySlot) {
+			i = (i + 1) & mask;
+		}
+		mSlots[i] = index;
+	}
+
+	/** Empty a slot, later slots of the same probe run are shifted back so
+	 * lookups never need tombstones. */
+	void EraseSlot(uint32_t *slot)
+	{
+		const size_t mask = this->SlotMask();
+		size_t hole = static_cast<size_t>(slot - mSlots.Data());
+		for (size_t i = (hole + 1) & mask; mSlots[i] != EmptySlot;
+			 i = (i + 1) & mask) {
+			const size_t home = mHashes[mSlots[i]] & mask;
+			/* Move the key back unless its home lies cyclically in (hole, i]. */
+			if (((i - home) & mask) >= ((i - hole) & mask)) {
+				mSlots[hole] = mSlots[i];
+				hole = i;
+			}
+		}
+		mSlots[hole] = EmptySlot;
+	}
+
+	template<typename ForwardKey>
+	void AppendNew(ForwardKey &&key, const unsigned int hash)
+	{
+		const size_t index = mKeys.Size();
+		LOOM_assert(index < EmptySlot);
+		if ((index + 1) * 2 > mSlots.Size()) {
+			this->Rehash(index + 1);
+		}
+		mKeys.AppendAs(std::forward<ForwardKey>(key));
+		mHashes.Append(hash);
+		this->InsertSlot(hash, static_cast<uint32_t>(index));
+	}
+
+	// Rebuild the lookup table for at least \a min_size keys.
+	void Rehash(const size_t min_size)
+	{
+		size_t nslots = MinSlots;
+		while (nslots < min_size * 2) {
+			nslots <<= 1;
+		}
+		mSlots.Clear();
+		mSlots.Resize(nslots, EmptySlot);
+		for (size_t i = 0; i < mHashes.Size(); i++) {
+			this->InsertSlot(mHashes[i], static_cast<uint32_t>(i));
+		}
+	}
+};
+
+}  // namespace loom
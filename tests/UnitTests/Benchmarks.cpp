@@ -0,0 +1,668 @@
+/* Throughput reports, not correctness tests. They take a while and only mean
+ * something in an optimized build, so they are left out unless the test
+ * project is built with `WITH_BENCHMARKS` defined, e.g.
+ * `msbuild tests/UnitTests/UnitTests.vcxproj /p:Configuration=Release
+ * /p:WithBenchmarks=true`. */
+
+#ifdef WITH_BENCHMARKS
+
+#	include "CppUnitTest.h"
+
+#	include "loomlib/loomlib_filter.h"
+#	include "loomlib/loomlib_ghash.h"
+#	include "loomlib/loomlib_hash_mm2a.h"
+#	include "loomlib/loomlib_hash_xxh3.h"
+#	include "loomlib/loomlib_listbase.h"
+#	include "loomlib/loomlib_mempool.h"
+#	include "loomlib/loomlib_string.h"
+#	include "loomlib/loomlib_string_search.h"
+#	include "loomlib/loomlib_vector.hh"
+
+#	include "utfconv/utfconv.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#	include <algorithm>
+#	include <chrono>
+#	include <cstdarg>
+#	include <cstdint>
+#	include <cstdio>
+#	include <cstdlib>
+#	include <cstring>
+#	include <string>
+#	include <thread>
+#	include <vector>
+
+/** \return The seconds \a fn takes to run. */
+template<typename Fn> static double bench_time(Fn &&fn)
+{
+	const auto start = std::chrono::steady_clock::now();
+	fn();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+										 start)
+		.count();
+}
+
+/** Print a line of results to the test output. */
+static void bench_log(const char *format, ...)
+{
+	char message[256];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(message, sizeof(message), format, args);
+	va_end(args);
+	Logger::WriteMessage(message);
+}
+
+/* clang-format off */
+TEST_CLASS(LoomLibBenchmark)
+{
+public:
+/* clang-format on */
+
+TEST_METHOD(HashXXH3_throughput)
+{
+	/* The 64 bit hashes against #GLU_hash_mm2 for input sizes from 4 B to
+	 * 1 MB. */
+	std::vector<unsigned char> data(1 << 20);
+	for (size_t i = 0; i < data.size(); i++) {
+		data[i] = (unsigned char)(i * 2654435761u >> 24);
+	}
+
+	for (size_t len = 4; len <= data.size(); len *= 4) {
+		const size_t iterations = std::max<size_t>((16 << 20) / len, 1);
+		uint64_t sink = 0;
+
+		const double t_xxh3 = bench_time([&]() {
+			for (size_t i = 0; i < iterations; i++) {
+				sink += GLU_hash_xxh3_64(data.data(), len, i);
+			}
+		});
+		const double t_mm2 = bench_time([&]() {
+			for (size_t i = 0; i < iterations; i++) {
+				sink += GLU_hash_mm2(data.data(), len, (uint32_t)i);
+			}
+		});
+
+		const double bytes = (double)len * (double)iterations;
+		bench_log("%8zu B: xxh3 %8.1f MB/s, mm2 %8.1f MB/s (%llx)\n",
+				  len,
+				  bytes / t_xxh3 / 1e6,
+				  bytes / t_mm2 / 1e6,
+				  (unsigned long long)(sink & 0xf));
+	}
+}
+
+TEST_METHOD(StringSimd_throughput)
+{
+	/* #GLU_strlen and #GLU_memchr for every supported instruction set and
+	 * string lengths from 1 B to 1 MB, from an aligned and an unaligned
+	 * start. */
+	const eStrSimdLevel level_max = GLU_str_simd_level_get();
+	const char *names[] = {"scalar", "sse2", "avx2", "avx512"};
+
+	std::vector<char> buf((1 << 20) + 128, 'x');
+	char *base = (char *)(((uintptr_t)buf.data() + 63) & ~(uintptr_t)63);
+
+	for (int level = STR_SIMD_SCALAR; level <= STR_SIMD_AVX512; level++) {
+		if (GLU_str_simd_level_set((eStrSimdLevel)level) != level) {
+			continue;
+		}
+		for (size_t len = 1; len <= (1 << 20); len *= 4) {
+			for (size_t misalign = 0; misalign < 2; misalign++) {
+				char *str = base + misalign * 7;
+				str[len] = '\0';
+
+				const size_t iterations = std::max<size_t>((16 << 20) / len, 16);
+				size_t sink = 0;
+
+				const double t_strlen = bench_time([&]() {
+					for (size_t i = 0; i < iterations; i++) {
+						sink += GLU_strlen(str);
+						str[0] = 'x';
+					}
+				});
+				const double t_memchr = bench_time([&]() {
+					for (size_t i = 0; i < iterations; i++) {
+						sink += (size_t)GLU_memchr(str, 'y', len + 1);
+						str[0] = 'x';
+					}
+				});
+
+				const double bytes = (double)(len + 1) * (double)iterations;
+				bench_log(
+					"%6s %8zu B %s: strlen %8.1f MB/s, memchr %8.1f MB/s "
+					"(%zx)\n",
+					names[level],
+					len,
+					misalign ? "unaligned" : "aligned  ",
+					bytes / t_strlen / 1e6,
+					bytes / t_memchr / 1e6,
+					sink & 0xf);
+				str[len] = 'x';
+			}
+		}
+	}
+
+	GLU_str_simd_level_set(level_max);
+}
+
+TEST_METHOD(UtfConv_throughput)
+{
+	/* Validation and conversion of 1 MB of text in different scripts, with
+	 * the code unit at a time #conv_utf_8_to_16 (plus its counting pass) for
+	 * reference. */
+	const struct {
+		const char *name;
+		const char *text;
+	} corpora[] = {
+		{"ascii", "The quick brown fox jumps over the lazy dog. "},
+		{"latin",
+		 "Le c\xC5\x93ur d\xC3\xA9\xC3\xA7u mais l'\xC3\xA2me "
+		 "plut\xC3\xB4t na\xC3\xAFve. "},
+		{"cjk", "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E\xE3\x81\xAE\xE6\x96\x87"
+				"\xE7\xAB\xA0\xE3\x81\xA7\xE3\x81\x99\xE3\x80\x82"},
+		{"emoji", "\xF0\x9F\x98\x80\xF0\x9F\x8E\x89 ok \xF0\x9F\x9A\x80"
+				  "\xF0\x9F\x8C\x8D"},
+	};
+
+	for (const auto &corpus : corpora) {
+		std::string str;
+		while (str.size() < (1 << 20)) {
+			str += corpus.text;
+		}
+		std::vector<wchar_t> str16(UTF_16_LEN_MAX_FROM_8(str.size()) + 1);
+		std::vector<char> str8(UTF_8_LEN_MAX_FROM_16(str.size()) + 1);
+		const int iterations = 20;
+		size_t sink = 0, len16 = 0;
+
+		const double t_validate = bench_time([&]() {
+			for (int i = 0; i < iterations; i++) {
+				sink += is_valid_utf_8(str.data(), str.size());
+			}
+		});
+		const double t_8_to_16 = bench_time([&]() {
+			for (int i = 0; i < iterations; i++) {
+				len16 = transcode_utf_8_to_16(
+					str.data(), str.size(), str16.data(), NULL);
+			}
+		});
+		const double t_16_to_8 = bench_time([&]() {
+			for (int i = 0; i < iterations; i++) {
+				sink += transcode_utf_16_to_8(
+					str16.data(), len16, str8.data(), NULL);
+			}
+		});
+		const double t_old = bench_time([&]() {
+			for (int i = 0; i < iterations; i++) {
+				const size_t size16 = count_utf_16_from_8(str.c_str());
+				sink += conv_utf_8_to_16(str.c_str(), str16.data(), size16);
+			}
+		});
+
+		const double bytes = (double)str.size() * iterations;
+		bench_log("%6s: validate %8.1f MB/s, 8->16 %8.1f MB/s, "
+				  "16->8 %8.1f MB/s, old 8->16 %8.1f MB/s (%zx)\n",
+				  corpus.name,
+				  bytes / t_validate / 1e6,
+				  bytes / t_8_to_16 / 1e6,
+				  bytes / t_16_to_8 / 1e6,
+				  bytes / t_old / 1e6,
+				  sink & 0xf);
+	}
+}
+
+TEST_METHOD(StringSearch_throughput)
+{
+	/* #GLU_strstr, a reused #StrNeedle, the C library and #GLU_strrstr on
+	 * 1 MB of text and of repetitive input. */
+	const size_t len = 1 << 20;
+	std::string text, repetitive(len, 'a');
+	uint32_t seed = 39;
+	while (text.size() < len) {
+		seed = seed * 1664525u + 1013904223u;
+		const char *words[] = {"the ", "quick ", "brown ", "fox ", "jumps ",
+							   "over ", "lazy ", "dog ", "needle ", "hay "};
+		text += words[(seed >> 8) % 10];
+	}
+	struct {
+		const char *name;
+		const std::string *hay;
+		std::string needle;
+	} cases[] = {
+		{"text", &text, "needle in a haystack"},
+		{"short", &text, "fox cat"},
+		{"repetitive", &repetitive, std::string(64, 'a') + "b"},
+		/* Every position passes the byte filter. */
+		{"adversarial", &repetitive, std::string(500, 'a') + "ba"},
+	};
+
+	for (const auto &c : cases) {
+		const size_t iterations = 64;
+		const char *hay = c.hay->c_str();
+		size_t sink = 0;
+
+		/* The start varies so the calls can't be hoisted out of the loop. */
+		auto rate = [&](auto &&fn) {
+			return (double)len * iterations /
+				   bench_time([&]() {
+					   for (size_t i = 0; i < iterations; i++) {
+						   sink += (size_t)fn(i & 7);
+					   }
+				   }) /
+				   1e6;
+		};
+
+		StrNeedle *nd = GLU_str_needle_new(c.needle.data(), c.needle.size(), 0);
+		const double r_glu = rate([&](size_t i) {
+			return GLU_strstr(hay + i, c.needle.c_str());
+		});
+		const double r_needle = rate([&](size_t i) {
+			return GLU_str_needle_find(nd, hay + i, len - i);
+		});
+		const double r_libc = rate([&](size_t i) {
+			return strstr(hay + i, c.needle.c_str());
+		});
+		const double r_rstr = rate([&](size_t i) {
+			return GLU_strrstr(hay + i, c.needle.c_str());
+		});
+		GLU_str_needle_free(nd);
+
+		bench_log("%11s: strstr %8.1f MB/s, needle %8.1f MB/s, libc %8.1f MB/s, "
+				  "strrstr %8.1f MB/s (%zx)\n",
+				  c.name,
+				  r_glu,
+				  r_needle,
+				  r_libc,
+				  r_rstr,
+				  sink & 0xf);
+	}
+}
+
+TEST_METHOD(NumberChars_throughput)
+{
+	/* The number conversions against the C library on random doubles and
+	 * integers. */
+	const int count = 1 << 18;
+	std::vector<double> doubles(count);
+	std::vector<int64_t> ints(count);
+	uint64_t seed = 41;
+	for (int i = 0; i < count; i++) {
+		seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+		doubles[i] = (double)(int64_t)seed / (double)(1ull << (seed & 63));
+		ints[i] = (int64_t)seed >> (seed & 63);
+	}
+	std::vector<std::string> strs(count);
+	char buf[GLU_DOUBLE_CHARS_SIZE];
+	for (int i = 0; i < count; i++) {
+		strs[i].assign(buf, GLU_double_to_chars(buf, sizeof(buf), doubles[i]));
+	}
+
+	size_t sink = 0;
+	auto rate = [&](auto &&fn) {
+		return (double)count / bench_time([&]() {
+			for (int i = 0; i < count; i++) {
+				sink += (size_t)fn(i);
+			}
+		}) / 1e6;
+	};
+
+	const double r_dtoc = rate([&](int i) {
+		return GLU_double_to_chars(buf, sizeof(buf), doubles[i]);
+	});
+	const double r_dprintf = rate([&](int i) {
+		return snprintf(buf, sizeof(buf), "%.17g", doubles[i]);
+	});
+	const double r_ctod = rate([&](int i) {
+		double value;
+		GLU_chars_to_double(strs[i].data(), strs[i].size(), &value);
+		return value > 0.0;
+	});
+	const double r_strtod = rate(
+		[&](int i) { return strtod(strs[i].c_str(), NULL) > 0.0; });
+	const double r_itoc = rate(
+		[&](int i) { return GLU_int_to_chars(buf, sizeof(buf), ints[i]); });
+	const double r_iprintf = rate([&](int i) {
+		return snprintf(buf, sizeof(buf), "%lld", (long long)ints[i]);
+	});
+
+	bench_log("double_to_chars %6.1f M/s, snprintf %6.1f M/s\n"
+			  "chars_to_double %6.1f M/s, strtod   %6.1f M/s\n"
+			  "int_to_chars    %6.1f M/s, snprintf %6.1f M/s (%zx)\n",
+			  r_dtoc,
+			  r_dprintf,
+			  r_ctod,
+			  r_strtod,
+			  r_itoc,
+			  r_iprintf,
+			  sink & 0xf);
+}
+
+TEST_METHOD(GHash_freeze_throughput)
+{
+	/* Building a frozen table from a GHash, and what it saves on lookups and
+	 * memory. */
+	for (int len = 1000; len <= 1000000; len *= 10) {
+		GHash *ghash = GLU_ghash_int_new_ex(__func__, len);
+		const double t_insert = bench_time([&]() {
+			for (int i = 0; i < len; i++) {
+				GLU_ghash_insert(
+					ghash, POINTER_FROM_INT(i * 7), POINTER_FROM_INT(i));
+			}
+		});
+
+		GHashFrozen *frozen = NULL;
+		const double t_freeze = bench_time(
+			[&]() { frozen = GLU_ghash_freeze(ghash); });
+		Assert::IsNotNull(frozen);
+
+		const int lookups = 4000000;
+		int sink = 0;
+		const double t_lookup = bench_time([&]() {
+			for (int i = 0; i < lookups; i++) {
+				sink += POINTER_AS_INT(
+					GLU_ghash_lookup(ghash, POINTER_FROM_INT((i % len) * 7)));
+			}
+		});
+		const double t_lookup_frozen = bench_time([&]() {
+			for (int i = 0; i < lookups; i++) {
+				sink += POINTER_AS_INT(GLU_ghash_frozen_lookup(
+					frozen, POINTER_FROM_INT((i % len) * 7)));
+			}
+		});
+
+		bench_log("%7d keys: insert %8.3f ms, freeze %8.3f ms, lookup %5.1f "
+				  "/ %5.1f ns, memory %zu / %zu B (%x)\n",
+				  len,
+				  t_insert * 1e3,
+				  t_freeze * 1e3,
+				  t_lookup * 1e9 / lookups,
+				  t_lookup_frozen * 1e9 / lookups,
+				  GLU_ghash_calc_memory(ghash),
+				  GLU_ghash_frozen_calc_memory(frozen),
+				  sink & 0xf);
+
+		GLU_ghash_frozen_free(frozen, NULL, NULL);
+		GLU_ghash_free(ghash, NULL, NULL);
+	}
+}
+
+TEST_METHOD(Filter_throughput)
+{
+	/* The lookups of keys that are mostly missing against a plain #GSet. */
+	const unsigned int count = 1 << 20;
+	GSet *gset = GLU_gset_int_new_ex(__func__, count);
+	GBloom *bloom = GLU_bloom_new(GLU_ghashutil_inthash_p, count, 0.01);
+	GCuckoo *cuckoo = GLU_cuckoo_new(GLU_ghashutil_inthash_p, count);
+	for (unsigned int i = 0; i < count; i++) {
+		GLU_gset_add(gset, POINTER_FROM_UINT(i * 8));
+		GLU_bloom_add(bloom, POINTER_FROM_UINT(i * 8));
+		GLU_cuckoo_add(cuckoo, POINTER_FROM_UINT(i * 8));
+	}
+
+	size_t sink = 0;
+	auto rate = [&](auto &&fn) {
+		return (double)count / bench_time([&]() {
+			for (unsigned int i = 0; i < count; i++) {
+				/* One key in eight is in the set. */
+				sink += fn(POINTER_FROM_UINT(i * 9));
+			}
+		}) / 1e6;
+	};
+
+	const double r_gset = rate([&](void *key) {
+		return GLU_gset_haskey(gset, key);
+	});
+	const double r_bloom = rate([&](void *key) {
+		return GLU_bloom_may_contain(bloom, key) && GLU_gset_haskey(gset, key);
+	});
+	const double r_cuckoo = rate([&](void *key) {
+		return GLU_cuckoo_may_contain(cuckoo, key) && GLU_gset_haskey(gset, key);
+	});
+
+	bench_log("gset %6.1f M/s, bloom + gset %6.1f M/s, cuckoo + gset %6.1f M/s "
+			  "(bloom %zu KiB, %zx)\n",
+			  r_gset,
+			  r_bloom,
+			  r_cuckoo,
+			  GLU_bloom_size(bloom) / 1024,
+			  sink & 0xf);
+
+	GLU_cuckoo_free(cuckoo);
+	GLU_bloom_free(bloom);
+	GLU_gset_free(gset, NULL);
+}
+
+TEST_METHOD(ListBase_sort_throughput)
+{
+	/* The merge sort against copying the links to an array, qsort and
+	 * relinking, up to lists far larger than the caches. */
+	struct Item {
+		Item *prev, *next;
+		unsigned int key;
+	};
+	auto cmp = [](const void *a, const void *b) {
+		const unsigned int ka = static_cast<const Item *>(a)->key;
+		const unsigned int kb = static_cast<const Item *>(b)->key;
+		return (ka > kb) - (ka < kb);
+	};
+	auto cmp_array = [](const void *a, const void *b) {
+		const unsigned int ka = (*static_cast<Item *const *>(a))->key;
+		const unsigned int kb = (*static_cast<Item *const *>(b))->key;
+		return (ka > kb) - (ka < kb);
+	};
+
+	for (int len = 1000; len <= 10000000; len *= 10) {
+		std::vector<Item> items(len);
+		uint32_t seed = 44;
+		auto shuffle = [&](ListBase *lb) {
+			GLU_listbase_clear(lb);
+			for (int i = 0; i < len; i++) {
+				seed = seed * 1664525u + 1013904223u;
+				items[i].key = seed;
+				GLU_addtail(lb, &items[i]);
+			}
+		};
+		const int repeat = std::max(1000000 / len, 1);
+		ListBase lb;
+		double t_sort = 0.0, t_qsort = 0.0;
+		for (int r = 0; r < repeat; r++) {
+			shuffle(&lb);
+			t_sort += bench_time([&]() { GLU_listbase_sort(&lb, cmp); });
+
+			shuffle(&lb);
+			t_qsort += bench_time([&]() {
+				Item **array = static_cast<Item **>(
+					MEM_mallocN(sizeof(*array) * len, __func__));
+				int i = 0;
+				LISTBASE_FOREACH (Item *, item, &lb) {
+					array[i++] = item;
+				}
+				qsort(array, len, sizeof(*array), cmp_array);
+				GLU_listbase_clear(&lb);
+				for (i = 0; i < len; i++) {
+					GLU_addtail(&lb, array[i]);
+				}
+				MEM_freeN(array);
+			});
+		}
+
+		bench_log("%8d links: merge sort %7.3f ms, array + qsort %7.3f ms\n",
+				  len,
+				  t_sort * 1e3 / repeat,
+				  t_qsort * 1e3 / repeat);
+	}
+}
+
+TEST_METHOD(ListBase_defragment_throughput)
+{
+	/* Traversing a list allocated in one order and linked in another,
+	 * before and after #GLU_listbase_defragment. */
+	struct Item {
+		Item *prev, *next;
+		int value;
+	};
+	const int len = 200000;
+
+	std::vector<Item *> items(len);
+	for (int i = 0; i < len; i++) {
+		items[i] = MEM_cnew<Item>(__func__);
+	}
+	uint32_t seed = 46;
+	for (int i = len - 1; i > 0; i--) {
+		seed = seed * 1664525u + 1013904223u;
+		std::swap(items[i], items[seed % (uint32_t)(i + 1)]);
+	}
+	ListBase lb = {nullptr, nullptr};
+	for (int i = 0; i < len; i++) {
+		items[i]->value = i;
+		GLU_addtail(&lb, items[i]);
+	}
+
+	long long sum = 0;
+	auto traverse = [&]() {
+		LISTBASE_FOREACH (Item *, item, &lb) {
+			sum += item->value;
+		}
+	};
+	const double t_before = bench_time(traverse);
+	void *block = GLU_listbase_defragment(&lb, sizeof(Item), true, NULL);
+	const double t_after = bench_time(traverse);
+	GLU_listbase_defragment_free(&lb, block);
+
+	bench_log("%d links traversed: scattered %.3f ms, defragmented %.3f ms "
+			  "(%llx)\n",
+			  len,
+			  t_before * 1e3,
+			  t_after * 1e3,
+			  sum & 0xf);
+}
+
+TEST_METHOD(ListBase_parallel_foreach_throughput)
+{
+	/* #GLU_listbase_parallel_foreach against a plain loop for growing
+	 * amounts of work per link. */
+	struct Item {
+		Item *prev, *next;
+		unsigned int value;
+		unsigned int result;
+	};
+	const int len = 200000;
+	std::vector<Item> items(len);
+	ListBase lb = {nullptr, nullptr};
+	for (int i = 0; i < len; i++) {
+		items[i].value = (unsigned int)i;
+		GLU_addtail(&lb, &items[i]);
+	}
+
+	static int work;
+	auto process = [](Item *item) {
+		unsigned int h = item->value;
+		for (int i = 0; i < work; i++) {
+			h = (h ^ (h >> 15)) * 2246822519u;
+		}
+		item->result = h;
+	};
+	auto func = [](void *userdata, Link *link, int index, void *chunk) {
+		(*static_cast<void (**)(Item *)>(userdata))(
+			reinterpret_cast<Item *>(link));
+		(void)index;
+		(void)chunk;
+	};
+	void (*process_fn)(Item *) = process;
+
+	bench_log("%d links, %u hardware threads\n",
+			  len,
+			  std::thread::hardware_concurrency());
+	for (work = 0; work <= 1000; work = work ? work * 10 : 1) {
+		const double t_serial = bench_time([&]() {
+			LISTBASE_FOREACH (Item *, item, &lb) {
+				process(item);
+			}
+		});
+
+		ListBaseParallelSettings settings;
+		GLU_listbase_parallel_settings_init(&settings);
+		settings.userdata = &process_fn;
+		const double t_parallel = bench_time(
+			[&]() { GLU_listbase_parallel_foreach(&lb, func, &settings); });
+
+		bench_log("%4d steps per link: serial %8.3f ms, parallel %8.3f ms\n",
+				  work,
+				  t_serial * 1e3,
+				  t_parallel * 1e3);
+	}
+}
+
+TEST_METHOD(ListBase_pooled_nodes_throughput)
+{
+	/* Pooled #LinkData nodes against a separate allocation per node. */
+	const int len = 100000;
+	std::vector<int> values(len);
+	MemPool *pool = GLU_genericNode_pool_create(0);
+	ListBase lb = {nullptr, nullptr};
+
+	const double t_malloc = bench_time([&]() {
+		for (int i = 0; i < len; i++) {
+			GLU_addtail(&lb, GLU_genericNodeN(&values[i]));
+		}
+		GLU_freelistN(&lb);
+	});
+	const double t_pooled = bench_time([&]() {
+		for (int i = 0; i < len; i++) {
+			GLU_addtail_pooled(&lb, pool, &values[i]);
+		}
+		GLU_freelist_pooled_all(&lb, pool);
+	});
+	GLU_mempool_discard(pool);
+
+	bench_log("%d nodes added and freed: MEM_mallocN %.3f ms, pooled %.3f ms\n",
+			  len,
+			  t_malloc * 1e3,
+			  t_pooled * 1e3);
+}
+
+TEST_METHOD(Vector_relocatable_growth_throughput)
+{
+	/* Appending to a vector that grows with MEM_reallocN against one that
+	 * moves every element when growing. */
+	struct Moving {
+		int value;
+		Moving(int value) : value(value)
+		{
+		}
+		Moving(Moving &&other) noexcept : value(other.value)
+		{
+		}
+	};
+	const int len = 100000000;
+
+	int sink = 0;
+	const double t_realloc = bench_time([&]() {
+		loom::Vector<int> values;
+		for (int i = 0; i < len; i++) {
+			values.Append(i);
+		}
+		sink += values[len - 1];
+	});
+	const double t_relocate = bench_time([&]() {
+		loom::Vector<Moving> values;
+		for (int i = 0; i < len; i++) {
+			values.Append(Moving(i));
+		}
+		sink += values[len - 1].value;
+	});
+
+	bench_log("%d appends: realloc growth %.1f ms, relocating growth %.1f ms "
+			  "(%x)\n",
+			  len,
+			  t_realloc * 1e3,
+			  t_relocate * 1e3,
+			  sink & 0xf);
+}
+
+/* clang-format off */
+};
+/* clang-format on */
+
+#endif /* WITH_BENCHMARKS */
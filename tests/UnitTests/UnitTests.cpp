@@ -1,14 +1,49 @@
 #include "CppUnitTest.h"
 #include "CppUnitTestAssert.h"
 
+/* For #GLU_ghash_internal_freeze_ex. */
+#define GHASH_INTERNAL_API
+
+#include "loomlib/loomlib_array.hh"
+#include "loomlib/loomlib_dynstr.h"
+#include "loomlib/loomlib_filter.h"
 #include "loomlib/loomlib_ghash.h"
+#include "loomlib/loomlib_ghash_concurrent.h"
+#include "loomlib/loomlib_ghash_mmap.h"
+#include "loomlib/loomlib_hash_mm2a.h"
+#include "loomlib/loomlib_hash_xxh3.h"
+#include "loomlib/loomlib_listbase.h"
+#include "loomlib/loomlib_listbase_index.h"
+#include "loomlib/loomlib_memarena.h"
+#include "loomlib/loomlib_mempool.h"
 #include "loomlib/loomlib_string.h"
+#include "loomlib/loomlib_string.hh"
+#include "loomlib/loomlib_string_ref.hh"
+#include "loomlib/loomlib_string_replace.h"
+#include "loomlib/loomlib_string_search.h"
+#include "loomlib/loomlib_strintern.h"
+#include "loomlib/loomlib_vector.hh"
+#include "loomlib/loomlib_vector_map.hh"
+#include "loomlib/loomlib_vector_set.hh"
 
 #include "makesdna/dna_types_c.h"
 
+#include "utfconv/utfconv.h"
+
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <map>
+#include <string>
+#include <thread>
+#include <vector>
 
 TEST_CLASS(LoomLibUnitTest){public : TEST_METHOD(GHashUnitTest_simple){
 	GHash *ghash = GLU_ghash_str_new(__func__);
@@ -225,5 +260,1986 @@ TEST_METHOD(LoomType_simple)
 	Assert::AreEqual(8, LOOM_MAGIC(LOOM_MAKETYPE_EX(LOOM_32S, 3, 3, 8)));
 	Assert::AreEqual(15, LOOM_MAGIC(LOOM_MAKETYPE_EX(LOOM_32S, 3, 3, 15)));
 }
+
+TEST_METHOD(CGHashUnitTest_threaded)
+{
+	CGHash *cghash = GLU_cghash_new(
+		GLU_ghashutil_inthash_p, GLU_ghashutil_intcmp, __func__);
+
+	const int nthreads = 8;
+	const int nkeys = 1 << 16;
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < nthreads; t++) {
+		threads.emplace_back([cghash, t]() {
+			for (int i = t; i < nkeys; i += nthreads) {
+				GLU_cghash_insert(
+					cghash, POINTER_FROM_INT(i), POINTER_FROM_INT(i + 1));
+			}
+			/* Remove the odd keys while other threads are still inserting. */
+			for (int i = t; i < nkeys; i += nthreads) {
+				if (i & 1) {
+					GLU_cghash_remove(cghash, POINTER_FROM_INT(i), NULL, NULL);
+				}
+			}
+		});
+	}
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+
+	Assert::AreEqual((unsigned int)nkeys / 2, GLU_cghash_len(cghash));
+	for (int i = 0; i < nkeys; i++) {
+		if (i & 1) {
+			Assert::IsFalse(GLU_cghash_haskey(cghash, POINTER_FROM_INT(i)));
+		}
+		else {
+			Assert::AreEqual(POINTER_FROM_INT(i + 1),
+							 GLU_cghash_lookup(cghash, POINTER_FROM_INT(i)));
+		}
+	}
+
+	GLU_cghash_free(cghash, NULL, NULL);
+}
+
+TEST_METHOD(CGHashUnitTest_threaded_readers)
+{
+	/* Starts with the minimum of buckets, the writers resize it many times
+	 * while the readers look up every key that was inserted so far. */
+	CGHash *cghash = GLU_cghash_new(
+		GLU_ghashutil_inthash_p, GLU_ghashutil_intcmp, __func__);
+
+	const int nwriters = 4;
+	const int nreaders = 4;
+	const int nkeys = 1 << 17;
+
+	std::atomic<int> inserted[nwriters];
+	for (std::atomic<int> &count : inserted) {
+		count.store(0);
+	}
+	std::atomic<int> writers_done(0);
+	std::atomic<int> failed(0);
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < nwriters; t++) {
+		threads.emplace_back([&, t]() {
+			for (int n = 0; t + n * nwriters < nkeys; n++) {
+				const int i = t + n * nwriters;
+				GLU_cghash_insert(
+					cghash, POINTER_FROM_INT(i), POINTER_FROM_INT(i + 1));
+				inserted[t].store(n + 1, std::memory_order_release);
+			}
+			writers_done.fetch_add(1);
+		});
+	}
+	for (int t = 0; t < nreaders; t++) {
+		threads.emplace_back([&, t]() {
+			unsigned int seed = 7 + t;
+			while (writers_done.load() < nwriters) {
+				seed = seed * 1664525u + 1013904223u;
+				const int w = (int)(seed >> 8) % nwriters;
+				const int n = inserted[w].load(std::memory_order_acquire);
+				if (n == 0) {
+					continue;
+				}
+				const int i = w + (int)((seed >> 12) % (unsigned int)n) *
+									  nwriters;
+				if (GLU_cghash_lookup(cghash, POINTER_FROM_INT(i)) !=
+					POINTER_FROM_INT(i + 1)) {
+					failed.fetch_add(1);
+				}
+				/* Not inserted by any writer. */
+				if (GLU_cghash_haskey(cghash, POINTER_FROM_INT(-1 - i))) {
+					failed.fetch_add(1);
+				}
+			}
+		});
+	}
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+
+	Assert::AreEqual(0, failed.load());
+	Assert::AreEqual((unsigned int)nkeys, GLU_cghash_len(cghash));
+
+	GLU_cghash_free(cghash, NULL, NULL);
+}
+
+TEST_METHOD(GHashUnitTest_freeze)
+{
+	GHash *ghash = GLU_ghash_str_new(__func__);
+
+	std::vector<std::string> keys;
+	for (int i = 0; i < 10000; i++) {
+		keys.push_back("key_" + std::to_string(i));
+	}
+	for (int i = 0; i < (int)keys.size(); i++) {
+		GLU_ghash_insert(
+			ghash, (void *)keys[i].c_str(), POINTER_FROM_INT(i + 1));
+	}
+
+	GHashFrozen *frozen = GLU_ghash_freeze(ghash);
+	Assert::IsNotNull(frozen);
+	GLU_ghash_free(ghash, NULL, NULL);
+
+	Assert::AreEqual((unsigned int)keys.size(), GLU_ghash_frozen_len(frozen));
+	for (int i = 0; i < (int)keys.size(); i++) {
+		Assert::AreEqual(POINTER_FROM_INT(i + 1),
+						 GLU_ghash_frozen_lookup(frozen, keys[i].c_str()));
+	}
+	Assert::IsFalse(GLU_ghash_frozen_haskey(frozen, "key_10000"));
+	Assert::IsNull(GLU_ghash_frozen_lookup(frozen, "missing"));
+
+	GLU_ghash_frozen_free(frozen, NULL, NULL);
+
+	/* Keys sharing a hash, all but one of each group land in the overflow. */
+	ghash = GLU_ghash_new(
+		[](const void *key) {
+			return (unsigned int)(POINTER_AS_INT(key) / 4);
+		},
+		GLU_ghashutil_intcmp,
+		__func__);
+	for (int i = 0; i < 1000; i++) {
+		GLU_ghash_insert(ghash, POINTER_FROM_INT(i), POINTER_FROM_INT(i + 1));
+	}
+	frozen = GLU_ghash_freeze(ghash);
+	Assert::IsNotNull(frozen);
+	Assert::AreEqual(1000u, GLU_ghash_frozen_len(frozen));
+	for (int i = 0; i < 1000; i++) {
+		Assert::AreEqual(POINTER_FROM_INT(i + 1),
+						 GLU_ghash_frozen_lookup(frozen, POINTER_FROM_INT(i)));
+	}
+	Assert::IsFalse(GLU_ghash_frozen_haskey(frozen, POINTER_FROM_INT(1000)));
+	Assert::IsFalse(GLU_ghash_frozen_haskey(frozen, POINTER_FROM_INT(-1)));
+	GLU_ghash_frozen_free(frozen, NULL, NULL);
+
+	/* With a single pilot per bucket no seed can place every key. */
+	Assert::IsNull(GLU_ghash_internal_freeze_ex(ghash, 1));
+	GLU_ghash_free(ghash, NULL, NULL);
+}
+
+TEST_METHOD(GHashUnitTest_lookup_batch)
+{
+	GHash *ghash = GLU_ghash_int_new(__func__);
+	GSet *gset = GLU_gset_int_new(__func__);
+
+	for (int i = 0; i < 1000; i++) {
+		GLU_ghash_insert(
+			ghash, POINTER_FROM_INT(i * 3), POINTER_FROM_INT(i + 1));
+		GLU_gset_insert(gset, POINTER_FROM_INT(i * 3));
+	}
+
+	/* Not a multiple of the internal batch size on purpose. */
+	std::vector<const void *> keys;
+	for (int i = 0; i < 2999; i++) {
+		keys.push_back(POINTER_FROM_INT(i));
+	}
+
+	std::vector<void *> vals(keys.size());
+	std::vector<void *> set_keys(keys.size());
+	GLU_ghash_lookup_batch(
+		ghash, keys.data(), (unsigned int)keys.size(), vals.data());
+	GLU_gset_lookup_batch(
+		gset, keys.data(), (unsigned int)keys.size(), set_keys.data());
+
+	for (int i = 0; i < (int)keys.size(); i++) {
+		Assert::AreEqual(GLU_ghash_lookup_default(ghash, keys[i], NULL),
+						 vals[i]);
+		Assert::AreEqual(GLU_gset_haskey(gset, keys[i]),
+						 set_keys[i] == keys[i]);
+	}
+
+	GLU_gset_free(gset, NULL);
+	GLU_ghash_free(ghash, NULL, NULL);
+}
+
+TEST_METHOD(VectorSet_simple)
+{
+	loom::VectorSet<int> set = {4, 2, 4, 7};
+	Assert::AreEqual((size_t)3, set.Size());
+	Assert::AreEqual(7, set[2]);
+	Assert::IsTrue(set.Add(9));
+	Assert::IsFalse(set.Add(2));
+	Assert::AreEqual((size_t)3, set.IndexOf(9));
+	Assert::AreEqual((size_t)-1, set.IndexOfTry(5));
+
+	/* The last key moves into the place of the removed one. */
+	Assert::IsTrue(set.Remove(4));
+	Assert::AreEqual(9, set[0]);
+	Assert::AreEqual((size_t)0, set.IndexOf(9));
+	Assert::IsFalse(set.Contains(4));
+
+	for (int i = 0; i < 1000; i++) {
+		set.Add(i * 5);
+	}
+	for (int i = 0; i < 1000; i++) {
+		Assert::AreEqual(i * 5, set[set.IndexOf(i * 5)]);
+	}
+	for (int i = 0; i < 1000; i += 2) {
+		Assert::IsTrue(set.Remove(i * 5));
+	}
+	for (int i = 0; i < 1000; i++) {
+		Assert::AreEqual(i % 2 != 0, set.Contains(i * 5));
+	}
+}
+
+TEST_METHOD(VectorMap_simple)
+{
+	loom::VectorMap<std::string, int> map;
+	Assert::IsTrue(map.Add("a", 1));
+	Assert::IsTrue(map.Add("b", 2));
+	Assert::IsFalse(map.Add("a", 3));
+	Assert::IsFalse(map.AddOverwrite("a", 4));
+	Assert::AreEqual(4, map.Lookup("a"));
+	Assert::AreEqual(0, map.LookupDefault("c", 0));
+	map.LookupOrAddDefault("c") += 5;
+	Assert::AreEqual(5, *map.LookupPtr("c"));
+
+	Assert::IsTrue(map.Keys()[1] == "b");
+	Assert::AreEqual(2, map.Values()[1]);
+
+	Assert::IsTrue(map.Remove("a"));
+	Assert::IsTrue(map.Keys()[0] == "c");
+	Assert::AreEqual(5, map.Values()[0]);
+	Assert::IsTrue(map.LookupPtr("a") == nullptr);
+}
+
+TEST_METHOD(GHashUnitTest_mmap)
+{
+	GHash *ghash = GLU_ghash_str_new(__func__);
+	std::vector<std::string> keys;
+	for (int i = 0; i < 1000; i++) {
+		keys.push_back("key" + std::to_string(i));
+	}
+	for (int i = 0; i < 1000; i++) {
+		GLU_ghash_insert(
+			ghash, (void *)keys[i].c_str(), POINTER_FROM_INT(i + 1));
+	}
+
+	size_t size;
+	void *data = GLU_ghash_mmap_write(
+		ghash, GHASH_MMAP_KEY_STR, GHASH_MMAP_VAL_INT, &size);
+
+	GHashMMap map;
+	Assert::IsTrue(GLU_ghash_mmap_init(&map, data, size));
+	Assert::AreEqual(1000u, GLU_ghash_mmap_len(&map));
+	for (int i = 0; i < 1000; i++) {
+		Assert::AreEqual(
+			i + 1,
+			POINTER_AS_INT(GLU_ghash_mmap_lookup(&map, keys[i].c_str())));
+	}
+	Assert::IsNull(GLU_ghash_mmap_lookup(&map, "key1000"));
+	Assert::IsFalse(GLU_ghash_mmap_haskey(&map, ""));
+
+	/* Truncated data is rejected. */
+	Assert::IsFalse(GLU_ghash_mmap_init(&map, data, size - 1));
+
+	MEM_freeN(data);
+	GLU_ghash_free(ghash, NULL, NULL);
+
+	GHash *ghash_int = GLU_ghash_int_new(__func__);
+	for (int i = -100; i < 100; i++) {
+		GLU_ghash_insert(
+			ghash_int, POINTER_FROM_INT(i), (void *)keys[i + 100].c_str());
+	}
+
+	data = GLU_ghash_mmap_write(
+		ghash_int, GHASH_MMAP_KEY_INT, GHASH_MMAP_VAL_STR, &size);
+	Assert::IsTrue(GLU_ghash_mmap_init(&map, data, size));
+	for (int i = -100; i < 100; i++) {
+		Assert::AreEqual(
+			keys[i + 100].c_str(),
+			(const char *)GLU_ghash_mmap_lookup(&map, POINTER_FROM_INT(i)));
+	}
+	Assert::IsFalse(GLU_ghash_mmap_haskey(&map, POINTER_FROM_INT(100)));
+
+	/* Negative integers are stored as 64 bit, the same on every platform. */
+	const int64_t key_min = -100;
+	bool found = false;
+	for (size_t offset = 0; offset + sizeof(key_min) <= size; offset += 8) {
+		found |= memcmp((const char *)data + offset, &key_min, 8) == 0;
+	}
+	Assert::IsTrue(found);
+	MEM_freeN(data);
+
+	GHash *ghash_neg = GLU_ghash_int_new(__func__);
+	for (int i = 0; i < 100; i++) {
+		GLU_ghash_insert(ghash_neg, POINTER_FROM_INT(i), POINTER_FROM_INT(-i));
+	}
+	data = GLU_ghash_mmap_write(
+		ghash_neg, GHASH_MMAP_KEY_INT, GHASH_MMAP_VAL_INT, &size);
+	Assert::IsTrue(GLU_ghash_mmap_init(&map, data, size));
+	for (int i = 0; i < 100; i++) {
+		Assert::AreEqual(
+			-i, POINTER_AS_INT(GLU_ghash_mmap_lookup(&map, POINTER_FROM_INT(i))));
+	}
+	MEM_freeN(data);
+
+	/* Through a file, negative keys and values included. */
+	const char *filepath = "GHashUnitTest_mmap.bin";
+	for (int i = -100; i < 0; i++) {
+		GLU_ghash_insert(ghash_neg, POINTER_FROM_INT(i), POINTER_FROM_INT(-i));
+	}
+	Assert::IsTrue(GLU_ghash_mmap_write_file(
+		ghash_neg, GHASH_MMAP_KEY_INT, GHASH_MMAP_VAL_INT, filepath));
+	Assert::IsTrue(GLU_ghash_mmap_file_open(&map, filepath));
+	Assert::AreEqual(GLU_ghash_len(ghash_neg), GLU_ghash_mmap_len(&map));
+	for (int i = -100; i < 100; i++) {
+		Assert::AreEqual(
+			-i, POINTER_AS_INT(GLU_ghash_mmap_lookup(&map, POINTER_FROM_INT(i))));
+	}
+	Assert::IsFalse(GLU_ghash_mmap_haskey(&map, POINTER_FROM_INT(-101)));
+	GLU_ghash_mmap_file_close(&map);
+	Assert::AreEqual(0, remove(filepath));
+
+	Assert::IsFalse(GLU_ghash_mmap_file_open(&map, filepath));
+
+	GLU_ghash_free(ghash_neg, NULL, NULL);
+	GLU_ghash_free(ghash_int, NULL, NULL);
+}
+
+TEST_METHOD(GHashUnitTest_calc_quality)
+{
+	GHash *ghash = GLU_ghash_int_new(__func__);
+	GHashQuality quality;
+
+	GLU_ghash_calc_quality_ex(ghash, &quality);
+	Assert::AreEqual(0u, quality.nentries);
+	Assert::AreEqual(quality.nbuckets, quality.empty_buckets);
+
+	for (int i = 0; i < 10000; i++) {
+		GLU_ghash_insert(ghash, POINTER_FROM_INT(i), POINTER_FROM_INT(i));
+	}
+
+	const double value = GLU_ghash_calc_quality_ex(ghash, &quality);
+	Assert::AreEqual(10000u, quality.nentries);
+	Assert::IsTrue(quality.load > 0.0 && quality.load <= 1.0);
+	Assert::IsTrue(quality.probe_mean >= 1.0);
+	Assert::IsTrue(quality.probe_max >= 1);
+	Assert::IsTrue(value > 0.5 && value < 2.0);
+
+	unsigned int nbuckets = 0, nentries = 0;
+	for (unsigned int i = 0; i < GHASH_QUALITY_HISTOGRAM_LEN; i++) {
+		nbuckets += quality.chain_histogram[i];
+		nentries += i * quality.chain_histogram[i];
+	}
+	Assert::AreEqual(quality.nbuckets, nbuckets);
+	Assert::AreEqual(quality.empty_buckets, quality.chain_histogram[0]);
+	/* No chain is long enough to be clamped into the last slot. */
+	Assert::AreEqual(quality.nentries, nentries);
+
+	GLU_ghash_free(ghash, NULL, NULL);
+}
+
+TEST_METHOD(GHashUnitTest_ptrhash_upper_bits)
+{
+	/* Pointers that only differ above bit 32 must not all collide. */
+	if (sizeof(void *) > 4) {
+		const uintptr_t base = 0x1000;
+		const unsigned int hash = GLU_ghashutil_ptrhash((void *)base);
+		unsigned int ncollide = 0;
+		for (uintptr_t i = 1; i < 16; i++) {
+			const uintptr_t p = base | (i << (sizeof(void *) * 4));
+			ncollide += GLU_ghashutil_ptrhash((void *)p) == hash;
+		}
+		Assert::AreEqual(0u, ncollide);
+	}
+}
+
+TEST_METHOD(HashXXH3_vectors)
+{
+	std::vector<unsigned char> data(3000);
+	for (size_t i = 0; i < data.size(); i++) {
+		data[i] = (unsigned char)(i % 251);
+	}
+
+	Assert::AreEqual(0x2d06800538d394c2ull,
+					 (unsigned long long)GLU_hash_xxh3_64(NULL, 0, 0));
+	Assert::AreEqual(
+		0x78af5f94892f3950ull,
+		(unsigned long long)GLU_hash_xxh3_64(
+			(const unsigned char *)"abc", 3, 0));
+	Assert::AreEqual(
+		0x972a5725e93d338eull,
+		(unsigned long long)GLU_hash_xxh3_64(
+			(const unsigned char *)"hello world", 11, 42));
+	Assert::AreEqual(
+		0xa2d0ad26c4039f99ull,
+		(unsigned long long)GLU_hash_xxh3_64(data.data(), 3000, 7));
+
+	Hash128 h = GLU_hash_xxh3_128(
+		(const unsigned char *)"hello world", 11, 0);
+	Assert::AreEqual(0xa99b8775cc15b6c7ull, (unsigned long long)h.low);
+	Assert::AreEqual(0xdf8d09e93f874900ull, (unsigned long long)h.high);
+	h = GLU_hash_xxh3_128(data.data(), 3000, 7);
+	Assert::AreEqual(0xa2d0ad26c4039f99ull, (unsigned long long)h.low);
+	Assert::AreEqual(0xa28721cc2c8e46f8ull, (unsigned long long)h.high);
+}
+
+TEST_METHOD(HashXXH3_streaming)
+{
+	std::vector<unsigned char> data(5000);
+	for (size_t i = 0; i < data.size(); i++) {
+		data[i] = (unsigned char)(i * 31 + (i >> 7));
+	}
+
+	const size_t lengths[] = {0, 3, 16, 100, 240, 241, 256, 257, 1024, 5000};
+	for (size_t len : lengths) {
+		for (size_t chunk = 1; chunk < 700; chunk += 97) {
+			HashXXH3 xxh;
+			GLU_hash_xxh3_init(&xxh, 1234);
+			for (size_t i = 0; i < len; i += chunk) {
+				GLU_hash_xxh3_add(
+					&xxh, data.data() + i, std::min(chunk, len - i));
+			}
+
+			Assert::IsTrue(GLU_hash_xxh3_end(&xxh) ==
+						   GLU_hash_xxh3_64(data.data(), len, 1234));
+			const Hash128 a = GLU_hash_xxh3_end_128(&xxh);
+			const Hash128 b = GLU_hash_xxh3_128(data.data(), len, 1234);
+			Assert::IsTrue(a.low == b.low && a.high == b.high);
+		}
+	}
+}
+
+TEST_METHOD(StrIntern_simple)
+{
+	StrIntern *si = GLU_strintern_new(__func__);
+
+	char buffer[16] = "identifier";
+	const char *a = GLU_strintern(si, "identifier");
+	const char *b = GLU_strintern(si, buffer);
+	Assert::IsTrue(a == b);
+	Assert::IsTrue(a != buffer);
+	Assert::AreEqual("identifier", a);
+	Assert::AreEqual((size_t)10, GLU_strintern_strlen(a));
+
+	const char *c = GLU_strintern_n(si, "identifiers", 5);
+	Assert::AreEqual("ident", c);
+	Assert::IsTrue(c == GLU_strintern_find(si, "ident"));
+	Assert::IsNull(GLU_strintern_find(si, "iden"));
+	Assert::AreEqual(GLU_strintern_id(c), GLU_strintern_find_id(si, "ident"));
+	Assert::AreEqual(GLU_STRINTERN_ID_NONE, GLU_strintern_find_id(si, "iden"));
+
+	Assert::AreEqual(0u, GLU_strintern_id(a));
+	Assert::AreEqual(1u, GLU_strintern_id(c));
+	Assert::IsTrue(GLU_strintern_from_id(si, 1) == c);
+	Assert::IsNull(GLU_strintern_from_id(si, 2));
+	Assert::IsNull(GLU_strintern_from_id(si, 1u << 28));
+	Assert::IsNull(GLU_strintern_from_id(si, GLU_STRINTERN_ID_NONE));
+
+	/* Larger than an arena chunk. */
+	std::string large(100000, 'x');
+	const char *d = GLU_strintern(si, large.c_str());
+	Assert::IsTrue(d == GLU_strintern(si, large.c_str()));
+	Assert::AreEqual(large.size(), GLU_strintern_strlen(d));
+
+	StrInternMemStats stats;
+	GLU_strintern_calc_memory(si, &stats);
+	Assert::AreEqual(3u, stats.nstrings);
+	Assert::AreEqual((size_t)(11 + 6 + 100001), stats.bytes_strings);
+	Assert::IsTrue(stats.bytes_arena >= stats.bytes_strings);
+
+	GLU_strintern_free(si);
+}
+
+TEST_METHOD(StrIntern_threaded)
+{
+	StrIntern *si = GLU_strintern_new(__func__);
+	const int nthreads = 8, nstrings = 5000;
+
+	std::vector<std::string> strings;
+	for (int i = 0; i < nstrings; i++) {
+		strings.push_back("name_" + std::to_string(i));
+	}
+
+	std::vector<std::vector<const char *>> results(nthreads);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < nthreads; t++) {
+		threads.emplace_back([&, t]() {
+			for (int i = 0; i < nstrings; i++) {
+				/* Every thread in a different order. */
+				const int index = (i * 7 + t * 613) % nstrings;
+				results[t].push_back(
+					GLU_strintern(si, strings[index].c_str()));
+			}
+		});
+	}
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+
+	Assert::AreEqual((unsigned int)nstrings, GLU_strintern_len(si));
+	for (int t = 0; t < nthreads; t++) {
+		for (int i = 0; i < nstrings; i++) {
+			const int index = (i * 7 + t * 613) % nstrings;
+			const char *str = results[t][i];
+			Assert::IsTrue(
+				str == GLU_strintern_find(si, strings[index].c_str()));
+			Assert::IsTrue(
+				str == GLU_strintern_from_id(si, GLU_strintern_id(str)));
+		}
+	}
+
+	GLU_strintern_free(si);
+}
+
+TEST_METHOD(StringSimd_fuzz)
+{
+	/* Every supported instruction set against libc, for all alignments and
+	 * lengths around the vector sizes. */
+	const eStrSimdLevel level_max = GLU_str_simd_level_get();
+	const char *reject = ":/\\ \t\x80\xff";
+	StrCharClass cls;
+	GLU_str_charclass_init(&cls, reject);
+
+	std::vector<char> buf(1024 + 128), dst(1024 + 128);
+	uint32_t seed = 1234;
+	auto rand_next = [&seed]() {
+		seed = seed * 1664525u + 1013904223u;
+		return seed >> 8;
+	};
+
+	for (int level = STR_SIMD_SCALAR; level <= STR_SIMD_AVX512; level++) {
+		if (GLU_str_simd_level_set((eStrSimdLevel)level) != level) {
+			continue;
+		}
+		for (int trial = 0; trial < 20000; trial++) {
+			const size_t offset = rand_next() % 64;
+			const size_t len = (trial < 512) ? trial % 256 :
+											   rand_next() % 1000;
+			char *str = buf.data() + offset;
+			for (size_t i = 0; i < len; i++) {
+				/* Mostly letters, sometimes any non-zero byte. */
+				str[i] = (rand_next() % 32) ? (char)('a' + rand_next() % 26) :
+											  (char)(1 + rand_next() % 255);
+			}
+			str[len] = '\0';
+
+			Assert::AreEqual(strlen(str), GLU_strlen(str));
+
+			const size_t maxn = rand_next() % (len + 40);
+			Assert::AreEqual(strnlen(str, maxn), GLU_strnlen(str, maxn));
+
+			const int c = (rand_next() % 2) ? str[rand_next() % (len + 1)] :
+											  (int)(rand_next() % 256);
+			Assert::IsTrue(memchr(str, c, maxn) == GLU_memchr(str, c, maxn));
+
+			Assert::AreEqual(strcspn(str, reject), GLU_strcspn_class(str, &cls));
+
+			const size_t maxncpy = 1 + rand_next() % (len + 40);
+			const size_t expect = std::min(len, maxncpy - 1);
+			memset(dst.data(), 0x55, dst.size());
+			Assert::AreEqual(expect,
+							 GLU_strncpy_rlen(dst.data(), str, maxncpy));
+			Assert::IsTrue(memcmp(dst.data(), str, expect) == 0);
+			Assert::AreEqual('\0', dst[expect]);
+			Assert::AreEqual((char)0x55, dst[expect + 1]);
+		}
+	}
+
+	GLU_str_simd_level_set(level_max);
+}
+
+TEST_METHOD(StringReplace_multi)
+{
+	{
+		const char *patterns[] = {"he", "she", "his", "hers", "s"};
+		const char *replacements[] = {"1", "2", "3", "4", "_"};
+		StrReplacer *rep = GLU_str_replacer_new(patterns, replacements, 5);
+
+		/* Leftmost wins over longest, longest wins at the same start. */
+		const char *str = "ushers say his hershey";
+		const char *expected = "u2r_ _ay 3 41y";
+		Assert::AreEqual(strlen(expected), GLU_str_replacer_len(rep, str));
+		char *res = GLU_str_replacer_applyN(rep, str);
+		Assert::AreEqual(expected, res);
+		MEM_freeN(res);
+
+		std::string streamed;
+		GLU_str_replacer_stream(
+			rep,
+			str,
+			[](void *user_data, const char *data, size_t len) {
+				static_cast<std::string *>(user_data)->append(data, len);
+			},
+			&streamed);
+		Assert::AreEqual(expected, streamed.c_str());
+
+		GLU_str_replacer_free(rep);
+	}
+
+	/* Random patterns over a small alphabet against a brute force search. */
+	srand(35);
+	for (int t = 0; t < 500; t++) {
+		const int npatterns = 1 + rand() % 6;
+		std::vector<std::string> patterns, replacements;
+		std::vector<const char *> patterns_c, replacements_c;
+		for (int i = 0; i < npatterns; i++) {
+			std::string pattern, replacement;
+			for (int j = 1 + rand() % 4; j > 0; j--) {
+				pattern += (char)('a' + rand() % 3);
+			}
+			for (int j = rand() % 4; j > 0; j--) {
+				replacement += (char)('A' + rand() % 26);
+			}
+			patterns.push_back(pattern);
+			replacements.push_back(replacement);
+		}
+		for (int i = 0; i < npatterns; i++) {
+			patterns_c.push_back(patterns[i].c_str());
+			replacements_c.push_back(replacements[i].c_str());
+		}
+
+		std::string str;
+		for (int j = rand() % 200; j > 0; j--) {
+			str += (char)('a' + rand() % 4);
+		}
+
+		std::string expected;
+		for (size_t i = 0; i < str.size();) {
+			int best = -1;
+			for (int p = 0; p < npatterns; p++) {
+				if (str.compare(i, patterns[p].size(), patterns[p]) == 0 &&
+					(best < 0 || patterns[p].size() > patterns[best].size()))
+				{
+					best = p;
+				}
+			}
+			if (best < 0) {
+				expected += str[i++];
+			}
+			else {
+				expected += replacements[best];
+				i += patterns[best].size();
+			}
+		}
+
+		StrReplacer *rep = GLU_str_replacer_new(
+			patterns_c.data(), replacements_c.data(), npatterns);
+		char *res = GLU_str_replacer_applyN(rep, str.c_str());
+		Assert::AreEqual(expected.c_str(), res);
+		MEM_freeN(res);
+		GLU_str_replacer_free(rep);
+
+		if (npatterns == 1) {
+			res = GLU_str_replaceN(
+				str.c_str(), patterns_c[0], replacements_c[0]);
+			Assert::AreEqual(expected.c_str(), res);
+			MEM_freeN(res);
+		}
+	}
+}
+
+TEST_METHOD(DynStr_simple)
+{
+	DynStr *ds = GLU_dynstr_new();
+	std::string expected;
+
+	for (int i = 0; i < 2000; i++) {
+		GLU_dynstr_append(ds, "word ");
+		GLU_dynstr_nappend(ds, "abcdef", i % 7);
+		/* Now and then too long for the free space of the last chunk. */
+		const std::string arg((i % 100) ? 0 : 500, 'x');
+		GLU_dynstr_appendf(ds, "[%d:%s]", i, arg.c_str());
+		expected += "word ";
+		expected += std::string("abcdef").substr(0, i % 7);
+		expected += "[" + std::to_string(i) + ":" + arg + "]";
+	}
+
+	Assert::AreEqual(expected.size(), GLU_dynstr_get_len(ds));
+	char *str = GLU_dynstr_get_cstring(ds);
+	Assert::AreEqual(expected.c_str(), str);
+	MEM_freeN(str);
+
+	size_t len;
+	str = GLU_dynstr_steal(ds, &len);
+	Assert::AreEqual(expected.size(), len);
+	Assert::AreEqual(expected.c_str(), str);
+	Assert::AreEqual((size_t)0, GLU_dynstr_get_len(ds));
+	MEM_freeN(str);
+
+	/* Fits the reserved chunk, stolen without a copy. */
+	GLU_dynstr_reserve(ds, 64);
+	GLU_dynstr_appendf(ds, "%s-%d", "reserved", 42);
+	Assert::AreEqual("reserved-42", (str = GLU_dynstr_steal(ds, NULL)));
+	MEM_freeN(str);
+
+	GLU_dynstr_free(ds);
+}
+
+TEST_METHOD(DynStr_memarena)
+{
+	MemArena *ma = GLU_memarena_new(LOOM_MEMARENA_STD_BUFSIZE, __func__);
+	std::vector<char *> results;
+
+	for (int i = 0; i < 100; i++) {
+		DynStr *ds = GLU_dynstr_new_memarena(ma);
+		for (int j = 0; j <= i; j++) {
+			GLU_dynstr_appendf(ds, "%d,", j);
+		}
+		results.push_back(GLU_dynstr_steal(ds, NULL));
+		GLU_dynstr_free(ds);
+	}
+
+	for (int i = 0; i < 100; i++) {
+		std::string expected;
+		for (int j = 0; j <= i; j++) {
+			expected += std::to_string(j) + ",";
+		}
+		Assert::AreEqual(expected.c_str(), results[i]);
+	}
+
+	GLU_memarena_use_align(ma, 64);
+	void *ptr = GLU_memarena_calloc(ma, 100);
+	Assert::AreEqual((uintptr_t)0, (uintptr_t)ptr & 63);
+	GLU_memarena_clear(ma);
+	GLU_memarena_free(ma);
+}
+
+TEST_METHOD(UtfConv_transcode)
+{
+	/* Random valid text, round tripped and compared with the code unit at a
+	 * time converters, then with random mutations against the validator. */
+	srand(37);
+	for (int t = 0; t < 20000; t++) {
+		std::string str;
+		const int len = rand() % 300;
+		while ((int)str.size() < len) {
+			const int kind = rand() % 4;
+			unsigned int u = (kind == 0) ? 0x20 + rand() % 0x5F :
+							 (kind == 1) ? 0x80 + rand() % 0x780 :
+							 (kind == 2) ? 0x800 + rand() % 0xF800 :
+										   0x10000 + rand() % 0x100000;
+			if (u >= 0xD800 && u < 0xE000) {
+				u = 'x';
+			}
+			/* Long ASCII runs to exercise the vector paths. */
+			if (kind == 0 && rand() % 4 == 0) {
+				str.append(rand() % 70, 'a' + rand() % 26);
+			}
+			if (u < 0x80) {
+				str += (char)u;
+			}
+			else if (u < 0x800) {
+				str += (char)(0xC0 | (u >> 6));
+				str += (char)(0x80 | (u & 0x3F));
+			}
+			else if (u < 0x10000) {
+				str += (char)(0xE0 | (u >> 12));
+				str += (char)(0x80 | ((u >> 6) & 0x3F));
+				str += (char)(0x80 | (u & 0x3F));
+			}
+			else {
+				str += (char)(0xF0 | (u >> 18));
+				str += (char)(0x80 | ((u >> 12) & 0x3F));
+				str += (char)(0x80 | ((u >> 6) & 0x3F));
+				str += (char)(0x80 | (u & 0x3F));
+			}
+		}
+
+		Assert::IsTrue(is_valid_utf_8(str.data(), str.size()) == 1);
+
+		std::vector<wchar_t> str16(UTF_16_LEN_MAX_FROM_8(str.size()) + 1);
+		int err = -1;
+		const size_t len16 =
+			transcode_utf_8_to_16(str.data(), str.size(), str16.data(), &err);
+		Assert::AreEqual(0, err);
+		str16[len16] = 0;
+
+		std::vector<wchar_t> expected16(count_utf_16_from_8(str.c_str()));
+		conv_utf_8_to_16(str.c_str(), expected16.data(), expected16.size());
+		Assert::AreEqual(expected16.size() - 1, len16);
+		Assert::IsTrue(memcmp(expected16.data(),
+							  str16.data(),
+							  len16 * sizeof(wchar_t)) == 0);
+
+		std::vector<char> str8(UTF_8_LEN_MAX_FROM_16(len16) + 1);
+		const size_t len8 =
+			transcode_utf_16_to_8(str16.data(), len16, str8.data(), &err);
+		Assert::AreEqual(0, err);
+		Assert::AreEqual(str.size(), len8);
+		Assert::IsTrue(memcmp(str.data(), str8.data(), len8) == 0);
+
+		char *alloc8 = alloc_utf_8_from_16(str16.data(), 0);
+		Assert::AreEqual(str.c_str(), alloc8);
+		free(alloc8);
+
+		/* Any broken byte must be caught by the validator as by the
+		 * converter. */
+		if (!str.empty()) {
+			str[rand() % str.size()] = (char)(rand() % 256);
+			const int valid = is_valid_utf_8(str.data(), str.size());
+			transcode_utf_8_to_16(str.data(), str.size(), str16.data(), &err);
+			Assert::AreEqual(valid == 1, err == 0);
+		}
+	}
+
+	/* Overlong, surrogate, too large and truncated sequences. */
+	const char *invalid[] = {
+		"\xC0\xAF", "\xE0\x80\xAF", "\xED\xA0\x80", "\xF4\x90\x80\x80",
+		"\xF8\x88\x80\x80\x80", "abc\xE2\x82", "\x80", "\xC3\xA9\xA9"};
+	for (const char *str : invalid) {
+		Assert::AreEqual(0, is_valid_utf_8(str, strlen(str)));
+	}
+
+	/* A single code unit above U+FFFF, only where wchar_t holds one. */
+	if (sizeof(wchar_t) > 2) {
+		const wchar_t emoji16[] = {(wchar_t)0x1F600};
+		std::vector<char> emoji8(UTF_8_LEN_MAX_FROM_16(1));
+		int err = -1;
+		Assert::AreEqual((size_t)4,
+						 transcode_utf_16_to_8(emoji16, 1, emoji8.data(), &err));
+		Assert::AreEqual(0, err);
+		Assert::IsTrue(memcmp(emoji8.data(), "\xF0\x9F\x98\x80", 4) == 0);
+	}
+}
+
+TEST_METHOD(UtfConv_stream)
+{
+	/* Random chunks into small buffers must give what converting all the
+	 * input at once gives, errors included. */
+	srand(38);
+	const char pieces[][5] = {"a", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80",
+							  "\xC3", "\xE2\x82", "\xF0\x9F", "\xBF", "\xFF",
+							  "\xED\xA0\x80"};
+	for (int t = 0; t < 20000; t++) {
+		std::string str;
+		const int len = rand() % 200;
+		while ((int)str.size() < len) {
+			const int kind = rand() % 12;
+			if (kind < 2) {
+				str.append(rand() % 40, 'a' + rand() % 26);
+			}
+			else {
+				/* Mostly valid, sometimes a broken sequence. */
+				str += pieces[(rand() % 4 == 0) ? kind - 2 : (kind - 2) % 4];
+			}
+		}
+
+		std::vector<wchar_t> expected16(UTF_16_LEN_MAX_FROM_8(str.size()) + 1);
+		int expected_err;
+		expected16.resize(transcode_utf_8_to_16(
+			str.data(), str.size(), expected16.data(), &expected_err));
+
+		UTFStream stream;
+		utf_stream_init(&stream);
+		std::vector<wchar_t> str16;
+		for (size_t pos = 0; pos < str.size();) {
+			const size_t chunk = std::min<size_t>(rand() % 20, str.size() - pos);
+			size_t done = 0;
+			do {
+				wchar_t buf[64];
+				size_t len16;
+				done += utf_stream_feed_8_to_16(&stream,
+												str.data() + pos + done,
+												chunk - done,
+												buf,
+												4 + rand() % 40,
+												&len16);
+				str16.insert(str16.end(), buf, buf + len16);
+			} while (done < chunk);
+			pos += chunk;
+		}
+		Assert::AreEqual(expected_err, utf_stream_finish(&stream));
+		Assert::IsTrue(expected16 == str16);
+
+		/* And back, with unpaired surrogates thrown in. */
+		if (rand() % 2) {
+			str16.insert(str16.begin() + rand() % (str16.size() + 1),
+						 (wchar_t)(0xD800 + rand() % 0x800));
+		}
+		std::vector<char> expected8(UTF_8_LEN_MAX_FROM_16(str16.size()) + 1);
+		expected8.resize(transcode_utf_16_to_8(
+			str16.data(), str16.size(), expected8.data(), &expected_err));
+
+		std::vector<char> str8;
+		for (size_t pos = 0; pos < str16.size();) {
+			const size_t chunk = std::min<size_t>(rand() % 20, str16.size() - pos);
+			size_t done = 0;
+			do {
+				char buf[128];
+				size_t len8;
+				done += utf_stream_feed_16_to_8(&stream,
+												str16.data() + pos + done,
+												chunk - done,
+												buf,
+												8 + rand() % 80,
+												&len8);
+				str8.insert(str8.end(), buf, buf + len8);
+			} while (done < chunk);
+			pos += chunk;
+		}
+		Assert::AreEqual(expected_err, utf_stream_finish(&stream));
+		Assert::IsTrue(expected8 == str8);
+	}
+
+	/* Code units above U+FFFF where wchar_t holds them, an output with room
+	 * for one and a half of them takes one. */
+	if (sizeof(wchar_t) > 2) {
+		const wchar_t emoji16[] = {(wchar_t)0x1F600, (wchar_t)0x1F600};
+		char emoji8[6];
+		size_t len8;
+		UTFStream stream;
+		utf_stream_init(&stream);
+		Assert::AreEqual(
+			(size_t)1,
+			utf_stream_feed_16_to_8(&stream, emoji16, 2, emoji8, 6, &len8));
+		Assert::AreEqual((size_t)4, len8);
+		Assert::AreEqual(0, utf_stream_finish(&stream));
+	}
+}
+
+TEST_METHOD(StringSearch_fuzz)
+{
+	/* Every supported instruction set against std::string, small alphabets
+	 * give many partial matches and periodic needles. */
+	const eStrSimdLevel level_max = GLU_str_simd_level_get();
+	uint32_t seed = 39;
+	auto rand_next = [&seed]() {
+		seed = seed * 1664525u + 1013904223u;
+		return seed >> 8;
+	};
+	auto lower = [](std::string s) {
+		for (char &c : s) {
+			if (c >= 'A' && c <= 'Z') {
+				c = (char)(c | 0x20);
+			}
+		}
+		return s;
+	};
+
+	for (int level = STR_SIMD_SCALAR; level <= STR_SIMD_AVX512; level++) {
+		if (GLU_str_simd_level_set((eStrSimdLevel)level) != level) {
+			continue;
+		}
+		for (int trial = 0; trial < 20000; trial++) {
+			const char *alphabets[] = {"ab", "abc", "aAbB", "abcdefghij"};
+			const char *alphabet = alphabets[rand_next() % 4];
+			const size_t nalpha = strlen(alphabet);
+
+			/* Some long ones, where verifying the candidates costs enough to
+			 * fall back to Two-Way. */
+			const bool large = (trial % 16) == 0;
+			std::string hay, needle;
+			const size_t hay_len = rand_next() % (large ? 4000 : 300);
+			for (size_t i = 0; i < hay_len; i++) {
+				hay += alphabet[rand_next() % nalpha];
+			}
+			/* Often a piece of the haystack, so there is a match. */
+			if (hay_len && rand_next() % 2) {
+				const size_t start = rand_next() % hay_len;
+				needle = hay.substr(start, rand_next() % (large ? 400 : 40));
+			}
+			else {
+				const size_t needle_len = rand_next() % 12;
+				for (size_t i = 0; i < needle_len; i++) {
+					needle += alphabet[rand_next() % nalpha];
+				}
+			}
+
+			const size_t pos = hay.find(needle);
+			const char *r = GLU_strstr(hay.c_str(), needle.c_str());
+			Assert::IsTrue(r == ((pos == std::string::npos) ? nullptr :
+															 hay.c_str() + pos));
+
+			const size_t rpos = hay.rfind(needle);
+			r = GLU_strrstr(hay.c_str(), needle.c_str());
+			Assert::IsTrue(r == ((rpos == std::string::npos) ? nullptr :
+															  hay.c_str() + rpos));
+
+			const size_t cpos = lower(hay).find(lower(needle));
+			r = GLU_strcasestr(hay.c_str(), needle.c_str());
+			Assert::IsTrue(r == ((cpos == std::string::npos) ? nullptr :
+															  hay.c_str() + cpos));
+
+			StrNeedle *nd = GLU_str_needle_new(
+				needle.data(), needle.size(), STR_NEEDLE_IGNORE_CASE);
+			r = GLU_str_needle_find(nd, hay.data(), hay.size());
+			Assert::IsTrue(r == ((cpos == std::string::npos) ? nullptr :
+															  hay.data() + cpos));
+			const size_t crpos = lower(hay).rfind(lower(needle));
+			r = GLU_str_needle_rfind(nd, hay.data(), hay.size());
+			Assert::IsTrue(r == ((crpos == std::string::npos) ? nullptr :
+															   hay.data() + crpos));
+			GLU_str_needle_free(nd);
+
+			/* NULL bytes are ordinary bytes for #GLU_memmem. */
+			for (char &c : hay) {
+				if (c == 'a') {
+					c = '\0';
+				}
+			}
+			for (char &c : needle) {
+				if (c == 'a') {
+					c = '\0';
+				}
+			}
+			const size_t mpos = hay.find(needle);
+			const void *m = GLU_memmem(
+				hay.data(), hay.size(), needle.data(), needle.size());
+			Assert::IsTrue(m == ((mpos == std::string::npos) ? nullptr :
+															  hay.data() + mpos));
+		}
+	}
+	GLU_str_simd_level_set(level_max);
+}
+
+TEST_METHOD(StringRef_simple)
+{
+	constexpr loom::StringRef ref = "loom";
+	static_assert(ref.Size() == 4 && ref.Hash() == 2090479452u);
+	Assert::AreEqual(GLU_ghashutil_strhash_p("loom"), ref.Hash());
+	Assert::AreEqual(GLU_ghashutil_strhash_p("lo"), ref.TakeFront(2).Hash());
+
+	/* A reference into a larger string can key a #GHash of C strings. */
+	const char *text = "red,green,blue";
+	GHash *ghash = GLU_ghash_str_new(__func__);
+	GLU_ghash_insert(ghash, (void *)"green", (void *)"2");
+	GLU_ghash_insert(ghash, (void *)"gre", (void *)"3");
+	const loom::StringRef green = loom::StringRef(text).Slice(4, 5);
+	Assert::IsTrue(green == "green");
+	Assert::AreEqual(GLU_ghash_strhash("green"), green.Hash());
+	Assert::AreEqual("2", (const char *)green.LookupIn(ghash));
+	Assert::AreEqual("3", (const char *)green.TakeFront(3).LookupIn(ghash));
+	Assert::IsTrue(green.TakeFront(4).LookupIn(ghash) == NULL);
+	GLU_ghash_free(ghash, NULL, NULL);
+
+	GSet *gset = GLU_gset_str_new(__func__);
+	GLU_gset_insert(gset, (void *)"blue");
+	Assert::AreEqual("blue",
+					 (const char *)loom::StringRef(text).Slice(10, 4).LookupIn(
+						 gset));
+	Assert::IsTrue(loom::StringRef(text).Slice(9, 4).LookupIn(gset) == NULL);
+	GLU_gset_free(gset, NULL);
+
+	const loom::StringRef csv = text;
+	Assert::AreEqual((size_t)3, csv.Find(','));
+	Assert::AreEqual((size_t)9, csv.Find(',', 4));
+	Assert::AreEqual(loom::StringRef::NotFound, csv.Find(';'));
+	Assert::AreEqual((size_t)10, csv.Find("blue"));
+	Assert::AreEqual((size_t)5, csv.RFind("re"));
+	Assert::IsTrue(csv.StartsWith("red") && csv.EndsWith("blue"));
+	Assert::IsTrue(csv.DropFront(10) == "blue" && csv.DropBack(10) == "red,");
+	Assert::IsTrue(loom::StringRef("ab") < "abc");
+	Assert::IsFalse(loom::StringRef("b") < "abc");
+}
+
+TEST_METHOD(String_simple)
+{
+	loom::String str = "short";
+	Assert::IsTrue(str.IsInline());
+	Assert::AreEqual("short", str.CStr());
+
+	/* Growing past the inline buffer moves to the heap. */
+	str += " and then longer";
+	Assert::IsFalse(str.IsInline());
+	Assert::AreEqual("short and then longer", str.CStr());
+	Assert::AreEqual(GLU_ghashutil_strhash_p(str.CStr()), str.Hash());
+
+	/* Moving steals the heap buffer. */
+	const char *data = str.CStr();
+	loom::String moved = std::move(str);
+	Assert::IsTrue(moved.CStr() == data);
+	Assert::IsTrue(str.IsEmpty() && str.IsInline());
+
+	/* Appending a part of itself. */
+	moved.Append(moved.Ref().TakeFront(5));
+	Assert::AreEqual("short and then longershort", moved.CStr());
+	moved.Assign(moved.Ref().DropFront(21));
+	Assert::AreEqual("short", moved.CStr());
+	Assert::IsTrue(moved.CStr() == data);
+
+	loom::String built;
+	for (int i = 0; i < 100; i++) {
+		built.Appendf("%d,", i);
+	}
+	Assert::AreEqual((size_t)290, built.Size());
+	Assert::IsTrue(built.Ref().EndsWith("98,99,"));
+	/* Formatting from its own storage, growing it on the way. */
+	loom::String doubled("0123456789");
+	for (int i = 0; i < 6; i++) {
+		doubled.Appendf("%s", doubled.CStr());
+	}
+	Assert::AreEqual((size_t)640, doubled.Size());
+	Assert::IsTrue(doubled.Ref().EndsWith("89012345678901234567890123456789"));
+	built.Resize(3, 'x');
+	Assert::AreEqual("0,1", built.CStr());
+	built.Resize(5, 'x');
+	Assert::AreEqual("0,1xx", built.CStr());
+
+	/* Passing ownership to and from the C API without copying. */
+	char *cstr = GLU_strdup("a string long enough for the heap");
+	loom::String adopted = loom::String::Adopt(cstr);
+	Assert::IsTrue(adopted.CStr() == cstr);
+	adopted += '!';
+	char *released = adopted.Release();
+	Assert::AreEqual("a string long enough for the heap!", released);
+	Assert::IsTrue(adopted.IsEmpty());
+	MEM_freeN(released);
+
+	loom::VectorSet<loom::String> set;
+	set.Add("one");
+	set.Add(loom::String("two") + "-and-a-half-on-the-heap");
+	Assert::IsTrue(set.Contains("one"));
+	Assert::IsTrue(set.Contains("two-and-a-half-on-the-heap"));
+	Assert::IsFalse(set.Contains("two"));
+}
+
+TEST_METHOD(NumberChars_simple)
+{
+	char buf[GLU_DOUBLE_CHARS_SIZE];
+	struct {
+		double value;
+		const char *str;
+	} doubles[] = {
+		{0.0, "0"},
+		{-0.0, "-0"},
+		{1.0, "1"},
+		{0.1, "0.1"},
+		{0.3, "0.3"},
+		{0.1 + 0.2, "0.30000000000000004"},
+		{-1234.5, "-1234.5"},
+		{100.0, "100"},
+		{1e15, "1000000000000000"},
+		{1e16, "1e+16"},
+		{0.0001, "0.0001"},
+		{0.00001, "1e-05"},
+		{2.5e-7, "2.5e-07"},
+		{1.7976931348623157e308, "1.7976931348623157e+308"},
+		{2.2250738585072014e-308, "2.2250738585072014e-308"},
+		{5e-324, "5e-324"},
+		{INFINITY, "inf"},
+		{-INFINITY, "-inf"},
+		{NAN, "nan"},
+	};
+	for (const auto &d : doubles) {
+		const size_t len = GLU_double_to_chars(buf, sizeof(buf), d.value);
+		Assert::AreEqual(d.str, (const char *)buf);
+		Assert::AreEqual(strlen(d.str), len);
+	}
+	Assert::AreEqual((size_t)0, GLU_double_to_chars(buf, 4, 1234.5));
+	Assert::AreEqual("", (const char *)buf);
+
+	GLU_float_to_chars(buf, sizeof(buf), 0.1f);
+	Assert::AreEqual("0.1", (const char *)buf);
+	GLU_float_to_chars(buf, sizeof(buf), 16777216.0f);
+	Assert::AreEqual("16777216", (const char *)buf);
+	GLU_float_to_chars(buf, sizeof(buf), 3.4028235e38f);
+	Assert::AreEqual("3.4028235e+38", (const char *)buf);
+
+	GLU_int_to_chars(buf, sizeof(buf), INT64_MIN);
+	Assert::AreEqual("-9223372036854775808", (const char *)buf);
+	GLU_uint_to_chars(buf, sizeof(buf), UINT64_MAX);
+	Assert::AreEqual("18446744073709551615", (const char *)buf);
+
+	int64_t i = 7;
+	uint64_t u = 7;
+	Assert::AreEqual((size_t)3, GLU_chars_to_int("-42abc", 6, &i));
+	Assert::AreEqual((int64_t)-42, i);
+	Assert::AreEqual((size_t)20, GLU_chars_to_int("-9223372036854775808", 20, &i));
+	Assert::IsTrue(i == INT64_MIN);
+	Assert::AreEqual((size_t)0, GLU_chars_to_int("9223372036854775808", 19, &i));
+	Assert::AreEqual((size_t)25,
+					 GLU_chars_to_uint("0000018446744073709551615", 25, &u));
+	Assert::IsTrue(u == UINT64_MAX);
+	Assert::AreEqual((size_t)0, GLU_chars_to_uint("18446744073709551616", 20, &u));
+	Assert::AreEqual((size_t)0, GLU_chars_to_uint("-1", 2, &u));
+
+	/* Halfway cases, long inputs and the ends of the range. */
+	const char *strs[] = {
+		"9007199254740993",
+		"9007199254740993.0000000000000000000000000000000000000001",
+		"2.2250738585072011e-308",
+		"2.4703282292062327e-324",
+		"2.4703282292062328e-324",
+		"1.7976931348623158e308",
+		"1.7976931348623159e308",
+		"0.1e-400",
+		"1e400",
+		"123456789012345678901234567890e-20",
+		".5",
+		"5.",
+		"+1.5E+3x",
+		"7e",
+		"-0",
+	};
+	for (const char *str : strs) {
+		const size_t len = strlen(str);
+		char *end;
+		const double expect = strtod(str, &end);
+		double value = 0.0;
+		Assert::AreEqual((size_t)(end - str), GLU_chars_to_double(str, len, &value));
+		Assert::IsTrue(memcmp(&value, &expect, sizeof(value)) == 0);
+	}
+	double value = 0.0;
+	Assert::AreEqual((size_t)8, GLU_chars_to_double("Infinity", 8, &value));
+	Assert::IsTrue(value == INFINITY);
+	Assert::AreEqual((size_t)4, GLU_chars_to_double("-nan", 4, &value));
+	Assert::IsTrue(value != value);
+	Assert::AreEqual((size_t)0, GLU_chars_to_double(".e5", 3, &value));
+
+	/* Everything printed reads back the same, like with the C library. */
+	uint64_t seed = 41;
+	for (int iter = 0; iter < 100000; iter++) {
+		seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+		double d;
+		memcpy(&d, &seed, sizeof(d));
+		if (d != d) {
+			continue;
+		}
+		const size_t len = GLU_double_to_chars(buf, sizeof(buf), d);
+		double back = 0.0;
+		Assert::AreEqual(len, GLU_chars_to_double(buf, len, &back));
+		Assert::IsTrue(memcmp(&back, &d, sizeof(d)) == 0);
+		Assert::IsTrue(strtod(buf, NULL) == d);
+
+		const float f = (float)d;
+		float fback = 0.0f;
+		const size_t flen = GLU_float_to_chars(buf, sizeof(buf), f);
+		Assert::AreEqual(flen, GLU_chars_to_float(buf, flen, &fback));
+		Assert::IsTrue(memcmp(&fback, &f, sizeof(f)) == 0);
+
+		/* Many digits, correctly rounded like #strtod. */
+		char digits[64];
+		snprintf(digits, sizeof(digits), "%.20e", d);
+		GLU_chars_to_double(digits, strlen(digits), &back);
+		const double expect = strtod(digits, NULL);
+		Assert::IsTrue(memcmp(&back, &expect, sizeof(d)) == 0);
+	}
+}
+
+TEST_METHOD(Filter_bloom)
+{
+	const unsigned int count = 100000;
+	GBloom *bloom = GLU_bloom_new(GLU_ghashutil_inthash_p, count, 0.01);
+	Assert::AreEqual(0.01, GLU_bloom_calc_fpp(bloom, count), 0.001);
+	for (unsigned int i = 0; i < count; i++) {
+		GLU_bloom_add(bloom, POINTER_FROM_UINT(i * 2));
+	}
+	unsigned int nfalse = 0;
+	for (unsigned int i = 0; i < count; i++) {
+		/* A key that was added is never missed. */
+		Assert::IsTrue(GLU_bloom_may_contain(bloom, POINTER_FROM_UINT(i * 2)));
+		nfalse += GLU_bloom_may_contain(bloom, POINTER_FROM_UINT(i * 2 + 1));
+	}
+	Assert::IsTrue(nfalse > count / 200 && nfalse < count / 50);
+
+	/* The scalar kernels agree with the SIMD ones picked at runtime. */
+	const eStrSimdLevel level = GLU_str_simd_level_get();
+	GLU_str_simd_level_set(STR_SIMD_SCALAR);
+	unsigned int nfalse_scalar = 0;
+	for (unsigned int i = 0; i < count; i++) {
+		Assert::IsTrue(GLU_bloom_may_contain(bloom, POINTER_FROM_UINT(i * 2)));
+		nfalse_scalar += GLU_bloom_may_contain(bloom,
+											   POINTER_FROM_UINT(i * 2 + 1));
+	}
+	Assert::AreEqual(nfalse, nfalse_scalar);
+	GLU_str_simd_level_set(level);
+
+	GLU_bloom_clear(bloom);
+	Assert::IsFalse(GLU_bloom_may_contain(bloom, POINTER_FROM_UINT(0)));
+	GLU_bloom_free(bloom);
+}
+
+TEST_METHOD(Filter_cuckoo)
+{
+	const unsigned int count = 100000;
+	GCuckoo *cuckoo = GLU_cuckoo_new(GLU_ghashutil_inthash_p, count);
+	for (unsigned int i = 0; i < count; i++) {
+		Assert::IsTrue(GLU_cuckoo_add(cuckoo, POINTER_FROM_UINT(i * 2)));
+	}
+	Assert::AreEqual(count, GLU_cuckoo_len(cuckoo));
+	unsigned int nfalse = 0;
+	for (unsigned int i = 0; i < count; i++) {
+		Assert::IsTrue(GLU_cuckoo_may_contain(cuckoo, POINTER_FROM_UINT(i * 2)));
+		nfalse += GLU_cuckoo_may_contain(cuckoo, POINTER_FROM_UINT(i * 2 + 1));
+	}
+	Assert::IsTrue(nfalse < count / 1000);
+
+	/* Removed keys are gone, the rest stay. */
+	for (unsigned int i = 0; i < count; i += 2) {
+		Assert::IsTrue(GLU_cuckoo_remove(cuckoo, POINTER_FROM_UINT(i * 2)));
+	}
+	Assert::AreEqual(count / 2, GLU_cuckoo_len(cuckoo));
+	unsigned int nremoved = 0;
+	for (unsigned int i = 0; i < count; i++) {
+		const bool found = GLU_cuckoo_may_contain(cuckoo, POINTER_FROM_UINT(i * 2));
+		if (i % 2) {
+			Assert::IsTrue(found);
+		}
+		else {
+			nremoved += !found;
+		}
+	}
+	Assert::IsTrue(nremoved > count / 2 - count / 1000);
+
+	/* Filling past the size fails at some point, without losing keys. */
+	GLU_cuckoo_clear(cuckoo);
+	unsigned int nadded = 0;
+	while (GLU_cuckoo_add(cuckoo, POINTER_FROM_UINT(nadded))) {
+		nadded++;
+	}
+	Assert::IsTrue(nadded >= count);
+	Assert::AreEqual(nadded, GLU_cuckoo_len(cuckoo));
+	for (unsigned int i = 0; i < nadded; i++) {
+		Assert::IsTrue(GLU_cuckoo_may_contain(cuckoo, POINTER_FROM_UINT(i)));
+	}
+	/* Removing a key makes room again. */
+	Assert::IsTrue(GLU_cuckoo_remove(cuckoo, POINTER_FROM_UINT(0)));
+	Assert::IsTrue(GLU_cuckoo_add(cuckoo, POINTER_FROM_UINT(0)));
+	GLU_cuckoo_free(cuckoo);
+}
+
+TEST_METHOD(GSetBloom_simple)
+{
+	GSetBloom *gsb = GLU_gset_bloom_new(GLU_ghashutil_strhash_p,
+										GLU_ghashutil_strcmp,
+										__func__);
+	const int count = 5000;
+	char buf[32];
+	for (int i = 0; i < count; i++) {
+		snprintf(buf, sizeof(buf), "key%d", i);
+		Assert::IsTrue(GLU_gset_bloom_add(gsb, GLU_strdup(buf)));
+	}
+	Assert::IsFalse(GLU_gset_bloom_add(gsb, (void *)"key0"));
+	Assert::AreEqual((unsigned int)count, GLU_gset_bloom_len(gsb));
+	for (int i = 0; i < count; i++) {
+		snprintf(buf, sizeof(buf), "key%d", i);
+		Assert::IsTrue(GLU_gset_bloom_haskey(gsb, buf));
+		Assert::AreEqual(buf, (const char *)GLU_gset_bloom_lookup(gsb, buf));
+		snprintf(buf, sizeof(buf), "other%d", i);
+		Assert::IsFalse(GLU_gset_bloom_haskey(gsb, buf));
+	}
+
+	/* Enough removals to rebuild the filter. */
+	for (int i = 0; i < count; i += 2) {
+		snprintf(buf, sizeof(buf), "key%d", i);
+		Assert::IsTrue(GLU_gset_bloom_remove(gsb, buf, MEM_freeN));
+		Assert::IsFalse(GLU_gset_bloom_remove(gsb, buf, MEM_freeN));
+	}
+	Assert::AreEqual((unsigned int)count / 2, GLU_gset_bloom_len(gsb));
+	Assert::AreEqual(GLU_gset_bloom_len(gsb),
+					 GLU_gset_len(GLU_gset_bloom_gset(gsb)));
+	for (int i = 0; i < count; i++) {
+		snprintf(buf, sizeof(buf), "key%d", i);
+		Assert::AreEqual(i % 2 != 0, GLU_gset_bloom_haskey(gsb, buf));
+	}
+	GLU_gset_bloom_free(gsb, MEM_freeN);
+}
+
+TEST_METHOD(GSet_setops)
+{
+	/* Multiples of 2 and of 3 below 6000. */
+	GSet *two = GLU_gset_int_new(__func__);
+	GSet *three = GLU_gset_int_new(__func__);
+	for (unsigned int i = 0; i < 6000; i++) {
+		if (i % 2 == 0) {
+			GLU_gset_add(two, POINTER_FROM_UINT(i));
+		}
+		if (i % 3 == 0) {
+			GLU_gset_add(three, POINTER_FROM_UINT(i));
+		}
+	}
+	auto check = [](const GSet *gs, bool (*expect)(unsigned int)) {
+		unsigned int len = 0;
+		for (unsigned int i = 0; i < 6000; i++) {
+			Assert::AreEqual(expect(i), GLU_gset_haskey(gs, POINTER_FROM_UINT(i)));
+			len += expect(i);
+		}
+		Assert::AreEqual(len, GLU_gset_len(gs));
+	};
+	auto is_union = [](unsigned int i) { return i % 2 == 0 || i % 3 == 0; };
+	auto is_both = [](unsigned int i) { return i % 6 == 0; };
+	auto is_two_only = [](unsigned int i) { return i % 2 == 0 && i % 3 != 0; };
+	auto is_three_only = [](unsigned int i) { return i % 3 == 0 && i % 2 != 0; };
+
+	GSet *gs = GLU_gset_union_new(two, three, __func__);
+	check(gs, is_union);
+	GLU_gset_free(gs, NULL);
+	gs = GLU_gset_intersect_new(two, three, __func__);
+	check(gs, is_both);
+	GLU_gset_free(gs, NULL);
+	gs = GLU_gset_intersect_new(three, two, __func__);
+	check(gs, is_both);
+	GLU_gset_free(gs, NULL);
+	/* Both sides of the size check. */
+	gs = GLU_gset_difference_new(two, three, __func__);
+	check(gs, is_two_only);
+	GLU_gset_free(gs, NULL);
+	gs = GLU_gset_difference_new(three, two, __func__);
+	check(gs, is_three_only);
+	GLU_gset_free(gs, NULL);
+
+	gs = GLU_gset_copy(two, NULL);
+	GLU_gset_union(gs, three);
+	check(gs, is_union);
+	GLU_gset_intersect(gs, three, NULL);
+	check(gs, [](unsigned int i) { return i % 3 == 0; });
+	GLU_gset_difference(gs, two, NULL);
+	check(gs, is_three_only);
+	GLU_gset_free(gs, NULL);
+
+	gs = GLU_gset_copy(three, NULL);
+	GLU_gset_intersect(gs, two, NULL);
+	check(gs, is_both);
+	GLU_gset_difference(gs, three, NULL);
+	Assert::AreEqual(0u, GLU_gset_len(gs));
+	GLU_gset_free(gs, NULL);
+	GLU_gset_free(two, NULL);
+	GLU_gset_free(three, NULL);
+
+	/* Removed keys are freed, kept ones aren't. */
+	GSet *strs = GLU_gset_str_new(__func__);
+	GSet *keep = GLU_gset_str_new(__func__);
+	GLU_gset_add(strs, GLU_strdup("a"));
+	GLU_gset_add(strs, GLU_strdup("b"));
+	GLU_gset_add(strs, GLU_strdup("c"));
+	GLU_gset_add(keep, (void *)"b");
+	GLU_gset_intersect(strs, keep, MEM_freeN);
+	Assert::AreEqual(1u, GLU_gset_len(strs));
+	GLU_gset_difference(strs, keep, MEM_freeN);
+	Assert::AreEqual(0u, GLU_gset_len(strs));
+	GLU_gset_free(strs, MEM_freeN);
+	GLU_gset_free(keep, NULL);
+}
+
+TEST_METHOD(GSet_setops_large)
+{
+	const unsigned int count = 100000;
+	GSet *a = GLU_gset_int_new_ex(__func__, count);
+	GSet *b = GLU_gset_int_new_ex(__func__, count);
+	for (unsigned int i = 0; i < count; i++) {
+		GLU_gset_insert(a, POINTER_FROM_UINT(i));
+		GLU_gset_insert(b, POINTER_FROM_UINT(i + count / 4));
+	}
+
+	GSet *both = GLU_gset_intersect_new(a, b, __func__);
+	Assert::AreEqual(count - count / 4, GLU_gset_len(both));
+
+	/* The same by probing one key at a time. */
+	GSet *naive = GLU_gset_int_new(__func__);
+	GSET_FOREACH_BEGIN (void *, key, a) {
+		if (GLU_gset_haskey(b, key)) {
+			GLU_gset_insert(naive, key);
+		}
+	}
+	GSET_FOREACH_END();
+	Assert::AreEqual(GLU_gset_len(naive), GLU_gset_len(both));
+	for (unsigned int i = 0; i < count; i += 97) {
+		Assert::AreEqual(i >= count / 4,
+						 GLU_gset_haskey(both, POINTER_FROM_UINT(i)));
+	}
+
+	/* Removing most keys rebuilds the set. */
+	GSet *either = GLU_gset_union_new(a, b, __func__);
+	Assert::AreEqual(count + count / 4, GLU_gset_len(either));
+	GLU_gset_difference(either, both, NULL);
+	Assert::AreEqual(count / 4 * 2, GLU_gset_len(either));
+
+	/* Removing a few removes them one at a time. */
+	GSet *few = GLU_gset_int_new(__func__);
+	for (unsigned int i = 0; i < count; i += 100) {
+		GLU_gset_insert(few, POINTER_FROM_UINT(i));
+	}
+	GLU_gset_difference(a, few, NULL);
+	Assert::AreEqual(count - GLU_gset_len(few), GLU_gset_len(a));
+	Assert::IsFalse(GLU_gset_haskey(a, POINTER_FROM_UINT(100)));
+	Assert::IsTrue(GLU_gset_haskey(a, POINTER_FROM_UINT(101)));
+
+	GLU_gset_free(few, NULL);
+	GLU_gset_free(either, NULL);
+	GLU_gset_free(naive, NULL);
+	GLU_gset_free(both, NULL);
+	GLU_gset_free(b, NULL);
+	GLU_gset_free(a, NULL);
+}
+
+TEST_METHOD(VectorSet_setops)
+{
+	const loom::VectorSet<int> a = {1, 2, 3, 4, 5, 6};
+	const loom::VectorSet<int> b = {8, 6, 4, 2};
+	auto equal = [](const loom::VectorSet<int> &set,
+					const std::vector<int> &expect) {
+		Assert::AreEqual(expect.size(), set.Size());
+		for (size_t i = 0; i < expect.size(); i++) {
+			Assert::AreEqual(expect[i], set[i]);
+			Assert::AreEqual(i, set.IndexOf(expect[i]));
+		}
+	};
+
+	/* The order of the first set is kept. */
+	equal(a.Union(b), {1, 2, 3, 4, 5, 6, 8});
+	equal(a.Intersection(b), {2, 4, 6});
+	equal(b.Intersection(a), {6, 4, 2});
+	equal(a.Difference(b), {1, 3, 5});
+	equal(b.Difference(a), {8});
+
+	loom::VectorSet<int> c = a;
+	c.IntersectWith(b);
+	equal(c, {2, 4, 6});
+	c.UnionWith(a);
+	equal(c, {2, 4, 6, 1, 3, 5});
+	c.Subtract(loom::VectorSet<int>{4});
+	equal(c, {2, 6, 1, 3, 5});
+	c.Subtract(a);
+	Assert::IsTrue(c.IsEmpty());
+
+	loom::VectorSet<int> d;
+	for (int i = 0; i < 1000; i++) {
+		d.Add(i);
+	}
+	d.IntersectWith(loom::VectorSet<int>{999, 5, 7, 2000});
+	equal(d, {5, 7, 999});
+}
+
+TEST_METHOD(ListBase_sort)
+{
+	struct Item {
+		Item *prev, *next;
+		int key;
+		int order;
+	};
+	auto cmp = [](const void *a, const void *b) {
+		const int ka = static_cast<const Item *>(a)->key;
+		const int kb = static_cast<const Item *>(b)->key;
+		return (ka > kb) - (ka < kb);
+	};
+	auto check = [](const ListBase *lb, int len) {
+		int count = 0;
+		const Item *prev = nullptr;
+		LISTBASE_FOREACH (const Item *, item, lb) {
+			Assert::IsTrue(item->prev == prev);
+			if (prev) {
+				/* Sorted, equal keys keep their order. */
+				Assert::IsTrue(prev->key < item->key ||
+							   (prev->key == item->key && prev->order < item->order));
+			}
+			prev = item;
+			count++;
+		}
+		Assert::IsTrue(lb->last == prev);
+		Assert::AreEqual(len, count);
+	};
+
+	for (int len : {0, 1, 2, 3, 7, 64, 1000, 4097}) {
+		std::vector<Item> items(len);
+		ListBase lb = {nullptr, nullptr};
+		uint32_t seed = (uint32_t)len;
+		for (int i = 0; i < len; i++) {
+			seed = seed * 1664525u + 1013904223u;
+			items[i].key = (int)(seed >> 24) % 50;
+			items[i].order = i;
+			GLU_addtail(&lb, &items[i]);
+		}
+		GLU_listbase_sort(&lb, cmp);
+		check(&lb, len);
+		/* Sorting a sorted list changes nothing. */
+		GLU_listbase_sort(&lb, cmp);
+		check(&lb, len);
+
+		/* Descending with the thunk. */
+		int sign = -1;
+		GLU_listbase_sort_r(
+			&lb,
+			[](void *thunk, const void *a, const void *b) {
+				const int ka = static_cast<const Item *>(a)->key;
+				const int kb = static_cast<const Item *>(b)->key;
+				return *(int *)thunk * ((ka > kb) - (ka < kb));
+			},
+			&sign);
+		int prev_key = INT_MAX;
+		LISTBASE_FOREACH (const Item *, item, &lb) {
+			Assert::IsTrue(item->key <= prev_key);
+			prev_key = item->key;
+		}
+
+		ListBase sorted = {nullptr, nullptr};
+		for (int i = 0; i < len; i++) {
+			GLU_listbase_insert_sorted(&sorted, &items[i], cmp);
+		}
+		check(&sorted, len);
+	}
+}
+
+TEST_METHOD(ListBaseIndex_simple)
+{
+	struct Item {
+		Item *prev, *next;
+		char name[16];
+		const char *label;
+		void *owner;
+	};
+	const int count = 20000;
+	std::vector<Item> items(count + 2);
+	const char *labels[] = {"red", "green", NULL};
+	ListBase lb = {nullptr, nullptr};
+	for (int i = 0; i < count; i++) {
+		snprintf(items[i].name, sizeof(items[i].name), "item%d", i % 15000);
+		items[i].label = labels[i % 3];
+		items[i].owner = &items[i % 100];
+		GLU_addtail(&lb, &items[i]);
+	}
+	const int name_offset = offsetof(Item, name);
+	const int label_offset = offsetof(Item, label);
+	const int owner_offset = offsetof(Item, owner);
+
+	ListBaseIndex *index = GLU_listbase_index_new(&lb);
+	auto check = [&]() {
+		const int len = GLU_listbase_count(&lb);
+		Assert::AreEqual(len, GLU_listbase_index_count(index));
+		for (int i = -1; i <= len; i += 7) {
+			Assert::IsTrue(GLU_findlink(&lb, i) ==
+						   GLU_listbase_index_findlink(index, i));
+		}
+		for (int i = 0; i < count + 2; i += 13) {
+			Assert::AreEqual(GLU_findindex(&lb, &items[i]),
+							 GLU_listbase_index_findindex(index, &items[i]));
+		}
+		char name[16];
+		for (int i = 0; i < 15000; i += 11) {
+			snprintf(name, sizeof(name), "item%d", i);
+			Assert::IsTrue(GLU_findstring(&lb, name, name_offset) ==
+						   GLU_listbase_index_findstring(
+							   index, name, name_offset));
+		}
+		Assert::IsTrue(GLU_listbase_index_findstring(
+						   index, "none", name_offset) == NULL);
+		/* The first of the equal keys. */
+		Assert::IsTrue(GLU_findstring_ptr(&lb, "green", label_offset) ==
+					   GLU_listbase_index_findstring_ptr(
+						   index, "green", label_offset));
+		for (int i = 0; i < 100; i++) {
+			Assert::IsTrue(GLU_findptr(&lb, &items[i], owner_offset) ==
+						   GLU_listbase_index_findptr(
+							   index, &items[i], owner_offset));
+		}
+	};
+	check();
+
+	/* Changes at the ends are noticed. */
+	GLU_addhead(&lb, &items[count]);
+	snprintf(items[count].name, sizeof(items[count].name), "item7");
+	items[count].label = "green";
+	items[count].owner = &items[5];
+	check();
+	GLU_pophead(&lb);
+	GLU_addtail(&lb, &items[count + 1]);
+	check();
+
+	/* Others have to be tagged. */
+	GLU_remlink(&lb, &items[500]);
+	GLU_insertlinkafter(&lb, &items[10], &items[500]);
+	GLU_listbase_index_tag_dirty(index);
+	check();
+
+	GLU_listbase_index_free(index);
+}
+
+TEST_METHOD(ListBase_defragment)
+{
+	struct Item {
+		Item *prev, *next;
+		int value;
+		Item *other;
+	};
+	const int len = 200000;
+
+	/* Allocated in one order, linked in another, as a list that was edited
+	 * for a while. */
+	std::vector<Item *> items(len);
+	for (int i = 0; i < len; i++) {
+		items[i] = MEM_cnew<Item>(__func__);
+	}
+	uint32_t seed = 46;
+	for (int i = len - 1; i > 0; i--) {
+		seed = seed * 1664525u + 1013904223u;
+		std::swap(items[i], items[seed % (uint32_t)(i + 1)]);
+	}
+	ListBase lb = {nullptr, nullptr};
+	for (int i = 0; i < len; i++) {
+		items[i]->value = i;
+		items[i]->other = items[(i * 7) % len];
+		GLU_addtail(&lb, items[i]);
+	}
+
+	auto traverse = [&lb]() {
+		long long sum = 0;
+		LISTBASE_FOREACH (Item *, item, &lb) {
+			sum += item->value;
+		}
+		return sum;
+	};
+	const long long expected = (long long)len * (len - 1) / 2;
+	Assert::AreEqual(expected, traverse());
+
+	GHash *old_to_new;
+	void *block = GLU_listbase_defragment(
+		&lb, sizeof(Item), true, &old_to_new);
+	Assert::IsTrue(block == lb.first);
+	Assert::AreEqual((unsigned int)len, GLU_ghash_len(old_to_new));
+
+	Assert::AreEqual(expected, traverse());
+
+	int i = 0;
+	Item *prev = nullptr;
+	LISTBASE_FOREACH (Item *, item, &lb) {
+		Assert::IsTrue(item == static_cast<Item *>(block) + i);
+		Assert::IsTrue(item->prev == prev);
+		Assert::AreEqual(i, item->value);
+		/* Patch the references to the old links. */
+		item->other = static_cast<Item *>(
+			GLU_ghash_lookup(old_to_new, (void *)item->other));
+		prev = item;
+		i++;
+	}
+	Assert::IsTrue(lb.last == prev);
+	LISTBASE_FOREACH (Item *, item, &lb) {
+		Assert::AreEqual((item->value * 7) % len, item->other->value);
+	}
+	GLU_ghash_free(old_to_new, NULL, NULL);
+
+	/* Links added later are freed one at a time. */
+	GLU_remlink(&lb, GLU_findlink(&lb, 10));
+	GLU_addhead(&lb, MEM_cnew<Item>(__func__));
+	GLU_addtail(&lb, MEM_cnew<Item>(__func__));
+	GLU_listbase_defragment_free(&lb, block);
+	Assert::IsTrue(GLU_listbase_is_empty(&lb));
+
+	Assert::IsTrue(GLU_listbase_defragment(&lb, sizeof(Item), true, NULL) ==
+				   NULL);
+}
+
+TEST_METHOD(ListBase_parallel_foreach)
+{
+	struct Item {
+		Item *prev, *next;
+		int value;
+		int visits;
+		int index;
+	};
+	struct Totals {
+		long long sum;
+		int count;
+	};
+	const int len = 100000;
+	std::vector<Item> items(len);
+	ListBase lb = {nullptr, nullptr};
+	for (int i = 0; i < len; i++) {
+		items[i].value = i % 1000;
+		GLU_addtail(&lb, &items[i]);
+	}
+	long long expected = 0;
+	for (int i = 0; i < len; i++) {
+		expected += items[i].value;
+	}
+
+	auto func = [](void *userdata, Link *link, int index, void *chunk) {
+		Item *item = reinterpret_cast<Item *>(link);
+		Totals *totals = static_cast<Totals *>(chunk);
+		item->visits++;
+		item->index = index;
+		totals->sum += item->value;
+		totals->count++;
+		(*static_cast<std::atomic<int> *>(userdata))++;
+	};
+	auto reduce = [](void *userdata, void *chunk_join, void *chunk) {
+		Totals *join = static_cast<Totals *>(chunk_join);
+		const Totals *totals = static_cast<const Totals *>(chunk);
+		join->sum += totals->sum;
+		join->count += totals->count;
+		(void)userdata;
+	};
+
+	for (int threads_num = 1; threads_num <= 4; threads_num++) {
+		for (int i = 0; i < len; i++) {
+			items[i].visits = 0;
+			items[i].index = -1;
+		}
+		std::atomic<int> calls(0);
+		Totals totals = {0, 0};
+		ListBaseParallelSettings settings;
+		GLU_listbase_parallel_settings_init(&settings);
+		settings.userdata = &calls;
+		settings.userdata_chunk = &totals;
+		settings.userdata_chunk_size = sizeof(totals);
+		settings.func_reduce = reduce;
+		settings.min_iter_per_thread = 100;
+		settings.threads_num = threads_num;
+		GLU_listbase_parallel_foreach(&lb, func, &settings);
+
+		Assert::AreEqual(len, calls.load());
+		Assert::AreEqual(len, totals.count);
+		Assert::AreEqual(expected, totals.sum);
+		for (int i = 0; i < len; i++) {
+			Assert::AreEqual(1, items[i].visits);
+			Assert::AreEqual(i, items[i].index);
+		}
+	}
+}
+
+TEST_METHOD(ListBase_pooled_nodes)
+{
+	const int len = 100000;
+	std::vector<int> values(len);
+
+	MemPool *pool = GLU_genericNode_pool_create(0);
+	Assert::AreEqual((size_t)0, GLU_mempool_len(pool));
+	Assert::IsTrue(GLU_addtail_pooled(NULL, pool, NULL) == NULL);
+
+	ListBase lb_a = {nullptr, nullptr}, lb_b = {nullptr, nullptr};
+	for (int i = 0; i < len; i++) {
+		GLU_addtail_pooled((i % 2) ? &lb_b : &lb_a, pool, &values[i]);
+	}
+	Assert::AreEqual((size_t)len, GLU_mempool_len(pool));
+	int i = 0;
+	LISTBASE_FOREACH (LinkData *, ld, &lb_a) {
+		Assert::IsTrue(ld->data == &values[i]);
+		i += 2;
+	}
+
+	/* Nodes of one list go back to the pool, the other list is untouched. */
+	GLU_freelist_pooled(&lb_a, pool);
+	Assert::IsTrue(GLU_listbase_is_empty(&lb_a));
+	Assert::AreEqual((size_t)(len / 2), GLU_mempool_len(pool));
+	i = 1;
+	LISTBASE_FOREACH (LinkData *, ld, &lb_b) {
+		Assert::IsTrue(ld->data == &values[i]);
+		i += 2;
+	}
+
+	GLU_freelist_pooled_all(&lb_b, pool);
+	Assert::IsTrue(GLU_listbase_is_empty(&lb_b));
+	Assert::AreEqual((size_t)0, GLU_mempool_len(pool));
+
+	/* The emptied pool hands out its nodes again. */
+	for (i = 0; i < len; i++) {
+		GLU_addtail_pooled(&lb_a, pool, &values[i]);
+	}
+	Assert::AreEqual((size_t)len, GLU_mempool_len(pool));
+	GLU_freelist_pooled_all(&lb_a, pool);
+	Assert::AreEqual((size_t)0, GLU_mempool_len(pool));
+	GLU_mempool_discard(pool);
+}
+
+TEST_METHOD(Vector_relocatable_growth)
+{
+	struct Moving {
+		int value;
+		Moving(int value) : value(value)
+		{
+		}
+		Moving(Moving &&other) noexcept : value(other.value)
+		{
+		}
+	};
+	struct alignas(32) Wide {
+		int value;
+	};
+	Assert::IsTrue(loom::is_trivially_relocatable_extended_v<int>);
+	Assert::IsTrue(loom::is_trivially_relocatable_extended_v<Wide>);
+	Assert::IsFalse(loom::is_trivially_relocatable_extended_v<Moving>);
+
+	const int len = 1000000;
+	loom::Vector<int> ints;
+	loom::Vector<Wide> wides;
+	loom::Vector<Wide, 0, loom::RawAllocator> raw_wides;
+	loom::Vector<Moving> movings;
+	for (int i = 0; i < len; i++) {
+		ints.Append(i);
+		wides.Append({i});
+		raw_wides.Append({i});
+		movings.Append(Moving(i));
+	}
+	Assert::AreEqual((uintptr_t)0, (uintptr_t)wides.Data() % 32);
+	Assert::AreEqual((uintptr_t)0, (uintptr_t)raw_wides.Data() % 32);
+	for (int i = 0; i < len; i++) {
+		Assert::AreEqual(i, ints[i]);
+		Assert::AreEqual(i, wides[i].value);
+		Assert::AreEqual(i, raw_wides[i].value);
+		Assert::AreEqual(i, movings[i].value);
+	}
+}
+
+TEST_METHOD(Vector_append_uninitialized)
+{
+	struct Point {
+		float x = 1.0f, y = 2.0f;
+	};
+
+	loom::Vector<int> ints;
+	ints.Append(-1);
+	loom::MutableSpan<int> tail = ints.ExtendUninitialized(100);
+	Assert::AreEqual((size_t)101, ints.Size());
+	Assert::AreEqual((size_t)100, tail.Size());
+	for (size_t i = 0; i < tail.Size(); i++) {
+		tail[i] = (int)i;
+	}
+	Assert::AreEqual(-1, ints[0]);
+	Assert::AreEqual(99, ints[100]);
+
+	/* Write an unknown number, up to the space asked for. */
+	int *cursor = ints.EnsureSpaceFor(1000);
+	Assert::IsTrue(ints.Capacity() - ints.Size() >= 1000);
+	int written = 0;
+	for (int i = 0; i < 1000; i += 3) {
+		cursor[written++] = i;
+	}
+	ints.IncreaseSizeByUnchecked(written);
+	Assert::AreEqual((size_t)(101 + written), ints.Size());
+	Assert::AreEqual(999, ints[ints.Size() - 1]);
+	Assert::IsTrue(ints.EnsureSpaceFor(0) == ints.End());
+
+	loom::Vector<Point> points;
+	loom::MutableSpan<Point> new_points = points.AppendN(10);
+	Assert::AreEqual((size_t)10, points.Size());
+	for (size_t i = 0; i < new_points.Size(); i++) {
+		Assert::AreEqual(1.0f, new_points[i].x);
+		Assert::AreEqual(2.0f, new_points[i].y);
+	}
+	Assert::AreEqual((size_t)10, points.IndexRange().Size());
+	const loom::Vector<Point> &points_const = points;
+	Assert::IsTrue(points_const.ReverseBegin() != points_const.ReverseEnd());
+}
+
+TEST_METHOD(Array_simple)
+{
+	struct Point {
+		float x = 1.0f, y = 2.0f;
+	};
+
+	loom::Array<int> ints(100);
+	for (size_t i = 0; i < ints.Size(); i++) {
+		ints[i] = (int)i;
+	}
+	loom::Array<int> copy(ints);
+	Assert::AreEqual((size_t)100, copy.Size());
+	Assert::AreEqual(99, copy.Last());
+	loom::Array<int> moved(std::move(copy));
+	Assert::AreEqual(99, moved[99]);
+	Assert::IsTrue(copy.IsEmpty());
+	copy = moved;
+	Assert::AreEqual(42, copy[42]);
+	Assert::AreEqual((size_t)100, copy.IndexRange().Size());
+
+	loom::Array<int> filled(5, 7);
+	Assert::AreEqual(7, filled.First());
+	filled.Reinitialize(20);
+	Assert::AreEqual((size_t)20, filled.Size());
+
+	loom::Array<Point> points(10);
+	Assert::AreEqual(2.0f, points[9].y);
+	/* The elements are left as they are, to be written afterwards. */
+	loom::Array<Point> raw_points(1000, loom::NoInitialization());
+	Assert::AreEqual((size_t)1000, raw_points.Size());
+	for (size_t i = 0; i < raw_points.Size(); i++) {
+		new (&raw_points[i]) Point();
+	}
+	Assert::AreEqual(1.0f, raw_points[999].x);
+
+	loom::Array<std::string> strings = {"a", "b", "c"};
+	const loom::Array<std::string> &strings_const = strings;
+	Assert::IsTrue(*strings_const.ReverseBegin() == "c");
+}
 }
 ;